@@ -0,0 +1,82 @@
+#include "bench_util.hpp"
+
+namespace hypertea {
+
+// inplace_channeled_scaladd as it was, with a TensorCPU view per image and
+// per channel on every call; the baseline of the flat loops.
+static void chunked_channeled_scaladd(
+    TensorCPU<float>& x, const TensorCPU<float>& weight, const TensorCPU<float>& bias,
+    int channels, int spatial_dim) {
+
+  int num = x.count() / (channels * spatial_dim);
+
+  auto weight_data = weight.immutable_data();
+  auto bias_data = bias.immutable_data();
+
+  for (auto& n: x.chunked_tensors(num)) {
+    auto d = n.chunked_tensors(channels);
+    for (int i = 0; i < channels; ++i) {
+      (d[i] *= weight_data[i]) += bias_data[i];
+    }
+  }
+}
+
+
+// The inplace_channeled_* helpers on the (channels, spatial_dim) feature
+// maps of the demo nets. Scaling kernels restore their input before every
+// call, see vs_helpers.
+HYPERTEA_BENCHMARK(inplace_channeled) {
+
+  const std::vector<std::pair<int, int> > shapes {
+    {1024, 13 * 13}, {512, 26 * 26}, {256, 52 * 52}, {32, 416 * 416},
+    {128, 128 * 128}, {32, 512 * 512},
+  };
+
+  struct Kernel {
+    const char* name;
+    std::function<void(TensorCPU<float>&, const TensorCPU<float>&, const TensorCPU<float>&, int, int)> func;
+    double flops_per_element;
+    bool drifts;
+  };
+
+  const std::vector<Kernel> kernels {
+    {"inplace_channeled_scal", [](TensorCPU<float>& x, const TensorCPU<float>& w, const TensorCPU<float>&, int c, int s) {
+      inplace_channeled_scal(x, w, c, s); }, 1, true},
+    {"inplace_channeled_add", [](TensorCPU<float>& x, const TensorCPU<float>&, const TensorCPU<float>& b, int c, int s) {
+      inplace_channeled_add(x, b, c, s); }, 1, false},
+    {"inplace_channeled_sub", [](TensorCPU<float>& x, const TensorCPU<float>&, const TensorCPU<float>& b, int c, int s) {
+      inplace_channeled_sub(x, b, c, s); }, 1, false},
+    {"inplace_channeled_scaladd", [](TensorCPU<float>& x, const TensorCPU<float>& w, const TensorCPU<float>& b, int c, int s) {
+      inplace_channeled_scaladd(x, w, b, c, s); }, 2, true},
+    {"chunked_channeled_scaladd", chunked_channeled_scaladd, 2, true},
+    {"inplace_channeled_bias_activation", [](TensorCPU<float>& x, const TensorCPU<float>&, const TensorCPU<float>& b, int c, int s) {
+      inplace_channeled_bias_activation(x, &b, c, s, ACTIVATION_TYPE::RELU, .1f); }, 2, true},
+  };
+
+  for (auto& k : kernels) {
+    for (auto& shape : shapes) {
+
+      const int channels = shape.first, spatial_dim = shape.second;
+      const std::string name = std::string(k.name) + "/c=" + std::to_string(channels)
+        + ",spatial=" + std::to_string(spatial_dim);
+      if (!suite.selected(name)) { continue; }
+
+      const int count = channels * spatial_dim;
+      TensorCPU<float> input = bench_tensor(count);
+      TensorCPU<float> x = input.duplicate();
+      TensorCPU<float> weight = bench_tensor(channels, .5f, 2.f);
+      TensorCPU<float> bias = bench_tensor(channels);
+
+      const BenchmarkWork work {2.0 * count * sizeof(float), k.flops_per_element * count};
+      auto func = [&]() { k.func(x, weight, bias, channels, spatial_dim); };
+
+      if (k.drifts) {
+        suite.run(name, work, func, [&]() { x.copy_data(input); });
+      } else {
+        suite.run(name, work, func);
+      }
+    }
+  }
+}
+
+}  // namespace hypertea
@@ -0,0 +1,93 @@
+#include <algorithm>
+#include <thread>
+
+#include "bench_util.hpp"
+#include "hypertea/util/packed_gemm.hpp"
+
+namespace hypertea {
+
+// inplace_gemm as the im2col convolution calls it: weight (M x K) times
+// the column matrix (K x N), and the transposed weight of the style
+// transfer deconvolutions.
+HYPERTEA_BENCHMARK(inplace_gemm) {
+
+  struct GemmShape {
+    std::string name;
+    CBLAS_TRANSPOSE trans_a;
+    int M, N, K;
+  };
+
+  std::vector<GemmShape> shapes;
+  for (auto& s : demo_net_conv_shapes()) {
+    shapes.push_back({s.str(), CblasNoTrans, s.out_channels, s.col_cols(), s.col_rows()});
+  }
+  shapes.push_back({"style_deconv1/128x128x128/k3s2/64", CblasTrans, 64 * 3 * 3, 128 * 128, 128});
+  shapes.push_back({"style_deconv2/64x256x256/k3s2/32", CblasTrans, 32 * 3 * 3, 256 * 256, 64});
+
+  for (auto& s : shapes) {
+
+    char dims[64];
+    snprintf(dims, sizeof(dims), "%s/M%dN%dK%d", s.trans_a == CblasTrans ? "T" : "N", s.M, s.N, s.K);
+    const std::string name = "inplace_gemm/" + s.name + "/" + dims;
+    if (!suite.selected(name)) { continue; }
+
+    TensorCPU<float> a = bench_tensor(s.M * s.K);
+    TensorCPU<float> b = bench_tensor(s.K * s.N);
+    TensorCPU<float> c(s.M * s.N, 0.f);
+
+    const double bytes = ((double)s.M * s.K + (double)s.K * s.N + (double)s.M * s.N) * sizeof(float);
+    suite.run(name, {bytes, 2.0 * s.M * s.N * s.K}, [&]() {
+      inplace_gemm(s.trans_a, CblasNoTrans, s.M, s.N, s.K, 1.f, a, b, 0.f, c);
+    });
+  }
+}
+
+
+// packed_gemm, which the CPU convolutions, linear and RNN operators call,
+// on the conv shapes with 1 .. all cores in ThreadPool::Gemm(). Each shape
+// ends with the speedup of every thread count over one thread.
+HYPERTEA_BENCHMARK(packed_gemm) {
+
+  const int cores = std::max(1u, std::thread::hardware_concurrency());
+  std::vector<int> threads;
+  for (int t = 1; t < cores; t *= 2) { threads.push_back(t); }
+  threads.push_back(cores);
+
+  for (auto& s : demo_net_conv_shapes()) {
+
+    const int M = s.out_channels, N = s.col_cols(), K = s.col_rows();
+
+    char dims[64];
+    snprintf(dims, sizeof(dims), "M%dN%dK%d", M, N, K);
+    const std::string prefix = "packed_gemm/" + s.str() + "/" + dims;
+    if (!suite.selected(prefix)) { continue; }
+
+    TensorCPU<float> a = bench_tensor(M * K);
+    TensorCPU<float> b = bench_tensor(K * N);
+    TensorCPU<float> c(M * N, 0.f);
+    PackedMatrix packed(a.immutable_data(), M, K);
+
+    const double bytes = ((double)M * K + (double)K * N + (double)M * N) * sizeof(float);
+    std::vector<double> median_us;
+
+    for (int t : threads) {
+      ThreadPool::Get().set_parallelism(1, t);
+      suite.run(prefix + "/threads=" + std::to_string(t), {bytes, 2.0 * M * N * K}, [&]() {
+        packed_gemm(packed, N, b.immutable_data(), N, 1, nullptr, 0.f, c.mutable_data(), N, 1);
+      });
+      median_us.push_back(suite.results().back().median_us);
+    }
+
+    if (!suite.options().csv) {
+      printf("  scaling:");
+      for (int i = 0; i < threads.size(); ++i) {
+        printf(" %dT x%.2f", threads[i], median_us[0] / median_us[i]);
+      }
+      printf("\n");
+    }
+  }
+
+  ThreadPool::Get().set_parallelism(1, cores);
+}
+
+}  // namespace hypertea
@@ -0,0 +1,37 @@
+#include "bench_util.hpp"
+
+namespace hypertea {
+
+// im2col reads the image and writes the column matrix, col2im reads the
+// column matrix and accumulates it into the cleared image.
+HYPERTEA_BENCHMARK(im2col) {
+
+  for (auto& s : demo_net_conv_shapes()) {
+
+    const double im_count = (double)s.channels * s.height * s.width;
+    const double col_count = (double)s.col_rows() * s.col_cols();
+
+    const std::string im2col_name = "im2col/" + s.str();
+    const std::string col2im_name = "col2im/" + s.str();
+    if (!suite.selected(im2col_name) && !suite.selected(col2im_name)) { continue; }
+
+    TensorCPU<float> im = bench_tensor(s.channels * s.height * s.width);
+    TensorCPU<float> col(s.col_rows() * s.col_cols());
+
+    if (suite.selected(im2col_name)) {
+      suite.run(im2col_name, {(im_count + col_count) * sizeof(float), 0}, [&]() {
+        im2col(im, s.channels, s.height, s.width, s.kernel, s.kernel,
+          s.pad, s.pad, s.stride, s.stride, 1, 1, col);
+      });
+    }
+
+    if (suite.selected(col2im_name)) {
+      suite.run(col2im_name, {(2 * im_count + col_count) * sizeof(float), col_count}, [&]() {
+        col2im(col, s.channels, s.height, s.width, s.kernel, s.kernel,
+          s.pad, s.pad, s.stride, s.stride, 1, 1, im);
+      });
+    }
+  }
+}
+
+}  // namespace hypertea
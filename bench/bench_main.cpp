@@ -0,0 +1,143 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+
+#include "bench_util.hpp"
+
+namespace hypertea {
+
+std::vector<std::pair<std::string, BenchmarkFunc> >& benchmark_registry() {
+  static std::vector<std::pair<std::string, BenchmarkFunc> > registry;
+  return registry;
+}
+
+
+static double elapsed_us(std::chrono::steady_clock::time_point start) {
+  return std::chrono::duration<double, std::micro>(std::chrono::steady_clock::now() - start).count();
+}
+
+
+void BenchmarkSuite::run(const std::string& name, BenchmarkWork work,
+  std::function<void()> func, std::function<void()> reset) {
+
+  for (int i = 0; i < options_.warmup; ++i) {
+    if (reset) { reset(); }
+    func();
+  }
+
+  int calls = 1;
+  if (!reset) {
+    auto start = std::chrono::steady_clock::now();
+    func();
+    const double once = std::max(elapsed_us(start), 1e-3);
+    calls = std::min(1 << 20, std::max(1, (int)std::ceil(options_.min_sample_us / once)));
+  }
+
+  std::vector<double> samples;
+  for (int r = 0; r < options_.repeat; ++r) {
+    if (reset) { reset(); }
+    auto start = std::chrono::steady_clock::now();
+    for (int i = 0; i < calls; ++i) { func(); }
+    samples.push_back(elapsed_us(start) / calls);
+  }
+
+  std::sort(samples.begin(), samples.end());
+
+  BenchmarkResult result;
+  result.name = name;
+  result.work = work;
+  result.samples = samples.size();
+  result.calls_per_sample = calls;
+  result.min_us = samples.front();
+  result.median_us = samples.size() % 2 ? samples[samples.size() / 2]
+    : (samples[samples.size() / 2 - 1] + samples[samples.size() / 2]) / 2;
+
+  double sum = 0, sum_sq = 0;
+  for (double s : samples) { sum += s; sum_sq += s * s; }
+  result.mean_us = sum / samples.size();
+  result.stddev_us = std::sqrt(std::max(0.0, sum_sq / samples.size() - result.mean_us * result.mean_us));
+
+  results_.push_back(result);
+  report(result);
+}
+
+
+void BenchmarkSuite::report(const BenchmarkResult& r) const {
+
+  if (options_.csv) {
+    printf("%s,%d,%d,%.3f,%.3f,%.3f,%.3f,%.0f,%.0f,%.3f,%.3f\n",
+      r.name.c_str(), r.samples, r.calls_per_sample,
+      r.min_us, r.median_us, r.mean_us, r.stddev_us,
+      r.work.bytes, r.work.flops, r.gbps(), r.gflops());
+  } else {
+    printf("%-56s %7d %11.2f %11.2f %11.2f %7.1f%% %8.2f %8.2f\n",
+      r.name.c_str(), r.calls_per_sample,
+      r.min_us, r.median_us, r.mean_us, 100 * r.stddev_us / r.mean_us,
+      r.gbps(), r.gflops());
+  }
+  fflush(stdout);
+}
+
+}  // namespace hypertea
+
+
+using namespace hypertea;
+
+static bool parse_flag(const char* arg, const char* flag, const char** value) {
+  const size_t len = strlen(flag);
+  if (strncmp(arg, flag, len) != 0 || arg[len] != '=') { return false; }
+  *value = arg + len + 1;
+  return true;
+}
+
+
+int main(int argc, char** argv) {
+
+  BenchmarkSuite::Options options;
+
+  for (int i = 1; i < argc; ++i) {
+    const char* value;
+    if (parse_flag(argv[i], "--filter", &value)) {
+      options.filter = value;
+    } else if (parse_flag(argv[i], "--warmup", &value)) {
+      options.warmup = atoi(value);
+    } else if (parse_flag(argv[i], "--repeat", &value)) {
+      options.repeat = std::max(1, atoi(value));
+    } else if (parse_flag(argv[i], "--min_sample_us", &value)) {
+      options.min_sample_us = atof(value);
+    } else if (strcmp(argv[i], "--csv") == 0) {
+      options.csv = true;
+    } else {
+      printf("usage: %s [--filter=substring] [--warmup=%d] [--repeat=%d] [--min_sample_us=%.0f] [--csv]\n",
+        argv[0], options.warmup, options.repeat, options.min_sample_us);
+      return strcmp(argv[i], "--help") == 0 ? 0 : 1;
+    }
+  }
+
+  if (options.csv) {
+    printf("name,samples,calls_per_sample,min_us,median_us,mean_us,stddev_us,bytes,flops,gbps,gflops\n");
+  } else {
+    printf("%d warmup calls, %d samples per case, statistics per call, GB/s and GFLOP/s at the median\n",
+      options.warmup, options.repeat);
+    printf("%-56s %7s %11s %11s %11s %8s %8s %8s\n",
+      "case", "calls", "min us", "median us", "mean us", "stddev", "GB/s", "GFLOP/s");
+  }
+
+  BenchmarkSuite suite(options);
+
+  // Static registration order depends on the link order, sort it.
+  auto& registry = benchmark_registry();
+  std::sort(registry.begin(), registry.end(),
+    [](const std::pair<std::string, BenchmarkFunc>& a, const std::pair<std::string, BenchmarkFunc>& b) {
+      return a.first < b.first;
+    });
+
+  for (auto& group : registry) {
+    group.second(suite);
+  }
+
+  return 0;
+}
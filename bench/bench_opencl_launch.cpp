@@ -0,0 +1,65 @@
+#ifdef USE_OPENCL
+
+#include "bench_util.hpp"
+
+namespace hypertea {
+
+// A sigmoid_kernel launch the way opencl_launch_wrapper used to do it, with
+// a cl_kernel created and released every time.
+static void launch_uncached(cl_mem x, int n) {
+
+  cl_int ret;
+  cl_kernel kernel = clCreateKernel(OpenCLHandler::Get().math_program, "sigmoid_kernel", &ret);
+  OPENCL_CHECK(ret);
+
+  size_t global = HYPERTEA_GET_BLOCKS(n);
+  size_t local = HYPERTEA_OPENCL_NUM_THREADS;
+
+  OPENCL_CHECK(clSetKernelArg(kernel, 0, sizeof(cl_mem), &x));
+  OPENCL_CHECK(clSetKernelArg(kernel, 1, sizeof(cl_mem), &x));
+  OPENCL_CHECK(clSetKernelArg(kernel, 2, sizeof(cl_int), &n));
+  OPENCL_CHECK(clEnqueueNDRangeKernel(OpenCLHandler::Get().commandQueue,
+    kernel, 1, nullptr, &global, &local, 0, nullptr, nullptr));
+  OPENCL_CHECK(clReleaseKernel(kernel));
+}
+
+
+// Host-side cost of launching a small element-wise kernel, with and without
+// the kernel cache of opencl_launch_wrapper. Each call is a round of
+// launches ending with clFinish; the tensor is small enough to keep the
+// device time out of the way, so the difference is the per-launch overhead.
+HYPERTEA_BENCHMARK(opencl_launch) {
+
+  const int count = 1024;
+  const int launches = 1000;
+
+  const std::string prefix = "opencl_launch/sigmoid/n=" + std::to_string(count)
+    + ",launches=" + std::to_string(launches);
+  if (!suite.selected(prefix)) { return; }
+
+  OpenCLHandler::Get().build_opencl_math_code(false);
+
+  TensorGPU<float> x(std::vector<float>(count, 0.5f));
+  cl_mem x_data = x.mutable_data();
+
+  auto round = [&](const std::function<void()>& launch) {
+    return [&, launch]() {
+      for (int i = 0; i < launches; ++i) { launch(); }
+      OPENCL_CHECK(clFinish(OpenCLHandler::Get().commandQueue));
+    };
+  };
+
+  suite.run(prefix + "/uncached", {0, 0}, round([&]() { launch_uncached(x_data, count); }));
+  const double uncached_us = suite.results().back().median_us;
+
+  suite.run(prefix + "/cached", {0, 0}, round([&]() { inplace_sigmoid(x); }));
+
+  if (!suite.options().csv) {
+    printf("  per launch: uncached %.2f us, cached %.2f us, %zu kernels cached\n",
+      uncached_us / launches, suite.results().back().median_us / launches, opencl_kernel_cache_size());
+  }
+}
+
+}  // namespace hypertea
+
+#endif //USE_OPENCL
@@ -0,0 +1,122 @@
+#include "bench_util.hpp"
+
+namespace hypertea {
+
+// Statistics of the style transfer batch norms: one pass reads x.
+HYPERTEA_BENCHMARK(mean_var) {
+
+  for (auto& shape : std::vector<std::pair<int, int> > {{32, 512 * 512}, {64, 256 * 256}, {128, 128 * 128}}) {
+
+    const int channels = shape.first, spatial_dim = shape.second;
+    const std::string name = "mean_var/c=" + std::to_string(channels) + ",spatial=" + std::to_string(spatial_dim);
+    if (!suite.selected(name)) { continue; }
+
+    const int count = channels * spatial_dim;
+    TensorCPU<float> x = bench_tensor(count);
+    TensorCPU<float> mean(channels), var(channels);
+
+    suite.run(name, {(double)count * sizeof(float), 3.0 * count}, [&]() {
+      mean_var(x, mean, var, channels, spatial_dim, 1e-5f);
+    });
+  }
+}
+
+
+// One comparison per element.
+HYPERTEA_BENCHMARK(batched_argmax) {
+
+  for (auto& shape : std::vector<std::pair<int, int> > {{10647, 80}, {64, 4096}, {1, 1 << 20}}) {
+
+    const int batch = shape.first, spatial_dim = shape.second;
+    const std::string name = "batched_argmax/batch=" + std::to_string(batch) + ",spatial=" + std::to_string(spatial_dim);
+    if (!suite.selected(name)) { continue; }
+
+    TensorCPU<float> x = bench_tensor(batch * spatial_dim);
+
+    suite.run(name, {(double)batch * spatial_dim * sizeof(float), (double)batch * spatial_dim}, [&]() {
+      batched_argmax(x, spatial_dim);
+    });
+  }
+}
+
+
+// The YOLO upsampling layers, nearest neighbour by 2.
+HYPERTEA_BENCHMARK(upsampling_2d) {
+
+  for (auto& shape : std::vector<std::pair<int, int> > {{256, 13}, {128, 26}, {64, 104}}) {
+
+    const int channels = shape.first, size = shape.second, scale = 2;
+    const std::string name = "upsampling_2d/c=" + std::to_string(channels) + ",hw=" + std::to_string(size)
+      + ",scale=" + std::to_string(scale);
+    if (!suite.selected(name)) { continue; }
+
+    const int count = channels * size * size;
+    TensorCPU<float> x = bench_tensor(count);
+
+    suite.run(name, {(1.0 + scale * scale) * count * sizeof(float), 0}, [&]() {
+      upsampling_2d(x, scale, size, size, size * size);
+    });
+  }
+}
+
+
+// The YOLO route layers: concate for a single image, hconcate for a batch
+// of 4, where each image's channels are concatenated separately.
+HYPERTEA_BENCHMARK(concate) {
+
+  struct Route { int c0, c1, hw; };
+
+  for (auto& r : std::vector<Route> {{256, 512, 26 * 26}, {128, 256, 52 * 52}}) {
+
+    const std::string shape = "/c=" + std::to_string(r.c0) + "+" + std::to_string(r.c1)
+      + ",spatial=" + std::to_string(r.hw);
+
+    const std::string concate_name = "concate" + shape;
+    if (suite.selected(concate_name)) {
+
+      TensorCPU<float> a = bench_tensor(r.c0 * r.hw);
+      TensorCPU<float> b = bench_tensor(r.c1 * r.hw);
+      const double count = (double)(r.c0 + r.c1) * r.hw;
+
+      suite.run(concate_name, {2 * count * sizeof(float), 0}, [&]() {
+        concate(std::vector<TensorCPU<float>* > {&a, &b});
+      });
+    }
+
+    const int batch = 4;
+    const std::string hconcate_name = "hconcate" + shape + ",batch=" + std::to_string(batch);
+    if (suite.selected(hconcate_name)) {
+
+      TensorCPU<float> a = bench_tensor(batch * r.c0 * r.hw);
+      TensorCPU<float> b = bench_tensor(batch * r.c1 * r.hw);
+      const double count = (double)batch * (r.c0 + r.c1) * r.hw;
+
+      suite.run(hconcate_name, {2 * count * sizeof(float), 0}, [&]() {
+        hconcate(std::vector<TensorCPU<float>* > {&a, &b}, batch);
+      });
+    }
+  }
+}
+
+
+// nums transposes of an (old_last_dim x new_last_dim) matrix each.
+HYPERTEA_BENCHMARK(transpose_hw) {
+
+  struct Shape { int nums, old_last_dim, new_last_dim; };
+
+  for (auto& s : std::vector<Shape> {{255, 13, 13}, {64, 128, 64}, {1, 1024, 1024}}) {
+
+    const std::string name = "transpose_hw/nums=" + std::to_string(s.nums) + ",hw="
+      + std::to_string(s.new_last_dim) + "x" + std::to_string(s.old_last_dim);
+    if (!suite.selected(name)) { continue; }
+
+    const int count = s.nums * s.old_last_dim * s.new_last_dim;
+    TensorCPU<float> x = bench_tensor(count);
+
+    suite.run(name, {2.0 * count * sizeof(float), 0}, [&]() {
+      x.transpose_hw(s.old_last_dim, s.new_last_dim);
+    });
+  }
+}
+
+}  // namespace hypertea
@@ -0,0 +1,156 @@
+// Micro-benchmark harness of the bench target. A bench_*.cpp file
+// registers its cases with HYPERTEA_BENCHMARK and reports every
+// parameterization through BenchmarkSuite::run():
+//
+//   HYPERTEA_BENCHMARK(vs_exp) {
+//     for (int n : {1 << 12, 1 << 20}) {
+//       std::string name = "vsExp/n=" + std::to_string(n);
+//       if (!suite.selected(name)) { continue; }
+//       TensorCPU<float> x = bench_tensor(n);
+//       suite.run(name, {2.0 * n * sizeof(float), 0}, [&]() { vsExp(n, x.mutable_data()); });
+//     }
+//   }
+//
+// Every case is warmed up, then timed for --repeat samples. Calls shorter
+// than --min_sample_us are batched into one sample, unless the case has a
+// reset function (for in-place kernels whose input would drift when applied
+// over and over), which then runs untimed before each single timed call.
+// GB/s and GFLOP/s are derived from the median time per call.
+#ifndef BENCH_BENCH_UTIL_HPP_
+#define BENCH_BENCH_UTIL_HPP_
+
+#include <stdio.h>
+#include <functional>
+#include <random>
+#include <string>
+#include <vector>
+
+#include "hypertea/hypertea.hpp"
+
+namespace hypertea {
+
+// Bytes read plus written and floating point operations of one call.
+struct BenchmarkWork {
+  double bytes;
+  double flops;
+};
+
+struct BenchmarkResult {
+  std::string name;
+  BenchmarkWork work;
+  int samples;
+  int calls_per_sample;
+  double min_us;
+  double median_us;
+  double mean_us;
+  double stddev_us;
+
+  double gbps() const { return work.bytes / (median_us * 1e3); }
+  double gflops() const { return work.flops / (median_us * 1e3); }
+};
+
+
+class BenchmarkSuite {
+ public:
+
+  struct Options {
+    std::string filter;
+    int warmup = 3;
+    int repeat = 20;
+    double min_sample_us = 1000;
+    bool csv = false;
+  };
+
+  explicit BenchmarkSuite(const Options& options) : options_(options) {}
+
+  // Whether the case passes --filter; check it before allocating inputs.
+  bool selected(const std::string& name) const {
+    return name.find(options_.filter) != std::string::npos;
+  }
+
+  void run(const std::string& name, BenchmarkWork work,
+    std::function<void()> func, std::function<void()> reset = nullptr);
+
+  const Options& options() const { return options_; }
+  const std::vector<BenchmarkResult>& results() const { return results_; }
+
+ private:
+
+  void report(const BenchmarkResult& result) const;
+
+  Options options_;
+  std::vector<BenchmarkResult> results_;
+
+};
+
+
+typedef void (*BenchmarkFunc)(BenchmarkSuite& suite);
+
+std::vector<std::pair<std::string, BenchmarkFunc> >& benchmark_registry();
+
+struct BenchmarkRegisterer {
+  BenchmarkRegisterer(const char* group, BenchmarkFunc func) {
+    benchmark_registry().push_back(std::make_pair(std::string(group), func));
+  }
+};
+
+#define HYPERTEA_BENCHMARK(group) \
+  static void hypertea_benchmark_##group(::hypertea::BenchmarkSuite& suite); \
+  static ::hypertea::BenchmarkRegisterer hypertea_benchmark_registerer_##group( \
+    #group, hypertea_benchmark_##group); \
+  static void hypertea_benchmark_##group(::hypertea::BenchmarkSuite& suite)
+
+
+// Uniformly distributed values in [lo, hi), the same on every run.
+inline TensorCPU<float> bench_tensor(int count, float lo = -1, float hi = 1) {
+
+  static std::mt19937 generator(1234);
+  std::uniform_real_distribution<float> distribution(lo, hi);
+
+  TensorCPU<float> x(count);
+  auto data = x.mutable_data();
+  for (int i = 0; i < count; ++i) {
+    data[i] = distribution(generator);
+  }
+  return x;
+}
+
+
+// Convolution layers of the demo nets (tools/yolo at 416 x 416,
+// tools/style_transfer at 512 x 512), the shapes im2col and inplace_gemm
+// see in them.
+struct BenchConvShape {
+  const char* net;
+  int channels, height, width;
+  int kernel, pad, stride;
+  int out_channels;
+
+  int out_height() const { return (height + 2 * pad - kernel) / stride + 1; }
+  int out_width() const { return (width + 2 * pad - kernel) / stride + 1; }
+  int col_rows() const { return channels * kernel * kernel; }
+  int col_cols() const { return out_height() * out_width(); }
+
+  std::string str() const {
+    char s[96];
+    snprintf(s, sizeof(s), "%s/%dx%dx%d/k%ds%d/%d", net, channels, height, width, kernel, stride, out_channels);
+    return s;
+  }
+};
+
+inline std::vector<BenchConvShape> demo_net_conv_shapes() {
+  return {
+    {"yolo_conv_0",      3, 416, 416, 3, 1, 1,   32},
+    {"yolo_conv_1",     32, 416, 416, 3, 1, 2,   64},
+    {"yolo_conv_2",     64, 208, 208, 1, 0, 1,   32},
+    {"yolo_52",        128,  52,  52, 3, 1, 1,  256},
+    {"yolo_13",        512,  13,  13, 3, 1, 1, 1024},
+    {"yolo_head_13",  1024,  13,  13, 1, 0, 1,  255},
+    {"style_conv2",     32, 512, 512, 3, 1, 2,   64},
+    {"style_conv3",     64, 256, 256, 3, 1, 2,  128},
+    {"style_res",      128, 128, 128, 3, 1, 1,  128},
+  };
+}
+
+}  // namespace hypertea
+
+#endif  // BENCH_BENCH_UTIL_HPP_
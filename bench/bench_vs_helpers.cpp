@@ -0,0 +1,119 @@
+#include <math.h>
+#include <algorithm>
+
+#include "bench_util.hpp"
+
+namespace hypertea {
+
+// The vs* helpers of cpu_blas_helper.hpp, each over an L1, an L2 and a
+// DRAM sized array. One flop is counted per element, also for the
+// transcendental ones. Helpers whose values would run into inf, NaN or
+// denormals when applied over and over restore their input before every
+// call instead of being batched.
+HYPERTEA_BENCHMARK(vs_helpers) {
+
+  struct Helper {
+    const char* name;
+    std::function<void(int, const float*, float*)> func;
+    bool binary;
+    float lo, hi;
+    bool drifts;
+  };
+
+  const std::vector<Helper> helpers {
+    {"vsSqr",     [](int n, const float*, float* y) { vsSqr(n, y); },          false, -1.f, 1.f, true},
+    {"vsSqrt",    [](int n, const float*, float* y) { vsSqrt(n, y); },         false, .5f, 2.f, false},
+    {"vsAbs",     [](int n, const float*, float* y) { vsAbs(n, y); },          false, -1.f, 1.f, false},
+    {"vsInv",     [](int n, const float*, float* y) { vsInv(n, y); },          false, .5f, 2.f, false},
+    {"vsExp",     [](int n, const float*, float* y) { vsExp(n, y); },          false, -1.f, 1.f, true},
+    {"vsLn",      [](int n, const float*, float* y) { vsLn(n, y); },           false, .5f, 2.f, true},
+    {"vsSigmoid", [](int n, const float*, float* y) { vsSigmoid(n, y); },      false, -4.f, 4.f, false},
+    {"vsTanH",    [](int n, const float*, float* y) { vsTanH(n, y); },         false, -4.f, 4.f, false},
+    {"vsPowx",    [](int n, const float*, float* y) { vsPowx(n, 1.5f, y); },   false, .5f, 2.f, true},
+    {"vsAddScal", [](int n, const float*, float* y) { vsAddScal(n, .5f, y); }, false, -1.f, 1.f, false},
+    {"vsMulScal", [](int n, const float*, float* y) { vsMulScal(n, .5f, y); }, false, -1.f, 1.f, true},
+    {"vsReLU",    [](int n, const float*, float* y) { vsReLU(n, .1f, y); },    false, -1.f, 1.f, true},
+    {"vsELU",     [](int n, const float*, float* y) { vsELU(n, 1.f, y); },     false, -1.f, 1.f, true},
+    {"vsAdd",     [](int n, const float* a, float* y) { vsAdd(n, a, y); },     true, -1.f, 1.f, false},
+    {"vsSub",     [](int n, const float* a, float* y) { vsSub(n, a, y); },     true, -1.f, 1.f, false},
+    {"vsMul",     [](int n, const float* a, float* y) { vsMul(n, a, y); },     true, .5f, 2.f, true},
+    {"vsDiv",     [](int n, const float* a, float* y) { vsDiv(n, a, y); },     true, .5f, 2.f, true},
+  };
+
+  for (auto& h : helpers) {
+    for (int n : {1 << 12, 1 << 16, 1 << 22}) {
+
+      const std::string name = std::string(h.name) + "/n=" + std::to_string(n);
+      if (!suite.selected(name)) { continue; }
+
+      TensorCPU<float> input = bench_tensor(n, h.lo, h.hi);
+      TensorCPU<float> a = bench_tensor(n, h.lo, h.hi);
+      TensorCPU<float> y = input.duplicate();
+
+      const double bytes = (h.binary ? 3.0 : 2.0) * n * sizeof(float);
+      auto func = [&]() { h.func(n, a.immutable_data(), y.mutable_data()); };
+
+      if (h.drifts) {
+        suite.run(name, {bytes, (double)n}, func, [&]() { y.copy_data(input); });
+      } else {
+        suite.run(name, {bytes, (double)n}, func);
+      }
+    }
+  }
+}
+
+
+
+static void scalar_exp(const int n, float* y) { for (int i = 0; i < n; ++i) { y[i] = exp(y[i]); } }
+static void scalar_log(const int n, float* y) { for (int i = 0; i < n; ++i) { y[i] = log(y[i]); } }
+static void scalar_tanh(const int n, float* y) { for (int i = 0; i < n; ++i) { y[i] = tanh(y[i]); } }
+static void scalar_sigmoid(const int n, float* y) { for (int i = 0; i < n; ++i) { y[i] = 0.5 * tanh(0.5 * y[i]) + 0.5; } }
+static void scalar_elu(const int n, float* y) {
+  for (int i = 0; i < n; ++i) { y[i] = std::max(y[i], 0.f) + (exp(std::min(y[i], 0.f)) - 1.f); }
+}
+static void simd_elu_one(const int n, float* y) { simd_elu(n, 1.f, y); }
+
+// The vectorized transcendental functions behind vsExp, vsLn, vsTanH,
+// vsSigmoid and vsELU against the scalar libm loops they replaced, on the
+// simd_math_isa() of this machine.
+HYPERTEA_BENCHMARK(simd_math) {
+
+  struct Function {
+    const char* name;
+    float lo, hi;
+    void (*scalar)(const int, float*);
+    void (*simd)(const int, float*);
+  };
+
+  const std::vector<Function> functions {
+    {"exp", -20.f, 20.f, scalar_exp, simd_exp},
+    {"log", 1e-3f, 1e3f, scalar_log, simd_log},
+    {"tanh", -5.f, 5.f, scalar_tanh, simd_tanh},
+    {"sigmoid", -10.f, 10.f, scalar_sigmoid, simd_sigmoid},
+    {"elu", -5.f, 5.f, scalar_elu, simd_elu_one},
+  };
+
+  const int n = 1 << 20;
+
+  for (auto& f : functions) {
+
+    const std::string prefix = std::string("simd_math/") + f.name + "/n=" + std::to_string(n);
+    if (!suite.selected(prefix)) { continue; }
+
+    TensorCPU<float> input = bench_tensor(n, f.lo, f.hi);
+    TensorCPU<float> y = input.duplicate();
+
+    suite.run(prefix + "/scalar", {2.0 * n * sizeof(float), (double)n},
+      [&]() { f.scalar(n, y.mutable_data()); }, [&]() { y.copy_data(input); });
+    const double scalar_us = suite.results().back().median_us;
+
+    suite.run(prefix + "/" + simd_math_isa(), {2.0 * n * sizeof(float), (double)n},
+      [&]() { f.simd(n, y.mutable_data()); }, [&]() { y.copy_data(input); });
+
+    if (!suite.options().csv) {
+      printf("  speedup: x%.2f\n", scalar_us / suite.results().back().median_us);
+    }
+  }
+}
+
+}  // namespace hypertea
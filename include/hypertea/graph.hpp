@@ -0,0 +1,175 @@
+#ifndef HYPERTEA_GRAPH_H_
+#define HYPERTEA_GRAPH_H_
+
+#include <functional>
+#include <ostream>
+#include <string>
+#include <vector>
+
+#include "hypertea/operator.hpp"
+
+namespace hypertea {
+
+// A net as data instead of a hand-written inference(): nodes wrap a
+// TensorOperator or a math function, values (the edges) are the tensors
+// flowing between them. GraphBuilder records the net once, in the order of
+// the hand-written code,
+//
+//   GraphBuilder<DeviceTensor> b;
+//   GraphValue x = b.input("data", {3, 512, 512});
+//   x = b.chain(x, {&conv1, &bn1, &relu1});
+//   x = b.add(x, b.chain(x, {&res_conv1, &res_bn1, &res_relu1}));
+//   b.output(x);
+//   graph_ = b.build();
+//
+// and Graph::run() executes the nodes in that order, so results are exactly
+// those of the hand-written code. Passes work on nodes() and values() and
+// call finalize() after changing them; finalize() itself is the analysis
+// run() relies on:
+//  - liveness: every value is released after its last consumer, so its
+//    storage goes back to the memory planner / buffer pool early;
+//  - in-place updates: a node that writes its first input (add()) copies it
+//    first when a later node still reads the old value;
+//  - scheduling: nodes added inside branch() run on a BranchGroup branch
+//    of their own (OpenCL), joined before anything else consumes them;
+//  - profiling: named operator nodes are reported under their node name.
+//
+// Operators run exactly as called, an in-place operator (e.g. ReLUOp with
+// IN_PLACE) still writes its input tensor; passes that reorder nodes must
+// keep that in mind.
+//
+// The demo nets (tools/*/demo_net.hpp) build graph_ this way and keep the
+// hand-written code it was recorded from as reference_inference(), to check
+// the graph against; that runs outside the memory plan.
+
+// Handle to a value of the graph a GraphBuilder is building.
+struct GraphValue {
+  int id = -1;
+};
+
+
+template <typename DeviceTensor>
+class Graph {
+public:
+
+  // Maps the input tensors of a node to its output tensors. Functions may
+  // update an input in place only when they are its last consumer.
+  typedef std::function<std::vector<DeviceTensor>(std::vector<DeviceTensor>&)> Function;
+
+  struct Value {
+    std::string name;
+    // Given by the builder or empty; count is then taken from the first run.
+    std::vector<int> shape;
+    int count = -1;
+    int producer = -1;               // node, -1 for graph inputs
+    int alias = -1;                  // value whose storage this one shares
+    int branch = 0;
+    std::vector<int> consumers;      // nodes, in execution order
+  };
+
+  struct Node {
+    std::string name;
+    std::string type;                // operator type() or function name
+    TensorOperator<DeviceTensor>* op = nullptr;
+    Function function;               // when op is nullptr
+    std::vector<int> inputs;
+    std::vector<int> outputs;
+    bool writes_input = false;       // function updates inputs[0] in place
+    int branch = 0;                  // 0 is the trunk
+
+    // Set by finalize().
+    bool copy_input = false;
+    std::vector<int> release;        // values whose last consumer this is
+  };
+
+  // Called when output k has been computed, e.g. to start reading it back
+  // on the queue of its branch.
+  typedef std::function<void(int k, const DeviceTensor& output)> OutputCallback;
+
+  const std::vector<Node>& nodes() const { return nodes_; }
+  std::vector<Node>& mutable_nodes() { return nodes_; }
+  const std::vector<Value>& values() const { return values_; }
+  std::vector<Value>& mutable_values() { return values_; }
+  const std::vector<int>& inputs() const { return inputs_; }
+  const std::vector<int>& outputs() const { return outputs_; }
+
+  void finalize();
+
+  // Stops at the first node that fails (a missing input, a wrong number of
+  // results) and returns no outputs then, after logging the error.
+  std::vector<DeviceTensor> run(const std::vector<DeviceTensor>& inputs,
+    const OutputCallback& on_output = nullptr);
+
+  // The single output, or the input itself if the run failed.
+  DeviceTensor run(const DeviceTensor& input) {
+    auto outputs = run(std::vector<DeviceTensor> {input});
+    return outputs.empty() ? input : outputs[0];
+  }
+
+  // One line per node: %outputs = type(%inputs) name [branch], with counts.
+  void dump(std::ostream& out) const;
+
+private:
+
+  template <typename> friend class GraphBuilder;
+
+  std::vector<Node> nodes_;
+  std::vector<Value> values_;
+  std::vector<int> inputs_;
+  std::vector<int> outputs_;
+
+};
+
+
+template <typename DeviceTensor>
+class GraphBuilder {
+public:
+
+  typedef typename Graph<DeviceTensor>::Function Function;
+
+  GraphValue input(const std::string& name, const std::vector<int>& shape = {});
+  void output(GraphValue x);
+
+  GraphValue op(TensorOperator<DeviceTensor>& op, GraphValue x,
+    const std::string& name = "", const std::vector<int>& shape = {});
+
+  // op() for each operator in turn, e.g. conv, batch norm, activation.
+  GraphValue chain(GraphValue x, const std::vector<TensorOperator<DeviceTensor>*>& ops);
+
+  std::vector<GraphValue> function(const std::string& type,
+    const std::vector<GraphValue>& inputs, int num_outputs, Function f);
+
+  GraphValue function(const std::string& type, const std::vector<GraphValue>& inputs,
+    std::function<DeviceTensor(std::vector<DeviceTensor>&)> f);
+
+  // a + b; in a's storage unless a is read again later.
+  GraphValue add(GraphValue a, GraphValue b);
+  GraphValue concate(const std::vector<GraphValue>& xs);
+  GraphValue hconcate(const std::vector<GraphValue>& xs, int top_dim);
+  GraphValue sub_view(GraphValue x, int offset, int count);
+  GraphValue gemm(const CBLAS_TRANSPOSE TransA, const CBLAS_TRANSPOSE TransB,
+    const int M, const int N, const int K, const float alpha,
+    GraphValue a, GraphValue b, const float beta);
+
+  // Nodes added by body run on a branch of their own.
+  void branch(const std::function<void()>& body);
+
+  void set_shape(GraphValue x, const std::vector<int>& shape);
+
+  Graph<DeviceTensor> build();
+
+private:
+
+  GraphValue new_value(int producer);
+  typename Graph<DeviceTensor>::Node& new_node(const std::string& type,
+    const std::vector<GraphValue>& inputs, int num_outputs);
+
+  Graph<DeviceTensor> graph_;
+  int branch_ = 0;
+  int branches_ = 0;
+
+};
+
+}  // namespace hypertea
+
+#endif  // HYPERTEA_GRAPH_H_
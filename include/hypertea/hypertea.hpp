@@ -5,6 +5,7 @@
 #define HYPERTEA_HYPERTEA_HPP_
 
 #include "hypertea/common.hpp"
+#include "hypertea/util/mapped_file.hpp"
 
 #include "hypertea/operators/activation.hpp"
 #include "hypertea/operators/sampling_op.hpp"
@@ -16,41 +17,59 @@
 #include "hypertea/operators/MIOpen_batch_norm_op.hpp"
 #include "hypertea/operators/rnn_op.hpp"
 #include "hypertea/operators/linear_op.hpp"
+#include "hypertea/operators/blocked_op.hpp"
+
+#include "hypertea/graph.hpp"
 
 namespace hypertea {
 
+    // Creates the parameter tensor of a net from a weight file. Host tensors
+    // are backed by the file mapping itself, so nothing is read until a layer
+    // touches its weights; device tensors are uploaded straight from the mapping.
     template <typename DeviceTensor>
-    void load_weight_to_tensor(std::string path, DeviceTensor& param) {
-        
-        size_t weight_size = param.size();
+    DeviceTensor load_weight_tensor(const std::string& path, int count) {
 
-        void* all_weights = malloc(weight_size);
+        DeviceTensor param(count);
 
-        FILE *f = fopen(path.c_str(), "rb");
-        
-        size_t read_size = fread(all_weights, 1, weight_size, f);
-        
-        if (read_size != weight_size) { 
-            LOG(ERROR) << "Weight File Size Mismatch" << read_size << " and " << weight_size << std::endl;
+        auto mapping = map_file(path, param.size());
+        if (mapping) {
+            param.copy_from_ptr(mapping.get());
         }
-        
-        fclose(f);
+        return param;
+    }
 
-        param.copy_from_ptr((void*)all_weights);
+    template <>
+    inline TensorCPU<float> load_weight_tensor(const std::string& path, int count) {
 
-        free(all_weights);
-        
+        auto mapping = map_file(path, count * sizeof(float));
+        if (!mapping) {
+            return TensorCPU<float>(count);
+        }
+        return TensorCPU<float>(std::static_pointer_cast<float>(mapping), count);
     }
 
 
+    template <typename DeviceTensor>
+    void load_weight_to_tensor(std::string path, DeviceTensor& param) {
 
-    void compile_opencl_kernels(
-#ifdef USE_OPENCL
+        auto mapping = map_file(path, param.size());
+        if (mapping) {
+            param.copy_from_ptr(mapping.get());
+        }
+    }
+
+
+
+    inline void compile_opencl_kernels(
         const std::string &conv_opencl_funcs,
         const std::string &bn_opencl_funcs) {
+#ifdef USE_OPENCL
         OpenCLHandler::Get().build_opencl_math_code(false);
         OpenCLHandler::Get().build_opencl_program(conv_opencl_funcs, OpenCLHandler::Get().conv_program);
         OpenCLHandler::Get().build_opencl_program(bn_opencl_funcs, OpenCLHandler::Get().bn_program);
+#else
+        (void)conv_opencl_funcs;
+        (void)bn_opencl_funcs;
 #endif //USE_OPENCL
 
     }
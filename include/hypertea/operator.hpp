@@ -2,6 +2,7 @@
 #define HYPERTEA_LAYER_H_
 
 #include "hypertea/tensor.hpp"
+#include "hypertea/util/profiler.hpp"
 
 namespace hypertea {
 
@@ -6,6 +6,7 @@
 
 #include "hypertea/util/im2col.hpp"
 #include "hypertea/operator.hpp"
+#include "hypertea/util/thread_pool.hpp"
 
 namespace hypertea {
 
@@ -65,11 +66,14 @@ class BaseConvolutionOp : public TensorOperator<DeviceTensor>{
             conv_out_spatial_dim_ = std::accumulate(output_shape.begin()+2, output_shape.end(), 1, std::multiplies<int>());
           }
 
-          kernel_dim_ = conv_in_channels_ * std::accumulate(kernel_shape.begin(), kernel_shape.end(), 1, std::multiplies<int>());
-          weight_offset_ = conv_out_channels_ * kernel_dim_;
+          // Per group: weight_offset_, col_offset_ and output_offset_ separate
+          // the (M / group x kernel_dim_) weights, (kernel_dim_ x N) columns
+          // and (M / group x N) outputs of consecutive groups.
+          kernel_dim_ = conv_in_channels_ / group_ * std::accumulate(kernel_shape.begin(), kernel_shape.end(), 1, std::multiplies<int>());
+          weight_offset_ = conv_out_channels_ * kernel_dim_ / group_;
           col_buffer_shape_[0] *= kernel_dim_;
 
-          col_offset_ = std::accumulate(col_buffer_shape_.begin(), col_buffer_shape_.end(), 1, std::multiplies<int>());
+          col_offset_ = kernel_dim_ * conv_out_spatial_dim_;
           output_offset_ = conv_out_spatial_dim_ * conv_out_channels_ / group_;
 
  
@@ -95,8 +99,13 @@ class BaseConvolutionOp : public TensorOperator<DeviceTensor>{
 
           // << num_spatial_axes_ << std::endl;
 
+          workers_ = batch_workers<DeviceTensor>();
+
           if(!is_1x1) {
-            col_buffer_ = new DeviceTensor(col_offset_);
+            col_buffer_ = new DeviceTensor(col_offset_ * group_);
+            for (int i = 1; i < workers_; ++i) {
+              worker_col_buffers_.push_back(std::make_shared<DeviceTensor>(col_offset_ * group_));
+            }
           }
 
 
@@ -161,6 +170,29 @@ protected:
   }
 
 
+  // Images of a batch are spread over at most workers_ threads, each with
+  // its own col buffer.
+  DeviceTensor* worker_col_buffer(int worker) {
+    return worker == 0 ? col_buffer_ : worker_col_buffers_[worker - 1].get();
+  }
+
+  // Replaces the full-size col buffers, e.g. by tile sized ones; count 0
+  // frees them for paths that never run im2col (direct depthwise, Winograd).
+  void reset_col_buffers(int count) {
+    if (is_1x1_) { return; }
+
+    delete col_buffer_;
+    col_buffer_ = count > 0 ? new DeviceTensor(count) : nullptr;
+
+    worker_col_buffers_.clear();
+    for (int i = 1; count > 0 && i < workers_; ++i) {
+      worker_col_buffers_.push_back(std::make_shared<DeviceTensor>(count));
+    }
+  }
+
+  void release_col_buffers() { reset_col_buffers(0); }
+
+
   int conv_out_channels_;
   int conv_in_channels_;
   int conv_out_spatial_dim_;
@@ -168,7 +200,10 @@ protected:
   int col_offset_;
   int output_offset_;
 
-  DeviceTensor* col_buffer_;
+  DeviceTensor* col_buffer_ = nullptr;
+
+  int workers_;
+  std::vector<std::shared_ptr<DeviceTensor> > worker_col_buffers_;
 
 
 };
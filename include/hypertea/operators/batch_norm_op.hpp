@@ -45,6 +45,16 @@ public:
 
   virtual DeviceTensor operator()(DeviceTensor input) override;
 
+  // Only a batch norm with running statistics can be folded at load time.
+  bool foldable() const { return use_global_stats_; }
+
+  // Rescales conv_weight, laid out as (channels, ...), so that the preceding
+  // convolution already produces normalized outputs, and returns the bias it
+  // should add instead. conv_bias may be nullptr. Callers must test
+  // foldable() first: otherwise conv_weight is left as is, the returned bias
+  // equals conv_bias and bn stays in the forward pass.
+  DeviceTensor fold_into(DeviceTensor& conv_weight, const DeviceTensor* conv_bias) const;
+
 private:
 
   int channels_;
@@ -62,6 +72,19 @@ private:
 };
 
 
+// Folds y = (conv(x) + conv_bias - mean) / sqrt(variance + eps) * weight + bias
+// into the convolution: conv_weight is scaled per output channel and
+// folded_bias receives the new bias. conv_bias and weight may be nullptr;
+// folded_bias may alias conv_bias or bias.
+template <typename DeviceTensor>
+void fold_batch_norm(
+  DeviceTensor& conv_weight, const DeviceTensor* conv_bias,
+  const DeviceTensor& mean, const DeviceTensor& variance,
+  const DeviceTensor* weight, const DeviceTensor* bias,
+  int channels, float eps,
+  DeviceTensor& folded_bias
+);
+
 
 }  // namespace hypertea
 
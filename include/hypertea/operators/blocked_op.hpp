@@ -0,0 +1,131 @@
+#ifndef HYPERTEA_BLOCKED_OP_HPP_
+#define HYPERTEA_BLOCKED_OP_HPP_
+
+#include <vector>
+
+#include "hypertea/operator.hpp"
+#include "hypertea/operators/batch_norm_op.hpp"
+#include "hypertea/util/blocked_layout.hpp"
+
+namespace hypertea {
+
+// Host operators working on NCHWc tensors, see blocked_layout.hpp. A blocked
+// subgraph starts with ReorderOp(TO_NCHWC) and ends with ReorderOp(TO_NCHW);
+// in between element-wise ops (activations, +=, ...) work unchanged,
+// upsampling and concatenation go through blocked_upsampling_2d() and
+// blocked_concate().
+
+enum class LAYOUT_REORDER {
+  TO_NCHWC,
+  TO_NCHW
+};
+
+
+class ReorderOp : public TensorOperator<TensorCPU<float>> {
+public:
+
+  explicit ReorderOp(int channels, int spatial_dim, int block, LAYOUT_REORDER direction)
+    : channels_(channels), spatial_dim_(spatial_dim), block_(block), direction_(direction) {}
+
+  virtual inline const char* type() const override { return "Reorder"; }
+  virtual TensorCPU<float> operator()(TensorCPU<float> input) override;
+
+private:
+
+  int channels_;
+  int spatial_dim_;
+  int block_;
+  LAYOUT_REORDER direction_;
+
+};
+
+
+// Direct NCHWc convolution (group 1) with bias and activation fused, takes
+// the same OIhw weights and arguments as FusedConvolutionOp.
+class BlockedConvolutionOp : public TensorOperator<TensorCPU<float>> {
+public:
+
+  explicit BlockedConvolutionOp(
+    TensorCPU<float>* weight,
+    TensorCPU<float>* bias,
+    std::vector<int> kernel_shape,
+    std::vector<int> stride,
+    std::vector<int> pad,
+    std::vector<int> dilation,
+    std::vector<int> input_shape,
+    std::vector<int> output_shape,
+    int block,
+    ACTIVATION_TYPE activation = ACTIVATION_TYPE::NONE,
+    float alpha = 0,
+    TensorCPU<float>* activation_weight = nullptr);
+
+  virtual inline const char* type() const override { return "BlockedConvolution"; }
+  virtual TensorCPU<float> operator()(TensorCPU<float> input) override;
+
+  // Same as ConvolutionOp::fold_batch_norm(), rescales *weight in place.
+  void fold_batch_norm(const BatchNormOp<TensorCPU<float>>& bn);
+
+private:
+
+  void prepare_blocked_weights();
+
+  TensorCPU<float>* weight_;
+  TensorCPU<float>* bias_;
+  TensorCPU<float>* activation_weight_;
+
+  std::vector<int> kernel_shape_;
+  std::vector<int> stride_;
+  std::vector<int> pad_;
+  std::vector<int> dilation_;
+  std::vector<int> input_shape_;
+  std::vector<int> output_shape_;
+
+  int block_;
+  ACTIVATION_TYPE activation_;
+  float activation_alpha_;
+
+  std::shared_ptr<TensorCPU<float>> blocked_weight_;
+  std::shared_ptr<TensorCPU<float>> blocked_bias_;
+  std::shared_ptr<TensorCPU<float>> blocked_slope_;
+  std::shared_ptr<TensorCPU<float>> folded_bias_;
+
+};
+
+
+// Inference batch norm (running statistics) on NCHWc tensors: one
+// precomputed scale and shift vector per channel block, optionally followed
+// by an activation in the same pass.
+class BlockedBatchNormOp : public TensorOperator<TensorCPU<float>> {
+public:
+
+  explicit BlockedBatchNormOp(
+    int channels, int spatial_dim,
+    float eps,
+    const TensorCPU<float>& mean, const TensorCPU<float>& variance,
+    const TensorCPU<float>* weight, const TensorCPU<float>* bias,
+    int block,
+    bool inplace = false,
+    ACTIVATION_TYPE activation = ACTIVATION_TYPE::NONE,
+    float alpha = 0);
+
+  virtual inline const char* type() const override { return "BlockedBatchNorm"; }
+  virtual TensorCPU<float> operator()(TensorCPU<float> input) override;
+
+private:
+
+  int channels_;
+  int spatial_dim_;
+  int block_;
+  bool inplace_;
+  ACTIVATION_TYPE activation_;
+  float activation_alpha_;
+
+  std::shared_ptr<TensorCPU<float>> scale_;
+  std::shared_ptr<TensorCPU<float>> shift_;
+
+};
+
+
+}  // namespace hypertea
+
+#endif  // HYPERTEA_BLOCKED_OP_HPP_
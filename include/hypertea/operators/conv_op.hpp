@@ -4,6 +4,10 @@
 #include <vector>
 
 #include "hypertea/operators/base_conv_op.hpp"
+#include "hypertea/operators/batch_norm_op.hpp"
+#include "hypertea/util/winograd.hpp"
+#include "hypertea/util/depthwise_conv.hpp"
+#include "hypertea/util/packed_gemm.hpp"
 
 namespace hypertea {
 
@@ -25,15 +29,125 @@ class ConvolutionOp : public BaseConvolutionOp<DeviceTensor> {
     std::vector<int> output_shape)
 
     : BaseConvolutionOp<DeviceTensor>(weight, bias, group, is_1x1,
-      kernel_shape, stride, pad, dilation, input_shape, output_shape, false) {}
+      kernel_shape, stride, pad, dilation, input_shape, output_shape, false) {
+
+      output_h_ = output_shape[2];
+      output_w_ = output_shape[3];
+
+      prepare_winograd();
+      prepare_depthwise();
+      prepare_im2col_tiles();
+      prepare_packed_weight();
+    }
 
   virtual inline const char* type() const override { return "Convolution"; }
 
   virtual DeviceTensor operator()(DeviceTensor input) override;
 
+  bool use_winograd() const { return winograd_weight_ != nullptr; }
+  bool use_depthwise() const { return depthwise_; }
+
+  // Load-time folding of the batch norm that follows this convolution,
+  // afterwards bn must be dropped from the forward pass. Does nothing unless
+  // bn.foldable().
+  void fold_batch_norm(const BatchNormOp<DeviceTensor>& bn) {
+    if (!bn.foldable()) {
+      LOG(ERROR) << "BatchNorm without running statistics can not be folded";
+      return;
+    }
+    folded_bias_ = std::make_shared<DeviceTensor>(bn.fold_into(*this->weight_, this->bias_));
+    this->bias_ = folded_bias_.get();
+    prepare_winograd();
+    prepare_packed_weight();
+  }
+
+protected:
+
+  // Epilogue applied to every output element: y = activation(y + bias).
+  ACTIVATION_TYPE activation_ = ACTIVATION_TYPE::NONE;
+  float activation_alpha_ = 0;
+  DeviceTensor* activation_weight_ = nullptr;
+
+private:
+
+  // Only TensorCPU<float> has a Winograd path, see the specializations below.
+  void prepare_winograd() {}
+  bool winograd_forward(const DeviceTensor& input, DeviceTensor& output) { return false; }
+
+  // Likewise for the direct depthwise 3x3 kernel (group == channels).
+  void prepare_depthwise() {}
+  bool depthwise_forward(const DeviceTensor& input, DeviceTensor& output) { return false; }
+
+  // The CPU path never materializes the full im2col matrix: it gathers
+  // (kernel_dim_ x tile_cols_) column tiles right before their GEMM, so the
+  // col buffers shrink to one tile per worker.
+  void prepare_im2col_tiles() {}
+
+  // Per group weights packed once for packed_gemm(), CPU only as well.
+  void prepare_packed_weight() {}
+
+  // Computes one image and runs the epilogue on it; the CPU specialization
+  // does so tile by tile while the tile is still in cache.
+  void forward_image(DeviceTensor& input, DeviceTensor& output, int worker);
+  void gemm_epilogue(DeviceTensor& col, DeviceTensor& output);
+
+  int output_h_;
+  int output_w_;
+
+  std::shared_ptr<TensorCPU<float>> winograd_weight_;
+  bool depthwise_ = false;
+  int tile_cols_ = 0;
+  std::vector<PackedMatrix> packed_weight_;
+  std::shared_ptr<DeviceTensor> folded_bias_;
+
 };
 
 
+template <> void ConvolutionOp<TensorCPU<float>>::prepare_winograd();
+template <> bool ConvolutionOp<TensorCPU<float>>::winograd_forward(
+  const TensorCPU<float>& input, TensorCPU<float>& output);
+template <> void ConvolutionOp<TensorCPU<float>>::prepare_depthwise();
+template <> bool ConvolutionOp<TensorCPU<float>>::depthwise_forward(
+  const TensorCPU<float>& input, TensorCPU<float>& output);
+template <> void ConvolutionOp<TensorCPU<float>>::prepare_im2col_tiles();
+template <> void ConvolutionOp<TensorCPU<float>>::prepare_packed_weight();
+template <> void ConvolutionOp<TensorCPU<float>>::forward_image(
+  TensorCPU<float>& input, TensorCPU<float>& output, int worker);
+
+
+// Convolution with bias and activation fused into its epilogue, replaces
+// conv -> ReLUOp / ELUOp / PReLUOp / TanHOp. alpha is the negative slope of
+// RELU or the alpha of ELU; PRELU takes per-channel slopes from weight.
+template <typename DeviceTensor>
+class FusedConvolutionOp : public ConvolutionOp<DeviceTensor> {
+ public:
+
+  explicit FusedConvolutionOp(
+    DeviceTensor* weight, 
+    DeviceTensor* bias,
+    int group,
+    bool is_1x1,
+    std::vector<int> kernel_shape,
+    std::vector<int> stride,
+    std::vector<int> pad,
+    std::vector<int> dilation,
+    std::vector<int> input_shape,
+    std::vector<int> output_shape,
+    ACTIVATION_TYPE activation,
+    float alpha = 0,
+    DeviceTensor* activation_weight = nullptr)
+
+    : ConvolutionOp<DeviceTensor>(weight, bias, group, is_1x1,
+      kernel_shape, stride, pad, dilation, input_shape, output_shape) {
+
+      this->activation_ = activation;
+      this->activation_alpha_ = alpha;
+      this->activation_weight_ = activation_weight;
+    }
+
+  virtual inline const char* type() const override { return "FusedConvolution"; }
+
+};
 
 
 }  // namespace hypertea
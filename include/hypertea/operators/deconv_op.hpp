@@ -4,6 +4,7 @@
 #include <vector>
 
 #include "hypertea/operators/base_conv_op.hpp"
+#include "hypertea/util/packed_gemm.hpp"
 
 namespace hypertea {
 
@@ -24,16 +25,35 @@ class DeconvolutionOp : public BaseConvolutionOp<DeviceTensor> {
     std::vector<int> output_shape) 
 
     : BaseConvolutionOp<DeviceTensor>(weight, bias, group, is_1x1,
-      kernel_shape, stride, pad, dilation, input_shape, output_shape, true) {}
+      kernel_shape, stride, pad, dilation, input_shape, output_shape, true) {
+
+      prepare_packed_weight();
+    }
 
 
 
   virtual inline const char* type() const override { return "Deconvolution"; }
   virtual DeviceTensor operator()(DeviceTensor input) override;
 
+private:
+
+  // Only TensorCPU<float> packs the transposed per group weights once for
+  // packed_gemm(), see the specializations below.
+  void prepare_packed_weight() {}
+
+  // col = weight^T * input for one image, group by group.
+  void weight_gemm(DeviceTensor& input, DeviceTensor& col);
+
+  std::vector<PackedMatrix> packed_weight_;
+
 };
 
 
+template <> void DeconvolutionOp<TensorCPU<float>>::prepare_packed_weight();
+template <> void DeconvolutionOp<TensorCPU<float>>::weight_gemm(
+  TensorCPU<float>& input, TensorCPU<float>& col);
+
+
 
 }  // namespace hypertea
 
@@ -2,6 +2,7 @@
 #define HYPERTEA_LINEAR_OP_HPP_
 
 #include "hypertea/operator.hpp"
+#include "hypertea/util/packed_gemm.hpp"
 
 namespace hypertea {
 
@@ -19,19 +20,31 @@ public:
     weight_(weight), 
     bias_(bias),
     in_features_(in_features),
-    out_features_(out_features) {}
+    out_features_(out_features) {
+
+        prepare_packed_weight();
+    }
     
     virtual inline const char* type() const override { return "Linear"; }
     virtual DeviceTensor operator()(DeviceTensor input) override;
 
 private:
+
+    // Only TensorCPU<float> packs the weight once for packed_gemm().
+    void prepare_packed_weight() {}
+
     DeviceTensor* weight_;
     DeviceTensor* bias_;
 	int in_features_;
     int out_features_;
 
+    std::shared_ptr<PackedMatrix> packed_weight_;
+
 };
 
+template <> void LinearOp<TensorCPU<float>>::prepare_packed_weight();
+template <> TensorCPU<float> LinearOp<TensorCPU<float>>::operator()(TensorCPU<float> input);
+
 
 
 template <typename DeviceTensor>
@@ -57,6 +70,8 @@ private:
 
 };
 
+template <> TensorCPU<float> EmbeddingOp<TensorCPU<float>>::operator()(std::vector<int> input);
+
 
 }  // namespace hypertea
 
@@ -4,6 +4,7 @@
 #include <vector>
 
 #include "hypertea/operator.hpp"
+#include "hypertea/util/packed_gemm.hpp"
 
 namespace hypertea {
 
@@ -15,31 +16,44 @@ enum class RNN_CELL_TYPE {
 
 
 
+// A cell runs in two steps. input_gates() computes W_ih * x + b_ih for
+// every timestep of a sequence with one GEMM per gate, since it does not
+// depend on the recurrence; Forward() then only adds W_hh * h for one
+// timestep. Gates are kept gate-major, (gates, batch, hidden_dim), so that
+// the element-wise gate math works on whole (batch, hidden_dim) blocks.
 template <typename DeviceTensor>
 class RNNCell {
 public:
 
 
   RNNCell(
-      const int input_dim, const int hidden_dim,
+      const int input_dim, const int hidden_dim, const int gates,
       const DeviceTensor& weight_ih,
       const DeviceTensor& weight_hh,
       const DeviceTensor& bias_ih,
-      const DeviceTensor& bias_hh,
-      const DeviceTensor& inter_i,
-      const DeviceTensor& inter_h
-  ) : input_dim_(input_dim), hidden_dim_(hidden_dim),
+      const DeviceTensor& bias_hh
+  ) : input_dim_(input_dim), hidden_dim_(hidden_dim), gates_(gates),
       weight_ih_(weight_ih),
       weight_hh_(weight_hh),
       bias_ih_(bias_ih),
       bias_hh_(bias_hh),
-      intermediate_i(inter_i),
-      intermediate_h(inter_h) { }
+      intermediate_h(gates * hidden_dim) {
+
+      prepare_packed_weights();
+  }
 
   virtual ~RNNCell() {}
-  
+
+  // (length, batch, input_dim) inputs -> (gates, length, batch, hidden_dim).
+  DeviceTensor input_gates(DeviceTensor& input_data, int length, int batch);
+
+  // The gates views of one timestep of input_gates(), (batch, hidden_dim) each.
+  std::vector<DeviceTensor> step_gates(DeviceTensor& input_gates, int length, int batch, int step);
+
+  // input_gates are left unchanged. hidden_data is (batch, hidden_offset_()),
+  // stored as hidden_offset_() / hidden_dim blocks of (batch, hidden_dim).
   virtual void Forward(
-    DeviceTensor& input_data,
+    std::vector<DeviceTensor>& input_gates,
     DeviceTensor& hidden_data,
     DeviceTensor& output_data
   ) = 0;
@@ -50,20 +64,35 @@ public:
 
 protected:
 
-  int input_dim_, hidden_dim_;
+  // W_hh * h + b_hh for a (batch, hidden_dim) h, into intermediate_h.
+  void hidden_gates(DeviceTensor& hidden, int batch);
+
+  // Only TensorCPU<float> packs the per gate W_ih / W_hh blocks once for
+  // packed_gemm(), see the specializations below.
+  void prepare_packed_weights() {}
+
+  int input_dim_, hidden_dim_, gates_;
 
   DeviceTensor weight_ih_;
   DeviceTensor weight_hh_;
   DeviceTensor bias_ih_;
   DeviceTensor bias_hh_;
 
-  DeviceTensor intermediate_i;
   DeviceTensor intermediate_h;
 
+  std::vector<PackedMatrix> packed_ih_;
+  std::vector<PackedMatrix> packed_hh_;
 
 };
 
 
+template <> void RNNCell<TensorCPU<float>>::prepare_packed_weights();
+template <> TensorCPU<float> RNNCell<TensorCPU<float>>::input_gates(
+  TensorCPU<float>& input_data, int length, int batch);
+template <> void RNNCell<TensorCPU<float>>::hidden_gates(
+  TensorCPU<float>& hidden, int batch);
+
+
 
 
 
@@ -77,17 +106,15 @@ public:
       const DeviceTensor& bias_ih,
       const DeviceTensor& bias_hh) : 
         RNNCell<DeviceTensor>(
-          input_dim, hidden_dim, 
+          input_dim, hidden_dim, 3,
           weight_ih, weight_hh,
-          bias_ih, bias_hh,
-          DeviceTensor(3 * hidden_dim),
-          DeviceTensor(3 * hidden_dim)
+          bias_ih, bias_hh
         ) {}
 
   virtual ~GRUCell() {}
   
   virtual void Forward(
-    DeviceTensor& input_data,
+    std::vector<DeviceTensor>& input_gates,
     DeviceTensor& hidden_data,
     DeviceTensor& output_data
   );
@@ -107,17 +134,15 @@ public:
       const DeviceTensor& bias_ih,
       const DeviceTensor& bias_hh) : 
         RNNCell<DeviceTensor>(
-          input_dim, hidden_dim, 
+          input_dim, hidden_dim, 4,
           weight_ih, weight_hh,
-          bias_ih, bias_hh,
-          DeviceTensor(4 * hidden_dim),
-          DeviceTensor(4 * hidden_dim)
+          bias_ih, bias_hh
         ) { }
 
   virtual ~LSTMCell() {}
   
   virtual void Forward(
-    DeviceTensor& input_data,
+    std::vector<DeviceTensor>& input_gates,
     DeviceTensor& hidden_data,
     DeviceTensor& output_data
   );
@@ -174,7 +199,8 @@ public:
 
   ~RNNOp()  {}
 
-  
+  // input_tensor is (length, batch, input_dim); the batch size is taken from
+  // hidden_tensor, (batch, hidden_offset_()) per direction.
   virtual DeviceTensor Forward(DeviceTensor &input_tensor, DeviceTensor &hidden_tensor) = 0;
   
 
@@ -257,10 +283,11 @@ public:
     }
   }
 
-  DeviceTensor operator()(DeviceTensor &input, std::vector<DeviceTensor >& hidden_tensors) {
-    Forward(input, hidden_tensors);
+  DeviceTensor operator()(DeviceTensor &input, std::vector<DeviceTensor > hidden_tensors) {
+    return Forward(input, hidden_tensors);
   }
-  DeviceTensor Forward(DeviceTensor &input, std::vector<DeviceTensor >& hidden_tensors);
+  // hidden_tensors share storage with the caller's, which are updated in place.
+  DeviceTensor Forward(DeviceTensor &input, std::vector<DeviceTensor > hidden_tensors);
 
   
 
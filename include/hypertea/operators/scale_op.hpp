@@ -11,10 +11,12 @@ class ScaleOp  : public TensorOperator<DeviceTensor>{
 public:
   explicit ScaleOp(
     DeviceTensor* weight, DeviceTensor* bias, 
-    int channels, int spatial_dim)
+    int channels, int spatial_dim,
+    bool inplace = false)
   : TensorOperator<DeviceTensor>(),
     weight_(weight), bias_(bias),
-    channels_(channels), spatial_dim_(spatial_dim) {}
+    channels_(channels), spatial_dim_(spatial_dim),
+    inplace_(inplace) {}
 
   virtual inline const char* type() const override { return "Scale"; }
   virtual DeviceTensor operator()(DeviceTensor input) override;
@@ -25,7 +27,7 @@ private:
   
   int channels_;
   int spatial_dim_;
-  bool inplace_ = false;
+  bool inplace_;
 
 };
 
@@ -5,9 +5,11 @@
 #include <assert.h>
 #include <numeric>
 #include "hypertea/common.hpp"
+#include "hypertea/util/memory_planner.hpp"
 #include "hypertea/util/tensor_cpu_math_func.hpp"
 
 #ifdef USE_OPENCL
+#include "hypertea/util/device_transfer.hpp"
 #include "hypertea/util/tensor_gpu_math_func.hpp"
 #endif //USE_OPENCL
 
@@ -41,18 +43,29 @@ public:
 
 	TensorCPU() = delete;
 	explicit TensorCPU(int count) {
-		data_.reset(new Dtype[count], std::default_delete<Dtype[]>() );
+		data_ = std::static_pointer_cast<Dtype>(planned_host_memory(count * sizeof(Dtype)));
 		this->count_ = count;
 	}
 
 	explicit TensorCPU(int count, Dtype value);
 	explicit TensorCPU(std::vector<Dtype> data);
 	explicit TensorCPU(Dtype* data_ptr, int count, bool shared = false);
+	// Takes shared ownership of externally managed storage, e.g. a file mapping.
+	explicit TensorCPU(std::shared_ptr<Dtype> data, int count);
 
 
+	// Evaluates an element-wise expression, see tensor_cpu_expression.hpp.
+	template <typename E>
+	TensorCPU(const TensorCPUExpression<E>& e) : TensorCPU(e.count()) { copy_data(e); }
+
 	TensorCPU& copy_data(const TensorCPU & other);
 	TensorCPU duplicate() const;
 
+	template <typename E>
+	TensorCPU& copy_data(const TensorCPUExpression<E>& e) {
+		return update<ExpressionAssign>(e);
+	}
+
 	void copy_to_ptr(void* ptr) const {
  		memcpy(ptr, immutable_data(), this->count_ * sizeof(Dtype));
  	}
@@ -88,11 +101,21 @@ public:
 	TensorCPU& operator/=(const TensorCPU & other) {return inplace_div(other, *this); }
 	TensorCPU& operator/=(const float other) {return inplace_div_scalar(*this, other); }
 
+	template <typename E> TensorCPU& operator+=(const TensorCPUExpression<E>& e) {return update<ExpressionAdd>(e); }
+	template <typename E> TensorCPU& operator-=(const TensorCPUExpression<E>& e) {return update<ExpressionSub>(e); }
+	template <typename E> TensorCPU& operator*=(const TensorCPUExpression<E>& e) {return update<ExpressionMul>(e); }
+	template <typename E> TensorCPU& operator/=(const TensorCPUExpression<E>& e) {return update<ExpressionDiv>(e); }
+
 	TensorCPU& set(const Dtype e) {return inplace_set(*this, e); }
 	std::vector<int> argmax() {return batched_argmax(*this, this->count()); }
 
 private:
 
+	template <typename Op, typename E>
+	TensorCPU& update(const TensorCPUExpression<E>& e) {
+		evaluate_expression<Op>(mutable_data(), e.derived());
+		return *this;
+	}
 
 	std::shared_ptr<Dtype> data_;
 
@@ -110,7 +133,7 @@ public:
 	TensorGPU() = delete;
 
 	explicit TensorGPU(int count) {
-		data_.reset((void*)clCreateBuffer(OpenCLHandler::Get().context, CL_MEM_READ_WRITE, count * sizeof(Dtype), NULL, NULL), [=](void *ptr){clReleaseMemObject((cl_mem) ptr);});
+		data_ = planned_device_memory(count * sizeof(Dtype));
 		this->count_ = count;
 	}
 
@@ -124,7 +147,7 @@ public:
  	void copy_to_ptr(void* ptr) const {
  		OPENCL_CHECK(
  			clEnqueueReadBuffer(
- 				OpenCLHandler::Get().commandQueue, 
+ 				current_queue(), 
  				mutable_data(), CL_TRUE, 
  				0, this->count_ * sizeof(Dtype), 
  				ptr, 
@@ -136,7 +159,7 @@ public:
 	void copy_from_ptr(void* ptr) const {
  		OPENCL_CHECK(
  			clEnqueueWriteBuffer(
- 				OpenCLHandler::Get().commandQueue, 
+ 				current_queue(), 
  				mutable_data(), CL_TRUE, 
  				0, this->count_ * sizeof(Dtype), 
  				ptr, 
@@ -145,11 +168,23 @@ public:
  		);
  	}
 
+	// Non-blocking versions on the command queue, ptr must stay valid until
+	// the returned event completes.
+	TransferEvent copy_to_ptr_async(void* ptr) const;
+	TransferEvent copy_from_ptr_async(const void* ptr) const;
+
+	// Reads the data back into pinned host memory without waiting for it.
+	PendingHostData<Dtype> cpu_data_async() const;
+
 	virtual ~TensorGPU() {}
 	
 	cl_mem mutable_data() const { return (cl_mem)data_.get(); }
 	const cl_mem immutable_data() const { return (cl_mem)data_.get(); }
 
+	// Shares ownership of the buffer, for work recorded now and enqueued
+	// later (see FusedExpression).
+	std::shared_ptr<void> shared_data() const { return data_; }
+
 	TensorGPU<Dtype> sub_view(unsigned int offset, unsigned int size, cl_mem_flags flags = CL_MEM_READ_WRITE);
 	std::vector<TensorGPU<Dtype> > chunked_tensors(int chunck_num, cl_mem_flags flags = CL_MEM_READ_WRITE);
 
@@ -172,6 +207,9 @@ public:
 
 private:
 
+	// Views (sub_view, chunked_tensors) share ownership of their parent.
+	TensorGPU(std::shared_ptr<void> data, int count) : data_(data) { this->count_ = count; }
+
 	std::shared_ptr<void> data_;
 
 };
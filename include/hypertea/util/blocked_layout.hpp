@@ -0,0 +1,73 @@
+#ifndef HYPERTEA_UTIL_BLOCKED_LAYOUT_HPP_
+#define HYPERTEA_UTIL_BLOCKED_LAYOUT_HPP_
+
+#include <vector>
+
+#include "hypertea/tensor.hpp"
+
+namespace hypertea {
+
+// NCHWc ("blocked") layout of host tensors: (num, channels / block, height,
+// width, block), channels padded up to a multiple of block. The channels of
+// one pixel sit next to each other, so the kernels below run one vector of
+// block channels at a time instead of striding over planes. Padded channels
+// are zero after reorder_to_blocked(); element-wise activations may turn
+// them into other finite values, which the blocked convolution ignores
+// (zero weights) and reorder_from_blocked() drops.
+//
+// block is 8 or 16; nchwc_block() is the width that fills one vector
+// register of the running CPU (16 with AVX-512, 8 otherwise).
+
+int nchwc_block();
+
+inline int blocked_channels(int channels, int block) {
+  return (channels + block - 1) / block * block;
+}
+
+// NCHW (num, channels, spatial_dim) <-> NCHWc, y being preallocated.
+void reorder_to_blocked(const TensorCPU<float>& x, TensorCPU<float>& y,
+    int num, int channels, int spatial_dim, int block);
+void reorder_from_blocked(const TensorCPU<float>& x, TensorCPU<float>& y,
+    int num, int channels, int spatial_dim, int block);
+
+// Per channel vector (bias, slope, ...) zero padded to blocked_channels().
+TensorCPU<float> blocked_channel_vector(const float* x, int channels, int block);
+
+// OIhw convolution weights -> (out / block, in / block, kh, kw, block in,
+// block out), zero padded, the layout blocked_conv2d() reads.
+TensorCPU<float> blocked_conv_weight(const float* weight,
+    int out_channels, int in_channels, int kernel_h, int kernel_w, int block);
+
+// Direct convolution of NCHWc x into NCHWc y (group 1). Each output pixel
+// accumulates block output channels in one vector and a few neighbouring
+// pixels are computed together, so every weight vector load feeds several
+// FMAs and no im2col buffer is needed. bias and slope are blocked channel
+// vectors or nullptr; bias and activation are applied row by row.
+void blocked_conv2d(const TensorCPU<float>& x, int num,
+    int in_channels, int height, int width,
+    const TensorCPU<float>& weight, int out_channels,
+    int kernel_h, int kernel_w, int pad_h, int pad_w,
+    int stride_h, int stride_w, int dilation_h, int dilation_w,
+    int output_h, int output_w, TensorCPU<float>& y, int block,
+    const float* bias = nullptr,
+    ACTIVATION_TYPE activation = ACTIVATION_TYPE::NONE,
+    float alpha = 0, const float* slope = nullptr);
+
+// y = activation(y * scale + bias) over pixels * block values of one channel
+// block; scale, bias and slope hold block entries each and may be nullptr.
+void blocked_scale_bias_activation(float* data, int pixels, int block,
+    const float* scale, const float* bias,
+    ACTIVATION_TYPE activation, float alpha = 0, const float* slope = nullptr);
+
+// Nearest neighbour upsampling of an NCHWc tensor, see upsampling_2d().
+TensorCPU<float> blocked_upsampling_2d(const TensorCPU<float>& x,
+    int scale, int height, int width, int block);
+
+// Concatenation along channels of num NCHWc images. All inputs but the last
+// must have a multiple of block channels, so that no padding ends up inside
+// the result.
+TensorCPU<float> blocked_concate(std::vector<TensorCPU<float>* > xs, int num);
+
+}  // namespace hypertea
+
+#endif  // HYPERTEA_UTIL_BLOCKED_LAYOUT_HPP_
@@ -3,6 +3,8 @@
 
 #include <math.h>
 
+#include "hypertea/util/cpu_simd_math.hpp"
+
 // Functions that hypertea uses but are not present if MKL is not linked.
 
 // A simple way to define the vsl unary functions. The operation should
@@ -17,13 +19,22 @@
 
 DEFINE_VSL_UNARY_FUNC(Sqr, y[i] *= y[i])
 DEFINE_VSL_UNARY_FUNC(Sqrt, y[i] = sqrt(y[i]))
-DEFINE_VSL_UNARY_FUNC(Exp, y[i] = exp(y[i]))
-DEFINE_VSL_UNARY_FUNC(Ln, y[i] = log(y[i]))
 DEFINE_VSL_UNARY_FUNC(Abs, y[i] = fabs(y[i]))
-DEFINE_VSL_UNARY_FUNC(Sigmoid, y[i] = (0.5 * tanh(0.5 * y[i]) + 0.5))
-DEFINE_VSL_UNARY_FUNC(TanH, y[i] = tanh(y[i]))
 DEFINE_VSL_UNARY_FUNC(Inv, y[i] = 1 / y[i])
 
+// Transcendental functions go to the vectorized versions in cpu_simd_math.
+#define DEFINE_VSL_SIMD_FUNC(name, simd_func) \
+  inline float* vs##name( \
+    const int n, float* y) { \
+    hypertea::simd_func(n, y); \
+    return y;\
+  }
+
+DEFINE_VSL_SIMD_FUNC(Exp, simd_exp)
+DEFINE_VSL_SIMD_FUNC(Ln, simd_log)
+DEFINE_VSL_SIMD_FUNC(Sigmoid, simd_sigmoid)
+DEFINE_VSL_SIMD_FUNC(TanH, simd_tanh)
+
 // A simple way to define the vsl unary functions with singular parameter b.
 // The operation should be in the form e.g. y[i] = pow(a[i], b)
 #define DEFINE_VSL_UNARY_FUNC_WITH_PARAM(name, operation) \
@@ -37,9 +48,13 @@ DEFINE_VSL_UNARY_FUNC(Inv, y[i] = 1 / y[i])
 DEFINE_VSL_UNARY_FUNC_WITH_PARAM(Powx, y[i] = pow(y[i], b))
 DEFINE_VSL_UNARY_FUNC_WITH_PARAM(AddScal, y[i] += b)
 DEFINE_VSL_UNARY_FUNC_WITH_PARAM(MulScal, y[i] *= b)
-DEFINE_VSL_UNARY_FUNC_WITH_PARAM(ELU, y[i] = std::max(y[i], float(0)) + b * (exp(std::min(y[i], float(0))) - float(1)))
 DEFINE_VSL_UNARY_FUNC_WITH_PARAM(ReLU, y[i] = std::max(y[i], float(0)) + b * std::min(y[i], float(0)))
 
+inline float* vsELU(const int n, const float b, float* y) {
+  hypertea::simd_elu(n, b, y);
+  return y;
+}
+
 
 // A simple way to define the vsl binary functions. The operation should
 // be in the form e.g. y[i] = a[i] + b[i]
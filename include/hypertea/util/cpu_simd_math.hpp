@@ -0,0 +1,31 @@
+#ifndef HYPERTEA_UTIL_CPU_SIMD_MATH_H_
+#define HYPERTEA_UTIL_CPU_SIMD_MATH_H_
+
+namespace hypertea {
+
+// In-place single precision transcendental functions used by the vs*
+// helpers. They are Cephes-style polynomial approximations evaluated 16
+// (AVX-512), 8 (AVX2 + FMA) or 4 (SSE2 / NEON) lanes at a time; the
+// instruction set is picked once at runtime from what the CPU supports.
+// Compilers without GCC vector extensions get a libm scalar loop.
+//
+// Max error against a double precision reference, as checked by
+// test_cpu_simd_math.cpp:
+//   simd_exp      1 ulp    (x in [-87.33, 88.72]; 0 below, +inf above)
+//   simd_log      1 ulp    (normal x > 0; -inf at 0, NaN below)
+//   simd_tanh     1.5 ulp
+//   simd_sigmoid  2.5 ulp
+//   simd_elu      1.5 ulp  (exp(x) - 1 is computed without cancellation)
+
+void simd_exp(const int n, float* y);
+void simd_log(const int n, float* y);
+void simd_tanh(const int n, float* y);
+void simd_sigmoid(const int n, float* y);
+void simd_elu(const int n, const float alpha, float* y);
+
+// "avx512f", "avx2", "sse2", "neon", "vector4" or "scalar".
+const char* simd_math_isa();
+
+}  // namespace hypertea
+
+#endif  // HYPERTEA_UTIL_CPU_SIMD_MATH_H_
@@ -0,0 +1,37 @@
+#ifndef HYPERTEA_UTIL_DEPTHWISE_CONV_HPP_
+#define HYPERTEA_UTIL_DEPTHWISE_CONV_HPP_
+
+#include "hypertea/tensor.hpp"
+
+namespace hypertea {
+
+// Direct 3x3 depthwise convolution (group == channels, one filter per
+// channel). Each output row accumulates the 9 taps over contiguous input
+// rows, so the inner loop runs vectorized along the output width; only the
+// padded border columns take the scalar path. No im2col buffer is needed.
+// Bias and activation are applied while the output plane is still in cache.
+
+inline bool depthwise_applicable(
+    const std::vector<int>& kernel_shape,
+    const std::vector<int>& dilation,
+    int group, int in_channels, int out_channels) {
+
+  return kernel_shape.size() == 2
+      && kernel_shape[0] == 3 && kernel_shape[1] == 3
+      && dilation[0] == 1 && dilation[1] == 1
+      && group == in_channels && in_channels == out_channels;
+}
+
+void depthwise_conv3x3(const TensorCPU<float>& data_im,
+    const int num, const int channels, const int height, const int width,
+    const int pad_h, const int pad_w, const int stride_h, const int stride_w,
+    const TensorCPU<float>& weight,
+    const int output_h, const int output_w,
+    TensorCPU<float>& data_out,
+    const float* bias = nullptr,
+    ACTIVATION_TYPE activation = ACTIVATION_TYPE::NONE,
+    float alpha = 0, const float* slope = nullptr);
+
+}  // namespace hypertea
+
+#endif  // HYPERTEA_UTIL_DEPTHWISE_CONV_HPP_
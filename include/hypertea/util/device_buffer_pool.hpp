@@ -0,0 +1,89 @@
+#ifndef HYPERTEA_UTIL_DEVICE_BUFFER_POOL_H_
+#define HYPERTEA_UTIL_DEVICE_BUFFER_POOL_H_
+
+#ifdef USE_OPENCL
+
+#include <cstdint>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <tuple>
+#include <vector>
+
+#include "hypertea/util/opencl_util.hpp"
+
+namespace hypertea {
+
+// DeviceBufferPool keeps released cl_mem buffers and hands them out again,
+// so temporaries of TensorGPU stop costing a clCreateBuffer (and, on mobile
+// drivers, fragmenting device memory) once a forward pass has run. Sizes are
+// rounded up to size classes of four steps per power of two, which bounds
+// the waste to a quarter of a request. Sub-buffers of pooled buffers are
+// cached with them, a repeated sub_view or chunked_tensors creates nothing.
+//
+// Idle buffers are kept up to capacity() bytes, trim() releases all of them.
+class DeviceBufferPool {
+public:
+
+  static DeviceBufferPool& Get();
+
+  std::shared_ptr<void> allocate(size_t bytes);
+
+  // Region [offset, offset + bytes) of parent, which it keeps alive. parent
+  // may itself be a sub-buffer, e.g. a memory planner arena block.
+  std::shared_ptr<void> sub_buffer(const std::shared_ptr<void>& parent,
+    size_t offset, size_t bytes, cl_mem_flags flags = CL_MEM_READ_WRITE);
+
+  void trim();
+
+  // Between hold_releases() and the matching resume_releases() released
+  // buffers are not handed out again (see BranchGroup).
+  void hold_releases();
+  void resume_releases();
+
+  size_t capacity() const;
+  void set_capacity(size_t bytes);
+
+  struct Stats {
+    size_t hits = 0;
+    size_t misses = 0;
+    size_t sub_buffer_hits = 0;
+    size_t sub_buffer_misses = 0;
+    size_t bytes_held = 0;      // idle, ready to be handed out
+    size_t bytes_in_use = 0;
+  };
+
+  Stats stats() const;
+
+  static size_t bucket_size(size_t bytes);
+
+private:
+
+  DeviceBufferPool() {}
+
+  void release(cl_mem buffer);
+  void destroy(cl_mem buffer);
+
+  struct Buffer {
+    size_t bytes;
+    std::map<std::tuple<size_t, size_t, cl_mem_flags>, cl_mem> views;
+  };
+
+  mutable std::mutex mutex_;
+  std::map<cl_mem, Buffer> buffers_;
+  std::map<size_t, std::vector<cl_mem> > idle_;
+  size_t capacity_ = SIZE_MAX;
+  int holds_ = 0;
+  std::vector<cl_mem> held_;
+  Stats stats_;
+
+  DeviceBufferPool(const DeviceBufferPool&);
+  DeviceBufferPool& operator=(const DeviceBufferPool&);
+
+};
+
+}  // namespace hypertea
+
+#endif //USE_OPENCL
+
+#endif   // HYPERTEA_UTIL_DEVICE_BUFFER_POOL_H_
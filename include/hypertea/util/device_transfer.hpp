@@ -0,0 +1,127 @@
+#ifndef HYPERTEA_UTIL_DEVICE_TRANSFER_H_
+#define HYPERTEA_UTIL_DEVICE_TRANSFER_H_
+
+#ifdef USE_OPENCL
+
+#include <memory>
+#include <type_traits>
+#include <vector>
+
+#include "hypertea/util/opencl_util.hpp"
+
+namespace hypertea {
+
+template <typename Dtype> class TensorGPU;
+
+// Non-blocking host/device transfers. TensorGPU::copy_from_ptr_async,
+// copy_to_ptr_async and cpu_data_async enqueue the copy and return at once
+// with a TransferEvent; the host only waits where it needs the data:
+//
+//   auto prediction = conv_81(x).cpu_data_async();   // the queue keeps going
+//   ...                                                // more kernels
+//   use(prediction.get());                             // waits for the read
+//
+// Host memory handed to the driver comes from pinned_host_memory(), which
+// the device reaches by DMA without an intermediate copy.
+
+
+// Completion of an enqueued command. Copies share the cl_event; a default
+// constructed TransferEvent stands for a command that is already complete.
+class TransferEvent {
+public:
+  TransferEvent() {}
+  explicit TransferEvent(cl_event event);
+
+  cl_event event() const { return event_.get(); }
+
+  bool ready() const;
+  void wait() const;
+
+  // Commands enqueued on queue from now on start after this one.
+  void enqueue_wait(cl_command_queue queue) const;
+
+private:
+  std::shared_ptr<std::remove_pointer<cl_event>::type> event_;
+};
+
+
+// Host memory mapped from a CL_MEM_ALLOC_HOST_PTR buffer, i.e. page-locked on
+// drivers that pin. Released blocks are kept for reuse.
+std::shared_ptr<void> pinned_host_memory(size_t bytes);
+
+
+// Result of TensorGPU::cpu_data_async(): pinned host data being read back.
+template <typename Dtype>
+class PendingHostData {
+public:
+  // No data, e.g. a slot filled in later; get() returns nullptr.
+  PendingHostData() {}
+  PendingHostData(std::shared_ptr<void> data, TransferEvent done)
+    : data_(data), done_(done) {}
+
+  const Dtype* get() const { done_.wait(); return (const Dtype*)data_.get(); }
+  bool ready() const { return done_.ready(); }
+  const TransferEvent& event() const { return done_; }
+
+private:
+  std::shared_ptr<void> data_;
+  TransferEvent done_;
+};
+
+
+// Uploads input frames through pinned staging buffers on the transfer queue,
+// so frame N + 1 is copied while the kernels of frame N run:
+//
+//   TensorUploader<float> uploader(count);
+//   uploader.upload(frames[0]);
+//   for (int i = 0; i < n; ++i) {
+//     auto x = uploader.take();
+//     if (i + 1 < n) { uploader.upload(frames[i + 1]); }
+//     net.inference(*x, output);
+//   }
+//
+// Kernels enqueued after take() wait for the upload on the device, the host
+// does not. depth tensors rotate: the one returned by take() is overwritten
+// by an upload after the next take(), by then every kernel using it must
+// have been enqueued. upload() refuses (returns false) while every tensor
+// is pending or in use, take() returns nullptr when nothing is pending.
+template <typename Dtype>
+class TensorUploader {
+public:
+
+  explicit TensorUploader(int count, int depth = 2);
+  ~TensorUploader();
+
+  // Copies count elements of data to staging and enqueues the upload.
+  bool upload(const Dtype* data);
+  std::shared_ptr<TensorGPU<Dtype> > take();
+
+  int pending() const { return pending_; }
+
+private:
+
+  struct Slot {
+    std::shared_ptr<TensorGPU<Dtype> > tensor;
+    std::shared_ptr<void> staging;
+    TransferEvent uploaded;
+    // kernels enqueued while the tensor was the current input are done
+    TransferEvent consumed;
+  };
+
+  int count_;
+  std::vector<Slot> slots_;
+  int next_upload_ = 0;
+  int next_take_ = 0;
+  int pending_ = 0;
+  int in_use_ = -1;
+
+  TensorUploader(const TensorUploader&);
+  TensorUploader& operator=(const TensorUploader&);
+
+};
+
+}  // namespace hypertea
+
+#endif //USE_OPENCL
+
+#endif   // HYPERTEA_UTIL_DEVICE_TRANSFER_H_
@@ -19,6 +19,17 @@ void col2im(const TensorCPU<Dtype>& data_col, const int channels,
     const int stride_w, const int dilation_h, const int dilation_w,
     TensorCPU<Dtype>& data_im);
 
+// Columns [col_start, col_start + col_count) of the im2col matrix, i.e. the
+// patches of col_count consecutive output pixels, written as a
+// (channels * kernel_h * kernel_w) x col_count row-major tile. Lets the CPU
+// convolution gather small cache-resident tiles instead of the full matrix.
+template <typename Dtype>
+void im2col_tile(const Dtype* data_im, const int channels,
+    const int height, const int width, const int kernel_h, const int kernel_w,
+    const int pad_h, const int pad_w, const int stride_h,
+    const int stride_w, const int dilation_h, const int dilation_w,
+    const int col_start, const int col_count, Dtype* data_col);
+
 #ifdef USE_OPENCL
 template <typename Dtype>
 void im2col(const TensorGPU<Dtype>& data_im, const int channels,
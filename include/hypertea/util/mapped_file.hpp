@@ -0,0 +1,21 @@
+#ifndef HYPERTEA_UTIL_MAPPED_FILE_H_
+#define HYPERTEA_UTIL_MAPPED_FILE_H_
+
+#include <memory>
+#include <string>
+
+namespace hypertea {
+
+// Maps the first bytes of a file into memory, released when the last
+// reference goes away. The mapping is private and copy-on-write: untouched
+// pages stay backed by the page cache (shared by every process mapping the
+// same file, and evictable by the OS), pages that are written to (e.g. when
+// folding BatchNorm into conv weights) become private copies.
+//
+// Returns nullptr if the file is missing or shorter than bytes. Platforms
+// without mmap get a heap buffer filled with fread.
+std::shared_ptr<void> map_file(const std::string& path, size_t bytes);
+
+}  // namespace hypertea
+
+#endif  // HYPERTEA_UTIL_MAPPED_FILE_H_
@@ -0,0 +1,76 @@
+#ifndef HYPERTEA_UTIL_MEMORY_PLANNER_H_
+#define HYPERTEA_UTIL_MEMORY_PLANNER_H_
+
+#include <memory>
+#include <vector>
+
+#include "hypertea/util/opencl_util.hpp"
+
+namespace hypertea {
+
+// MemoryPlanner records every temporary buffer a forward pass asks for,
+// derives the lifetime of each one and packs them into a single arena with
+// offset reuse. Once a pass has been recorded, later passes that request the
+// same sequence of buffers are served from the arena without touching the
+// allocator. If a pass diverges (e.g. a different input shape) the remaining
+// requests fall back to the heap and the plan is rebuilt at the end of it.
+//
+// Tensors created inside a pass must not be used after the next pass begins:
+// their storage is handed out again.
+class MemoryPlanner {
+public:
+
+  explicit MemoryPlanner(size_t alignment = 64);
+  ~MemoryPlanner();
+
+  static MemoryPlanner* current();
+
+  void begin_pass();
+  void end_pass();
+
+  std::shared_ptr<void> allocate_host(size_t bytes);
+#ifdef USE_OPENCL
+  std::shared_ptr<void> allocate_device(size_t bytes);
+#endif //USE_OPENCL
+
+  bool planned() const;
+
+  size_t host_arena_size() const;
+  size_t device_arena_size() const;
+  size_t peak_live_bytes() const;
+
+  int arena_allocations() const;
+  int heap_allocations() const;
+
+  struct State;
+
+private:
+
+  std::shared_ptr<State> state_;
+
+  MemoryPlanner(const MemoryPlanner&);
+  MemoryPlanner& operator=(const MemoryPlanner&);
+
+};
+
+
+// Makes planner the current one for the enclosing scope and runs one pass.
+class MemoryPlanScope {
+public:
+  explicit MemoryPlanScope(MemoryPlanner& planner);
+  ~MemoryPlanScope();
+
+private:
+  MemoryPlanner& planner_;
+  MemoryPlanner* previous_;
+};
+
+
+std::shared_ptr<void> planned_host_memory(size_t bytes);
+#ifdef USE_OPENCL
+std::shared_ptr<void> planned_device_memory(size_t bytes);
+#endif //USE_OPENCL
+
+}  // namespace hypertea
+
+#endif   // HYPERTEA_UTIL_MEMORY_PLANNER_H_
@@ -0,0 +1,152 @@
+#ifndef HYPERTEA_UTIL_OPENCL_FUSION_H_
+#define HYPERTEA_UTIL_OPENCL_FUSION_H_
+
+#ifdef USE_OPENCL
+
+#include <memory>
+#include <string>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+#include "hypertea/common.hpp"
+
+namespace hypertea {
+
+// Element-wise chains on TensorGPU run as one generated kernel. Each
+// operation of tensor_gpu_math_func.hpp is a launch of its own, usually
+// into a freshly created buffer; a FusedExpression only records the chain,
+// and fused_assign() turns it into OpenCL source, builds that once per
+// distinct chain (programs are cached by source, scalars are kernel
+// arguments, so their values do not matter) and writes every output in a
+// single launch:
+//
+//   FusedExpression<float> cy = fused(cx) * fused_sigmoid(fused(f))
+//                             + fused_sigmoid(fused(i)) * fused_tanh(fused(g));
+//   fused_assign<float>({{&c, cy}, {&h, fused_tanh(cy) * fused_sigmoid(fused(o))}});
+//
+// Every node is evaluated once per element, also when several outputs share
+// it, and all outputs are computed before any is stored, so outputs may be
+// operands as well. Operands and outputs have the same count.
+
+// Node of the recorded chain: a tensor operand (data, shared with the
+// tensor so that a temporary operand outlives its statement), a scalar, or
+// an operation whose OpenCL code has $0 / $1 in place of its operands.
+struct FusedNode {
+  std::shared_ptr<void> data;
+  int count = 0;
+  float scalar = 0;
+  std::string code;
+  std::shared_ptr<const FusedNode> lhs;
+  std::shared_ptr<const FusedNode> rhs;
+};
+
+
+template <typename Dtype>
+class FusedExpression {
+ public:
+
+  FusedExpression(const TensorGPU<Dtype>& x) {
+    auto node = std::make_shared<FusedNode>();
+    node->data = x.shared_data();
+    node->count = x.count();
+    node_ = node;
+  }
+
+  FusedExpression(float scalar) {
+    auto node = std::make_shared<FusedNode>();
+    node->scalar = scalar;
+    node_ = node;
+  }
+
+  FusedExpression(const std::string& code, const FusedExpression& lhs, const FusedExpression* rhs = nullptr) {
+    auto node = std::make_shared<FusedNode>();
+    node->code = code;
+    node->lhs = lhs.node_;
+    node->rhs = rhs ? rhs->node_ : nullptr;
+    node_ = node;
+  }
+
+  const FusedNode& node() const { return *node_; }
+
+  friend FusedExpression operator+(const FusedExpression& a, const FusedExpression& b) { return {"($0 + $1)", a, &b}; }
+  friend FusedExpression operator-(const FusedExpression& a, const FusedExpression& b) { return {"($0 - $1)", a, &b}; }
+  friend FusedExpression operator*(const FusedExpression& a, const FusedExpression& b) { return {"($0 * $1)", a, &b}; }
+  friend FusedExpression operator/(const FusedExpression& a, const FusedExpression& b) { return {"($0 / $1)", a, &b}; }
+
+ private:
+
+  std::shared_ptr<const FusedNode> node_;
+
+};
+
+
+template <typename Dtype>
+inline FusedExpression<Dtype> fused(const TensorGPU<Dtype>& x) { return FusedExpression<Dtype>(x); }
+
+// Same formulas as the kernels of opencl_math_code().
+#define DEFINE_FUSED_UNARY_FUNC(name, code) \
+  template <typename Dtype> \
+  inline FusedExpression<Dtype> fused_##name(const FusedExpression<Dtype>& x) { \
+    return FusedExpression<Dtype>(code, x); \
+  }
+
+DEFINE_FUSED_UNARY_FUNC(sigmoid, "((Dtype)0.5 * tanh((Dtype)0.5 * $0) + (Dtype)0.5)")
+DEFINE_FUSED_UNARY_FUNC(tanh, "tanh($0)")
+DEFINE_FUSED_UNARY_FUNC(exp, "exp($0)")
+DEFINE_FUSED_UNARY_FUNC(log, "log($0)")
+DEFINE_FUSED_UNARY_FUNC(sqrt, "sqrt($0)")
+DEFINE_FUSED_UNARY_FUNC(abs, "fabs($0)")
+
+#undef DEFINE_FUSED_UNARY_FUNC
+
+template <typename Dtype>
+inline FusedExpression<Dtype> fused_relu(const FusedExpression<Dtype>& x, float negative_slope = 0) {
+  const FusedExpression<Dtype> slope(negative_slope);
+  return FusedExpression<Dtype>("($0 > 0 ? $0 : $0 * $1)", x, &slope);
+}
+
+
+// Generates (or takes from the cache) and launches the kernel computing
+// outputs[k].second into outputs[k].first for count elements.
+void launch_fused_kernel(
+  const std::vector<std::pair<cl_mem, const FusedNode*> >& outputs,
+  int count, bool is_half);
+
+// Programs built so far, one per distinct chain.
+size_t fused_program_count();
+
+// Whether every tensor operand of the chain has count elements.
+bool fused_operands_have_count(const FusedNode& node, int count);
+
+
+// Nothing is launched when the outputs and operands differ in count.
+template <typename Dtype>
+void fused_assign(const std::vector<std::pair<TensorGPU<Dtype>*, FusedExpression<Dtype> > >& assignments) {
+
+  if (assignments.empty()) { return; }
+
+  const int count = assignments[0].first->count();
+
+  std::vector<std::pair<cl_mem, const FusedNode*> > outputs;
+  for (auto& a : assignments) {
+    if (a.first->count() != count || !fused_operands_have_count(a.second.node(), count)) {
+      LOG(ERROR) << "fused_assign operands and outputs differ in count";
+      return;
+    }
+    outputs.push_back(std::make_pair(a.first->mutable_data(), &a.second.node()));
+  }
+
+  launch_fused_kernel(outputs, count, std::is_same<Dtype, half>::value);
+}
+
+template <typename Dtype>
+void fused_assign(TensorGPU<Dtype>& y, const FusedExpression<Dtype>& e) {
+  fused_assign<Dtype>({{&y, e}});
+}
+
+}  // namespace hypertea
+
+#endif //USE_OPENCL
+
+#endif  // HYPERTEA_UTIL_OPENCL_FUSION_H_
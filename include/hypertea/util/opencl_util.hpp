@@ -3,6 +3,7 @@
 
 #ifdef USE_OPENCL
 
+#include <functional>
 #include <iostream>
 #include <vector>
 #include <string.h>
@@ -26,6 +27,9 @@ inline size_t HYPERTEA_GET_BLOCKS(const size_t N) {
 
 void cl_mem_destory(void* ptr);
 
+// Launches kernel_name of program on the command queue. The cl_kernel is
+// created on first use and cached per (program, name), launches may come
+// from any thread.
 void opencl_launch_wrapper(
   const cl_program& program,
   const std::string& kernel_name,
@@ -37,12 +41,21 @@ void opencl_launch_wrapper(
   cl_event *event = nullptr
 );
 
+// Kernel objects cached by opencl_launch_wrapper, and their release (e.g.
+// before the programs they belong to are rebuilt).
+size_t opencl_kernel_cache_size();
+void release_opencl_kernels();
 
 
 
 
 
 
+
+// Dtype definitions (float, or half with cl_khr_fp16) and OPENCL_KERNEL_LOOP,
+// the preamble of the math program and of generated element-wise kernels.
+std::string opencl_math_header(bool is_half);
+
 size_t reference_count(cl_mem mem_obj);
 size_t cl_mem_count(cl_mem mem_obj);
 
@@ -56,7 +69,10 @@ public:
 	static OpenCLHandler& Get();
 
 	void DeviceQuery();
-	void build_opencl_program(const std::string &kernel_code, cl_program &program);
+	// Builds from source once per source, options, device and driver: the
+	// binary is kept in program_cache_dir and loaded by later runs, falling
+	// back to the source when it is missing or rejected.
+	void build_opencl_program(const std::string &kernel_code, cl_program &program, const std::string &options = "");
 	void build_save_opencl_program(std::string kernel_code, cl_program &program, std::string save_binary_file);
 
 	void load_opencl_program(std::string save_binary_file, cl_program &program);
@@ -66,6 +82,11 @@ public:
 
   	void build_opencl_math_code(bool is_half);
 
+  	// Queue of the index-th branch of a group forked from parent: the
+  	// branchQueues in order, skipping parent (it may be one of them), each
+  	// in-order and created on first use.
+  	cl_command_queue branch_queue(int index, cl_command_queue parent);
+
 
 
   	cl_platform_id platformId = NULL;
@@ -75,6 +96,13 @@ public:
 	  
 	cl_context context;
 	cl_command_queue commandQueue;
+	// Uploads of TensorUploader, they overlap the kernels on commandQueue.
+	cl_command_queue transferQueue;
+	std::vector<cl_command_queue> branchQueues;
+
+	// HYPERTEA_KERNEL_CACHE_DIR, else $HOME/.cache/hypertea; empty disables
+	// the program cache (e.g. set it to the app cache directory on Android).
+	std::string program_cache_dir;
 
 	cl_program math_program;
 	cl_program conv_program;
@@ -89,6 +117,48 @@ private:
 
 };
 
+
+// Queue the calling thread enqueues to: commandQueue, or the queue of the
+// BranchGroup branch it is running.
+cl_command_queue current_queue();
+
+
+// Runs independent branches of a net on queues of their own, so the device
+// may execute them concurrently:
+//
+//   BranchGroup heads;
+//   heads.run([&]() { p1 = head_1(x).cpu_data_async(); });
+//   x = trunk(x);
+//   heads.run([&]() { p2 = head_2(x).cpu_data_async(); });
+//   heads.join();
+//
+// Dependencies are tracked with events per branch: a branch starts after
+// everything enqueued on the current queue before run(), join() (or the
+// destructor) makes the current queue wait for every branch. Until then,
+// neither the branches nor the trunk may write what another of them uses.
+//
+// While a group is open, released device buffers are held back until its
+// join and the memory planner is bypassed: storage freed on one queue may
+// still be in use by kernels of another.
+class BranchGroup {
+public:
+	BranchGroup();
+	~BranchGroup();
+
+	void run(const std::function<void()>& branch);
+	void join();
+
+	static bool open();
+
+private:
+	cl_command_queue parent_;
+	std::vector<cl_event> done_;
+	bool joined_ = false;
+
+	BranchGroup(const BranchGroup&);
+	BranchGroup& operator=(const BranchGroup&);
+};
+
 }  // namespace hypertea
 
 #endif //USE_OPENCL
@@ -0,0 +1,50 @@
+#ifndef HYPERTEA_UTIL_PACKED_GEMM_H_
+#define HYPERTEA_UTIL_PACKED_GEMM_H_
+
+#include <vector>
+
+namespace hypertea {
+
+// Constant (M x K) GEMM operand, i.e. operator weights, packed once into
+// panels of PACKED_GEMM_MR rows stored k-major (the last panel zero padded),
+// the layout packed_gemm() streams through its micro-kernel. A BLAS call
+// repacks the unpacked weights on every call instead, which dominates small
+// batch inference.
+const int PACKED_GEMM_MR = 16;
+
+class PackedMatrix {
+public:
+
+  // a is rows x cols row-major, or cols x rows when transposed (A = a^T).
+  PackedMatrix(const float* a, int rows, int cols, bool transposed = false);
+
+  int rows() const { return rows_; }
+  int cols() const { return cols_; }
+
+  const float* data() const { return data_.data(); }
+
+private:
+
+  int rows_;
+  int cols_;
+  std::vector<float> data_;
+
+};
+
+
+// C = A * B + bias + beta * C, with A (M x K) packed, B (K x N) and C (M x N)
+// addressed through row and column strides, so that row-major, transposed
+// and (batch, features) operands need no copy:
+//   B(k, n) = b[k * b_row_stride + n * b_col_stride]
+//   C(m, n) = c[m * c_row_stride + n * c_col_stride]
+// bias has M entries (one per row of A), or is nullptr. Panels are spread
+// over the ThreadPool::Gemm() workers when the product is large enough; the
+// micro-kernel is picked at runtime like the ones of cpu_simd_math.hpp.
+void packed_gemm(const PackedMatrix& a, const int n,
+    const float* b, const int b_row_stride, const int b_col_stride,
+    const float* bias, const float beta,
+    float* c, const int c_row_stride, const int c_col_stride);
+
+}  // namespace hypertea
+
+#endif  // HYPERTEA_UTIL_PACKED_GEMM_H_
@@ -0,0 +1,111 @@
+#ifndef HYPERTEA_UTIL_PROFILER_H_
+#define HYPERTEA_UTIL_PROFILER_H_
+
+#include <atomic>
+#include <chrono>
+#include <map>
+#include <mutex>
+#include <ostream>
+#include <string>
+#include <type_traits>
+#include <vector>
+
+#include "hypertea/util/opencl_util.hpp"
+
+namespace hypertea {
+
+template <typename DeviceTensor> class TensorOperator;
+template <typename Dtype> class TensorCPU;
+
+// Opt-in per-operator profiling. Every TensorOperator invocation opens an
+// OperatorProfileScope; while the profiler is enabled (enable(), or the
+// HYPERTEA_PROFILE environment variable) it records the wall time of the
+// call, on OpenCL also the device time between markers enqueued around it,
+// and the tensor storage it requested. report() prints a table aggregated
+// per operator instance, write_chrome_trace() a file for chrome://tracing.
+//
+// Instances are named <type>_<k> in order of first invocation unless
+// set_name() gave them a name. Device times are read when reported, which
+// waits for the profiled work to finish.
+class Profiler {
+public:
+
+  static Profiler& Get();
+
+  bool enabled() const { return enabled_; }
+  void enable(bool on = true) { enabled_ = on; }
+
+  void set_name(const void* op, const std::string& name);
+  void clear();
+
+  void report(std::ostream& out);
+  bool write_chrome_trace(const std::string& path);
+
+  struct Record {
+    const void* op;
+    const char* type;
+    int thread;
+    int depth;
+    double start_us;
+    double duration_us;
+    size_t bytes;
+#ifdef USE_OPENCL
+    cl_event device_begin = nullptr;
+    cl_event device_end = nullptr;
+#endif //USE_OPENCL
+  };
+
+  void add(const Record& record);
+
+  // Tensor storage requested by the calling thread so far.
+  static size_t& allocated_bytes();
+  static double now_us();
+
+private:
+
+  Profiler();
+
+  std::string name_of(const void* op, const char* type);
+  void resolve_device_times();
+
+  std::atomic<bool> enabled_;
+  std::mutex mutex_;
+  std::vector<Record> records_;
+  std::vector<std::pair<double, double> > device_us_;
+  std::map<const void*, std::string> names_;
+  std::map<std::string, int> type_counts_;
+
+  Profiler(const Profiler&);
+  Profiler& operator=(const Profiler&);
+
+};
+
+
+class OperatorProfileScope {
+public:
+
+  template <typename DeviceTensor>
+  explicit OperatorProfileScope(const TensorOperator<DeviceTensor>* op) {
+    if (Profiler::Get().enabled()) {
+      begin(op, op->type(), !std::is_same<DeviceTensor, TensorCPU<float> >::value);
+    }
+  }
+
+  ~OperatorProfileScope() { if (active_) { end(); } }
+
+private:
+
+  void begin(const void* op, const char* type, bool device);
+  void end();
+
+  bool active_ = false;
+  Profiler::Record record_;
+
+  OperatorProfileScope(const OperatorProfileScope&);
+  OperatorProfileScope& operator=(const OperatorProfileScope&);
+
+};
+
+}  // namespace hypertea
+
+#endif   // HYPERTEA_UTIL_PROFILER_H_
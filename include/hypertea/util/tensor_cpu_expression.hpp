@@ -0,0 +1,182 @@
+#ifndef HYPERTEA_UTIL_TENSOR_CPU_EXPRESSION_H_
+#define HYPERTEA_UTIL_TENSOR_CPU_EXPRESSION_H_
+
+#include <algorithm>
+#include <type_traits>
+
+#include "hypertea/util/thread_pool.hpp"
+
+namespace hypertea {
+
+template<typename Dtype> class TensorCPU;
+
+// Lazily evaluated element-wise arithmetic on TensorCPU, opted into with
+// lazy(): once one side of operator+, -, * or / is an expression, the
+// operators only record their operands, and the resulting tree is evaluated
+// in a single loop when it is turned into a tensor (construction or
+// assignment), passed to copy_data() or applied with +=, -=, *=, /=.
+// (lazy(temp) + 1) * 127.5 thus costs one pass and one allocation instead of
+// two of each, and since the whole tree is inlined into the loop body the
+// compiler vectorizes it. Operators on plain tensors stay eager.
+//
+// An expression points to the data of its tensor operands and must not
+// outlive them, so spell out the result type instead of `auto`:
+//   TensorCPU<float> y = (lazy(x) - mean) / std;
+template <typename Derived>
+struct TensorCPUExpression {
+	const Derived& derived() const { return static_cast<const Derived&>(*this); }
+	int count() const { return derived().count(); }
+};
+
+
+template <typename Dtype>
+struct TensorCPUOperand : public TensorCPUExpression<TensorCPUOperand<Dtype> > {
+	typedef Dtype value_type;
+
+	explicit TensorCPUOperand(const TensorCPU<Dtype>& x)
+		: data_(x.immutable_data()), count_(x.count()) {}
+
+	int count() const { return count_; }
+	Dtype operator[](int i) const { return data_[i]; }
+
+	const Dtype* data_;
+	int count_;
+};
+
+// A scalar broadcast over the other operand, it has no count of its own.
+template <typename Dtype>
+struct TensorCPUScalar {
+	typedef Dtype value_type;
+
+	explicit TensorCPUScalar(Dtype value) : value_(value) {}
+
+	int count() const { return 0; }
+	Dtype operator[](int) const { return value_; }
+
+	Dtype value_;
+};
+
+
+// Element-wise operations; update() is the compound assignment y op= b.
+#define DEFINE_EXPRESSION_OP(name, operation) \
+	struct name { \
+		template <typename T> static T apply(T a, T b) { return operation; } \
+		template <typename T> static void update(T& y, T b) { y = apply(y, b); } \
+	};
+
+DEFINE_EXPRESSION_OP(ExpressionAdd, a + b)
+DEFINE_EXPRESSION_OP(ExpressionSub, a - b)
+DEFINE_EXPRESSION_OP(ExpressionMul, a * b)
+DEFINE_EXPRESSION_OP(ExpressionDiv, a / b)
+
+#undef DEFINE_EXPRESSION_OP
+
+struct ExpressionAssign {
+	template <typename T> static void update(T& y, T b) { y = b; }
+};
+
+template <typename Op, typename L, typename R>
+struct TensorCPUBinary : public TensorCPUExpression<TensorCPUBinary<Op, L, R> > {
+	typedef typename std::conditional<std::is_same<L, TensorCPUScalar<typename L::value_type> >::value,
+		typename R::value_type, typename L::value_type>::type value_type;
+
+	TensorCPUBinary(const L& lhs, const R& rhs)
+		: lhs_(lhs), rhs_(rhs), count_(std::max(lhs.count(), rhs.count())) {}
+
+	int count() const { return count_; }
+	value_type operator[](int i) const { return Op::apply(lhs_[i], rhs_[i]); }
+
+	L lhs_;
+	R rhs_;
+	int count_;
+};
+
+
+// Starts an expression from x, see above.
+template <typename Dtype>
+inline TensorCPUOperand<Dtype> lazy(const TensorCPU<Dtype>& x) { return TensorCPUOperand<Dtype>(x); }
+
+
+// Maps what may appear on either side of an operator to its expression node:
+// a TensorCPU becomes a TensorCPUOperand, expressions are taken as they are.
+// Anything else (TensorGPU, scalars) has no node type, which removes the
+// operators below from overload resolution, as does having no expression on
+// either side (the eager operators of tensor_cpu_math_func.hpp).
+template <typename T, typename Enable = void>
+struct tensor_cpu_expression_node {};
+
+template <typename Dtype>
+struct tensor_cpu_expression_node<TensorCPU<Dtype> > {
+	typedef TensorCPUOperand<Dtype> type;
+	static type wrap(const TensorCPU<Dtype>& x) { return type(x); }
+};
+
+template <typename E>
+struct tensor_cpu_expression_node<E,
+	typename std::enable_if<std::is_base_of<TensorCPUExpression<E>, E>::value>::type> {
+	typedef E type;
+	static const E& wrap(const E& e) { return e; }
+};
+
+
+template <typename T>
+struct is_tensor_cpu_expression : std::is_base_of<TensorCPUExpression<T>, T> {};
+
+#define DEFINE_TENSOR_CPU_EXPRESSION_OPERATOR(sign, Op) \
+	template <typename L, typename R> \
+	inline typename std::enable_if<is_tensor_cpu_expression<L>::value || is_tensor_cpu_expression<R>::value, \
+		TensorCPUBinary<Op, typename tensor_cpu_expression_node<L>::type, \
+			typename tensor_cpu_expression_node<R>::type> >::type \
+	operator sign (const L& lhs, const R& rhs) { \
+		return {tensor_cpu_expression_node<L>::wrap(lhs), tensor_cpu_expression_node<R>::wrap(rhs)}; \
+	} \
+	template <typename L> \
+	inline typename std::enable_if<is_tensor_cpu_expression<L>::value, \
+		TensorCPUBinary<Op, L, TensorCPUScalar<typename L::value_type> > >::type \
+	operator sign (const L& lhs, const float rhs) { \
+		return {lhs, TensorCPUScalar<typename L::value_type>(rhs)}; \
+	} \
+	template <typename R> \
+	inline typename std::enable_if<is_tensor_cpu_expression<R>::value, \
+		TensorCPUBinary<Op, TensorCPUScalar<typename R::value_type>, R> >::type \
+	operator sign (const float lhs, const R& rhs) { \
+		return {TensorCPUScalar<typename R::value_type>(lhs), rhs}; \
+	}
+
+DEFINE_TENSOR_CPU_EXPRESSION_OPERATOR(+, ExpressionAdd)
+DEFINE_TENSOR_CPU_EXPRESSION_OPERATOR(-, ExpressionSub)
+DEFINE_TENSOR_CPU_EXPRESSION_OPERATOR(*, ExpressionMul)
+DEFINE_TENSOR_CPU_EXPRESSION_OPERATOR(/, ExpressionDiv)
+
+#undef DEFINE_TENSOR_CPU_EXPRESSION_OPERATOR
+
+
+// Elements above which the evaluation is split over the thread pool workers.
+const int EXPRESSION_PARALLEL_THRESHOLD = 1 << 16;
+
+// y[i] op= e[i] for every element of e, y[i] = e[i] with ExpressionAssign.
+// y may be one of the tensor operands of e: element i is read before it is
+// written.
+template <typename Op, typename E>
+inline void evaluate_expression(typename E::value_type* y, const E& e) {
+
+	const int n = e.count();
+	const int workers = ThreadPool::Get().num_workers();
+
+	auto run = [&](int begin, int end) {
+		for (int i = begin; i < end; ++i) { Op::update(y[i], e[i]); }
+	};
+
+	if (workers <= 1 || n < EXPRESSION_PARALLEL_THRESHOLD) {
+		run(0, n);
+		return;
+	}
+
+	ThreadPool::Get().parallel_for(workers, [&](int w, int) {
+		run((long long)n * w / workers, (long long)n * (w + 1) / workers);
+	});
+}
+
+}  // namespace hypertea
+
+#endif  // HYPERTEA_UTIL_TENSOR_CPU_EXPRESSION_H_
@@ -5,6 +5,8 @@
 #include <cmath>  // for std::fabs and std::signbit
 #include <cblas.h>
 #include "hypertea/util/cpu_blas_helper.hpp"
+#include "hypertea/util/thread_pool.hpp"
+#include "hypertea/util/tensor_cpu_expression.hpp"
 
 
 namespace hypertea {
@@ -13,6 +15,60 @@ template<typename Dtype> class Tensor;
 template<typename Dtype> class TensorCPU;
 
 
+// Activations that can be applied in a convolution epilogue. Leaky ReLU is
+// RELU with a non-zero slope, PRELU takes its slopes per channel.
+enum class ACTIVATION_TYPE {
+  NONE,
+  RELU,
+  ELU,
+  PRELU,
+  TANH
+};
+
+inline float activation_value(float x, ACTIVATION_TYPE activation, float alpha) {
+	switch (activation) {
+		case ACTIVATION_TYPE::RELU:
+		case ACTIVATION_TYPE::PRELU: return x > 0 ? x : x * alpha;
+		case ACTIVATION_TYPE::ELU: return x > 0 ? x : alpha * (exp(x) - 1);
+		case ACTIVATION_TYPE::TANH: return tanh(x);
+		default: return x;
+	}
+}
+
+// Adds bias and applies activation to a (channels x width) block whose rows
+// are ld apart, in a single pass. bias and slope (PReLU only) may be nullptr.
+template <typename Dtype>
+void channeled_bias_activation(
+	Dtype* data, int channels, int width, int ld,
+	const Dtype* bias, ACTIVATION_TYPE activation,
+	float alpha, const Dtype* slope) {
+
+	for (int c = 0; c < channels; ++c) {
+
+		Dtype* row = data + c * ld;
+		const Dtype b = bias ? bias[c] : Dtype(0);
+		const float a = (activation == ACTIVATION_TYPE::PRELU) ? slope[c] : alpha;
+
+		switch (activation) {
+			case ACTIVATION_TYPE::NONE:
+				for (int i = 0; i < width; ++i) { row[i] += b; }
+				break;
+			case ACTIVATION_TYPE::RELU:
+			case ACTIVATION_TYPE::PRELU:
+				for (int i = 0; i < width; ++i) {
+					Dtype v = row[i] + b;
+					row[i] = v > 0 ? v : v * a;
+				}
+				break;
+			default:
+				for (int i = 0; i < width; ++i) {
+					row[i] = activation_value(row[i] + b, activation, a);
+				}
+		}
+	}
+}
+
+
 template <typename Dtype>
 TensorCPU<Dtype>& inplace_gemm(
 	const CBLAS_TRANSPOSE TransA,
@@ -208,6 +264,32 @@ inline TensorCPU<Dtype>& inplace_div(const TensorCPU<Dtype>& x, TensorCPU<Dtype>
 
 
 
+// Calls op(row, channel) for every (image, channel) row of spatial_dim
+// elements, directly on the flat (num, channels, spatial_dim) layout. Large
+// tensors are split over the thread pool workers.
+const int CHANNELED_PARALLEL_THRESHOLD = 1 << 16;
+
+template <typename Op>
+inline void for_each_channel_row(int num, int channels, int spatial_dim, const Op& op) {
+
+	const int rows = num * channels;
+	const int workers = ThreadPool::Get().num_workers();
+
+	auto run_rows = [&](int begin, int end) {
+		for (int r = begin; r < end; ++r) { op(r, r % channels); }
+	};
+
+	if (workers <= 1 || rows < 2 || rows * spatial_dim < CHANNELED_PARALLEL_THRESHOLD) {
+		run_rows(0, rows);
+		return;
+	}
+
+	ThreadPool::Get().parallel_for(workers, [&](int w, int) {
+		run_rows(rows * w / workers, rows * (w + 1) / workers);
+	});
+}
+
+
 template <typename Dtype>
 TensorCPU<Dtype>& inplace_prelu(
 	TensorCPU<Dtype>& x, 
@@ -221,13 +303,13 @@ TensorCPU<Dtype>& inplace_prelu(
 	auto data = x.mutable_data();
 	auto weight_data = weight.immutable_data();
 
-	for (auto& n: x.chunked_tensors(num)) {
-		auto d = n.chunked_tensors(channels);
-
-		for (int i = 0; i < channels; ++i) {
-			inplace_relu(d[i], weight_data[i]);
+	for_each_channel_row(num, channels, spatial_dim, [&](int r, int c) {
+		Dtype* row = data + r * spatial_dim;
+		const Dtype a = weight_data[c];
+		for (int i = 0; i < spatial_dim; ++i) {
+			row[i] = std::max(row[i], Dtype(0)) + a * std::min(row[i], Dtype(0));
 		}
-	}
+	});
 	return x;
 }
 
@@ -245,13 +327,11 @@ TensorCPU<Dtype>& inplace_channeled_scal(
 	auto data = x.mutable_data();
 	auto weight_data = weight.immutable_data();
 
-	for (auto& n: x.chunked_tensors(num)) {
-		auto d = n.chunked_tensors(channels);
-
-		for (int i = 0; i < channels; ++i) {
-			d[i] *= weight_data[i];
-		}
-	}
+	for_each_channel_row(num, channels, spatial_dim, [&](int r, int c) {
+		Dtype* row = data + r * spatial_dim;
+		const Dtype w = weight_data[c];
+		for (int i = 0; i < spatial_dim; ++i) { row[i] *= w; }
+	});
 	return x;
 }
 
@@ -269,13 +349,39 @@ TensorCPU<Dtype>& inplace_channeled_add(
 	auto data = x.mutable_data();
 	auto bias_data = bias.immutable_data();
 
-	for (auto& n: x.chunked_tensors(num)) {
-		auto d = n.chunked_tensors(channels);
+	for_each_channel_row(num, channels, spatial_dim, [&](int r, int c) {
+		Dtype* row = data + r * spatial_dim;
+		const Dtype b = bias_data[c];
+		for (int i = 0; i < spatial_dim; ++i) { row[i] += b; }
+	});
+	return x;
+}
+
 
-		for (int i = 0; i < channels; ++i) {
-			d[i] += bias_data[i];
-		}
-	}
+template <typename Dtype>
+TensorCPU<Dtype>& inplace_channeled_bias_activation(
+	TensorCPU<Dtype>& x, 
+	const TensorCPU<Dtype>* bias,
+	int channels,
+	int spatial_dim,
+	ACTIVATION_TYPE activation,
+	float alpha = 0,
+	const TensorCPU<Dtype>* slope = nullptr
+) {
+
+	int num = x.count() / (channels * spatial_dim);
+
+	auto data = x.mutable_data();
+	auto bias_data = bias ? bias->immutable_data() : nullptr;
+	auto slope_data = slope ? slope->immutable_data() : nullptr;
+
+	for_each_channel_row(num, channels, spatial_dim, [&](int r, int c) {
+		channeled_bias_activation(
+			data + r * spatial_dim, 1, spatial_dim, spatial_dim,
+			bias_data ? bias_data + c : nullptr, activation, alpha,
+			slope_data ? slope_data + c : nullptr
+		);
+	});
 	return x;
 }
 
@@ -293,13 +399,11 @@ TensorCPU<Dtype>& inplace_channeled_sub(
 	auto data = x.mutable_data();
 	auto bias_data = bias.immutable_data();
 
-	for (auto& n: x.chunked_tensors(num)) {
-		auto d = n.chunked_tensors(channels);
-
-		for (int i = 0; i < channels; ++i) {
-			d[i] -= bias_data[i];
-		}
-	}
+	for_each_channel_row(num, channels, spatial_dim, [&](int r, int c) {
+		Dtype* row = data + r * spatial_dim;
+		const Dtype b = bias_data[c];
+		for (int i = 0; i < spatial_dim; ++i) { row[i] -= b; }
+	});
 	return x;
 }
 
@@ -318,13 +422,12 @@ TensorCPU<Dtype>& inplace_channeled_scaladd(
 	auto weight_data = weight.immutable_data();
 	auto bias_data = bias.immutable_data();
 
-	for (auto& n: x.chunked_tensors(num)) {
-		auto d = n.chunked_tensors(channels);
-
-		for (int i = 0; i < channels; ++i) {
-			(d[i] *= weight_data[i]) += bias_data[i];
-		}
-	}
+	for_each_channel_row(num, channels, spatial_dim, [&](int r, int c) {
+		Dtype* row = data + r * spatial_dim;
+		const Dtype w = weight_data[c];
+		const Dtype b = bias_data[c];
+		for (int i = 0; i < spatial_dim; ++i) { row[i] = row[i] * w + b; }
+	});
 
 	return x;
 }
@@ -382,58 +485,42 @@ TensorCPU<Dtype> outplace_gemv(
 
 template <typename Dtype>
 inline TensorCPU<Dtype> outplace_add(const TensorCPU<Dtype>& x, const TensorCPU<Dtype> &y) {
-	auto z = x.duplicate();
-	inplace_add(y, z);
-	return z;
+	return lazy(x) + y;
 }
 
 template <typename Dtype>
 inline TensorCPU<Dtype> outplace_sub(const TensorCPU<Dtype>& x, const TensorCPU<Dtype> &y) {
-	auto z = x.duplicate();
-	inplace_sub(y, z);
-	return z;
+	return lazy(x) - y;
 }
 
 template <typename Dtype>
 inline TensorCPU<Dtype> outplace_mul(const TensorCPU<Dtype>& x, const TensorCPU<Dtype> &y) {
-	auto z = x.duplicate();
-	inplace_mul(y, z);
-	return z;
+	return lazy(x) * y;
 }
 
 template <typename Dtype>
 inline TensorCPU<Dtype> outplace_div(const TensorCPU<Dtype>& x, const TensorCPU<Dtype> &y) {
-	auto z = x.duplicate();
-	inplace_div(y, z);
-	return z;
+	return lazy(x) / y;
 }
 
 template <typename Dtype>
 inline TensorCPU<Dtype> outplace_add_scalar(const TensorCPU<Dtype> &y, const float a) {
-	auto z = y.duplicate();
-	inplace_add_scalar(z, a);
-	return z;
+	return lazy(y) + a;
 }
 
 template <typename Dtype>
 inline TensorCPU<Dtype> outplace_sub_scalar(const TensorCPU<Dtype> &y, const float a) {
-	auto z = y.duplicate();
-	inplace_sub_scalar(z, a);
-	return z;
+	return lazy(y) - a;
 }
 
 template <typename Dtype>
 inline TensorCPU<Dtype> outplace_mul_scalar(const TensorCPU<Dtype> &y, const float a) {
-	auto z = y.duplicate();
-	inplace_mul_scalar(z, a);
-	return z;
+	return lazy(y) * a;
 }
 
 template <typename Dtype>
 inline TensorCPU<Dtype> outplace_div_scalar(const TensorCPU<Dtype> &y, const float a) {
-	auto z = y.duplicate();
-	inplace_div_scalar(z, a);
-	return z;
+	return lazy(y) / a;
 }
 
 
@@ -563,9 +650,9 @@ TensorCPU<Dtype> channeled_sum(
 	auto sum_data = sum.mutable_data();
 
 	for (int n = 0; n < nums; ++n) {
-		sum_data[n * spatial_dim] = 0;
+		sum_data[n] = 0;
 		for (int i = 0; i < spatial_dim; ++i) {
-			sum_data[n * spatial_dim] += x_data[n * spatial_dim + i];
+			sum_data[n] += x_data[n * spatial_dim + i];
 		}
 	}
 
@@ -703,7 +790,7 @@ TensorCPU<Dtype> operator- (const TensorCPU<Dtype>& lhs, const TensorCPU<Dtype>&
 template<typename Dtype>
 TensorCPU<Dtype> operator- (const TensorCPU<Dtype>& lhs, const float rhs) {return outplace_sub_scalar(lhs, rhs); }
 template<typename Dtype>
-TensorCPU<Dtype> operator- (const float lhs, const TensorCPU<Dtype>& rhs) {return outplace_add_scalar(rhs, lhs); }
+TensorCPU<Dtype> operator- (const float lhs, const TensorCPU<Dtype>& rhs) {return lhs - lazy(rhs); }
 
 template<typename Dtype>
 TensorCPU<Dtype> operator* (const TensorCPU<Dtype>& lhs, const TensorCPU<Dtype>& rhs) {return outplace_mul(lhs ,rhs); }
@@ -76,6 +76,8 @@ TensorGPU<Dtype>& inplace_gemm(
   	auto blastTransB =
       (TransB == CblasNoTrans) ? clblast::Transpose::kNo : clblast::Transpose::kYes;
 
+	cl_command_queue queue = current_queue();
+
 	CLBLAST_CPP_CHECK(clblast::Gemm<Dtype>(
     clblast::Layout::kRowMajor,
     blastTransA, blastTransB,
@@ -85,7 +87,7 @@ TensorGPU<Dtype>& inplace_gemm(
     (cl_mem) B_data, 0, ldb,
     beta_,
     (cl_mem) C_data, 0, ldc,
-    &OpenCLHandler::Get().commandQueue, NULL)
+    &queue, NULL)
   );
 
 	return C;
@@ -114,6 +116,8 @@ TensorGPU<Dtype>& inplace_gemv(
 	auto blastTransA =
 	(TransA != CblasNoTrans) ? clblast::Transpose::kNo : clblast::Transpose::kYes;
 
+	cl_command_queue queue = current_queue();
+
 	CLBLAST_CPP_CHECK(clblast::Gemv<Dtype>(
 		clblast::Layout::kColMajor,
 		blastTransA, 
@@ -123,7 +127,7 @@ TensorGPU<Dtype>& inplace_gemv(
 		x_data, 0, 1,
 		beta_,
 		y_data, 0, 1,
-		&OpenCLHandler::Get().commandQueue, NULL)
+		&queue, NULL)
 	);
 
 	return y;
@@ -134,7 +138,7 @@ template <typename Dtype>
 inline TensorGPU<Dtype>& inplace_set(TensorGPU<Dtype> &x, const Dtype alpha) {
 	size_t x_size = x.count() * sizeof(Dtype);
 	auto x_data = x.mutable_data();
-	OPENCL_CHECK(clEnqueueFillBuffer(OpenCLHandler::Get().commandQueue, x_data, &alpha, sizeof(Dtype), 0, x_size, 0, NULL, NULL));
+	OPENCL_CHECK(clEnqueueFillBuffer(current_queue(), x_data, &alpha, sizeof(Dtype), 0, x_size, 0, NULL, NULL));
 	return x;
 }
 
@@ -263,6 +267,17 @@ TensorGPU<Dtype>& inplace_channeled_add(
 	int inner_dim
 );
 
+template <typename Dtype>
+TensorGPU<Dtype>& inplace_channeled_bias_activation(
+	TensorGPU<Dtype>& x, 
+	const TensorGPU<Dtype>* bias,
+	int channels,
+	int inner_dim,
+	ACTIVATION_TYPE activation,
+	float alpha = 0,
+	const TensorGPU<Dtype>* slope = nullptr
+);
+
 template <typename Dtype>
 TensorGPU<Dtype>& inplace_channeled_sub(
 	TensorGPU<Dtype>& x, 
@@ -313,6 +328,8 @@ TensorGPU<Dtype> outplace_gemm(
   	auto blastTransB =
       (TransB == CblasNoTrans) ? clblast::Transpose::kNo : clblast::Transpose::kYes;
 
+	cl_command_queue queue = current_queue();
+
 	CLBLAST_CPP_CHECK(clblast::Gemm<Dtype>(
     clblast::Layout::kRowMajor,
     blastTransA, blastTransB,
@@ -322,7 +339,7 @@ TensorGPU<Dtype> outplace_gemm(
     (cl_mem) B_data, 0, ldb,
     beta_,
     (cl_mem) C_data, 0, ldc,
-    &OpenCLHandler::Get().commandQueue, NULL)
+    &queue, NULL)
   );
 
 	return nC;
@@ -354,6 +371,8 @@ TensorGPU<Dtype> outplace_gemv(
 	auto blastTransA =
 	(TransA != CblasNoTrans) ? clblast::Transpose::kNo : clblast::Transpose::kYes;
 
+	cl_command_queue queue = current_queue();
+
 	CLBLAST_CPP_CHECK(clblast::Gemv<Dtype>(
 		clblast::Layout::kColMajor,
 		blastTransA, 
@@ -363,7 +382,7 @@ TensorGPU<Dtype> outplace_gemv(
 		x_data, 0, 1,
 		beta_,
 		ny_data, 0, 1,
-		&OpenCLHandler::Get().commandQueue, NULL)
+		&queue, NULL)
 	);
 
 	return ny;
@@ -567,7 +586,7 @@ TensorGPU<Dtype> operator- (const TensorGPU<Dtype>& lhs, const TensorGPU<Dtype>&
 template<typename Dtype>
 TensorGPU<Dtype> operator- (const TensorGPU<Dtype>& lhs, const float rhs) {return outplace_sub_scalar(lhs, rhs); }
 template<typename Dtype>
-TensorGPU<Dtype> operator- (const float lhs, const TensorGPU<Dtype>& rhs) {return outplace_add_scalar(rhs, -lhs); }
+TensorGPU<Dtype> operator- (const float lhs, const TensorGPU<Dtype>& rhs) {auto y = outplace_mul_scalar(rhs, -1.0f); return inplace_add_scalar(y, lhs); }
 
 
 template<typename Dtype>
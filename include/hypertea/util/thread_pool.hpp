@@ -0,0 +1,110 @@
+#ifndef HYPERTEA_UTIL_THREAD_POOL_H_
+#define HYPERTEA_UTIL_THREAD_POOL_H_
+
+#include <atomic>
+#include <climits>
+#include <cstdint>
+#include <condition_variable>
+#include <functional>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+#include "hypertea/util/half.hpp"
+
+namespace hypertea {
+
+template<typename Dtype> class TensorGPU;
+
+// Library-owned pools used to spread independent work over several cores.
+// Workers are numbered 0 .. num_workers() - 1, worker 0 being the calling
+// thread, so callers can keep per-worker scratch buffers.
+//
+// Get() runs the images of a batch and defaults to a single worker. Gemm()
+// runs the panels of one packed_gemm() and defaults to one worker per core.
+// A GEMM issued from inside a batch job runs on its image's worker alone.
+class ThreadPool {
+public:
+
+  static ThreadPool& Get();
+  static ThreadPool& Gemm();
+  ~ThreadPool();
+
+  // Splits the cores between inter_image workers, each running its own
+  // GEMMs, and gemm_threads threads inside every GEMM, for packed_gemm() and
+  // the BLAS library alike (0 keeps the current setting). Operators size
+  // their per-worker buffers at construction, so this should be called
+  // before the network is built.
+  void set_parallelism(int inter_image, int gemm_threads = 0);
+
+  int num_workers() const { return threads_.size() + 1; }
+
+  // Runs fn(index, worker) for every index in [0, n) on at most max_workers
+  // workers. Nested calls from inside a job run serially.
+  void parallel_for(int n, const std::function<void(int, int)>& fn, int max_workers = INT_MAX);
+
+private:
+
+  ThreadPool() {}
+  ThreadPool(const ThreadPool&);
+  ThreadPool& operator=(const ThreadPool&);
+
+  void resize(int workers);
+  void start_workers(int count);
+  void stop_workers();
+  void worker_loop(int worker, int seen_generation);
+  void run_job(int worker);
+
+  std::vector<std::thread> threads_;
+
+  std::mutex run_mutex_;
+  std::mutex mutex_;
+  std::condition_variable start_;
+  std::condition_variable done_;
+
+  const std::function<void(int, int)>* job_ = nullptr;
+  int job_size_ = 0;
+  int job_workers_ = 0;
+  std::atomic<int> next_index_;
+  int active_ = 0;
+  int generation_ = 0;
+  bool stop_ = false;
+
+};
+
+
+// Parallel loop over the images of a batch. Host tensors use the pool;
+// OpenCL tensors only enqueue work, so they stay on the calling thread.
+template <typename DeviceTensor>
+inline void batch_parallel_for(int n, const std::function<void(int, int)>& fn, int max_workers = INT_MAX) {
+  ThreadPool::Get().parallel_for(n, fn, max_workers);
+}
+
+// Number of workers batch_parallel_for will use, i.e. how many scratch
+// buffers an operator needs.
+template <typename DeviceTensor>
+inline int batch_workers() {
+  return ThreadPool::Get().num_workers();
+}
+
+#ifdef USE_OPENCL
+template <>
+inline int batch_workers<TensorGPU<float> >() { return 1; }
+
+template <>
+inline int batch_workers<TensorGPU<half> >() { return 1; }
+
+template <>
+inline void batch_parallel_for<TensorGPU<float> >(int n, const std::function<void(int, int)>& fn, int max_workers) {
+  for (int i = 0; i < n; ++i) { fn(i, 0); }
+}
+
+template <>
+inline void batch_parallel_for<TensorGPU<half> >(int n, const std::function<void(int, int)>& fn, int max_workers) {
+  for (int i = 0; i < n; ++i) { fn(i, 0); }
+}
+#endif //USE_OPENCL
+
+}  // namespace hypertea
+
+#endif   // HYPERTEA_UTIL_THREAD_POOL_H_
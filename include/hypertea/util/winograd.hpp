@@ -0,0 +1,47 @@
+#ifndef HYPERTEA_UTIL_WINOGRAD_HPP_
+#define HYPERTEA_UTIL_WINOGRAD_HPP_
+
+#include "hypertea/tensor.hpp"
+
+namespace hypertea {
+
+// Winograd F(4x4, 3x3): every 4x4 output tile is computed from a 6x6 input
+// tile with 36 multiplications per (input, output) channel pair instead of 144.
+// The 36 element-wise products over channels are done as 36 independent
+// GEMMs covering all tiles of the batch at once. Bias and activation are
+// applied while each output tile is written back.
+
+const int WINOGRAD_TILE = 4;
+const int WINOGRAD_ALPHA = 6;
+
+inline bool winograd_applicable(
+    const std::vector<int>& kernel_shape,
+    const std::vector<int>& stride,
+    const std::vector<int>& dilation,
+    int group) {
+
+  return kernel_shape.size() == 2
+      && kernel_shape[0] == 3 && kernel_shape[1] == 3
+      && stride[0] == 1 && stride[1] == 1
+      && dilation[0] == 1 && dilation[1] == 1
+      && group == 1;
+}
+
+// Transforms (out_channels, in_channels, 3, 3) weights into U = G g G^T,
+// laid out as (36, out_channels, in_channels).
+TensorCPU<float> winograd_transform_weight(const TensorCPU<float>& weight,
+    const int out_channels, const int in_channels);
+
+void winograd_conv(const TensorCPU<float>& data_im,
+    const int num, const int channels, const int height, const int width,
+    const int pad_h, const int pad_w,
+    const TensorCPU<float>& transformed_weight, const int out_channels,
+    const int output_h, const int output_w,
+    TensorCPU<float>& data_out,
+    const float* bias = nullptr,
+    ACTIVATION_TYPE activation = ACTIVATION_TYPE::NONE,
+    float alpha = 0, const float* slope = nullptr);
+
+}  // namespace hypertea
+
+#endif  // HYPERTEA_UTIL_WINOGRAD_HPP_
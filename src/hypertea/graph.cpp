@@ -0,0 +1,435 @@
+#include <memory>
+#include <sstream>
+#include <type_traits>
+
+#include "hypertea/graph.hpp"
+
+namespace hypertea {
+
+template <typename DeviceTensor>
+void Graph<DeviceTensor>::finalize() {
+
+  for (auto& value : values_) {
+    value.consumers.clear();
+  }
+
+  for (int i = 0; i < nodes_.size(); ++i) {
+    auto& node = nodes_[i];
+    node.release.clear();
+    for (int v : node.inputs) {
+      values_[v].consumers.push_back(i);
+    }
+    for (int v : node.outputs) {
+      values_[v].producer = i;
+      values_[v].branch = node.branch;
+    }
+    if (node.op != nullptr && !node.name.empty()) {
+      Profiler::Get().set_name(node.op, node.name);
+    }
+  }
+
+  std::vector<bool> kept(values_.size(), false);
+  for (int v : inputs_) { kept[v] = true; }
+  for (int v : outputs_) { kept[v] = true; }
+
+  for (int v = 0; v < values_.size(); ++v) {
+    if (kept[v]) { continue; }
+    auto& value = values_[v];
+    int last = value.consumers.empty() ? value.producer : value.consumers.back();
+    if (last >= 0) {
+      nodes_[last].release.push_back(v);
+    }
+  }
+
+  auto storage = [&](int v) {
+    while (values_[v].alias >= 0) { v = values_[v].alias; }
+    return v;
+  };
+
+  // A node writing its first input must not destroy a value that is still
+  // read later, through any value sharing the storage. Only values that
+  // exist when the node runs count: its own outputs and values produced
+  // later (e.g. the next add of a residual chain) overwrite it anyway.
+  for (int i = 0; i < nodes_.size(); ++i) {
+    auto& node = nodes_[i];
+    node.copy_input = false;
+    if (!node.writes_input) { continue; }
+
+    const int written = storage(node.inputs[0]);
+    for (int v = 0; v < values_.size(); ++v) {
+      if (values_[v].producer >= i || storage(v) != written) { continue; }
+      if (kept[v] || (!values_[v].consumers.empty() && values_[v].consumers.back() > i)) {
+        node.copy_input = true;
+        break;
+      }
+    }
+  }
+}
+
+
+template <typename DeviceTensor>
+std::vector<DeviceTensor> Graph<DeviceTensor>::run(
+  const std::vector<DeviceTensor>& inputs, const OutputCallback& on_output) {
+
+  if (inputs.size() != inputs_.size()) {
+    LOG(ERROR) << "Graph expects " << inputs_.size() << " inputs, got " << inputs.size();
+    return {};
+  }
+
+  std::vector<std::unique_ptr<DeviceTensor> > slots(values_.size());
+  std::vector<int> output_index(values_.size(), -1);
+  std::vector<int> segment_of(values_.size(), -1);
+
+  for (int k = 0; k < inputs_.size(); ++k) {
+    slots[inputs_[k]].reset(new DeviceTensor(inputs[k]));
+  }
+  for (int k = 0; k < outputs_.size(); ++k) {
+    output_index[outputs_[k]] = k;
+  }
+
+  // Stops the run at the first node that fails, run() then returns nothing.
+  bool failed = false;
+
+  auto run_node = [&](int i) {
+
+    auto& node = nodes_[i];
+
+    std::vector<DeviceTensor> args;
+    for (int v : node.inputs) {
+      if (!slots[v]) {
+        LOG(ERROR) << "Graph node " << i << " (" << node.type << ") reads %" << v << " which is not available";
+        failed = true;
+        return false;
+      }
+      args.push_back(*slots[v]);
+    }
+    if (node.copy_input) {
+      args[0] = args[0].duplicate();
+    }
+
+    std::vector<DeviceTensor> results;
+    if (node.op != nullptr) {
+      results.push_back((*node.op)(args[0]));
+    } else {
+      results = node.function(args);
+    }
+
+    if (results.size() != node.outputs.size()) {
+      LOG(ERROR) << "Graph node " << i << " (" << node.type << ") returned " << results.size()
+                 << " tensors instead of " << node.outputs.size();
+      failed = true;
+      return false;
+    }
+
+    for (int k = 0; k < node.outputs.size(); ++k) {
+      const int v = node.outputs[k];
+      auto& value = values_[v];
+
+      if (value.count < 0) {
+        value.count = results[k].count();
+        int expected = 1;
+        for (int d : value.shape) { expected *= d; }
+        if (!value.shape.empty() && expected != value.count) {
+          LOG(ERROR) << "Graph value %" << v << " has " << value.count << " elements, its shape " << expected;
+        }
+      }
+
+      slots[v].reset(new DeviceTensor(results[k]));
+      if (on_output && output_index[v] >= 0) {
+        on_output(output_index[v], *slots[v]);
+      }
+    }
+
+    for (int v : node.release) {
+      slots[v].reset();
+    }
+    return true;
+  };
+
+#ifdef USE_OPENCL
+  const bool branches = !std::is_same<DeviceTensor, TensorCPU<float> >::value;
+  std::unique_ptr<BranchGroup> group;
+#endif
+
+  // Consecutive nodes of one branch form a segment, the unit handed to the
+  // BranchGroup.
+  int segment = 0;
+  for (int begin = 0; begin < nodes_.size(); ++segment) {
+
+    const int branch = nodes_[begin].branch;
+    int end = begin + 1;
+    while (end < nodes_.size() && nodes_[end].branch == branch) { ++end; }
+
+    for (int i = begin; i < end; ++i) {
+      for (int v : nodes_[i].outputs) { segment_of[v] = segment; }
+    }
+
+#ifdef USE_OPENCL
+    if (branches) {
+      bool join = false;
+      for (int i = begin; i < end; ++i) {
+        for (int v : nodes_[i].inputs) {
+          join |= values_[v].branch != 0 && segment_of[v] != segment;
+        }
+      }
+      if (join) { group.reset(); }
+
+      if (branch != 0) {
+        if (!group) { group.reset(new BranchGroup()); }
+        group->run([&run_node, begin, end]() {
+          for (int i = begin; i < end && run_node(i); ++i) {}
+        });
+        if (failed) { break; }
+        begin = end;
+        continue;
+      }
+    }
+#endif //USE_OPENCL
+
+    for (int i = begin; i < end && run_node(i); ++i) {}
+    if (failed) { break; }
+    begin = end;
+  }
+
+#ifdef USE_OPENCL
+  group.reset();
+#endif
+
+  if (failed) { return {}; }
+
+  std::vector<DeviceTensor> outputs;
+  for (int v : outputs_) {
+    if (!slots[v]) {
+      LOG(ERROR) << "Graph output %" << v << " was not computed";
+      return {};
+    }
+    outputs.push_back(*slots[v]);
+  }
+  return outputs;
+}
+
+
+template <typename DeviceTensor>
+void Graph<DeviceTensor>::dump(std::ostream& out) const {
+
+  auto value_str = [&](int v) {
+    std::stringstream ss;
+    ss << "%" << v;
+    if (values_[v].count >= 0) { ss << "[" << values_[v].count << "]"; }
+    return ss.str();
+  };
+
+  for (int v : inputs_) {
+    out << "input " << value_str(v) << " " << values_[v].name << std::endl;
+  }
+
+  for (auto& node : nodes_) {
+    for (int k = 0; k < node.outputs.size(); ++k) {
+      out << (k ? ", " : "") << value_str(node.outputs[k]);
+    }
+    out << " = " << node.type << "(";
+    for (int k = 0; k < node.inputs.size(); ++k) {
+      out << (k ? ", " : "") << "%" << node.inputs[k];
+    }
+    out << ")";
+    if (!node.name.empty()) { out << " " << node.name; }
+    if (node.branch != 0) { out << " branch " << node.branch; }
+    if (node.copy_input) { out << " copy"; }
+    out << std::endl;
+  }
+
+  for (int v : outputs_) {
+    out << "output " << value_str(v) << std::endl;
+  }
+}
+
+
+template <typename DeviceTensor>
+GraphValue GraphBuilder<DeviceTensor>::new_value(int producer) {
+  typename Graph<DeviceTensor>::Value value;
+  value.producer = producer;
+  value.branch = branch_;
+  graph_.values_.push_back(value);
+
+  GraphValue x;
+  x.id = graph_.values_.size() - 1;
+  return x;
+}
+
+template <typename DeviceTensor>
+typename Graph<DeviceTensor>::Node& GraphBuilder<DeviceTensor>::new_node(
+  const std::string& type, const std::vector<GraphValue>& inputs, int num_outputs) {
+
+  typename Graph<DeviceTensor>::Node node;
+  node.type = type;
+  node.branch = branch_;
+  for (auto& x : inputs) {
+    if (x.id < 0 || x.id >= graph_.values_.size()) {
+      LOG(ERROR) << "GraphBuilder: " << type << " uses an unknown value";
+    }
+    node.inputs.push_back(x.id);
+  }
+
+  const int index = graph_.nodes_.size();
+  for (int k = 0; k < num_outputs; ++k) {
+    node.outputs.push_back(new_value(index).id);
+  }
+
+  graph_.nodes_.push_back(node);
+  return graph_.nodes_.back();
+}
+
+
+template <typename DeviceTensor>
+GraphValue GraphBuilder<DeviceTensor>::input(const std::string& name, const std::vector<int>& shape) {
+  GraphValue x = new_value(-1);
+  graph_.values_[x.id].name = name;
+  graph_.values_[x.id].shape = shape;
+  graph_.inputs_.push_back(x.id);
+  return x;
+}
+
+template <typename DeviceTensor>
+void GraphBuilder<DeviceTensor>::output(GraphValue x) {
+  graph_.outputs_.push_back(x.id);
+}
+
+template <typename DeviceTensor>
+void GraphBuilder<DeviceTensor>::set_shape(GraphValue x, const std::vector<int>& shape) {
+  graph_.values_[x.id].shape = shape;
+}
+
+
+template <typename DeviceTensor>
+GraphValue GraphBuilder<DeviceTensor>::op(TensorOperator<DeviceTensor>& op, GraphValue x,
+  const std::string& name, const std::vector<int>& shape) {
+
+  auto& node = new_node(op.type(), {x}, 1);
+  node.op = &op;
+  node.name = name;
+
+  GraphValue y;
+  y.id = node.outputs[0];
+  graph_.values_[y.id].shape = shape;
+  return y;
+}
+
+template <typename DeviceTensor>
+GraphValue GraphBuilder<DeviceTensor>::chain(GraphValue x,
+  const std::vector<TensorOperator<DeviceTensor>*>& ops) {
+
+  for (auto op : ops) {
+    x = this->op(*op, x);
+  }
+  return x;
+}
+
+
+template <typename DeviceTensor>
+std::vector<GraphValue> GraphBuilder<DeviceTensor>::function(const std::string& type,
+  const std::vector<GraphValue>& inputs, int num_outputs, Function f) {
+
+  auto& node = new_node(type, inputs, num_outputs);
+  node.function = f;
+
+  std::vector<GraphValue> ys(num_outputs);
+  for (int k = 0; k < num_outputs; ++k) {
+    ys[k].id = node.outputs[k];
+  }
+  return ys;
+}
+
+template <typename DeviceTensor>
+GraphValue GraphBuilder<DeviceTensor>::function(const std::string& type,
+  const std::vector<GraphValue>& inputs,
+  std::function<DeviceTensor(std::vector<DeviceTensor>&)> f) {
+
+  return function(type, inputs, 1, [f](std::vector<DeviceTensor>& xs) {
+    return std::vector<DeviceTensor> {f(xs)};
+  })[0];
+}
+
+
+template <typename DeviceTensor>
+GraphValue GraphBuilder<DeviceTensor>::add(GraphValue a, GraphValue b) {
+
+  GraphValue y = function("add", {a, b}, [](std::vector<DeviceTensor>& xs) {
+    DeviceTensor y = xs[0];
+    y += xs[1];
+    return y;
+  });
+
+  graph_.nodes_.back().writes_input = true;
+  graph_.values_[y.id].alias = a.id;
+  return y;
+}
+
+template <typename DeviceTensor>
+GraphValue GraphBuilder<DeviceTensor>::concate(const std::vector<GraphValue>& xs) {
+
+  return function("concate", xs, [](std::vector<DeviceTensor>& xs) {
+    std::vector<DeviceTensor*> parts;
+    for (auto& x : xs) { parts.push_back(&x); }
+    return hypertea::concate(parts);
+  });
+}
+
+template <typename DeviceTensor>
+GraphValue GraphBuilder<DeviceTensor>::hconcate(const std::vector<GraphValue>& xs, int top_dim) {
+
+  return function("hconcate", xs, [top_dim](std::vector<DeviceTensor>& xs) {
+    std::vector<DeviceTensor*> parts;
+    for (auto& x : xs) { parts.push_back(&x); }
+    return hypertea::hconcate(parts, top_dim);
+  });
+}
+
+template <typename DeviceTensor>
+GraphValue GraphBuilder<DeviceTensor>::sub_view(GraphValue x, int offset, int count) {
+
+  GraphValue y = function("sub_view", {x}, [offset, count](std::vector<DeviceTensor>& xs) {
+    return xs[0].sub_view(offset, count);
+  });
+
+  graph_.values_[y.id].alias = x.id;
+  return y;
+}
+
+template <typename DeviceTensor>
+GraphValue GraphBuilder<DeviceTensor>::gemm(const CBLAS_TRANSPOSE TransA, const CBLAS_TRANSPOSE TransB,
+  const int M, const int N, const int K, const float alpha,
+  GraphValue a, GraphValue b, const float beta) {
+
+  return function("gemm", {a, b}, [=](std::vector<DeviceTensor>& xs) {
+    return outplace_gemm(TransA, TransB, M, N, K, alpha, xs[0], xs[1], beta);
+  });
+}
+
+
+template <typename DeviceTensor>
+void GraphBuilder<DeviceTensor>::branch(const std::function<void()>& body) {
+  const int parent = branch_;
+  branch_ = ++branches_;
+  body();
+  branch_ = parent;
+}
+
+
+template <typename DeviceTensor>
+Graph<DeviceTensor> GraphBuilder<DeviceTensor>::build() {
+  graph_.finalize();
+  return graph_;
+}
+
+
+template class Graph<TensorCPU<float> >;
+template class GraphBuilder<TensorCPU<float> >;
+
+#ifdef USE_OPENCL
+template class Graph<TensorGPU<float> >;
+template class Graph<TensorGPU<half> >;
+template class GraphBuilder<TensorGPU<float> >;
+template class GraphBuilder<TensorGPU<half> >;
+#endif //USE_OPENCL
+
+}  // namespace hypertea
@@ -6,6 +6,7 @@ namespace hypertea {
 
 template<typename DeviceTensor>
 DeviceTensor PReLUOp<DeviceTensor>::operator()(DeviceTensor input) {
+	OperatorProfileScope profile_scope(this);
 
 	DeviceTensor output = inplace_? input : input.duplicate();
 
@@ -19,6 +20,8 @@ DEFINE_FORWARD_FUNC(PReLUOp);
 
 template<typename DeviceTensor>
 DeviceTensor ReLUOp<DeviceTensor>::operator()(DeviceTensor input) {
+	OperatorProfileScope profile_scope(this);
+
 	return inplace_? DeviceTensor(inplace_relu(input, negative_slope_)) : outplace_relu(input, negative_slope_);
 }
 DEFINE_FORWARD_FUNC(ReLUOp);
@@ -26,6 +29,8 @@ DEFINE_FORWARD_FUNC(ReLUOp);
 
 template<typename DeviceTensor>
 DeviceTensor TanHOp<DeviceTensor>::operator()(DeviceTensor input) {
+	OperatorProfileScope profile_scope(this);
+
 	return inplace_? DeviceTensor(inplace_tanh(input)) : outplace_tanh(input);
 }
 DEFINE_FORWARD_FUNC(TanHOp);
@@ -33,6 +38,8 @@ DEFINE_FORWARD_FUNC(TanHOp);
 
 template<typename DeviceTensor>
 DeviceTensor ELUOp<DeviceTensor>::operator()(DeviceTensor input) {
+	OperatorProfileScope profile_scope(this);
+
 	return inplace_?DeviceTensor(inplace_elu(input, alpha_)) : outplace_elu(input, alpha_);
 }
 DEFINE_FORWARD_FUNC(ELUOp);
@@ -40,6 +47,7 @@ DEFINE_FORWARD_FUNC(ELUOp);
 
 template<typename DeviceTensor>
 DeviceTensor SoftMaxOp<DeviceTensor>::operator()(DeviceTensor input) {
+	OperatorProfileScope profile_scope(this);
 
 	auto output = inplace_? input : input.duplicate();
 
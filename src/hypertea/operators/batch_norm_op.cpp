@@ -10,6 +10,7 @@ namespace hypertea {
  
 template<typename DeviceTensor>
 DeviceTensor BatchNormOp<DeviceTensor>::operator()(DeviceTensor input) {
+  OperatorProfileScope profile_scope(this);
 
   DeviceTensor output = inplace_? input : input.duplicate();
 
@@ -48,4 +49,76 @@ DeviceTensor BatchNormOp<DeviceTensor>::operator()(DeviceTensor input) {
 
 DEFINE_FORWARD_FUNC(BatchNormOp);
 
+
+template<typename DeviceTensor>
+DeviceTensor BatchNormOp<DeviceTensor>::fold_into(
+  DeviceTensor& conv_weight, const DeviceTensor* conv_bias) const {
+
+  // mean_ / variance_ are per-batch scratch then, folding them would
+  // corrupt conv_weight: leave it alone and return the bias it had.
+  if (!use_global_stats_) {
+    LOG(ERROR) << "BatchNorm without running statistics can not be folded";
+    return conv_bias != nullptr ? conv_bias->duplicate() : DeviceTensor(channels_, 0);
+  }
+
+  DeviceTensor folded_bias(channels_);
+  fold_batch_norm(conv_weight, conv_bias, *mean_, *variance_, weight_, bias_, channels_, eps_, folded_bias);
+  return folded_bias;
+}
+
+
+template<typename DeviceTensor>
+void fold_batch_norm(
+  DeviceTensor& conv_weight, const DeviceTensor* conv_bias,
+  const DeviceTensor& mean, const DeviceTensor& variance,
+  const DeviceTensor* weight, const DeviceTensor* bias,
+  int channels, float eps,
+  DeviceTensor& folded_bias) {
+
+  auto scale = variance + eps;
+  inplace_sqrt(scale);
+  inplace_inv(scale);
+
+  if (weight != nullptr) {
+    scale *= *weight;
+  }
+
+  inplace_channeled_scal(conv_weight, scale, channels, conv_weight.count() / channels);
+
+  auto shift = (conv_bias != nullptr) ? (*conv_bias - mean) : (mean * -1.0f);
+  shift *= scale;
+
+  if (bias != nullptr) {
+    shift += *bias;
+  }
+
+  folded_bias.copy_data(shift);
+}
+
+
+template TensorCPU<float> BatchNormOp<TensorCPU<float>>::fold_into(
+  TensorCPU<float>& conv_weight, const TensorCPU<float>* conv_bias) const;
+template void fold_batch_norm(
+  TensorCPU<float>& conv_weight, const TensorCPU<float>* conv_bias,
+  const TensorCPU<float>& mean, const TensorCPU<float>& variance,
+  const TensorCPU<float>* weight, const TensorCPU<float>* bias,
+  int channels, float eps, TensorCPU<float>& folded_bias);
+
+#ifdef USE_OPENCL
+template TensorGPU<float> BatchNormOp<TensorGPU<float>>::fold_into(
+  TensorGPU<float>& conv_weight, const TensorGPU<float>* conv_bias) const;
+template TensorGPU<half> BatchNormOp<TensorGPU<half>>::fold_into(
+  TensorGPU<half>& conv_weight, const TensorGPU<half>* conv_bias) const;
+template void fold_batch_norm(
+  TensorGPU<float>& conv_weight, const TensorGPU<float>* conv_bias,
+  const TensorGPU<float>& mean, const TensorGPU<float>& variance,
+  const TensorGPU<float>* weight, const TensorGPU<float>* bias,
+  int channels, float eps, TensorGPU<float>& folded_bias);
+template void fold_batch_norm(
+  TensorGPU<half>& conv_weight, const TensorGPU<half>* conv_bias,
+  const TensorGPU<half>& mean, const TensorGPU<half>& variance,
+  const TensorGPU<half>* weight, const TensorGPU<half>* bias,
+  int channels, float eps, TensorGPU<half>& folded_bias);
+#endif //USE_OPENCL
+
 }  // namespace hypertea
@@ -0,0 +1,149 @@
+#include <math.h>
+#include <vector>
+
+#include "hypertea/operators/blocked_op.hpp"
+
+namespace hypertea {
+
+
+TensorCPU<float> ReorderOp::operator()(TensorCPU<float> input) {
+  OperatorProfileScope profile_scope(this);
+
+  const int padded = blocked_channels(channels_, block_);
+
+  if (direction_ == LAYOUT_REORDER::TO_NCHWC) {
+    const int num = input.count() / (channels_ * spatial_dim_);
+    TensorCPU<float> output(num * padded * spatial_dim_);
+    reorder_to_blocked(input, output, num, channels_, spatial_dim_, block_);
+    return output;
+  }
+
+  const int num = input.count() / (padded * spatial_dim_);
+  TensorCPU<float> output(num * channels_ * spatial_dim_);
+  reorder_from_blocked(input, output, num, channels_, spatial_dim_, block_);
+  return output;
+}
+
+
+
+BlockedConvolutionOp::BlockedConvolutionOp(
+    TensorCPU<float>* weight,
+    TensorCPU<float>* bias,
+    std::vector<int> kernel_shape,
+    std::vector<int> stride,
+    std::vector<int> pad,
+    std::vector<int> dilation,
+    std::vector<int> input_shape,
+    std::vector<int> output_shape,
+    int block,
+    ACTIVATION_TYPE activation,
+    float alpha,
+    TensorCPU<float>* activation_weight)
+  : weight_(weight), bias_(bias), activation_weight_(activation_weight),
+    kernel_shape_(kernel_shape), stride_(stride), pad_(pad), dilation_(dilation),
+    input_shape_(input_shape), output_shape_(output_shape),
+    block_(block), activation_(activation), activation_alpha_(alpha) {
+
+  prepare_blocked_weights();
+}
+
+
+void BlockedConvolutionOp::prepare_blocked_weights() {
+
+  const int out_channels = output_shape_[1];
+
+  blocked_weight_ = std::make_shared<TensorCPU<float>>(blocked_conv_weight(
+    weight_->immutable_data(), out_channels, input_shape_[1],
+    kernel_shape_[0], kernel_shape_[1], block_));
+
+  if (bias_ != nullptr) {
+    blocked_bias_ = std::make_shared<TensorCPU<float>>(
+      blocked_channel_vector(bias_->immutable_data(), out_channels, block_));
+  }
+  if (activation_weight_ != nullptr) {
+    blocked_slope_ = std::make_shared<TensorCPU<float>>(
+      blocked_channel_vector(activation_weight_->immutable_data(), out_channels, block_));
+  }
+}
+
+
+void BlockedConvolutionOp::fold_batch_norm(const BatchNormOp<TensorCPU<float>>& bn) {
+  if (!bn.foldable()) {
+    LOG(ERROR) << "BatchNorm without running statistics can not be folded";
+    return;
+  }
+  folded_bias_ = std::make_shared<TensorCPU<float>>(bn.fold_into(*weight_, bias_));
+  bias_ = folded_bias_.get();
+  prepare_blocked_weights();
+}
+
+
+TensorCPU<float> BlockedConvolutionOp::operator()(TensorCPU<float> input) {
+  OperatorProfileScope profile_scope(this);
+
+  const int num = input_shape_[0];
+  const int output_h = output_shape_[2];
+  const int output_w = output_shape_[3];
+
+  TensorCPU<float> output(num * blocked_channels(output_shape_[1], block_) * output_h * output_w);
+
+  blocked_conv2d(input, num, input_shape_[1], input_shape_[2], input_shape_[3],
+    *blocked_weight_, output_shape_[1],
+    kernel_shape_[0], kernel_shape_[1], pad_[0], pad_[1],
+    stride_[0], stride_[1], dilation_[0], dilation_[1],
+    output_h, output_w, output, block_,
+    blocked_bias_ ? blocked_bias_->immutable_data() : nullptr,
+    activation_, activation_alpha_,
+    blocked_slope_ ? blocked_slope_->immutable_data() : nullptr);
+
+  return output;
+}
+
+
+
+BlockedBatchNormOp::BlockedBatchNormOp(
+    int channels, int spatial_dim,
+    float eps,
+    const TensorCPU<float>& mean, const TensorCPU<float>& variance,
+    const TensorCPU<float>* weight, const TensorCPU<float>* bias,
+    int block,
+    bool inplace,
+    ACTIVATION_TYPE activation,
+    float alpha)
+  : channels_(channels), spatial_dim_(spatial_dim), block_(block),
+    inplace_(inplace), activation_(activation), activation_alpha_(alpha) {
+
+  std::vector<float> scale(channels), shift(channels);
+
+  for (int c = 0; c < channels; ++c) {
+    scale[c] = 1.f / sqrtf(variance.immutable_data()[c] + eps);
+    if (weight != nullptr) { scale[c] *= weight->immutable_data()[c]; }
+    shift[c] = (bias != nullptr ? bias->immutable_data()[c] : 0.f) - mean.immutable_data()[c] * scale[c];
+  }
+
+  scale_ = std::make_shared<TensorCPU<float>>(blocked_channel_vector(scale.data(), channels, block));
+  shift_ = std::make_shared<TensorCPU<float>>(blocked_channel_vector(shift.data(), channels, block));
+}
+
+
+TensorCPU<float> BlockedBatchNormOp::operator()(TensorCPU<float> input) {
+  OperatorProfileScope profile_scope(this);
+
+  TensorCPU<float> output = inplace_ ? input : input.duplicate();
+
+  const int channel_blocks = blocked_channels(channels_, block_) / block_;
+  const int num = output.count() / (channel_blocks * block_ * spatial_dim_);
+
+  auto data = output.mutable_data();
+  auto scale = scale_->immutable_data();
+  auto shift = shift_->immutable_data();
+
+  for_each_channel_row(num, channel_blocks, spatial_dim_ * block_, [&](int r, int cb) {
+    blocked_scale_bias_activation(data + r * spatial_dim_ * block_, spatial_dim_, block_,
+      scale + cb * block_, shift + cb * block_, activation_, activation_alpha_);
+  });
+
+  return output;
+}
+
+}  // namespace hypertea
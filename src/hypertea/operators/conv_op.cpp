@@ -1,3 +1,4 @@
+#include <algorithm>
 #include <vector>
 
 #include "hypertea/operators/conv_op.hpp"
@@ -6,36 +7,239 @@
 namespace hypertea {
 
 
-template<typename DeviceTensor>
-DeviceTensor ConvolutionOp<DeviceTensor>::operator()(DeviceTensor input) {
-  
-  auto output = DeviceTensor(this->top_count_, 0);
+template<>
+void ConvolutionOp<TensorCPU<float>>::prepare_winograd() {
 
+  if (this->is_1x1_ || !winograd_applicable(this->kernel_shape_, this->stride_, this->dilation_, this->group_)) {
+    return;
+  }
 
-  auto inputs_tensors  = input.chunked_tensors(this->num_);
-  auto outputs_tensors = output.chunked_tensors(this->num_);
+  winograd_weight_ = std::make_shared<TensorCPU<float>>(
+    winograd_transform_weight(*this->weight_, this->conv_out_channels_, this->conv_in_channels_)
+  );
+}
+
+
+template<>
+bool ConvolutionOp<TensorCPU<float>>::winograd_forward(
+  const TensorCPU<float>& input, TensorCPU<float>& output) {
+
+  if (!use_winograd()) { return false; }
+
+  winograd_conv(input, this->num_, this->conv_in_channels_,
+    this->conv_input_shape_[1], this->conv_input_shape_[2],
+    this->pad_[0], this->pad_[1],
+    *winograd_weight_, this->conv_out_channels_,
+    output_h_, output_w_, output,
+    this->bias_ ? this->bias_->immutable_data() : nullptr,
+    activation_, activation_alpha_,
+    activation_weight_ ? activation_weight_->immutable_data() : nullptr);
+
+  return true;
+}
+
+
+template<>
+void ConvolutionOp<TensorCPU<float>>::prepare_depthwise() {
+
+  if (!depthwise_applicable(this->kernel_shape_, this->dilation_, this->group_,
+      this->conv_in_channels_, this->conv_out_channels_)) {
+    return;
+  }
+
+  depthwise_ = true;
+  this->release_col_buffers();
+}
+
+
+template<>
+bool ConvolutionOp<TensorCPU<float>>::depthwise_forward(
+  const TensorCPU<float>& input, TensorCPU<float>& output) {
+
+  if (!use_depthwise()) { return false; }
+
+  depthwise_conv3x3(input, this->num_, this->conv_in_channels_,
+    this->conv_input_shape_[1], this->conv_input_shape_[2],
+    this->pad_[0], this->pad_[1], this->stride_[0], this->stride_[1],
+    *this->weight_, output_h_, output_w_, output,
+    this->bias_ ? this->bias_->immutable_data() : nullptr,
+    activation_, activation_alpha_,
+    activation_weight_ ? activation_weight_->immutable_data() : nullptr);
+
+  return true;
+}
+
+
+// Output columns per GEMM block, sized so that a (out_channels x block) tile
+// of the output stays in L2 until the epilogue has run over it.
+static const int CONV_EPILOGUE_TILE_FLOATS = 32 * 1024;
+
+// Same for the (kernel_dim x block) im2col tile gathered for that block.
+static const int CONV_IM2COL_TILE_FLOATS = 64 * 1024;
+
+static int conv_block_cols(int limit_floats, int rows, int cols) {
+  return std::min(cols, std::max(64, limit_floats / rows / 16 * 16));
+}
+
+
+template<>
+void ConvolutionOp<TensorCPU<float>>::prepare_im2col_tiles() {
+
+  if (this->is_1x1_ || use_depthwise()) { return; }
+
+  if (use_winograd()) {
+    this->release_col_buffers();
+    return;
+  }
+
+  const int N = this->conv_out_spatial_dim_;
+  tile_cols_ = std::min(
+    conv_block_cols(CONV_IM2COL_TILE_FLOATS, this->kernel_dim_, N),
+    conv_block_cols(CONV_EPILOGUE_TILE_FLOATS, this->conv_out_channels_ / this->group_, N)
+  );
+
+  this->reset_col_buffers(this->kernel_dim_ * tile_cols_);
+}
+
+
+template<>
+void ConvolutionOp<TensorCPU<float>>::prepare_packed_weight() {
+
+  packed_weight_.clear();
+  if (use_winograd() || use_depthwise()) { return; }
+
+  for (int g = 0; g < this->group_; ++g) {
+    packed_weight_.emplace_back(this->weight_->immutable_data() + g * this->weight_offset_,
+      this->conv_out_channels_ / this->group_, this->kernel_dim_);
+  }
+}
+
+
+template<>
+void ConvolutionOp<TensorCPU<float>>::forward_image(
+  TensorCPU<float>& input, TensorCPU<float>& output, int worker) {
+
+  const int M = this->conv_out_channels_ / this->group_;
+  const int N = this->conv_out_spatial_dim_;
+
+  const int height = this->conv_input_shape_[1];
+  const int width = this->conv_input_shape_[2];
+  const int group_channels = this->conv_in_channels_ / this->group_;
+
+  auto input_data = input.immutable_data();
+  auto output_data = output.mutable_data();
+
+  auto bias_data = this->bias_ ? this->bias_->immutable_data() : nullptr;
+  auto slope_data = activation_weight_ ? activation_weight_->immutable_data() : nullptr;
+  bool has_epilogue = bias_data != nullptr || activation_ != ACTIVATION_TYPE::NONE;
+
+  // A 1x1 input already is the (K x N) column matrix; otherwise each
+  // (K x block) tile is gathered right before its GEMM.
+  const int block = !this->is_1x1_ ? tile_cols_ :
+    has_epilogue ? conv_block_cols(CONV_EPILOGUE_TILE_FLOATS, M, N) : N;
+  float* tile = this->is_1x1_ ? nullptr : this->worker_col_buffer(worker)->mutable_data();
+
+  for (int j = 0; j < N; j += block) {
+
+    const int cols = std::min(block, N - j);
 
-  for (int i = 0; i < this->num_; ++i) {
+    for (int g = 0; g < this->group_; ++g) {
 
+      const float* col_data = input_data + g * this->col_offset_ + j;
+      int ldb = N;
 
-    if (!this->is_1x1_) {
-      this->conv_im2col(inputs_tensors[i], *this->col_buffer_);
-    } else {
-      this->col_buffer_ = &inputs_tensors[i];
+      if (!this->is_1x1_) {
+        im2col_tile(input_data + g * group_channels * height * width, group_channels,
+          height, width,
+          this->kernel_shape_[0], this->kernel_shape_[1],
+          this->pad_[0], this->pad_[1],
+          this->stride_[0], this->stride_[1],
+          this->dilation_[0], this->dilation_[1],
+          j, cols, tile);
+        col_data = tile;
+        ldb = cols;
+      }
+
+      float* group_output = output_data + g * this->output_offset_ + j;
+
+      packed_gemm(packed_weight_[g], cols, col_data, ldb, 1,
+        nullptr, 0, group_output, N, 1);
+
+      if (has_epilogue) {
+        channeled_bias_activation(group_output, M, cols, N,
+          bias_data ? bias_data + g * M : nullptr, activation_, activation_alpha_,
+          slope_data ? slope_data + g * M : nullptr);
+      }
     }
+  }
+}
+
+
+template<typename DeviceTensor>
+void ConvolutionOp<DeviceTensor>::forward_image(
+  DeviceTensor& input, DeviceTensor& output, int worker) {
+
+  DeviceTensor* col_buffer = &input;
+
+  if (!this->is_1x1_) {
+    col_buffer = this->worker_col_buffer(worker);
+    this->conv_im2col(input, *col_buffer);
+  }
 
+  gemm_epilogue(*col_buffer, output);
+}
+
+
+template<typename DeviceTensor>
+void ConvolutionOp<DeviceTensor>::gemm_epilogue(
+  DeviceTensor& col, DeviceTensor& output) {
+
+  if (this->group_ == 1) {
     inplace_gemm(
       CblasNoTrans, CblasNoTrans, 
       this->conv_out_channels_, this->conv_out_spatial_dim_, this->kernel_dim_,
-      (float)1., *this->weight_, *this->col_buffer_,
-      (float)0., outputs_tensors[i]
+      (float)1., *this->weight_, col,
+      (float)0., output
     );
-
-    if (this->bias_) {
-      inplace_channeled_add(outputs_tensors[i], *this->bias_, this->num_output_, this->out_spatial_dim_);
+  } else {
+    auto weights = this->weight_->chunked_tensors(this->group_);
+    auto cols = col.chunked_tensors(this->group_);
+    auto outputs = output.chunked_tensors(this->group_);
+
+    for (int g = 0; g < this->group_; ++g) {
+      inplace_gemm(
+        CblasNoTrans, CblasNoTrans, 
+        this->conv_out_channels_ / this->group_, this->conv_out_spatial_dim_, this->kernel_dim_,
+        (float)1., weights[g], cols[g],
+        (float)0., outputs[g]
+      );
     }
+  }
 
+  if (this->bias_ || activation_ != ACTIVATION_TYPE::NONE) {
+    inplace_channeled_bias_activation(output, this->bias_, this->num_output_, this->out_spatial_dim_,
+      activation_, activation_alpha_, activation_weight_);
   }
+}
+
+
+
+template<typename DeviceTensor>
+DeviceTensor ConvolutionOp<DeviceTensor>::operator()(DeviceTensor input) {
+  OperatorProfileScope profile_scope(this);
+  
+  auto output = DeviceTensor(this->top_count_, 0);
+
+  if (winograd_forward(input, output) || depthwise_forward(input, output)) {
+    return output;
+  }
+
+  auto inputs_tensors  = input.chunked_tensors(this->num_);
+  auto outputs_tensors = output.chunked_tensors(this->num_);
+
+  batch_parallel_for<DeviceTensor>(this->num_, [&](int i, int worker) {
+    forward_image(inputs_tensors[i], outputs_tensors[i], worker);
+  }, this->workers_);
 
   return output;
 
@@ -6,8 +6,62 @@ namespace hypertea {
 
 
 
+template<>
+void DeconvolutionOp<TensorCPU<float>>::prepare_packed_weight() {
+
+  for (int g = 0; g < this->group_; ++g) {
+    packed_weight_.emplace_back(this->weight_->immutable_data() + g * this->weight_offset_,
+      this->kernel_dim_, this->conv_out_channels_ / this->group_, true);
+  }
+}
+
+
+template<>
+void DeconvolutionOp<TensorCPU<float>>::weight_gemm(
+  TensorCPU<float>& input, TensorCPU<float>& col) {
+
+  const int N = this->conv_out_spatial_dim_;
+  const int group_channels = this->conv_out_channels_ / this->group_;
+
+  for (int g = 0; g < this->group_; ++g) {
+    packed_gemm(packed_weight_[g], N,
+      input.immutable_data() + g * group_channels * N, N, 1,
+      nullptr, 0, col.mutable_data() + g * this->col_offset_, N, 1);
+  }
+}
+
+
+template<typename DeviceTensor>
+void DeconvolutionOp<DeviceTensor>::weight_gemm(
+  DeviceTensor& input, DeviceTensor& col) {
+
+  if (this->group_ == 1) {
+    inplace_gemm(
+      CblasTrans, CblasNoTrans, 
+      this->kernel_dim_, this->conv_out_spatial_dim_, this->conv_out_channels_,
+      (float)1., *this->weight_, input,
+      (float)0., col
+    );
+  } else {
+    auto weights = this->weight_->chunked_tensors(this->group_);
+    auto inputs = input.chunked_tensors(this->group_);
+    auto cols = col.chunked_tensors(this->group_);
+
+    for (int g = 0; g < this->group_; ++g) {
+      inplace_gemm(
+        CblasTrans, CblasNoTrans, 
+        this->kernel_dim_, this->conv_out_spatial_dim_, this->conv_out_channels_ / this->group_,
+        (float)1., weights[g], inputs[g],
+        (float)0., cols[g]
+      );
+    }
+  }
+}
+
+
 template<typename DeviceTensor>
 DeviceTensor DeconvolutionOp<DeviceTensor>::operator()(DeviceTensor input) {
+  OperatorProfileScope profile_scope(this);
 
 
   auto output = DeviceTensor(this->top_count_, 0);
@@ -15,28 +69,21 @@ DeviceTensor DeconvolutionOp<DeviceTensor>::operator()(DeviceTensor input) {
   auto inputs_tensors  = input.chunked_tensors(this->num_);
   auto outputs_tensors = output.chunked_tensors(this->num_);
 
-  for (int i = 0; i < this->num_; ++i) {
+  batch_parallel_for<DeviceTensor>(this->num_, [&](int i, int worker) {
 
-    if (this->is_1x1_) {
-      this->col_buffer_ = &outputs_tensors[i];
-    }
+    DeviceTensor* col_buffer = this->is_1x1_ ? &outputs_tensors[i] : this->worker_col_buffer(worker);
 
-    inplace_gemm(
-      CblasTrans, CblasNoTrans, 
-      this->kernel_dim_, this->conv_out_spatial_dim_, this->conv_out_channels_,
-      (float)1., *this->weight_, inputs_tensors[i],
-      (float)0., *this->col_buffer_
-    );
+    weight_gemm(inputs_tensors[i], *col_buffer);
 
     if (!this->is_1x1_) {
-      this->conv_col2im(*this->col_buffer_, outputs_tensors[i]);
+      this->conv_col2im(*col_buffer, outputs_tensors[i]);
     }
 
     if (this->bias_) {
       inplace_channeled_add(outputs_tensors[i], *this->bias_, this->num_output_, this->out_spatial_dim_);
     }
 
-  }
+  }, this->workers_);
 
   return output;
 
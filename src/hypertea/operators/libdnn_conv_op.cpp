@@ -10,6 +10,7 @@ namespace hypertea {
 
 template <typename DeviceTensor>
 DeviceTensor LibDNNConvOp<DeviceTensor>::operator()(DeviceTensor input) {
+  OperatorProfileScope profile_scope(this);
 
   const cl_mem input_data = input.immutable_data();
   DeviceTensor output(this->top_count_);
@@ -45,6 +46,7 @@ template TensorGPU<half> LibDNNConvOp<TensorGPU<half>>::operator()(TensorGPU<hal
 
 template <typename DeviceTensor>
 DeviceTensor LibDNNDeconvOp<DeviceTensor>::operator()(DeviceTensor input) {
+  OperatorProfileScope profile_scope(this);
 
   const cl_mem input_data = input.immutable_data();
   DeviceTensor output(this->top_count_);
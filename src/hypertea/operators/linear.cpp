@@ -3,8 +3,33 @@
 
 namespace hypertea {
 
+template<>
+void LinearOp<TensorCPU<float>>::prepare_packed_weight() {
+	packed_weight_ = std::make_shared<PackedMatrix>(weight_->immutable_data(), out_features_, in_features_);
+}
+
+
+// output^T = weight * input^T, read and written through strides.
+template<>
+TensorCPU<float> LinearOp<TensorCPU<float>>::operator()(TensorCPU<float> input) {
+	OperatorProfileScope profile_scope(this);
+
+	auto batch_size = input.count() / in_features_;
+
+	TensorCPU<float> output(batch_size * out_features_);
+
+	packed_gemm(*packed_weight_, batch_size,
+		input.immutable_data(), 1, in_features_,
+		bias_ ? bias_->immutable_data() : nullptr, 0,
+		output.mutable_data(), 1, out_features_);
+
+	return output;
+}
+
+
 template<typename DeviceTensor>
 DeviceTensor LinearOp<DeviceTensor>::operator()(DeviceTensor input) {
+	OperatorProfileScope profile_scope(this);
 
 	auto batch_size = input.count() / in_features_;
 
@@ -27,14 +52,35 @@ DeviceTensor LinearOp<DeviceTensor>::operator()(DeviceTensor input) {
 
 }
 
-DEFINE_FORWARD_FUNC(LinearOp);
+#ifdef USE_OPENCL
+template TensorGPU<float> LinearOp<TensorGPU<float>>::operator()(TensorGPU<float> input);
+template TensorGPU<half> LinearOp<TensorGPU<half>>::operator()(TensorGPU<half> input);
+#endif //USE_OPENCL
+
+
+
+
 
+template<>
+TensorCPU<float> EmbeddingOp<TensorCPU<float>>::operator()(std::vector<int> input) {
+	OperatorProfileScope profile_scope(this);
 
+	TensorCPU<float> output(input.size() * embedding_dim_);
 
+	for (int i = 0; i < input.size(); ++i) {
+		memcpy(output.mutable_data() + i * embedding_dim_,
+			weight_->immutable_data() + input[i] * embedding_dim_,
+			embedding_dim_ * sizeof(float));
+	}
+
+	return output;
+}
 
 
+#ifdef USE_OPENCL
 template<typename DeviceTensor>
 DeviceTensor EmbeddingOp<DeviceTensor>::operator()(std::vector<int> input) {
+	OperatorProfileScope profile_scope(this);
 
 
 	DeviceTensor output = DeviceTensor(input.size() * embedding_dim_);
@@ -44,7 +90,7 @@ DeviceTensor EmbeddingOp<DeviceTensor>::operator()(std::vector<int> input) {
 
 	for (int i = 0; i < input.size(); ++i) {
 
-		OPENCL_CHECK(clEnqueueCopyBuffer(OpenCLHandler::Get().commandQueue, 
+		OPENCL_CHECK(clEnqueueCopyBuffer(current_queue(), 
     		embedding_weight, 
     		output_data, 
     		output.type_size() * embedding_dim_ * input[i], output.type_size() * embedding_dim_ * i, 
@@ -57,9 +103,9 @@ DeviceTensor EmbeddingOp<DeviceTensor>::operator()(std::vector<int> input) {
 
 }
 
-template TensorCPU<float> EmbeddingOp<TensorCPU<float>>::operator()(std::vector<int> input);
 template TensorGPU<float> EmbeddingOp<TensorGPU<float>>::operator()(std::vector<int> input);
 template TensorGPU<half> EmbeddingOp<TensorGPU<half>>::operator()(std::vector<int> input);
+#endif //USE_OPENCL
 
 
 }  // namespace hypertea
@@ -1,70 +1,268 @@
+#include <functional>
 #include <vector>
 
 #include "hypertea/operators/rnn_op.hpp"
+#include "hypertea/util/opencl_fusion.hpp"
 
 namespace hypertea {
 
+template <>
+void RNNCell<TensorCPU<float>>::prepare_packed_weights() {
+
+    for (int g = 0; g < this->gates_; ++g) {
+        packed_ih_.emplace_back(this->weight_ih_.immutable_data() + g * this->hidden_dim_ * this->input_dim_,
+            this->hidden_dim_, this->input_dim_);
+        packed_hh_.emplace_back(this->weight_hh_.immutable_data() + g * this->hidden_dim_ * this->hidden_dim_,
+            this->hidden_dim_, this->hidden_dim_);
+    }
+}
+
+
+// On the CPU, gate g of (gates, rows, hidden_dim) is W_ih[g] * input^T + b_ih[g]
+// written transposed, one packed GEMM with the bias folded in.
+template <>
+TensorCPU<float> RNNCell<TensorCPU<float>>::input_gates(
+    TensorCPU<float>& input,
+    int length,
+    int batch
+) {
+
+    const int rows = length * batch;
+    const int hidden_dim = this->hidden_dim_;
+
+    TensorCPU<float> gates(this->gates_ * rows * hidden_dim);
+
+    for (int g = 0; g < this->gates_; ++g) {
+        packed_gemm(packed_ih_[g], rows,
+            input.immutable_data(), 1, this->input_dim_,
+            this->bias_ih_.immutable_data() + g * hidden_dim, 0,
+            gates.mutable_data() + g * rows * hidden_dim, 1, hidden_dim);
+    }
+
+    return gates;
+}
+
+
+template <>
+void RNNCell<TensorCPU<float>>::hidden_gates(
+    TensorCPU<float>& hidden,
+    int batch
+) {
+
+    const int hidden_dim = this->hidden_dim_;
+
+    if (this->intermediate_h.count() != batch * this->gates_ * hidden_dim) {
+        this->intermediate_h = TensorCPU<float>(batch * this->gates_ * hidden_dim);
+    }
+
+    for (int g = 0; g < this->gates_; ++g) {
+        packed_gemm(packed_hh_[g], batch,
+            hidden.immutable_data(), 1, hidden_dim,
+            this->bias_hh_.immutable_data() + g * hidden_dim, 0,
+            this->intermediate_h.mutable_data() + g * batch * hidden_dim, 1, hidden_dim);
+    }
+}
+
+
 template <typename DeviceTensor>
-void GRUCell<DeviceTensor>::Forward(
+DeviceTensor RNNCell<DeviceTensor>::input_gates(
     DeviceTensor& input,
+    int length,
+    int batch
+) {
+
+    const int rows = length * batch;
+    const int hidden_dim = this->hidden_dim_;
+
+    DeviceTensor gates(this->gates_ * rows * hidden_dim);
+    auto gate_tensors = gates.chunked_tensors(this->gates_);
+
+    for (int g = 0; g < this->gates_; ++g) {
+
+        auto weight = this->weight_ih_.sub_view(g * hidden_dim * this->input_dim_, hidden_dim * this->input_dim_);
+        auto bias = this->bias_ih_.sub_view(g * hidden_dim, hidden_dim);
+
+        inplace_gemm(CblasNoTrans, CblasTrans, rows, hidden_dim, this->input_dim_,
+            1, input, weight, 0, gate_tensors[g]);
+        inplace_channeled_add(gate_tensors[g], bias, hidden_dim, 1);
+    }
+
+    return gates;
+}
+
+
+template <typename DeviceTensor>
+std::vector<DeviceTensor> RNNCell<DeviceTensor>::step_gates(
+    DeviceTensor& input_gates,
+    int length,
+    int batch,
+    int step
+) {
+
+    const int step_count = batch * this->hidden_dim_;
+
+    std::vector<DeviceTensor> gates;
+    for (int g = 0; g < this->gates_; ++g) {
+        gates.push_back(input_gates.sub_view((g * length + step) * step_count, step_count));
+    }
+    return gates;
+}
+
+
+template <typename DeviceTensor>
+void RNNCell<DeviceTensor>::hidden_gates(
     DeviceTensor& hidden,
-    DeviceTensor& output
+    int batch
 ) {
 
-    
-    this->intermediate_i.copy_data(this->bias_ih_);
-    this->intermediate_h.copy_data(this->bias_hh_);
+    const int hidden_dim = this->hidden_dim_;
+    const int gate_dim = this->gates_ * hidden_dim;
 
-    inplace_gemv(CblasNoTrans, 3 * this->hidden_dim_,
-        this->input_dim_, 1, this->weight_ih_, input, 1, this->intermediate_i);
-    inplace_gemv(CblasNoTrans, 3 * this->hidden_dim_,
-        this->hidden_dim_, 1, this->weight_hh_, hidden, 1, this->intermediate_h);
+    if (this->intermediate_h.count() != batch * gate_dim) {
+        this->intermediate_h = DeviceTensor(batch * gate_dim);
+    }
 
-    auto igates = this->intermediate_i.chunked_tensors(3);
-    auto hgates = this->intermediate_h.chunked_tensors(3);
+    // A single sample is one gemv over all gates, (gates, 1, hidden_dim)
+    // being the same layout as (gates * hidden_dim).
+    if (batch == 1) {
+        this->intermediate_h.copy_data(this->bias_hh_);
+        inplace_gemv(CblasNoTrans, gate_dim,
+            hidden_dim, 1, this->weight_hh_, hidden, 1, this->intermediate_h);
+        return;
+    }
+
+    auto gate_tensors = this->intermediate_h.chunked_tensors(this->gates_);
+
+    for (int g = 0; g < this->gates_; ++g) {
+
+        auto weight = this->weight_hh_.sub_view(g * hidden_dim * hidden_dim, hidden_dim * hidden_dim);
+        auto bias = this->bias_hh_.sub_view(g * hidden_dim, hidden_dim);
+
+        inplace_gemm(CblasNoTrans, CblasTrans, batch, hidden_dim, hidden_dim,
+            1, hidden, weight, 0, gate_tensors[g]);
+        inplace_channeled_add(gate_tensors[g], bias, hidden_dim, 1);
+    }
+}
+
+
+
+// reset_gate = sigmoid(hgates[0] + igates[0])
+// input_gate = sigmoid(hgates[1] + igates[1])
+// new_gate = tanh(hgates[2] * reset_gate + igates[2])
+// hy = (hx - new_gate) * input_gate + new_gate
+template <typename DeviceTensor>
+static void gru_update(
+    std::vector<DeviceTensor>& hgates,
+    std::vector<DeviceTensor>& igates,
+    DeviceTensor& hidden,
+    DeviceTensor& output
+) {
 
     inplace_sigmoid(hgates[0] += igates[0]); //reset_gate
     inplace_sigmoid(hgates[1] += igates[1]); //input_gate
     inplace_tanh((hgates[2] *= hgates[0]) += igates[2]); //new_gate
 
-    ((hidden -= hgates[2]) *= hgates[1]) += hgates[2]; //hy = (hx - new_gate) * input_gate + new_gate
+    // A single pass on the CPU, see tensor_cpu_expression.hpp.
+    hidden.copy_data((lazy(hidden) - hgates[2]) * hgates[1] + hgates[2]);
 
     output.copy_data(hidden);
+}
+
 
+// cy = cx * forgetgate + ingate * cellgate
+// hy = tanh(cy) * outgate
+template <typename DeviceTensor>
+static void lstm_update(
+    std::vector<DeviceTensor>& gates,
+    std::vector<DeviceTensor>& igates,
+    std::vector<DeviceTensor>& hiddens,
+    DeviceTensor& output
+) {
+
+    DeviceTensor& ingate = inplace_sigmoid(gates[0] += igates[0]);
+    DeviceTensor& forgetgate = inplace_sigmoid(gates[1] += igates[1]);
+    DeviceTensor& cellgate = inplace_tanh(gates[2] += igates[2]);
+    DeviceTensor& outgate = inplace_sigmoid(gates[3] += igates[3]);
+
+    DeviceTensor& cy = (hiddens[1] *= forgetgate) += (ingate *= cellgate);
+    DeviceTensor& hy = inplace_tanh(hiddens[0].copy_data(cy)) *= outgate;
+
+    output.copy_data(hy);
+}
+
+
+#ifdef USE_OPENCL
+
+// On the device all of the gate math is one generated kernel instead of a
+// launch per operation, see opencl_fusion.hpp.
+template <typename Dtype>
+static void gru_update(
+    std::vector<TensorGPU<Dtype> >& hgates,
+    std::vector<TensorGPU<Dtype> >& igates,
+    TensorGPU<Dtype>& hidden,
+    TensorGPU<Dtype>& output
+) {
+
+    auto reset_gate = fused_sigmoid(fused(hgates[0]) + fused(igates[0]));
+    auto input_gate = fused_sigmoid(fused(hgates[1]) + fused(igates[1]));
+    auto new_gate = fused_tanh(fused(hgates[2]) * reset_gate + fused(igates[2]));
+    auto hy = (fused(hidden) - new_gate) * input_gate + new_gate;
+
+    fused_assign<Dtype>({{&hidden, hy}, {&output, hy}});
+}
+
+template <typename Dtype>
+static void lstm_update(
+    std::vector<TensorGPU<Dtype> >& gates,
+    std::vector<TensorGPU<Dtype> >& igates,
+    std::vector<TensorGPU<Dtype> >& hiddens,
+    TensorGPU<Dtype>& output
+) {
+
+    auto ingate = fused_sigmoid(fused(gates[0]) + fused(igates[0]));
+    auto forgetgate = fused_sigmoid(fused(gates[1]) + fused(igates[1]));
+    auto cellgate = fused_tanh(fused(gates[2]) + fused(igates[2]));
+    auto outgate = fused_sigmoid(fused(gates[3]) + fused(igates[3]));
+
+    auto cy = fused(hiddens[1]) * forgetgate + ingate * cellgate;
+    auto hy = fused_tanh(cy) * outgate;
+
+    fused_assign<Dtype>({{&hiddens[1], cy}, {&hiddens[0], hy}, {&output, hy}});
 }
 
+#endif //USE_OPENCL
 
 
 template <typename DeviceTensor>
-void LSTMCell<DeviceTensor>::Forward(
-    DeviceTensor& input,
+void GRUCell<DeviceTensor>::Forward(
+    std::vector<DeviceTensor>& igates,
     DeviceTensor& hidden,
     DeviceTensor& output
 ) {
 
+    this->hidden_gates(hidden, hidden.count() / this->hidden_dim_);
 
-    this->intermediate_i.copy_data(this->bias_ih_);
-    this->intermediate_h.copy_data(this->bias_hh_);
+    auto hgates = this->intermediate_h.chunked_tensors(3);
 
-    inplace_gemv(CblasNoTrans, 4 * this->hidden_dim_,
-        this->input_dim_, 1, this->weight_ih_, input, 1, this->intermediate_i);
-    inplace_gemv(CblasNoTrans, 4 * this->hidden_dim_,
-        this->hidden_dim_, 1, this->weight_hh_, hidden, 1, this->intermediate_h);
+    gru_update(hgates, igates, hidden, output);
+}
 
 
-    this->intermediate_i += this->intermediate_h;
 
-    auto gates = this->intermediate_i.chunked_tensors(4);
-    DeviceTensor& ingate = inplace_sigmoid(gates[0]);
-    DeviceTensor& forgetgate = inplace_sigmoid(gates[1]);
-    DeviceTensor& cellgate = inplace_tanh(gates[2]);
-    DeviceTensor& outgate = inplace_sigmoid(gates[3]);
+template <typename DeviceTensor>
+void LSTMCell<DeviceTensor>::Forward(
+    std::vector<DeviceTensor>& igates,
+    DeviceTensor& hidden,
+    DeviceTensor& output
+) {
 
     auto hiddens = hidden.chunked_tensors(2);
-    DeviceTensor& cy = (hiddens[1] *= forgetgate) += (ingate *= cellgate); //cy = cx * forgetgate + (ingate * cellgate)
-    DeviceTensor& hy = inplace_tanh(hiddens[0].copy_data(cy)) *= outgate; //hy = cy.tanh() * outgate
 
-    output.copy_data(hy);
+    this->hidden_gates(hiddens[0], hiddens[0].count() / this->hidden_dim_);
+
+    auto gates = this->intermediate_h.chunked_tensors(4);
+
+    lstm_update(gates, igates, hiddens, output);
 }
 
 
@@ -73,16 +271,20 @@ DeviceTensor UnidirectionalRNN<DeviceTensor>::Forward(
     DeviceTensor& input_tensor, 
     DeviceTensor& hidden_tensor) {
 
+    this->batch_size_ = hidden_tensor.count() / this->cell_->hidden_offset_();
+
     int input_length = input_tensor.count() / (this->batch_size_ * this->input_dim_);
     DeviceTensor output_tensor(this->batch_size_ * input_length * this->hidden_dim_);
 
-    auto input_tensors = input_tensor.chunked_tensors(input_length);
+    auto input_gates = this->cell_->input_gates(input_tensor, input_length, this->batch_size_);
     auto output_tensors = output_tensor.chunked_tensors(input_length);
 
     for (int i = 0; i < input_length; ++i) {
-        
+
+        auto gates = this->cell_->step_gates(input_gates, input_length, this->batch_size_, i);
+
         this->cell_->Forward(
-            input_tensors[i], 
+            gates, 
             hidden_tensor, 
             output_tensors[i]
         );
@@ -92,39 +294,81 @@ DeviceTensor UnidirectionalRNN<DeviceTensor>::Forward(
 
 }
 
+// The two directions share nothing but their input gates.
+template <typename DeviceTensor>
+static void run_directions(
+    DeviceTensor&,
+    const std::function<void()>& forward,
+    const std::function<void()>& reverse
+) {
+    forward();
+    reverse();
+}
+
+#ifdef USE_OPENCL
+
+// On the device each direction gets a queue of its own, see BranchGroup.
+template <typename Dtype>
+static void run_directions(
+    TensorGPU<Dtype>&,
+    const std::function<void()>& forward,
+    const std::function<void()>& reverse
+) {
+    BranchGroup directions;
+    directions.run(forward);
+    directions.run(reverse);
+}
+
+#endif //USE_OPENCL
+
+
 template <typename DeviceTensor>
 DeviceTensor BidirectionalRNN<DeviceTensor>::Forward(
     DeviceTensor& input_tensor, 
     DeviceTensor& hidden_tensor) {
 
+    this->batch_size_ = hidden_tensor.count() / (2 * this->cell_->hidden_offset_());
 
     int input_length = input_tensor.count() / (this->batch_size_ * this->input_dim_);
-    DeviceTensor output_tensor(2 * this->batch_size_ * input_length * this->hidden_dim_);
+    DeviceTensor forward_output(this->batch_size_ * input_length * this->hidden_dim_);
+    DeviceTensor reverse_output(this->batch_size_ * input_length * this->hidden_dim_);
+
+    auto input_gates = this->cell_->input_gates(input_tensor, input_length, this->batch_size_);
+    auto reverse_input_gates = this->reverse_cell_->input_gates(input_tensor, input_length, this->batch_size_);
 
-    auto input_tensors = input_tensor.chunked_tensors(input_length);
     auto hidden_tensors = hidden_tensor.chunked_tensors(2);
-    auto output_tensors = output_tensor.chunked_tensors(input_length * 2);
+    auto forward_outputs = forward_output.chunked_tensors(input_length);
+    auto reverse_outputs = reverse_output.chunked_tensors(input_length);
 
 
-    for (int i = 0; i < input_length; ++i) {
+    run_directions(hidden_tensor, [&]() {
 
-        this->cell_->Forward(
-            input_tensors[i], 
-            hidden_tensors[0], 
-            output_tensors[2*i]
-        );
-    }
+        for (int i = 0; i < input_length; ++i) {
 
-    for (int i = input_length - 1; i >= 0; --i) {
+            auto gates = this->cell_->step_gates(input_gates, input_length, this->batch_size_, i);
 
-        this->reverse_cell_->Forward(
-            input_tensors[i], 
-            hidden_tensors[1], 
-            output_tensors[2*i + 1]
-        );
-    }
+            this->cell_->Forward(
+                gates, 
+                hidden_tensors[0], 
+                forward_outputs[i]
+            );
+        }
+    }, [&]() {
 
-    return output_tensor;
+        for (int i = input_length - 1; i >= 0; --i) {
+
+            auto gates = this->reverse_cell_->step_gates(reverse_input_gates, input_length, this->batch_size_, i);
+
+            this->reverse_cell_->Forward(
+                gates, 
+                hidden_tensors[1], 
+                reverse_outputs[i]
+            );
+        }
+    });
+
+    // (length, batch, 2 * hidden_dim)
+    return hconcate(std::vector<DeviceTensor*> {&forward_output, &reverse_output}, input_length * this->batch_size_);
 
 
 }
@@ -134,7 +378,7 @@ DeviceTensor BidirectionalRNN<DeviceTensor>::Forward(
 template <typename DeviceTensor>
 DeviceTensor StackedRNN<DeviceTensor>::Forward(
     DeviceTensor &input_tensor, 
-    std::vector<DeviceTensor>& hidden_tensors) {
+    std::vector<DeviceTensor> hidden_tensors) {
 
     for (int i = 0; i < rnn_layers_.size(); ++i) {
         input_tensor = rnn_layers_[i]->Forward(input_tensor, hidden_tensors[i]);
@@ -148,20 +392,24 @@ DeviceTensor StackedRNN<DeviceTensor>::Forward(
 
 
 
-template void GRUCell<TensorCPU<float>>::Forward(TensorCPU<float>& input, TensorCPU<float>& hidden, TensorCPU<float>& output);
-template void LSTMCell<TensorCPU<float>>::Forward(TensorCPU<float>& input, TensorCPU<float>& hidden, TensorCPU<float>& output);
+template class RNNCell<TensorCPU<float>>;
+template void GRUCell<TensorCPU<float>>::Forward(std::vector<TensorCPU<float>>& input, TensorCPU<float>& hidden, TensorCPU<float>& output);
+template void LSTMCell<TensorCPU<float>>::Forward(std::vector<TensorCPU<float>>& input, TensorCPU<float>& hidden, TensorCPU<float>& output);
 template TensorCPU<float> UnidirectionalRNN<TensorCPU<float>>::Forward(TensorCPU<float>& input, TensorCPU<float>& hidden);
 template TensorCPU<float> BidirectionalRNN<TensorCPU<float>>::Forward(TensorCPU<float>& input, TensorCPU<float>& hidden);
-template TensorCPU<float> StackedRNN<TensorCPU<float>>::Forward(TensorCPU<float>& input, std::vector<TensorCPU<float>> &hidden);
+template TensorCPU<float> StackedRNN<TensorCPU<float>>::Forward(TensorCPU<float>& input, std::vector<TensorCPU<float>> hidden);
 
 
 
 #ifdef USE_OPENCL
-template void GRUCell<TensorGPU<float>>::Forward(TensorGPU<float>& input, TensorGPU<float>& hidden, TensorGPU<float>& output);
-template void GRUCell<TensorGPU<half>>::Forward(TensorGPU<half>& input, TensorGPU<half>& hidden, TensorGPU<half>& output);
+template class RNNCell<TensorGPU<float>>;
+template class RNNCell<TensorGPU<half>>;
+
+template void GRUCell<TensorGPU<float>>::Forward(std::vector<TensorGPU<float>>& input, TensorGPU<float>& hidden, TensorGPU<float>& output);
+template void GRUCell<TensorGPU<half>>::Forward(std::vector<TensorGPU<half>>& input, TensorGPU<half>& hidden, TensorGPU<half>& output);
 
-template void LSTMCell<TensorGPU<float>>::Forward(TensorGPU<float>& input, TensorGPU<float>& hidden, TensorGPU<float>& output);
-template void LSTMCell<TensorGPU<half>>::Forward(TensorGPU<half>& input, TensorGPU<half>& hidden, TensorGPU<half>& output);
+template void LSTMCell<TensorGPU<float>>::Forward(std::vector<TensorGPU<float>>& input, TensorGPU<float>& hidden, TensorGPU<float>& output);
+template void LSTMCell<TensorGPU<half>>::Forward(std::vector<TensorGPU<half>>& input, TensorGPU<half>& hidden, TensorGPU<half>& output);
 
 template TensorGPU<float> UnidirectionalRNN<TensorGPU<float>>::Forward(TensorGPU<float>& input, TensorGPU<float>& hidden);
 template TensorGPU<half> UnidirectionalRNN<TensorGPU<half>>::Forward(TensorGPU<half>& input, TensorGPU<half>& hidden);
@@ -169,8 +417,8 @@ template TensorGPU<half> UnidirectionalRNN<TensorGPU<half>>::Forward(TensorGPU<h
 template TensorGPU<float> BidirectionalRNN<TensorGPU<float>>::Forward(TensorGPU<float>& input, TensorGPU<float>& hidden);
 template TensorGPU<half> BidirectionalRNN<TensorGPU<half>>::Forward(TensorGPU<half>& input, TensorGPU<half>& hidden);
 
-template TensorGPU<float> StackedRNN<TensorGPU<float>>::Forward(TensorGPU<float>& input, std::vector<TensorGPU<float>> &hidden);
-template TensorGPU<half> StackedRNN<TensorGPU<half>>::Forward(TensorGPU<half>& input, std::vector<TensorGPU<half>> &hidden);
+template TensorGPU<float> StackedRNN<TensorGPU<float>>::Forward(TensorGPU<float>& input, std::vector<TensorGPU<float>> hidden);
+template TensorGPU<half> StackedRNN<TensorGPU<half>>::Forward(TensorGPU<half>& input, std::vector<TensorGPU<half>> hidden);
 #endif //USE_OPENCL
  
 
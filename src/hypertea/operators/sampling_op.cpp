@@ -6,6 +6,8 @@ namespace hypertea {
 
 template<typename DeviceTensor>
 DeviceTensor UpSampling2D<DeviceTensor>::operator()(DeviceTensor input) {
+	OperatorProfileScope profile_scope(this);
+
 	return upsampling_2d(input, scale_, height_, width_, height_* width_);
 }
 DEFINE_FORWARD_FUNC(UpSampling2D);
@@ -5,10 +5,13 @@ namespace hypertea {
 
 template<typename DeviceTensor>
 DeviceTensor ScaleOp<DeviceTensor>::operator()(DeviceTensor input) {
+  OperatorProfileScope profile_scope(this);
 
   DeviceTensor output = inplace_? input : input.duplicate();
 
-  if (bias_ != nullptr) {
+  if (weight_ == nullptr) {
+      inplace_channeled_add(output, *bias_, channels_, spatial_dim_);
+  } else if (bias_ != nullptr) {
       inplace_channeled_scaladd(output, *weight_, *bias_, channels_, spatial_dim_);
   } else {
       inplace_channeled_scal(output, *weight_, channels_, spatial_dim_);
@@ -1,13 +1,14 @@
 #include "hypertea/tensor.hpp"
+#include "hypertea/util/device_buffer_pool.hpp"
 
 namespace hypertea {
 
 
 template <typename Dtype>
 TensorCPU<Dtype>::TensorCPU(int count, Dtype value) {
-    data_.reset(new Dtype[count], std::default_delete<Dtype[]>() );
-    this->set(value);
+    data_ = std::static_pointer_cast<Dtype>(planned_host_memory(count * sizeof(Dtype)));
     this->count_ = count;
+    this->set(value);
 }
 template TensorCPU<float>::TensorCPU(int count, float value);
 
@@ -16,7 +17,7 @@ template TensorCPU<float>::TensorCPU(int count, float value);
 
 template <typename Dtype>
 TensorCPU<Dtype>::TensorCPU(std::vector<Dtype> data) {
-    data_.reset(new Dtype[data.size()], std::default_delete<Dtype[]>() );
+    data_ = std::static_pointer_cast<Dtype>(planned_host_memory(data.size() * sizeof(Dtype)));
     memcpy(data_.get(), data.data(), data.size() * sizeof(Dtype));
     this->count_ = data.size();
 } 
@@ -37,6 +38,14 @@ TensorCPU<Dtype>::TensorCPU(Dtype* data_ptr, int count, bool shared) {
 template TensorCPU<float>::TensorCPU(float* data_ptr, int count, bool shared);
 
 
+template <typename Dtype>
+TensorCPU<Dtype>::TensorCPU(std::shared_ptr<Dtype> data, int count) {
+    data_ = data;
+    this->count_ = count;
+}
+template TensorCPU<float>::TensorCPU(std::shared_ptr<float> data, int count);
+
+
 
 template <typename Dtype>
 TensorCPU<Dtype>& TensorCPU<Dtype>::copy_data(const TensorCPU & other) {
@@ -139,16 +148,9 @@ template TensorCPU<float> TensorCPU<float>::transpose_hw(int old_last_dim, int n
 template <typename Dtype>
 TensorGPU<Dtype>::TensorGPU(int count, Dtype value) {
 
-  data_.reset(
-    (void*)clCreateBuffer(OpenCLHandler::Get().context, 
-      CL_MEM_READ_WRITE,
-      count * sizeof(Dtype), 
-      NULL, NULL
-    ), 
-    [=](void *ptr){clReleaseMemObject((cl_mem) ptr);}
-  );
-  this->set(value);
+  data_ = planned_device_memory(count * sizeof(Dtype));
   this->count_ = count;
+  this->set(value);
 }
 template TensorGPU<float>::TensorGPU(int count, float value);
 template TensorGPU<half>::TensorGPU(int count, half value);
@@ -173,26 +175,54 @@ template TensorGPU<half>::TensorGPU(cl_mem data_ptr, int count, bool shared);
 template <typename Dtype>
 TensorGPU<Dtype>::TensorGPU(std::vector<Dtype> data) {
   
-  data_.reset(
-    (void*)clCreateBuffer(
-      OpenCLHandler::Get().context, 
-      CL_MEM_COPY_HOST_PTR|CL_MEM_READ_WRITE,  
-      data.size() * sizeof(Dtype),
-      data.data(),
-      NULL
-    ), 
-    [=](void *ptr){clReleaseMemObject((cl_mem) ptr);}
-  );
+  data_ = DeviceBufferPool::Get().allocate(data.size() * sizeof(Dtype));
   this->count_ = data.size();
+  copy_from_ptr(data.data());
 }
 template TensorGPU<float>::TensorGPU(std::vector<float> data);
 template TensorGPU<half>::TensorGPU(std::vector<half> data);
 
 
+template <typename Dtype>
+TransferEvent TensorGPU<Dtype>::copy_to_ptr_async(void* ptr) const {
+  cl_event event;
+  OPENCL_CHECK(clEnqueueReadBuffer(current_queue(), mutable_data(), CL_FALSE,
+    0, this->count_ * sizeof(Dtype), ptr, 0, nullptr, &event));
+  return TransferEvent(event);
+}
+template TransferEvent TensorGPU<float>::copy_to_ptr_async(void* ptr) const;
+template TransferEvent TensorGPU<half>::copy_to_ptr_async(void* ptr) const;
+
+
+template <typename Dtype>
+TransferEvent TensorGPU<Dtype>::copy_from_ptr_async(const void* ptr) const {
+  cl_event event;
+  OPENCL_CHECK(clEnqueueWriteBuffer(current_queue(), mutable_data(), CL_FALSE,
+    0, this->count_ * sizeof(Dtype), ptr, 0, nullptr, &event));
+  return TransferEvent(event);
+}
+template TransferEvent TensorGPU<float>::copy_from_ptr_async(const void* ptr) const;
+template TransferEvent TensorGPU<half>::copy_from_ptr_async(const void* ptr) const;
+
+
+template <typename Dtype>
+PendingHostData<Dtype> TensorGPU<Dtype>::cpu_data_async() const {
+  auto host = pinned_host_memory(this->count_ * sizeof(Dtype));
+  auto done = copy_to_ptr_async(host.get());
+  OPENCL_CHECK(clFlush(current_queue()));
+  // Dropped before done, the block must not go back to the pinned pool
+  // while the read still writes it.
+  std::shared_ptr<void> data(host.get(), [host, done](void*) { done.wait(); });
+  return PendingHostData<Dtype>(data, done);
+}
+template PendingHostData<float> TensorGPU<float>::cpu_data_async() const;
+template PendingHostData<half> TensorGPU<half>::cpu_data_async() const;
+
+
 template <typename Dtype>
 TensorGPU<Dtype>& TensorGPU<Dtype>::copy_data(const TensorGPU & other) {
 
-  OPENCL_CHECK(clEnqueueCopyBuffer(OpenCLHandler::Get().commandQueue, 
+  OPENCL_CHECK(clEnqueueCopyBuffer(current_queue(), 
     (cl_mem) other.immutable_data(), 
     (cl_mem) this->mutable_data(), 
     0, 0, sizeof(Dtype) * this->count(), 0, NULL, NULL));
@@ -219,11 +249,10 @@ template TensorGPU<half> TensorGPU<half>::duplicate() const;
 
 template <typename Dtype>
 TensorGPU<Dtype> TensorGPU<Dtype>::sub_view(unsigned int offset, unsigned int size, cl_mem_flags flags) {
-  cl_int ret;
-  cl_buffer_region region{offset * sizeof(Dtype), size * sizeof(Dtype)};
-  auto temp = clCreateSubBuffer((cl_mem)data_.get(), flags, CL_BUFFER_CREATE_TYPE_REGION, &region, &ret); 
-  OPENCL_CHECK(ret);
-  return TensorGPU<Dtype>(temp, size, false);
+  return TensorGPU<Dtype>(
+    DeviceBufferPool::Get().sub_buffer(data_, offset * sizeof(Dtype), size * sizeof(Dtype), flags),
+    size
+  );
 }
 template TensorGPU<float> TensorGPU<float>::sub_view(unsigned int offset, unsigned int size, cl_mem_flags flags);
 template TensorGPU<half> TensorGPU<half>::sub_view(unsigned int offset, unsigned int size, cl_mem_flags flags);
@@ -238,24 +267,17 @@ std::vector<TensorGPU<Dtype> > TensorGPU<Dtype>::chunked_tensors(int chunck_num,
   size_t chunck_size = chunck_count * sizeof(Dtype);
 
 
-  cl_int ret;
-  cl_buffer_region region{0, chunck_size};
-
   std::vector<TensorGPU<Dtype> > tensors;
   for (int i = 0; i < chunck_num; ++i) {
     tensors.push_back(
       TensorGPU<Dtype>(
-        clCreateSubBuffer((cl_mem)data_.get(), flags, CL_BUFFER_CREATE_TYPE_REGION, &region, &ret),
-        chunck_count,
-        false
+        DeviceBufferPool::Get().sub_buffer(data_, i * chunck_size, chunck_size, flags),
+        chunck_count
       )
     );
-        OPENCL_CHECK(ret);
-        region.origin += chunck_size;
-
   }
 
-      return tensors;
+  return tensors;
 }
 
 template std::vector<TensorGPU<float> > TensorGPU<float>::chunked_tensors(int chunck_num, cl_mem_flags flags);
@@ -304,7 +326,7 @@ template TensorGPU<half> TensorGPU<half>::transpose_hw(int old_last_dim, int new
 template <typename Dtype>
 std::shared_ptr<Dtype> TensorGPU<Dtype>::debug_gtest_cpu_data() const {
   auto cpu_data = std::shared_ptr<Dtype>(new Dtype[this->count_], std::default_delete<Dtype[]>());
-  OPENCL_CHECK(clEnqueueReadBuffer(OpenCLHandler::Get().commandQueue, (cl_mem)data_.get(), CL_TRUE, 0, sizeof(Dtype) * this->count_, cpu_data.get(), 0, NULL, NULL));
+  OPENCL_CHECK(clEnqueueReadBuffer(current_queue(), (cl_mem)data_.get(), CL_TRUE, 0, sizeof(Dtype) * this->count_, cpu_data.get(), 0, NULL, NULL));
   return cpu_data;
 }
 
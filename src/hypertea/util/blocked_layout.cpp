@@ -0,0 +1,446 @@
+#include <string.h>
+#include <algorithm>
+
+#include "hypertea/util/blocked_layout.hpp"
+#include "hypertea/util/cpu_simd_math.hpp"
+
+#if defined(__GNUC__) || defined(__clang__)
+#define HYPERTEA_SIMD_VECTOR
+#endif
+
+#if defined(HYPERTEA_SIMD_VECTOR) && (defined(__x86_64__) || defined(__i386__))
+#define HYPERTEA_SIMD_X86
+#endif
+
+namespace hypertea {
+
+
+int nchwc_block() {
+#ifdef HYPERTEA_SIMD_X86
+  static const int block = (__builtin_cpu_init(), __builtin_cpu_supports("avx512f")) ? 16 : 8;
+  return block;
+#else
+  return 8;
+#endif
+}
+
+
+void reorder_to_blocked(const TensorCPU<float>& x, TensorCPU<float>& y,
+    int num, int channels, int spatial_dim, int block) {
+
+  const int channel_blocks = blocked_channels(channels, block) / block;
+
+  auto x_data = x.immutable_data();
+  auto y_data = y.mutable_data();
+
+  for_each_channel_row(num, channel_blocks, spatial_dim * block, [&](int r, int cb) {
+
+    const int n = r / channel_blocks;
+    const int lanes = std::min(block, channels - cb * block);
+
+    const float* src = x_data + (n * channels + cb * block) * spatial_dim;
+    float* dst = y_data + r * spatial_dim * block;
+
+    for (int s = 0; s < spatial_dim; ++s) {
+      int l = 0;
+      for (; l < lanes; ++l) { dst[s * block + l] = src[l * spatial_dim + s]; }
+      for (; l < block; ++l) { dst[s * block + l] = 0; }
+    }
+  });
+}
+
+
+void reorder_from_blocked(const TensorCPU<float>& x, TensorCPU<float>& y,
+    int num, int channels, int spatial_dim, int block) {
+
+  const int channel_blocks = blocked_channels(channels, block) / block;
+
+  auto x_data = x.immutable_data();
+  auto y_data = y.mutable_data();
+
+  for_each_channel_row(num, channel_blocks, spatial_dim * block, [&](int r, int cb) {
+
+    const int n = r / channel_blocks;
+    const int lanes = std::min(block, channels - cb * block);
+
+    const float* src = x_data + r * spatial_dim * block;
+    float* dst = y_data + (n * channels + cb * block) * spatial_dim;
+
+    for (int l = 0; l < lanes; ++l) {
+      for (int s = 0; s < spatial_dim; ++s) { dst[l * spatial_dim + s] = src[s * block + l]; }
+    }
+  });
+}
+
+
+TensorCPU<float> blocked_channel_vector(const float* x, int channels, int block) {
+
+  TensorCPU<float> y(blocked_channels(channels, block), 0);
+  memcpy(y.mutable_data(), x, channels * sizeof(float));
+  return y;
+}
+
+
+TensorCPU<float> blocked_conv_weight(const float* weight,
+    int out_channels, int in_channels, int kernel_h, int kernel_w, int block) {
+
+  const int out_blocks = blocked_channels(out_channels, block) / block;
+  const int in_blocks = blocked_channels(in_channels, block) / block;
+  const int kernel_dim = kernel_h * kernel_w;
+
+  TensorCPU<float> y(out_blocks * in_blocks * kernel_dim * block * block, 0);
+  auto y_data = y.mutable_data();
+
+  for (int o = 0; o < out_channels; ++o) {
+    for (int i = 0; i < in_channels; ++i) {
+      for (int k = 0; k < kernel_dim; ++k) {
+        const int dst = (((o / block * in_blocks + i / block) * kernel_dim + k) * block + i % block) * block + o % block;
+        y_data[dst] = weight[(o * in_channels + i) * kernel_dim + k];
+      }
+    }
+  }
+
+  return y;
+}
+
+
+void blocked_scale_bias_activation(float* data, int pixels, int block,
+    const float* scale, const float* bias,
+    ACTIVATION_TYPE activation, float alpha, const float* slope) {
+
+  if (scale != nullptr || bias != nullptr) {
+    for (int p = 0; p < pixels; ++p) {
+      float* v = data + p * block;
+      for (int l = 0; l < block; ++l) {
+        v[l] = v[l] * (scale ? scale[l] : 1.f) + (bias ? bias[l] : 0.f);
+      }
+    }
+  }
+
+  switch (activation) {
+    case ACTIVATION_TYPE::NONE:
+      break;
+    case ACTIVATION_TYPE::RELU:
+    case ACTIVATION_TYPE::PRELU:
+      for (int p = 0; p < pixels; ++p) {
+        float* v = data + p * block;
+        for (int l = 0; l < block; ++l) {
+          const float a = activation == ACTIVATION_TYPE::PRELU ? slope[l] : alpha;
+          v[l] = v[l] > 0 ? v[l] : v[l] * a;
+        }
+      }
+      break;
+    case ACTIVATION_TYPE::ELU:
+      simd_elu(pixels * block, alpha, data);
+      break;
+    case ACTIVATION_TYPE::TANH:
+      simd_tanh(pixels * block, data);
+      break;
+  }
+}
+
+
+struct BlockedConvArgs {
+  const float* weight;
+  const float* bias;
+  int in_blocks;
+  int height, width;
+  int kernel_h, kernel_w;
+  int pad_h, pad_w;
+  int stride_h, stride_w;
+  int dilation_h, dilation_w;
+  int output_h, output_w;
+  // Output columns [ow_lo, ow_hi) read no padding.
+  int ow_lo, ow_hi;
+  ACTIVATION_TYPE activation;
+  float alpha;
+  const float* slope;
+};
+
+
+#ifdef HYPERTEA_SIMD_VECTOR
+
+#pragma GCC diagnostic ignored "-Wpsabi"
+
+#define SIMD_INLINE inline __attribute__((always_inline))
+
+typedef float v8sf __attribute__((vector_size(32)));
+typedef float v16sf __attribute__((vector_size(64)));
+
+
+// RW neighbouring output pixels of one row, block output channels each.
+// BORDER tiles (RW == 1) skip the taps that fall into the padding.
+template <typename V, int RW, bool BORDER>
+SIMD_INLINE void blocked_conv_tile(const BlockedConvArgs& g,
+    const float* x, const float* w, const float* bias, int oh, int ow, float* y) {
+
+  const int B = sizeof(V) / sizeof(float);
+
+  V acc[RW];
+  V b = {};
+  if (bias != nullptr) { memcpy(&b, bias, sizeof(V)); }
+  for (int r = 0; r < RW; ++r) { acc[r] = b; }
+
+  const int step = g.stride_w * B;
+
+  for (int icb = 0; icb < g.in_blocks; ++icb) {
+    for (int kh = 0; kh < g.kernel_h; ++kh) {
+
+      const int ih = oh * g.stride_h - g.pad_h + kh * g.dilation_h;
+      if ((unsigned)ih >= (unsigned)g.height) { continue; }
+
+      const float* x_row = x + (icb * g.height + ih) * g.width * B;
+
+      for (int kw = 0; kw < g.kernel_w; ++kw) {
+
+        const int iw = ow * g.stride_w - g.pad_w + kw * g.dilation_w;
+        if (BORDER && (unsigned)iw >= (unsigned)g.width) { continue; }
+
+        const float* xp = x_row + iw * B;
+        const float* wk = w + ((icb * g.kernel_h + kh) * g.kernel_w + kw) * B * B;
+
+        for (int ic = 0; ic < B; ++ic) {
+          V wv;
+          memcpy(&wv, wk + ic * B, sizeof(V));
+          for (int r = 0; r < RW; ++r) {
+            acc[r] += wv * xp[r * step + ic];
+          }
+        }
+      }
+    }
+  }
+
+  for (int r = 0; r < RW; ++r) {
+    memcpy(y + (oh * g.output_w + ow + r) * B, &acc[r], sizeof(V));
+  }
+}
+
+
+// Interior remainder of fewer than RW pixels in one tile.
+template <typename V, int RW>
+SIMD_INLINE void blocked_conv_tail(const int pixels, const BlockedConvArgs& g,
+    const float* x, const float* w, const float* bias, int oh, int ow, float* y) {
+  if (pixels == RW) {
+    blocked_conv_tile<V, RW, false>(g, x, w, bias, oh, ow, y);
+  } else {
+    blocked_conv_tail<V, RW - 1>(pixels, g, x, w, bias, oh, ow, y);
+  }
+}
+
+template <>
+SIMD_INLINE void blocked_conv_tail<v8sf, 0>(const int, const BlockedConvArgs&,
+    const float*, const float*, const float*, int, int, float*) {}
+
+template <>
+SIMD_INLINE void blocked_conv_tail<v16sf, 0>(const int, const BlockedConvArgs&,
+    const float*, const float*, const float*, int, int, float*) {}
+
+
+// One (image, output channel block) plane: padded border columns one pixel
+// at a time, the interior RW pixels at a time.
+template <typename V>
+SIMD_INLINE void blocked_conv_plane(const BlockedConvArgs& g,
+    const float* x, const float* w, const float* bias, const float* slope, float* y) {
+
+  const int B = sizeof(V) / sizeof(float);
+  const int RW = 6;
+
+  for (int oh = 0; oh < g.output_h; ++oh) {
+
+    int ow = 0;
+    for (; ow < g.ow_lo; ++ow) {
+      blocked_conv_tile<V, 1, true>(g, x, w, bias, oh, ow, y);
+    }
+    for (; ow + RW <= g.ow_hi; ow += RW) {
+      blocked_conv_tile<V, RW, false>(g, x, w, bias, oh, ow, y);
+    }
+    if (ow < g.ow_hi) {
+      blocked_conv_tail<V, RW - 1>(g.ow_hi - ow, g, x, w, bias, oh, ow, y);
+      ow = g.ow_hi;
+    }
+    for (; ow < g.output_w; ++ow) {
+      blocked_conv_tile<V, 1, true>(g, x, w, bias, oh, ow, y);
+    }
+
+    blocked_scale_bias_activation(y + oh * g.output_w * B, g.output_w, B,
+      nullptr, nullptr, g.activation, g.alpha, slope);
+  }
+}
+
+
+#define DEFINE_BLOCKED_CONV_KERNEL(suffix, V, attribute) \
+  attribute void blocked_conv_##suffix(const BlockedConvArgs& g, const float* x, \
+      const float* w, const float* bias, const float* slope, float* y) { \
+    blocked_conv_plane<V>(g, x, w, bias, slope, y); \
+  }
+
+DEFINE_BLOCKED_CONV_KERNEL(block8, v8sf, static)
+DEFINE_BLOCKED_CONV_KERNEL(block16, v16sf, static)
+
+#ifdef HYPERTEA_SIMD_X86
+DEFINE_BLOCKED_CONV_KERNEL(avx2, v8sf, static __attribute__((target("avx2,fma"))))
+DEFINE_BLOCKED_CONV_KERNEL(avx512, v16sf, static __attribute__((target("avx512f"))))
+#endif //HYPERTEA_SIMD_X86
+
+#else  // scalar fallback
+
+static void blocked_conv_scalar(const BlockedConvArgs& g, const float* x,
+    const float* w, const float* bias, const float* slope, float* y, int B) {
+
+  for (int oh = 0; oh < g.output_h; ++oh) {
+    for (int ow = 0; ow < g.output_w; ++ow) {
+      float* out = y + (oh * g.output_w + ow) * B;
+      for (int oc = 0; oc < B; ++oc) { out[oc] = bias ? bias[oc] : 0.f; }
+
+      for (int icb = 0; icb < g.in_blocks; ++icb) {
+        for (int kh = 0; kh < g.kernel_h; ++kh) {
+          const int ih = oh * g.stride_h - g.pad_h + kh * g.dilation_h;
+          if ((unsigned)ih >= (unsigned)g.height) { continue; }
+          for (int kw = 0; kw < g.kernel_w; ++kw) {
+            const int iw = ow * g.stride_w - g.pad_w + kw * g.dilation_w;
+            if ((unsigned)iw >= (unsigned)g.width) { continue; }
+            const float* xp = x + ((icb * g.height + ih) * g.width + iw) * B;
+            const float* wk = w + ((icb * g.kernel_h + kh) * g.kernel_w + kw) * B * B;
+            for (int ic = 0; ic < B; ++ic) {
+              for (int oc = 0; oc < B; ++oc) { out[oc] += wk[ic * B + oc] * xp[ic]; }
+            }
+          }
+        }
+      }
+    }
+    blocked_scale_bias_activation(y + oh * g.output_w * B, g.output_w, B,
+      nullptr, nullptr, g.activation, g.alpha, slope);
+  }
+}
+
+static void blocked_conv_block8(const BlockedConvArgs& g, const float* x,
+    const float* w, const float* bias, const float* slope, float* y) {
+  blocked_conv_scalar(g, x, w, bias, slope, y, 8);
+}
+
+static void blocked_conv_block16(const BlockedConvArgs& g, const float* x,
+    const float* w, const float* bias, const float* slope, float* y) {
+  blocked_conv_scalar(g, x, w, bias, slope, y, 16);
+}
+
+#endif //HYPERTEA_SIMD_VECTOR
+
+
+typedef void (*blocked_conv_kernel)(const BlockedConvArgs& g, const float* x,
+    const float* w, const float* bias, const float* slope, float* y);
+
+static blocked_conv_kernel select_blocked_conv_kernel(int block) {
+
+#ifdef HYPERTEA_SIMD_X86
+  __builtin_cpu_init();
+  if (block == 16 && __builtin_cpu_supports("avx512f")) {
+    return blocked_conv_avx512;
+  }
+  if (block == 8 && __builtin_cpu_supports("avx2") && __builtin_cpu_supports("fma")) {
+    return blocked_conv_avx2;
+  }
+#endif //HYPERTEA_SIMD_X86
+
+  return block == 16 ? blocked_conv_block16 : blocked_conv_block8;
+}
+
+
+void blocked_conv2d(const TensorCPU<float>& x, int num,
+    int in_channels, int height, int width,
+    const TensorCPU<float>& weight, int out_channels,
+    int kernel_h, int kernel_w, int pad_h, int pad_w,
+    int stride_h, int stride_w, int dilation_h, int dilation_w,
+    int output_h, int output_w, TensorCPU<float>& y, int block,
+    const float* bias, ACTIVATION_TYPE activation, float alpha, const float* slope) {
+
+  if (block != 8 && block != 16) {
+    LOG(ERROR) << "NCHWc block must be 8 or 16, got " << block;
+    return;
+  }
+
+  static const blocked_conv_kernel kernel8 = select_blocked_conv_kernel(8);
+  static const blocked_conv_kernel kernel16 = select_blocked_conv_kernel(16);
+  const blocked_conv_kernel kernel = block == 16 ? kernel16 : kernel8;
+
+  BlockedConvArgs g;
+  g.weight = weight.immutable_data();
+  g.bias = bias;
+  g.in_blocks = blocked_channels(in_channels, block) / block;
+  g.height = height;
+  g.width = width;
+  g.kernel_h = kernel_h;
+  g.kernel_w = kernel_w;
+  g.pad_h = pad_h;
+  g.pad_w = pad_w;
+  g.stride_h = stride_h;
+  g.stride_w = stride_w;
+  g.dilation_h = dilation_h;
+  g.dilation_w = dilation_w;
+  g.output_h = output_h;
+  g.output_w = output_w;
+  g.activation = activation;
+  g.alpha = alpha;
+  g.slope = slope;
+
+  g.ow_lo = std::min(output_w, (pad_w + stride_w - 1) / stride_w);
+  const int last = width - 1 + pad_w - (kernel_w - 1) * dilation_w;
+  g.ow_hi = last < 0 ? g.ow_lo : std::max(g.ow_lo, std::min(output_w, last / stride_w + 1));
+
+  const int out_blocks = blocked_channels(out_channels, block) / block;
+  const int in_image = g.in_blocks * height * width * block;
+  const int out_plane = output_h * output_w * block;
+  const int weight_block = g.in_blocks * kernel_h * kernel_w * block * block;
+
+  auto x_data = x.immutable_data();
+  auto y_data = y.mutable_data();
+
+  for_each_channel_row(num, out_blocks, out_plane, [&](int r, int ocb) {
+    kernel(g, x_data + r / out_blocks * in_image,
+      g.weight + ocb * weight_block,
+      bias ? bias + ocb * block : nullptr,
+      slope ? slope + ocb * block : nullptr,
+      y_data + r * out_plane);
+  });
+}
+
+
+TensorCPU<float> blocked_upsampling_2d(const TensorCPU<float>& x,
+    int scale, int height, int width, int block) {
+
+  const int planes = x.count() / (height * width * block);
+
+  TensorCPU<float> y(x.count() * scale * scale);
+
+  auto x_data = x.immutable_data();
+  auto y_data = y.mutable_data();
+
+  const int out_width = width * scale;
+
+  for_each_channel_row(planes, 1, height * width * block * scale * scale, [&](int p, int) {
+
+    const float* src = x_data + p * height * width * block;
+    float* dst = y_data + p * height * width * block * scale * scale;
+
+    for (int i = 0; i < height; ++i) {
+      float* row = dst + i * scale * out_width * block;
+
+      for (int j = 0; j < width; ++j) {
+        for (int js = 0; js < scale; ++js) {
+          memcpy(row + (j * scale + js) * block, src + (i * width + j) * block, block * sizeof(float));
+        }
+      }
+      for (int is = 1; is < scale; ++is) {
+        memcpy(row + is * out_width * block, row, out_width * block * sizeof(float));
+      }
+    }
+  });
+
+  return y;
+}
+
+
+TensorCPU<float> blocked_concate(std::vector<TensorCPU<float>* > xs, int num) {
+  return hconcate(xs, num);
+}
+
+}  // namespace hypertea
@@ -0,0 +1,306 @@
+#include <math.h>
+#include <string.h>
+#include <climits>
+#include <limits>
+
+#include "hypertea/util/cpu_simd_math.hpp"
+
+#if defined(__GNUC__) || defined(__clang__)
+#define HYPERTEA_SIMD_VECTOR
+#endif
+
+#if defined(HYPERTEA_SIMD_VECTOR) && (defined(__x86_64__) || defined(__i386__))
+#define HYPERTEA_SIMD_X86
+#endif
+
+namespace hypertea {
+
+
+#ifdef HYPERTEA_SIMD_VECTOR
+
+// The vector helpers are always inlined, so the ABI notes about passing
+// AVX vectors by value do not apply.
+#pragma GCC diagnostic ignored "-Wpsabi"
+
+// The kernels are written once on GCC/Clang vector extensions and inlined
+// into per-ISA entry points, so each copy is compiled for that ISA only.
+
+#define SIMD_INLINE inline __attribute__((always_inline))
+
+typedef float v4sf __attribute__((vector_size(16)));
+typedef int v4si __attribute__((vector_size(16)));
+typedef float v8sf __attribute__((vector_size(32)));
+typedef int v8si __attribute__((vector_size(32)));
+typedef float v16sf __attribute__((vector_size(64)));
+typedef int v16si __attribute__((vector_size(64)));
+
+template <typename V> struct SimdInt;
+template <> struct SimdInt<v4sf> { typedef v4si type; };
+template <> struct SimdInt<v8sf> { typedef v8si type; };
+template <> struct SimdInt<v16sf> { typedef v16si type; };
+
+
+template <typename V>
+SIMD_INLINE V splat(float c) {
+  V v = {};
+  return v + c;
+}
+
+template <typename V, typename IV>
+SIMD_INLINE V select(const IV& mask, const V& a, const V& b) {
+  return (V)((mask & (IV)a) | (~mask & (IV)b));
+}
+
+
+// exp(x) = 2^n * exp(r), r = x - n * ln2 in [-ln2 / 2, ln2 / 2]. The scale
+// is applied in two steps so that n = 128 (x close to ln(FLT_MAX)) and
+// n = -126 are both representable. With MINUS_ONE, exp(x) - 1 is returned
+// and exp(r) - 1 is used directly for n = 0, which avoids the cancellation
+// around 0 (ELU).
+template <typename V, bool MINUS_ONE>
+SIMD_INLINE V vexp_impl(const V& x) {
+
+  typedef typename SimdInt<V>::type IV;
+
+  const float hi = 88.72283905206835f;
+  const float lo = -87.33654475055310f;
+  const float magic = 12582912.f;  // 1.5 * 2^23, rounds to nearest integer
+
+  IV too_large = x > hi;
+  IV too_small = x < lo;
+
+  V xc = select(too_large, splat<V>(hi), x);
+  xc = select(too_small, splat<V>(lo), xc);
+
+  V t = xc * 1.44269504088896341f + magic;
+  V n = t - magic;
+  IV ni = (IV)t - (IV)splat<V>(magic);
+
+  V r = xc - n * 0.693359375f;
+  r = r + n * 2.12194440e-4f;
+
+  V z = r * r;
+  V p = splat<V>(1.9875691500E-4f);
+  p = p * r + 1.3981999507E-3f;
+  p = p * r + 8.3334519073E-3f;
+  p = p * r + 4.1665795894E-2f;
+  p = p * r + 1.6666665459E-1f;
+  p = p * r + 5.0000001201E-1f;
+  V q = p * z + r;
+
+  IV d = (ni > 0) & 1;
+  V scale1 = (V)((ni - d + 127) << 23);
+  V scale2 = (V)((d + 127) << 23);
+
+  V result = (q + 1.f) * scale1 * scale2;
+  if (MINUS_ONE) {
+    result = select(ni == 0, q, result - 1.f);
+  }
+  result = select(too_large, splat<V>(std::numeric_limits<float>::infinity()), result);
+  result = select(too_small, splat<V>(MINUS_ONE ? -1.f : 0.f), result);
+
+  return result;
+}
+
+template <typename V>
+SIMD_INLINE V vexp(const V& x) { return vexp_impl<V, false>(x); }
+
+template <typename V>
+SIMD_INLINE V vexpm1(const V& x) { return vexp_impl<V, true>(x); }
+
+
+// log(x) = e * ln2 + log(m), m in [sqrt(0.5), sqrt(2)).
+template <typename V>
+SIMD_INLINE V vlog(const V& x) {
+
+  typedef typename SimdInt<V>::type IV;
+
+  IV bits = (IV)x;
+  IV e = ((bits >> 23) & 0xff) - 126;
+  V m = (V)((bits & 0x007fffff) | 0x3f000000);
+
+  IV small = m < 0.707106781186547524f;
+  e = e + small;
+  V a = m - 1.f;
+  V f = a + select(small, m, splat<V>(0.f));
+
+  V ef = (V)(e + 0x4b400000) - 12582912.f;
+
+  V z = f * f;
+  V y = splat<V>(7.0376836292E-2f);
+  y = y * f - 1.1514610310E-1f;
+  y = y * f + 1.1676998740E-1f;
+  y = y * f - 1.2420140846E-1f;
+  y = y * f + 1.4249322787E-1f;
+  y = y * f - 1.6668057665E-1f;
+  y = y * f + 2.0000714765E-1f;
+  y = y * f - 2.4999993993E-1f;
+  y = y * f + 3.3333331174E-1f;
+  y = y * f * z;
+
+  y = y - ef * 2.12194440e-4f;
+  y = y - z * 0.5f;
+
+  V result = f + y + ef * 0.693359375f;
+
+  result = select((IV)(x == std::numeric_limits<float>::infinity()), x, result);
+  result = select((IV)(x < 0.f), splat<V>(std::numeric_limits<float>::quiet_NaN()), result);
+  result = select((IV)(x == 0.f), splat<V>(-std::numeric_limits<float>::infinity()), result);
+  result = select((IV)(x != x), x, result);
+
+  return result;
+}
+
+
+// Odd polynomial below 0.625, 1 - 2 / (exp(2|x|) + 1) above.
+template <typename V>
+SIMD_INLINE V vtanh(const V& x) {
+
+  typedef typename SimdInt<V>::type IV;
+
+  IV sign = (IV)x & INT_MIN;
+  V ax = (V)((IV)x & INT_MAX);
+
+  V z = x * x;
+  V p = splat<V>(-5.70498872745E-3f);
+  p = p * z + 2.06390887954E-2f;
+  p = p * z - 5.37397155531E-2f;
+  p = p * z + 1.33314422036E-1f;
+  p = p * z - 3.33332819422E-1f;
+  V small = p * z * x + x;
+
+  // tanh(x) rounds to 1 above 9.01.
+  IV saturated = ax > 9.f;
+  V t = vexp(select(saturated, splat<V>(9.f), ax) * 2.f);
+  V large = select(saturated, splat<V>(1.f), 1.f - 2.f / (t + 1.f));
+  large = (V)((IV)large | sign);
+
+  return select(ax < 0.625f, small, large);
+}
+
+
+template <typename V>
+SIMD_INLINE V vsigmoid(const V& x) {
+  return 1.f / (1.f + vexp(-x));
+}
+
+
+template <typename V>
+SIMD_INLINE V velu(const V& x, float alpha) {
+  return select(x > 0.f, x, vexpm1(x) * alpha);
+}
+
+
+struct ExpOp { template <typename V> static SIMD_INLINE V run(const V& x, float) { return vexp(x); } };
+struct LogOp { template <typename V> static SIMD_INLINE V run(const V& x, float) { return vlog(x); } };
+struct TanhOp { template <typename V> static SIMD_INLINE V run(const V& x, float) { return vtanh(x); } };
+struct SigmoidOp { template <typename V> static SIMD_INLINE V run(const V& x, float) { return vsigmoid(x); } };
+struct ELUOp { template <typename V> static SIMD_INLINE V run(const V& x, float a) { return velu(x, a); } };
+
+
+template <typename V, typename Op>
+SIMD_INLINE void simd_apply(const int n, const float a, float* y) {
+
+  const int width = sizeof(V) / sizeof(float);
+
+  int i = 0;
+  for (; i + width <= n; i += width) {
+    V x;
+    memcpy(&x, y + i, sizeof(V));
+    x = Op::template run<V>(x, a);
+    memcpy(y + i, &x, sizeof(V));
+  }
+
+  if (i < n) {
+    V x = splat<V>(1.f);
+    memcpy(&x, y + i, (n - i) * sizeof(float));
+    x = Op::template run<V>(x, a);
+    memcpy(y + i, &x, (n - i) * sizeof(float));
+  }
+}
+
+
+#define DEFINE_SIMD_MATH_KERNELS(suffix, V, attribute) \
+  attribute void exp_##suffix(const int n, const float a, float* y) { simd_apply<V, ExpOp>(n, a, y); } \
+  attribute void log_##suffix(const int n, const float a, float* y) { simd_apply<V, LogOp>(n, a, y); } \
+  attribute void tanh_##suffix(const int n, const float a, float* y) { simd_apply<V, TanhOp>(n, a, y); } \
+  attribute void sigmoid_##suffix(const int n, const float a, float* y) { simd_apply<V, SigmoidOp>(n, a, y); } \
+  attribute void elu_##suffix(const int n, const float a, float* y) { simd_apply<V, ELUOp>(n, a, y); }
+
+DEFINE_SIMD_MATH_KERNELS(vec4, v4sf, static)
+
+#ifdef HYPERTEA_SIMD_X86
+DEFINE_SIMD_MATH_KERNELS(avx2, v8sf, static __attribute__((target("avx2,fma"))))
+DEFINE_SIMD_MATH_KERNELS(avx512, v16sf, static __attribute__((target("avx512f"))))
+#endif //HYPERTEA_SIMD_X86
+
+#else  // scalar fallback
+
+#define DEFINE_SCALAR_MATH_KERNEL(name, operation) \
+  static void name##_scalar(const int n, const float a, float* y) { \
+    for (int i = 0; i < n; ++i) { operation; } \
+  }
+
+DEFINE_SCALAR_MATH_KERNEL(exp, y[i] = expf(y[i]))
+DEFINE_SCALAR_MATH_KERNEL(log, y[i] = logf(y[i]))
+DEFINE_SCALAR_MATH_KERNEL(tanh, y[i] = tanhf(y[i]))
+DEFINE_SCALAR_MATH_KERNEL(sigmoid, y[i] = 1.f / (1.f + expf(-y[i])))
+DEFINE_SCALAR_MATH_KERNEL(elu, y[i] = y[i] > 0 ? y[i] : a * (expf(y[i]) - 1.f))
+
+#endif //HYPERTEA_SIMD_VECTOR
+
+
+
+typedef void (*simd_math_kernel)(const int n, const float a, float* y);
+
+struct SimdMathKernels {
+  const char* isa;
+  simd_math_kernel exp;
+  simd_math_kernel log;
+  simd_math_kernel tanh;
+  simd_math_kernel sigmoid;
+  simd_math_kernel elu;
+};
+
+#define SIMD_MATH_KERNELS(isa, suffix) \
+  SimdMathKernels { isa, exp_##suffix, log_##suffix, tanh_##suffix, sigmoid_##suffix, elu_##suffix }
+
+
+static SimdMathKernels select_simd_math_kernels() {
+
+#ifdef HYPERTEA_SIMD_X86
+  __builtin_cpu_init();
+  if (__builtin_cpu_supports("avx512f")) {
+    return SIMD_MATH_KERNELS("avx512f", avx512);
+  }
+  if (__builtin_cpu_supports("avx2") && __builtin_cpu_supports("fma")) {
+    return SIMD_MATH_KERNELS("avx2", avx2);
+  }
+  return SIMD_MATH_KERNELS("sse2", vec4);
+#elif defined(HYPERTEA_SIMD_VECTOR)
+#if defined(__ARM_NEON) || defined(__ARM_NEON__)
+  return SIMD_MATH_KERNELS("neon", vec4);
+#else
+  return SIMD_MATH_KERNELS("vector4", vec4);
+#endif
+#else
+  return SIMD_MATH_KERNELS("scalar", scalar);
+#endif
+}
+
+static const SimdMathKernels& simd_math_kernels() {
+  static const SimdMathKernels kernels = select_simd_math_kernels();
+  return kernels;
+}
+
+
+
+void simd_exp(const int n, float* y) { simd_math_kernels().exp(n, 0, y); }
+void simd_log(const int n, float* y) { simd_math_kernels().log(n, 0, y); }
+void simd_tanh(const int n, float* y) { simd_math_kernels().tanh(n, 0, y); }
+void simd_sigmoid(const int n, float* y) { simd_math_kernels().sigmoid(n, 0, y); }
+void simd_elu(const int n, const float alpha, float* y) { simd_math_kernels().elu(n, alpha, y); }
+
+const char* simd_math_isa() { return simd_math_kernels().isa; }
+
+}  // namespace hypertea
@@ -0,0 +1,114 @@
+#include <algorithm>
+
+#include "hypertea/util/depthwise_conv.hpp"
+
+namespace hypertea {
+
+// Output column whose taps partly fall outside [0, width); rows outside the
+// input are nullptr.
+static inline float depthwise_border_column(const float* const* rows, const float* k, int iw, int width) {
+  float sum = 0;
+  for (int ki = 0; ki < 3; ++ki) {
+    if (!rows[ki]) { continue; }
+    for (int kj = 0; kj < 3; ++kj) {
+      if (iw + kj >= 0 && iw + kj < width) { sum += k[3 * ki + kj] * rows[ki][iw + kj]; }
+    }
+  }
+  return sum;
+}
+
+
+// STRIDE is the horizontal stride when known at compile time (1 or 2),
+// 0 takes it from stride_w.
+template <int STRIDE>
+static void depthwise_plane(const float* in, const int height, const int width,
+    const int pad_h, const int pad_w, const int stride_h, const int stride_w,
+    const float* k, float* out, const int output_h, const int output_w) {
+
+  const int s = STRIDE > 0 ? STRIDE : stride_w;
+
+  // Output columns whose three taps are all inside the input row.
+  const int ow_lo = std::min(output_w, (pad_w + s - 1) / s);
+  const int ow_hi = width - 3 + pad_w < 0 ? ow_lo :
+    std::max(ow_lo, std::min(output_w, (width - 3 + pad_w) / s + 1));
+
+  for (int oh = 0; oh < output_h; ++oh) {
+
+    const float* rows[3];
+    bool full = true;
+    for (int ki = 0; ki < 3; ++ki) {
+      const int ih = oh * stride_h - pad_h + ki;
+      rows[ki] = (ih >= 0 && ih < height) ? in + ih * width : nullptr;
+      full = full && rows[ki] != nullptr;
+    }
+
+    float* o = out + oh * output_w;
+
+    for (int ow = 0; ow < ow_lo; ++ow) {
+      o[ow] = depthwise_border_column(rows, k, ow * s - pad_w, width);
+    }
+    for (int ow = ow_hi; ow < output_w; ++ow) {
+      o[ow] = depthwise_border_column(rows, k, ow * s - pad_w, width);
+    }
+
+    if (full) {
+      const float* r0 = rows[0];
+      const float* r1 = rows[1];
+      const float* r2 = rows[2];
+      for (int ow = ow_lo; ow < ow_hi; ++ow) {
+        const int iw = ow * s - pad_w;
+        o[ow] = k[0] * r0[iw] + k[1] * r0[iw + 1] + k[2] * r0[iw + 2]
+              + k[3] * r1[iw] + k[4] * r1[iw + 1] + k[5] * r1[iw + 2]
+              + k[6] * r2[iw] + k[7] * r2[iw + 1] + k[8] * r2[iw + 2];
+      }
+    } else {
+      for (int ow = ow_lo; ow < ow_hi; ++ow) { o[ow] = 0; }
+      for (int ki = 0; ki < 3; ++ki) {
+        if (!rows[ki]) { continue; }
+        const float* r = rows[ki];
+        const float* kr = k + 3 * ki;
+        for (int ow = ow_lo; ow < ow_hi; ++ow) {
+          const int iw = ow * s - pad_w;
+          o[ow] += kr[0] * r[iw] + kr[1] * r[iw + 1] + kr[2] * r[iw + 2];
+        }
+      }
+    }
+  }
+}
+
+
+void depthwise_conv3x3(const TensorCPU<float>& data_im,
+    const int num, const int channels, const int height, const int width,
+    const int pad_h, const int pad_w, const int stride_h, const int stride_w,
+    const TensorCPU<float>& weight,
+    const int output_h, const int output_w,
+    TensorCPU<float>& data_out,
+    const float* bias,
+    ACTIVATION_TYPE activation,
+    float alpha, const float* slope) {
+
+  auto in_data = data_im.immutable_data();
+  auto weight_data = weight.immutable_data();
+  auto out_data = data_out.mutable_data();
+
+  const int in_spatial = height * width;
+  const int out_spatial = output_h * output_w;
+
+  auto plane = stride_w == 1 ? depthwise_plane<1> :
+    (stride_w == 2 ? depthwise_plane<2> : depthwise_plane<0>);
+
+  for_each_channel_row(num, channels, out_spatial, [&](int r, int c) {
+
+    float* out = out_data + r * out_spatial;
+
+    plane(in_data + r * in_spatial, height, width, pad_h, pad_w, stride_h, stride_w,
+      weight_data + c * 9, out, output_h, output_w);
+
+    if (bias || activation != ACTIVATION_TYPE::NONE) {
+      channeled_bias_activation(out, 1, out_spatial, out_spatial,
+        bias ? bias + c : nullptr, activation, alpha, slope ? slope + c : nullptr);
+    }
+  });
+}
+
+}  // namespace hypertea
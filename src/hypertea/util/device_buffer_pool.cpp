@@ -0,0 +1,217 @@
+#ifdef USE_OPENCL
+
+#include <climits>
+
+#include "hypertea/common.hpp"
+#include "hypertea/util/device_buffer_pool.hpp"
+
+namespace hypertea {
+
+
+static const size_t MIN_BUCKET_SIZE = 256;
+
+// Never destroyed: tensors released at exit still return their buffers.
+DeviceBufferPool& DeviceBufferPool::Get() {
+  static DeviceBufferPool* pool = new DeviceBufferPool();
+  return *pool;
+}
+
+
+size_t DeviceBufferPool::bucket_size(size_t bytes) {
+
+  if (bytes <= MIN_BUCKET_SIZE) { return MIN_BUCKET_SIZE; }
+
+  size_t power = MIN_BUCKET_SIZE;
+  while (power * 2 < bytes) { power *= 2; }
+
+  const size_t step = power / 4;
+  return (bytes + step - 1) / step * step;
+}
+
+
+std::shared_ptr<void> DeviceBufferPool::allocate(size_t bytes) {
+
+  const size_t bucket = bucket_size(bytes);
+  cl_mem buffer = nullptr;
+
+  {
+    std::lock_guard<std::mutex> lock(mutex_);
+
+    auto& idle = idle_[bucket];
+    if (!idle.empty()) {
+      buffer = idle.back();
+      idle.pop_back();
+      stats_.hits += 1;
+      stats_.bytes_held -= bucket;
+    } else {
+      stats_.misses += 1;
+    }
+    stats_.bytes_in_use += bucket;
+  }
+
+  if (buffer == nullptr) {
+    cl_int ret;
+    buffer = clCreateBuffer(OpenCLHandler::Get().context, CL_MEM_READ_WRITE, bucket, NULL, &ret);
+    OPENCL_CHECK(ret);
+
+    std::lock_guard<std::mutex> lock(mutex_);
+    buffers_[buffer].bytes = bucket;
+  }
+
+  return std::shared_ptr<void>((void*)buffer, [this](void* ptr) { release((cl_mem) ptr); });
+}
+
+
+// OpenCL rejects a sub-buffer as the parent of another one: views of views
+// (chunks of a sub_view, sub_views of memory planner arena blocks) are made
+// from the root buffer at the combined offset instead.
+static cl_mem root_buffer(cl_mem buffer, size_t& offset) {
+
+  while (true) {
+    cl_mem parent = nullptr;
+    OPENCL_CHECK(clGetMemObjectInfo(buffer, CL_MEM_ASSOCIATED_MEMOBJECT, sizeof(parent), &parent, nullptr));
+    if (parent == nullptr) { return buffer; }
+
+    size_t base = 0;
+    OPENCL_CHECK(clGetMemObjectInfo(buffer, CL_MEM_OFFSET, sizeof(base), &base, nullptr));
+    offset += base;
+    buffer = parent;
+  }
+}
+
+
+std::shared_ptr<void> DeviceBufferPool::sub_buffer(const std::shared_ptr<void>& parent,
+    size_t offset, size_t bytes, cl_mem_flags flags) {
+
+  cl_int ret;
+  cl_mem root = (cl_mem)parent.get();
+
+  std::unique_lock<std::mutex> lock(mutex_);
+
+  auto owner = buffers_.find(root);
+
+  if (owner == buffers_.end()) {
+    lock.unlock();
+    root = root_buffer(root, offset);
+    lock.lock();
+    owner = buffers_.find(root);
+  }
+
+  cl_buffer_region region{offset, bytes};
+
+  if (owner == buffers_.end()) {
+    lock.unlock();
+    cl_mem view = clCreateSubBuffer(root, flags, CL_BUFFER_CREATE_TYPE_REGION, &region, &ret);
+    OPENCL_CHECK(ret);
+    return std::shared_ptr<void>((void*)view, [parent](void* ptr) { clReleaseMemObject((cl_mem) ptr); });
+  }
+
+  auto key = std::make_tuple(offset, bytes, flags);
+  auto it = owner->second.views.find(key);
+
+  if (it != owner->second.views.end()) {
+    stats_.sub_buffer_hits += 1;
+  } else {
+    stats_.sub_buffer_misses += 1;
+    cl_mem view = clCreateSubBuffer(root, flags, CL_BUFFER_CREATE_TYPE_REGION, &region, &ret);
+    OPENCL_CHECK(ret);
+    it = owner->second.views.insert(std::make_pair(key, view)).first;
+  }
+
+  // The view lives as long as its pooled buffer, sharing ownership of the
+  // parent (and through it of the root) keeps the buffer from going back to
+  // the pool under it.
+  return std::shared_ptr<void>(parent, (void*)it->second);
+}
+
+
+void DeviceBufferPool::release(cl_mem buffer) {
+
+  std::lock_guard<std::mutex> lock(mutex_);
+
+  if (holds_ > 0) {
+    held_.push_back(buffer);
+    return;
+  }
+
+  const size_t bucket = buffers_[buffer].bytes;
+  stats_.bytes_in_use -= bucket;
+
+  if (stats_.bytes_held + bucket > capacity_) {
+    destroy(buffer);
+    return;
+  }
+
+  idle_[bucket].push_back(buffer);
+  stats_.bytes_held += bucket;
+}
+
+
+// Caller holds mutex_.
+void DeviceBufferPool::destroy(cl_mem buffer) {
+
+  auto it = buffers_.find(buffer);
+  for (auto& view : it->second.views) {
+    OPENCL_CHECK(clReleaseMemObject(view.second));
+  }
+  buffers_.erase(it);
+
+  OPENCL_CHECK(clReleaseMemObject(buffer));
+}
+
+
+void DeviceBufferPool::hold_releases() {
+  std::lock_guard<std::mutex> lock(mutex_);
+  holds_ += 1;
+}
+
+void DeviceBufferPool::resume_releases() {
+
+  std::vector<cl_mem> held;
+  {
+    std::lock_guard<std::mutex> lock(mutex_);
+    holds_ -= 1;
+    if (holds_ > 0) { return; }
+    held.swap(held_);
+  }
+
+  for (auto buffer : held) { release(buffer); }
+}
+
+
+void DeviceBufferPool::trim() {
+
+  std::lock_guard<std::mutex> lock(mutex_);
+
+  for (auto& bucket : idle_) {
+    for (auto buffer : bucket.second) { destroy(buffer); }
+  }
+  idle_.clear();
+  stats_.bytes_held = 0;
+}
+
+
+size_t DeviceBufferPool::capacity() const {
+  std::lock_guard<std::mutex> lock(mutex_);
+  return capacity_;
+}
+
+void DeviceBufferPool::set_capacity(size_t bytes) {
+  {
+    std::lock_guard<std::mutex> lock(mutex_);
+    capacity_ = bytes;
+    if (stats_.bytes_held <= capacity_) { return; }
+  }
+  trim();
+}
+
+
+DeviceBufferPool::Stats DeviceBufferPool::stats() const {
+  std::lock_guard<std::mutex> lock(mutex_);
+  return stats_;
+}
+
+
+}  // namespace hypertea
+
+#endif //USE_OPENCL
@@ -0,0 +1,173 @@
+#ifdef USE_OPENCL
+
+#include <map>
+#include <mutex>
+#include <string.h>
+
+#include "hypertea/common.hpp"
+#include "hypertea/util/device_buffer_pool.hpp"
+#include "hypertea/util/device_transfer.hpp"
+
+namespace hypertea {
+
+
+TransferEvent::TransferEvent(cl_event event)
+  : event_(event, [](cl_event e) { clReleaseEvent(e); }) {}
+
+bool TransferEvent::ready() const {
+  if (!event_) { return true; }
+  cl_int status;
+  OPENCL_CHECK(clGetEventInfo(event_.get(), CL_EVENT_COMMAND_EXECUTION_STATUS, sizeof(cl_int), &status, NULL));
+  return status == CL_COMPLETE;
+}
+
+void TransferEvent::wait() const {
+  if (!event_) { return; }
+  cl_event e = event_.get();
+  OPENCL_CHECK(clWaitForEvents(1, &e));
+}
+
+void TransferEvent::enqueue_wait(cl_command_queue queue) const {
+  if (!event_) { return; }
+  cl_event e = event_.get();
+  OPENCL_CHECK(clEnqueueBarrierWithWaitList(queue, 1, &e, NULL));
+}
+
+
+
+
+struct PinnedBlock {
+  cl_mem buffer;
+  size_t bytes;
+};
+
+static std::mutex pinned_mutex;
+static std::map<void*, PinnedBlock> pinned_blocks;
+static std::map<size_t, std::vector<void*> > pinned_idle;
+
+// Blocks stay mapped for the life of the process.
+std::shared_ptr<void> pinned_host_memory(size_t bytes) {
+
+  const size_t bucket = DeviceBufferPool::bucket_size(bytes);
+
+  {
+    std::lock_guard<std::mutex> lock(pinned_mutex);
+    auto& idle = pinned_idle[bucket];
+    if (!idle.empty()) {
+      void* host = idle.back();
+      idle.pop_back();
+      return std::shared_ptr<void>(host, [bucket](void* ptr) {
+        std::lock_guard<std::mutex> lock(pinned_mutex);
+        pinned_idle[bucket].push_back(ptr);
+      });
+    }
+  }
+
+  cl_int ret;
+  cl_mem buffer = clCreateBuffer(OpenCLHandler::Get().context, CL_MEM_READ_WRITE | CL_MEM_ALLOC_HOST_PTR, bucket, NULL, &ret);
+  OPENCL_CHECK(ret);
+
+  void* host = clEnqueueMapBuffer(OpenCLHandler::Get().commandQueue, buffer, CL_TRUE,
+    CL_MAP_READ | CL_MAP_WRITE, 0, bucket, 0, NULL, NULL, &ret);
+  OPENCL_CHECK(ret);
+
+  std::lock_guard<std::mutex> lock(pinned_mutex);
+  pinned_blocks[host] = PinnedBlock{buffer, bucket};
+
+  return std::shared_ptr<void>(host, [bucket](void* ptr) {
+    std::lock_guard<std::mutex> lock(pinned_mutex);
+    pinned_idle[bucket].push_back(ptr);
+  });
+}
+
+
+
+
+template <typename Dtype>
+TensorUploader<Dtype>::TensorUploader(int count, int depth)
+  : count_(count), slots_(depth) {
+
+  for (auto& slot : slots_) {
+    slot.tensor = std::make_shared<TensorGPU<Dtype> >(count);
+    slot.staging = pinned_host_memory(count * sizeof(Dtype));
+  }
+}
+
+
+// The staging buffers go back to the pinned pool, nothing may still read them.
+template <typename Dtype>
+TensorUploader<Dtype>::~TensorUploader() {
+  for (auto& slot : slots_) { slot.uploaded.wait(); }
+}
+
+
+template <typename Dtype>
+bool TensorUploader<Dtype>::upload(const Dtype* data) {
+
+  const int index = next_upload_ % slots_.size();
+  Slot& slot = slots_[index];
+
+  if (pending_ == slots_.size() || index == in_use_) {
+    LOG(ERROR) << "TensorUploader: every tensor is pending or in use, take() first";
+    return false;
+  }
+
+  // The previous upload from this staging buffer has to be through before
+  // it is overwritten, normally long since.
+  slot.uploaded.wait();
+  memcpy(slot.staging.get(), data, count_ * sizeof(Dtype));
+
+  cl_event consumed = slot.consumed.event();
+  cl_event uploaded;
+  OPENCL_CHECK(
+    clEnqueueWriteBuffer(
+      OpenCLHandler::Get().transferQueue,
+      slot.tensor->mutable_data(), CL_FALSE,
+      0, count_ * sizeof(Dtype),
+      slot.staging.get(),
+      consumed ? 1 : 0, consumed ? &consumed : nullptr, &uploaded
+    )
+  );
+  OPENCL_CHECK(clFlush(OpenCLHandler::Get().transferQueue));
+
+  slot.uploaded = TransferEvent(uploaded);
+  next_upload_ += 1;
+  pending_ += 1;
+  return true;
+}
+
+
+template <typename Dtype>
+std::shared_ptr<TensorGPU<Dtype> > TensorUploader<Dtype>::take() {
+
+  if (pending_ == 0) {
+    LOG(ERROR) << "TensorUploader: take() without an upload";
+    return nullptr;
+  }
+
+  auto queue = current_queue();
+
+  // Everything using the previous input has been enqueued by now.
+  if (in_use_ >= 0) {
+    cl_event consumed;
+    OPENCL_CHECK(clEnqueueMarkerWithWaitList(queue, 0, NULL, &consumed));
+    slots_[in_use_].consumed = TransferEvent(consumed);
+  }
+
+  in_use_ = next_take_ % slots_.size();
+  next_take_ += 1;
+  pending_ -= 1;
+
+  Slot& slot = slots_[in_use_];
+  slot.uploaded.enqueue_wait(queue);
+
+  return slot.tensor;
+}
+
+template class TensorUploader<float>;
+template class TensorUploader<half>;
+
+
+}  // namespace hypertea
+
+#endif //USE_OPENCL
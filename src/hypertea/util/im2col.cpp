@@ -1,3 +1,4 @@
+#include <algorithm>
 #include <vector>
 
 #include "hypertea/util/im2col.hpp"
@@ -61,6 +62,61 @@ template void im2col(const TensorCPU<float>& data_im, const int channels,
 
 
 
+template <typename Dtype>
+void im2col_tile(const Dtype* data_im, const int channels,
+    const int height, const int width, const int kernel_h, const int kernel_w,
+    const int pad_h, const int pad_w, const int stride_h,
+    const int stride_w, const int dilation_h, const int dilation_w,
+    const int col_start, const int col_count, Dtype* data_col) {
+
+  const int output_w = (width + 2 * pad_w -
+    (dilation_w * (kernel_w - 1) + 1)) / stride_w + 1;
+  const int channel_size = height * width;
+
+  const int first_row = col_start / output_w;
+  const int first_col = col_start % output_w;
+
+  for (int channel = channels; channel--; data_im += channel_size) {
+    for (int kernel_row = 0; kernel_row < kernel_h; kernel_row++) {
+      for (int kernel_col = 0; kernel_col < kernel_w; kernel_col++) {
+
+        // The tile may start and end in the middle of an output row.
+        int output_row = first_row;
+        int output_col = first_col;
+
+        for (int remaining = col_count; remaining > 0; ++output_row, output_col = 0) {
+
+          const int segment = std::min(remaining, output_w - output_col);
+          remaining -= segment;
+
+          const int input_row = output_row * stride_h - pad_h + kernel_row * dilation_h;
+          if (!is_a_ge_zero_and_a_lt_b(input_row, height)) {
+            for (int i = segment; i; i--) {
+              *(data_col++) = 0;
+            }
+            continue;
+          }
+
+          const Dtype* im_row = data_im + input_row * width;
+          int input_col = output_col * stride_w - pad_w + kernel_col * dilation_w;
+          for (int i = segment; i; i--) {
+            *(data_col++) = is_a_ge_zero_and_a_lt_b(input_col, width) ? im_row[input_col] : 0;
+            input_col += stride_w;
+          }
+        }
+      }
+    }
+  }
+}
+
+template void im2col_tile(const float* data_im, const int channels,
+    const int height, const int width, const int kernel_h, const int kernel_w,
+    const int pad_h, const int pad_w, const int stride_h,
+    const int stride_w, const int dilation_h, const int dilation_w,
+    const int col_start, const int col_count, float* data_col);
+
+
+
 template <typename Dtype>
 void col2im(const TensorCPU<Dtype>& data_col, const int channels,
     const int height, const int width, const int kernel_h, const int kernel_w,
@@ -0,0 +1,70 @@
+#include <stdio.h>
+#include <stdlib.h>
+
+#if defined(__unix__) || defined(__APPLE__)
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#define HYPERTEA_USE_MMAP
+#endif
+
+#include "hypertea/common.hpp"
+#include "hypertea/util/mapped_file.hpp"
+
+namespace hypertea {
+
+#ifdef HYPERTEA_USE_MMAP
+
+std::shared_ptr<void> map_file(const std::string& path, size_t bytes) {
+
+  int fd = open(path.c_str(), O_RDONLY);
+  if (fd < 0) {
+    LOG(ERROR) << "Cannot open " << path << std::endl;
+    return nullptr;
+  }
+
+  struct stat st;
+  if (fstat(fd, &st) != 0 || size_t(st.st_size) < bytes) {
+    LOG(ERROR) << "Weight File Size Mismatch " << st.st_size << " and " << bytes << std::endl;
+    close(fd);
+    return nullptr;
+  }
+
+  void* addr = mmap(nullptr, bytes, PROT_READ | PROT_WRITE, MAP_PRIVATE, fd, 0);
+  close(fd);
+
+  if (addr == MAP_FAILED) {
+    LOG(ERROR) << "Cannot map " << path << std::endl;
+    return nullptr;
+  }
+
+  return std::shared_ptr<void>(addr, [bytes](void* p) { munmap(p, bytes); });
+}
+
+#else
+
+std::shared_ptr<void> map_file(const std::string& path, size_t bytes) {
+
+  FILE *f = fopen(path.c_str(), "rb");
+  if (f == nullptr) {
+    LOG(ERROR) << "Cannot open " << path << std::endl;
+    return nullptr;
+  }
+
+  void* data = malloc(bytes);
+  size_t read_size = fread(data, 1, bytes, f);
+  fclose(f);
+
+  if (read_size != bytes) {
+    LOG(ERROR) << "Weight File Size Mismatch " << read_size << " and " << bytes << std::endl;
+    free(data);
+    return nullptr;
+  }
+
+  return std::shared_ptr<void>(data, free);
+}
+
+#endif //HYPERTEA_USE_MMAP
+
+}  // namespace hypertea
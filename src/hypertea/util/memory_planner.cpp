@@ -0,0 +1,363 @@
+#include <algorithm>
+#include <climits>
+
+#include "hypertea/common.hpp"
+#include "hypertea/util/memory_planner.hpp"
+#include "hypertea/util/device_buffer_pool.hpp"
+#include "hypertea/util/profiler.hpp"
+
+namespace hypertea {
+
+
+struct MemoryBlock {
+  size_t bytes;
+  bool device;
+  int first_use;
+  int last_use;
+  size_t offset;
+  // earlier blocks sharing bytes with this one, they must be gone before it is handed out
+  std::vector<int> predecessors;
+};
+
+
+#ifdef USE_OPENCL
+struct DeviceArena {
+  DeviceArena(size_t bytes, size_t blocks) : views(blocks, nullptr) {
+    cl_int ret;
+    buffer = clCreateBuffer(OpenCLHandler::Get().context, CL_MEM_READ_WRITE, bytes, NULL, &ret);
+    OPENCL_CHECK(ret);
+  }
+
+  ~DeviceArena() {
+    for (auto const& v : views) {
+      if (v != nullptr) { clReleaseMemObject(v); }
+    }
+    clReleaseMemObject(buffer);
+  }
+
+  cl_mem buffer;
+  std::vector<cl_mem> views;
+};
+#endif //USE_OPENCL
+
+
+struct MemoryPlanner::State {
+
+  size_t alignment;
+
+  std::vector<MemoryBlock> plan;
+  std::vector<MemoryBlock> trace;
+  std::vector<bool> released;
+
+  int clock = 0;
+  int generation = 0;
+  bool in_pass = false;
+  bool diverged = false;
+
+  size_t host_size = 0;
+  size_t device_size = 0;
+  size_t peak_live = 0;
+  size_t live = 0;
+
+  int arena_allocations = 0;
+  int heap_allocations = 0;
+
+  std::shared_ptr<char> host_arena;
+#ifdef USE_OPENCL
+  std::shared_ptr<DeviceArena> device_arena;
+#endif //USE_OPENCL
+
+
+  // Returns the trace index of the new block, or -1 outside of a pass.
+  int record(size_t bytes, bool device) {
+    if (!in_pass) { return -1; }
+
+    MemoryBlock block{bytes, device, clock++, INT_MAX, 0, {}};
+    trace.push_back(block);
+    released.push_back(false);
+
+    live += bytes;
+    peak_live = std::max(peak_live, live);
+
+    return trace.size() - 1;
+  }
+
+  void forget(int generation_, int id) {
+    if (!in_pass || generation_ != generation || id < 0) { return; }
+    trace[id].last_use = clock++;
+    released[id] = true;
+    live -= trace[id].bytes;
+  }
+
+  bool servable(int id, bool device) {
+
+    if (diverged) { return false; }
+
+    if (id < 0 || id >= plan.size()
+      || plan[id].bytes != trace[id].bytes
+      || plan[id].device != device) {
+      diverged = true;
+      return false;
+    }
+
+    for (auto const& p : plan[id].predecessors) {
+      if (!released[p]) {
+        diverged = true;
+        return false;
+      }
+    }
+
+    return true;
+  }
+
+  size_t align(size_t bytes, size_t alignment_) const {
+    return (bytes + alignment_ - 1) / alignment_ * alignment_;
+  }
+
+  // Greedy by size: the largest block is placed first at the lowest offset
+  // that does not collide with any placed block whose lifetime overlaps.
+  size_t pack(std::vector<MemoryBlock>& blocks, bool device, size_t alignment_) {
+
+    std::vector<int> order;
+    for (int i = 0; i < blocks.size(); ++i) {
+      if (blocks[i].device == device) { order.push_back(i); }
+    }
+
+    std::stable_sort(order.begin(), order.end(), [&blocks](int a, int b) {
+      return blocks[a].bytes > blocks[b].bytes;
+    });
+
+    size_t arena_size = 0;
+    std::vector<int> placed;
+
+    for (auto const& i : order) {
+
+      auto& block = blocks[i];
+      size_t size = align(block.bytes, alignment_);
+
+      std::vector<int> conflicts;
+      for (auto const& j : placed) {
+        if (blocks[j].first_use < block.last_use && block.first_use < blocks[j].last_use) {
+          conflicts.push_back(j);
+        }
+      }
+      std::sort(conflicts.begin(), conflicts.end(), [&blocks](int a, int b) {
+        return blocks[a].offset < blocks[b].offset;
+      });
+
+      size_t offset = 0;
+      for (auto const& j : conflicts) {
+        if (offset + size <= blocks[j].offset) { break; }
+        offset = std::max(offset, blocks[j].offset + align(blocks[j].bytes, alignment_));
+      }
+
+      block.offset = offset;
+      arena_size = std::max(arena_size, offset + size);
+      placed.push_back(i);
+    }
+
+    for (auto const& i : order) {
+      auto& block = blocks[i];
+      for (auto const& j : order) {
+        if (j < i
+          && blocks[j].last_use <= block.first_use
+          && blocks[j].offset < block.offset + block.bytes
+          && block.offset < blocks[j].offset + blocks[j].bytes) {
+          block.predecessors.push_back(j);
+        }
+      }
+    }
+
+    return arena_size;
+  }
+
+
+  void replan() {
+
+    plan = trace;
+
+    host_size = pack(plan, false, alignment);
+    if (host_size > 0) {
+      host_arena.reset(new char[host_size], std::default_delete<char[]>());
+    } else {
+      host_arena.reset();
+    }
+
+#ifdef USE_OPENCL
+    cl_uint base_align_bits = 0;
+    clGetDeviceInfo(OpenCLHandler::Get().deviceID, CL_DEVICE_MEM_BASE_ADDR_ALIGN,
+      sizeof(base_align_bits), &base_align_bits, NULL);
+    size_t device_alignment = std::max(alignment, static_cast<size_t>(base_align_bits / 8));
+
+    device_size = pack(plan, true, device_alignment);
+    if (device_size > 0) {
+      device_arena = std::make_shared<DeviceArena>(device_size, plan.size());
+    } else {
+      device_arena.reset();
+    }
+#endif //USE_OPENCL
+  }
+
+};
+
+
+
+
+static thread_local MemoryPlanner* current_planner_ = nullptr;
+
+
+MemoryPlanner::MemoryPlanner(size_t alignment)
+  : state_(std::make_shared<State>()) {
+  state_->alignment = alignment;
+}
+
+MemoryPlanner::~MemoryPlanner() {
+  if (current_planner_ == this) {
+    current_planner_ = nullptr;
+  }
+}
+
+
+MemoryPlanner* MemoryPlanner::current() {
+  return current_planner_;
+}
+
+
+void MemoryPlanner::begin_pass() {
+  state_->trace.clear();
+  state_->released.clear();
+  state_->clock = 0;
+  state_->live = 0;
+  state_->peak_live = 0;
+  state_->generation += 1;
+  state_->diverged = false;
+  state_->arena_allocations = 0;
+  state_->heap_allocations = 0;
+  state_->in_pass = true;
+}
+
+
+void MemoryPlanner::end_pass() {
+
+  auto& s = *state_;
+  s.in_pass = false;
+
+  if (s.plan.empty() || s.diverged || s.trace.size() != s.plan.size()) {
+    s.replan();
+  }
+}
+
+
+std::shared_ptr<void> MemoryPlanner::allocate_host(size_t bytes) {
+
+  auto state = state_;
+  int id = state->record(bytes, false);
+  int generation = state->generation;
+
+  if (state->in_pass && state->servable(id, false)) {
+
+    state->arena_allocations += 1;
+    auto arena = state->host_arena;
+
+    return std::shared_ptr<void>(
+      (void*)(arena.get() + state->plan[id].offset),
+      [state, arena, generation, id](void*) { state->forget(generation, id); }
+    );
+  }
+
+  state->heap_allocations += 1;
+  return std::shared_ptr<void>(
+    (void*)(new char[bytes]),
+    [state, generation, id](void* ptr) {
+      delete[] (char*) ptr;
+      state->forget(generation, id);
+    }
+  );
+}
+
+
+#ifdef USE_OPENCL
+std::shared_ptr<void> MemoryPlanner::allocate_device(size_t bytes) {
+
+  auto state = state_;
+  int id = state->record(bytes, true);
+  int generation = state->generation;
+
+  if (state->in_pass && state->servable(id, true)) {
+
+    state->arena_allocations += 1;
+    auto arena = state->device_arena;
+
+    // Blocks are sub-buffers of the arena; sub_view and chunked_tensors of
+    // them are made from the arena buffer (DeviceBufferPool::sub_buffer).
+    if (arena->views[id] == nullptr) {
+      cl_int ret;
+      cl_buffer_region region{state->plan[id].offset, bytes};
+      arena->views[id] = clCreateSubBuffer(arena->buffer, CL_MEM_READ_WRITE, CL_BUFFER_CREATE_TYPE_REGION, &region, &ret);
+      OPENCL_CHECK(ret);
+    }
+
+    return std::shared_ptr<void>(
+      (void*)arena->views[id],
+      [state, arena, generation, id](void*) { state->forget(generation, id); }
+    );
+  }
+
+  state->heap_allocations += 1;
+  auto buffer = DeviceBufferPool::Get().allocate(bytes);
+
+  return std::shared_ptr<void>(
+    buffer.get(),
+    [state, generation, id, buffer](void* ptr) { state->forget(generation, id); }
+  );
+}
+#endif //USE_OPENCL
+
+
+bool MemoryPlanner::planned() const { return !state_->plan.empty(); }
+
+size_t MemoryPlanner::host_arena_size() const { return state_->host_size; }
+size_t MemoryPlanner::device_arena_size() const { return state_->device_size; }
+size_t MemoryPlanner::peak_live_bytes() const { return state_->peak_live; }
+
+int MemoryPlanner::arena_allocations() const { return state_->arena_allocations; }
+int MemoryPlanner::heap_allocations() const { return state_->heap_allocations; }
+
+
+
+
+MemoryPlanScope::MemoryPlanScope(MemoryPlanner& planner)
+  : planner_(planner), previous_(current_planner_) {
+  current_planner_ = &planner_;
+  planner_.begin_pass();
+}
+
+MemoryPlanScope::~MemoryPlanScope() {
+  planner_.end_pass();
+  current_planner_ = previous_;
+}
+
+
+
+
+std::shared_ptr<void> planned_host_memory(size_t bytes) {
+  Profiler::allocated_bytes() += bytes;
+  if (current_planner_ != nullptr) {
+    return current_planner_->allocate_host(bytes);
+  }
+  return std::shared_ptr<void>((void*)(new char[bytes]), [](void* ptr) { delete[] (char*) ptr; });
+}
+
+
+#ifdef USE_OPENCL
+std::shared_ptr<void> planned_device_memory(size_t bytes) {
+  Profiler::allocated_bytes() += bytes;
+  if (current_planner_ != nullptr && !BranchGroup::open()) {
+    return current_planner_->allocate_device(bytes);
+  }
+  return DeviceBufferPool::Get().allocate(bytes);
+}
+#endif //USE_OPENCL
+
+
+}  // namespace hypertea
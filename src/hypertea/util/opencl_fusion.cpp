@@ -0,0 +1,177 @@
+#ifdef USE_OPENCL
+
+#include <map>
+#include <mutex>
+#include <sstream>
+
+#include "hypertea/util/opencl_fusion.hpp"
+
+namespace hypertea {
+
+
+// Source of one fused kernel. Tensor operands are loaded once into t
+// values, every operation becomes a t value of its own, scalars are read
+// from the s arguments.
+class FusedKernelSource {
+ public:
+
+  std::string value(const FusedNode* node) {
+
+    auto it = values_.find(node);
+    if (it != values_.end()) { return it->second; }
+
+    std::string v;
+
+    if (node->data != nullptr) {
+
+      cl_mem data = (cl_mem)node->data.get();
+      auto input = loads_.find(data);
+      if (input == loads_.end()) {
+        const int slot = inputs.size();
+        inputs.push_back(data);
+        input = loads_.insert(std::make_pair(data, temporary("x" + std::to_string(slot) + "[index]"))).first;
+      }
+      v = input->second;
+
+    } else if (node->code.empty()) {
+
+      v = "(Dtype)s" + std::to_string(scalars.size());
+      scalars.push_back(node->scalar);
+
+    } else {
+
+      const std::string lhs = value(node->lhs.get());
+      const std::string rhs = node->rhs ? value(node->rhs.get()) : "";
+
+      std::string code;
+      for (size_t i = 0; i < node->code.size(); ++i) {
+        if (node->code[i] == '$' && i + 1 < node->code.size()) {
+          code += node->code[++i] == '0' ? lhs : rhs;
+        } else {
+          code += node->code[i];
+        }
+      }
+      v = temporary(code);
+    }
+
+    values_[node] = v;
+    return v;
+  }
+
+  std::string kernel(const std::vector<std::string>& results, bool is_half) const {
+
+    std::stringstream ss;
+
+    ss << opencl_math_header(is_half) << std::endl
+       << "__kernel void fused_kernel(" << std::endl;
+    for (size_t i = 0; i < inputs.size(); ++i) {
+      ss << "  const __global Dtype *x" << i << "," << std::endl;
+    }
+    for (size_t i = 0; i < results.size(); ++i) {
+      ss << "  __global Dtype *y" << i << "," << std::endl;
+    }
+    for (size_t i = 0; i < scalars.size(); ++i) {
+      ss << "  const float s" << i << "," << std::endl;
+    }
+    ss << "  int N) {" << std::endl
+       << "  OPENCL_KERNEL_LOOP(index, N) {" << std::endl
+       << body_.str();
+    for (size_t i = 0; i < results.size(); ++i) {
+      ss << "    y" << i << "[index] = " << results[i] << ";" << std::endl;
+    }
+    ss << "  }" << std::endl
+       << "}" << std::endl;
+
+    return ss.str();
+  }
+
+  std::vector<cl_mem> inputs;
+  std::vector<float> scalars;
+
+ private:
+
+  std::string temporary(const std::string& code) {
+    const std::string name = "t" + std::to_string(temporaries_++);
+    body_ << "    const Dtype " << name << " = " << code << ";" << std::endl;
+    return name;
+  }
+
+  std::map<const FusedNode*, std::string> values_;
+  std::map<cl_mem, std::string> loads_;
+  std::stringstream body_;
+  int temporaries_ = 0;
+
+};
+
+
+static std::mutex fused_programs_mutex;
+static std::map<std::string, cl_program> fused_programs;
+
+static cl_program fused_program(const std::string& source) {
+
+  std::lock_guard<std::mutex> lock(fused_programs_mutex);
+
+  auto it = fused_programs.find(source);
+  if (it == fused_programs.end()) {
+    cl_program program;
+    OpenCLHandler::Get().build_opencl_program(source, program);
+    it = fused_programs.insert(std::make_pair(source, program)).first;
+  }
+  return it->second;
+}
+
+size_t fused_program_count() {
+  std::lock_guard<std::mutex> lock(fused_programs_mutex);
+  return fused_programs.size();
+}
+
+
+bool fused_operands_have_count(const FusedNode& node, int count) {
+  if (node.data != nullptr) { return node.count == count; }
+  return (!node.lhs || fused_operands_have_count(*node.lhs, count))
+      && (!node.rhs || fused_operands_have_count(*node.rhs, count));
+}
+
+
+void launch_fused_kernel(
+  const std::vector<std::pair<cl_mem, const FusedNode*> >& outputs,
+  int count, bool is_half) {
+
+  FusedKernelSource source;
+
+  std::vector<std::string> results;
+  for (auto& output : outputs) {
+    results.push_back(source.value(output.second));
+  }
+
+  cl_program program = fused_program(source.kernel(results, is_half));
+
+  std::vector<cl_mem> outputs_data;
+  for (auto& output : outputs) {
+    outputs_data.push_back(output.first);
+  }
+
+  std::vector<std::pair<size_t, const void *> > args;
+  for (auto& x : source.inputs) {
+    args.push_back(std::make_pair(sizeof(cl_mem), (const void *)&x));
+  }
+  for (auto& y : outputs_data) {
+    args.push_back(std::make_pair(sizeof(cl_mem), (const void *)&y));
+  }
+  for (auto& s : source.scalars) {
+    args.push_back(std::make_pair(sizeof(cl_float), (const void *)&s));
+  }
+  args.push_back(std::make_pair(sizeof(cl_int), (const void *)&count));
+
+  opencl_launch_wrapper(
+    program,
+    "fused_kernel",
+    args,
+    std::vector<size_t> {HYPERTEA_GET_BLOCKS(count)},
+    std::vector<size_t> {HYPERTEA_OPENCL_NUM_THREADS}
+  );
+}
+
+}  // namespace hypertea
+
+#endif //USE_OPENCL
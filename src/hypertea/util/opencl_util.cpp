@@ -1,7 +1,20 @@
 #include "hypertea/util/opencl_util.hpp"
 #include "hypertea/common.hpp"
+#include "hypertea/util/device_buffer_pool.hpp"
 
+#include <errno.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include <atomic>
 #include <fstream>
+#include <iterator>
+#include <map>
+#include <mutex>
 
 namespace hypertea {
  
@@ -11,6 +24,43 @@ void cl_mem_destory(void* ptr) { OPENCL_CHECK(clReleaseMemObject((cl_mem) ptr));
 
 
 
+// Kernel objects are created once per (program, name) and reused; creating
+// one per launch is a driver call every time and the handles were never
+// released. A cl_kernel keeps its program alive, so a cached entry cannot
+// be mistaken for a later program at the same address. The cached kernel is
+// shared by all threads, hence its arguments are set and captured by the
+// enqueue under the same lock.
+static std::mutex opencl_kernels_mutex;
+static std::map<std::pair<cl_program, std::string>, cl_kernel> opencl_kernels;
+
+static cl_kernel cached_kernel(const cl_program& program, const std::string& kernel_name) {
+
+  auto key = std::make_pair(program, kernel_name);
+  auto it = opencl_kernels.find(key);
+
+  if (it == opencl_kernels.end()) {
+    cl_int ret;
+    cl_kernel kernel = clCreateKernel(program, kernel_name.c_str(), &ret);
+    OPENCL_CHECK(ret);
+    it = opencl_kernels.insert(std::make_pair(key, kernel)).first;
+  }
+  return it->second;
+}
+
+size_t opencl_kernel_cache_size() {
+  std::lock_guard<std::mutex> lock(opencl_kernels_mutex);
+  return opencl_kernels.size();
+}
+
+void release_opencl_kernels() {
+  std::lock_guard<std::mutex> lock(opencl_kernels_mutex);
+  for (auto& kernel : opencl_kernels) {
+    OPENCL_CHECK(clReleaseKernel(kernel.second));
+  }
+  opencl_kernels.clear();
+}
+
+
 void opencl_launch_wrapper(
   const cl_program& program,
   const std::string& kernel_name,
@@ -22,11 +72,9 @@ void opencl_launch_wrapper(
   cl_event *event
 ) {
 
-  cl_int ret;
-
-  cl_kernel kernel = clCreateKernel(program, kernel_name.c_str(), &ret);
-  OPENCL_CHECK(ret);
+  std::lock_guard<std::mutex> lock(opencl_kernels_mutex);
 
+  cl_kernel kernel = cached_kernel(program, kernel_name);
 
   for (int i = 0; i < arg_list.size(); ++i) {
     OPENCL_CHECK(clSetKernelArg(kernel, i, arg_list[i].first, arg_list[i].second));
@@ -35,7 +83,7 @@ void opencl_launch_wrapper(
   
   OPENCL_CHECK(
     clEnqueueNDRangeKernel(
-      OpenCLHandler::Get().commandQueue, 
+      current_queue(), 
       kernel, 
       global_size.size(), 
       nullptr,
@@ -77,8 +125,102 @@ OpenCLHandler::OpenCLHandler() {
 	commandQueue = clCreateCommandQueue(context, deviceID, CL_QUEUE_PROFILING_ENABLE, &ret);
 	OPENCL_CHECK(ret);
 
+	transferQueue = clCreateCommandQueue(context, deviceID, 0, &ret);
+	OPENCL_CHECK(ret);
+
+	if (const char* dir = getenv("HYPERTEA_KERNEL_CACHE_DIR")) {
+		program_cache_dir = dir;
+	} else if (const char* home = getenv("HOME")) {
+		program_cache_dir = std::string(home) + "/.cache/hypertea";
+	}
+
 }
 
+
+static std::mutex branch_queues_mutex;
+
+cl_command_queue OpenCLHandler::branch_queue(int index, cl_command_queue parent) {
+
+	std::lock_guard<std::mutex> lock(branch_queues_mutex);
+
+	for (size_t i = 0; ; ++i) {
+		if (i == branchQueues.size()) {
+			cl_int ret;
+			branchQueues.push_back(clCreateCommandQueue(context, deviceID, CL_QUEUE_PROFILING_ENABLE, &ret));
+			OPENCL_CHECK(ret);
+		}
+		if (branchQueues[i] == parent) { continue; }
+		if (index-- == 0) { return branchQueues[i]; }
+	}
+}
+
+
+
+
+static thread_local cl_command_queue current_queue_ = nullptr;
+static std::atomic<int> open_branch_groups_(0);
+
+cl_command_queue current_queue() {
+	return current_queue_ != nullptr ? current_queue_ : OpenCLHandler::Get().commandQueue;
+}
+
+
+BranchGroup::BranchGroup() : parent_(current_queue()) {
+	open_branch_groups_ += 1;
+	DeviceBufferPool::Get().hold_releases();
+}
+
+BranchGroup::~BranchGroup() { join(); }
+
+bool BranchGroup::open() { return open_branch_groups_ > 0; }
+
+
+void BranchGroup::run(const std::function<void()>& branch) {
+
+	if (joined_) {
+		LOG(ERROR) << "BranchGroup: run() after join()";
+	}
+
+	// Never parent_ itself, the fork barrier would wait for its own marker.
+	// Queues are in-order and every dependency is an explicit event, so a
+	// queue a nested group shares with a sibling branch only costs
+	// concurrency, and nesting needs no queues beyond the widest group's.
+	cl_command_queue queue = OpenCLHandler::Get().branch_queue(done_.size(), parent_);
+
+	cl_event fork;
+	OPENCL_CHECK(clEnqueueMarkerWithWaitList(parent_, 0, NULL, &fork));
+	OPENCL_CHECK(clEnqueueBarrierWithWaitList(queue, 1, &fork, NULL));
+	OPENCL_CHECK(clReleaseEvent(fork));
+	OPENCL_CHECK(clFlush(parent_));
+
+	cl_command_queue previous = current_queue_;
+	current_queue_ = queue;
+	branch();
+	current_queue_ = previous;
+
+	cl_event done;
+	OPENCL_CHECK(clEnqueueMarkerWithWaitList(queue, 0, NULL, &done));
+	OPENCL_CHECK(clFlush(queue));
+	done_.push_back(done);
+}
+
+
+void BranchGroup::join() {
+
+	if (joined_) { return; }
+	joined_ = true;
+
+	if (!done_.empty()) {
+		OPENCL_CHECK(clEnqueueBarrierWithWaitList(parent_, done_.size(), done_.data(), NULL));
+		for (auto e : done_) { OPENCL_CHECK(clReleaseEvent(e)); }
+		done_.clear();
+	}
+
+	open_branch_groups_ -= 1;
+	DeviceBufferPool::Get().resume_releases();
+}
+
+
 void OpenCLHandler::build_opencl_math_code(bool is_half) {
     build_opencl_program(opencl_math_code(is_half), math_program);
 }
@@ -122,7 +264,140 @@ void OpenCLHandler::load_opencl_program(std::string save_binary_file, cl_program
 }
 
 
-void OpenCLHandler::build_opencl_program(const std::string &kernel_code, cl_program &program) {
+// Program cache entries are <cache dir>/<key>.clbin, the key hashes the
+// source, the build options and the identity of platform, device and
+// driver. The file starts with a second hash of the same text, so a key
+// collision or a truncated file reads as a miss.
+static const char PROGRAM_CACHE_MAGIC[8] = {'H', 'T', 'C', 'L', 'B', 'I', 'N', '1'};
+
+static uint64_t fnv1a(const std::string& text, uint64_t hash) {
+  for (unsigned char c : text) {
+    hash ^= c;
+    hash *= 1099511628211ULL;
+  }
+  return hash;
+}
+
+static std::string device_info_string(cl_device_id device, cl_device_info param) {
+  size_t size = 0;
+  if (clGetDeviceInfo(device, param, 0, NULL, &size) != CL_SUCCESS) { return ""; }
+  std::string value(size, '\0');
+  clGetDeviceInfo(device, param, size, &value[0], NULL);
+  return value;
+}
+
+static std::string platform_info_string(cl_platform_id platform, cl_platform_info param) {
+  size_t size = 0;
+  if (clGetPlatformInfo(platform, param, 0, NULL, &size) != CL_SUCCESS) { return ""; }
+  std::string value(size, '\0');
+  clGetPlatformInfo(platform, param, size, &value[0], NULL);
+  return value;
+}
+
+static bool make_directories(const std::string& path) {
+  for (size_t i = 1; i <= path.size(); ++i) {
+    if (i == path.size() || path[i] == '/') {
+      const std::string prefix = path.substr(0, i);
+      if (mkdir(prefix.c_str(), 0755) != 0 && errno != EEXIST) { return false; }
+    }
+  }
+  return true;
+}
+
+
+static bool load_cached_program(cl_context context, cl_device_id device, const std::string& path,
+    uint64_t check, const std::string& options, cl_program& program) {
+
+  std::ifstream file(path, std::ios::in | std::ios::binary);
+  if (!file) { return false; }
+
+  char magic[sizeof(PROGRAM_CACHE_MAGIC)];
+  uint64_t file_check = 0;
+  file.read(magic, sizeof(magic));
+  file.read((char*)&file_check, sizeof(file_check));
+  if (!file || memcmp(magic, PROGRAM_CACHE_MAGIC, sizeof(magic)) != 0 || file_check != check) {
+    return false;
+  }
+
+  std::string binary((std::istreambuf_iterator<char>(file)), std::istreambuf_iterator<char>());
+  if (binary.empty()) { return false; }
+
+  size_t binary_size = binary.size();
+  const unsigned char* binary_data = (const unsigned char*)binary.data();
+  cl_int binary_status, ret;
+
+  program = clCreateProgramWithBinary(context, 1, &device, &binary_size, &binary_data, &binary_status, &ret);
+  if (ret != CL_SUCCESS || binary_status != CL_SUCCESS) {
+    if (ret == CL_SUCCESS) { clReleaseProgram(program); }
+    return false;
+  }
+
+  if (clBuildProgram(program, 1, &device, options.c_str(), NULL, NULL) != CL_SUCCESS) {
+    clReleaseProgram(program);
+    return false;
+  }
+  return true;
+}
+
+
+static void save_cached_program(cl_program program, const std::string& dir, const std::string& path, uint64_t check) {
+
+  size_t binary_size = 0;
+  if (clGetProgramInfo(program, CL_PROGRAM_BINARY_SIZES, sizeof(size_t), &binary_size, NULL) != CL_SUCCESS
+      || binary_size == 0) {
+    return;
+  }
+
+  std::string binary(binary_size, '\0');
+  unsigned char* binary_data = (unsigned char*)&binary[0];
+  if (clGetProgramInfo(program, CL_PROGRAM_BINARIES, sizeof(unsigned char*), &binary_data, NULL) != CL_SUCCESS) {
+    return;
+  }
+
+  if (!make_directories(dir)) {
+    LOG(WARNING) << "Cannot create the OpenCL program cache " << dir;
+    return;
+  }
+
+  // Written aside and renamed, a concurrent reader sees all of it or nothing.
+  const std::string temporary = path + ".tmp" + std::to_string(getpid());
+  {
+    std::ofstream file(temporary, std::ios::out | std::ios::binary);
+    file.write(PROGRAM_CACHE_MAGIC, sizeof(PROGRAM_CACHE_MAGIC));
+    file.write((const char*)&check, sizeof(check));
+    file.write(binary.data(), binary.size());
+    if (!file) {
+      remove(temporary.c_str());
+      return;
+    }
+  }
+  rename(temporary.c_str(), path.c_str());
+}
+
+
+void OpenCLHandler::build_opencl_program(const std::string &kernel_code, cl_program &program, const std::string &options) {
+
+  std::string cache_path;
+  uint64_t check = 0;
+
+  if (!program_cache_dir.empty()) {
+
+    const std::string identity = kernel_code + '\0' + options + '\0'
+      + platform_info_string(platformId, CL_PLATFORM_VERSION) + '\0'
+      + device_info_string(deviceID, CL_DEVICE_NAME) + '\0'
+      + device_info_string(deviceID, CL_DEVICE_VENDOR) + '\0'
+      + device_info_string(deviceID, CL_DEVICE_VERSION) + '\0'
+      + device_info_string(deviceID, CL_DRIVER_VERSION);
+
+    char key[17];
+    snprintf(key, sizeof(key), "%016llx", (unsigned long long)fnv1a(identity, 14695981039346656037ULL));
+    check = fnv1a(identity, 0x84222325cbf29ce4ULL);
+    cache_path = program_cache_dir + "/" + key + ".clbin";
+
+    if (load_cached_program(context, deviceID, cache_path, check, options, program)) {
+      return;
+    }
+  }
 
   cl_int ret = -1;
 
@@ -133,10 +408,13 @@ void OpenCLHandler::build_opencl_program(const std::string &kernel_code, cl_prog
   program = clCreateProgramWithSource(context, 1, (const char **)&kernelSource, (const size_t *)&kernel_size, &ret); 
   OPENCL_CHECK(ret);
 
-  ret = clBuildProgram(program, 1, &deviceID, NULL, NULL, NULL);
+  ret = clBuildProgram(program, 1, &deviceID, options.c_str(), NULL, NULL);
 
   OPENCL_BUILD_CHECK(ret);
 
+  if (!cache_path.empty()) {
+    save_cached_program(program, program_cache_dir, cache_path, check);
+  }
 }
 
 
@@ -378,9 +656,7 @@ std::string binary_opencl_math_kernel(
 }
 
 
-std::string OpenCLHandler::opencl_math_code(bool is_half) {
-	
-
+std::string opencl_math_header(bool is_half) {
 
 	std::string opencl_kernel_header = is_half?
 
@@ -409,14 +685,16 @@ std::string OpenCLHandler::opencl_math_code(bool is_half) {
 
 	)";
 
-  
+	return opencl_kernel_header
+		+ "#define OPENCL_KERNEL_LOOP(i, n) for (int i = get_group_id(0) * get_local_size(0) + get_local_id(0); i < (n); i += get_num_groups(0)*get_local_size(0))\n";
+}
 
-	std::string opencl_kernel_code =
 
+std::string OpenCLHandler::opencl_math_code(bool is_half) {
 
-	"#define OPENCL_KERNEL_LOOP(i, n) for (int i = get_group_id(0) * get_local_size(0) + get_local_id(0); i < (n); i += get_num_groups(0)*get_local_size(0))"
+	std::string opencl_kernel_code =
 
-   + unary_opencl_math_kernel("sqrt", "sqrt(x[index]);")
+     unary_opencl_math_kernel("sqrt", "sqrt(x[index]);")
    + unary_opencl_math_kernel("sqr", "x[index] * x[index];")
    + unary_opencl_math_kernel("log", "log(x[index]);")
    + unary_opencl_math_kernel("exp", "exp(x[index]);")
@@ -504,6 +782,35 @@ std::string OpenCLHandler::opencl_math_code(bool is_half) {
   }
 
 
+  // activation follows ACTIVATION_TYPE: 0 none, 1 relu, 2 elu, 3 prelu, 4 tanh
+  __kernel void ChanneledBiasActivationForward(
+    const __global Dtype *in,
+    __global Dtype *out,
+    int N, 
+    const __global Dtype *bias, 
+    int has_bias,
+    int scale_dim, 
+    int inner_dim,
+    int activation,
+    Dtype alpha,
+    const __global Dtype *slope) {
+    OPENCL_KERNEL_LOOP(index, N) {
+      const int scale_index = (index / inner_dim) % scale_dim;
+      Dtype v = has_bias ? in[index] + bias[scale_index] : in[index];
+      if (activation == 1) {
+        v = v > 0 ? v : v * alpha;
+      } else if (activation == 2) {
+        v = v > 0 ? v : alpha * (exp(v) - 1);
+      } else if (activation == 3) {
+        v = v > 0 ? v : v * slope[scale_index];
+      } else if (activation == 4) {
+        v = tanh(v);
+      }
+      out[index] = v;
+    }
+  }
+
+
   __kernel void ChanneledSubForward(
     const __global Dtype *in,
     __global Dtype *out,
@@ -944,7 +1251,7 @@ static inline void SumReduceKernel(
 
 
 
-  	return opencl_kernel_header + opencl_kernel_code;
+  	return opencl_math_header(is_half) + opencl_kernel_code;
 }
 
 #endif
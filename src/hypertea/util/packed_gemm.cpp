@@ -0,0 +1,261 @@
+#include <string.h>
+#include <algorithm>
+
+#include "hypertea/util/packed_gemm.hpp"
+#include "hypertea/util/thread_pool.hpp"
+
+#if defined(__GNUC__) || defined(__clang__)
+#define HYPERTEA_SIMD_VECTOR
+#endif
+
+#if defined(HYPERTEA_SIMD_VECTOR) && (defined(__x86_64__) || defined(__i386__))
+#define HYPERTEA_SIMD_X86
+#endif
+
+namespace hypertea {
+
+
+PackedMatrix::PackedMatrix(const float* a, int rows, int cols, bool transposed)
+  : rows_(rows), cols_(cols) {
+
+  const int panels = (rows + PACKED_GEMM_MR - 1) / PACKED_GEMM_MR;
+  data_.assign((size_t)panels * cols * PACKED_GEMM_MR, 0.f);
+
+  for (int p = 0; p < panels; ++p) {
+    float* panel = data_.data() + (size_t)p * cols * PACKED_GEMM_MR;
+    const int panel_rows = std::min(PACKED_GEMM_MR, rows - p * PACKED_GEMM_MR);
+
+    for (int k = 0; k < cols; ++k) {
+      for (int i = 0; i < panel_rows; ++i) {
+        const int m = p * PACKED_GEMM_MR + i;
+        panel[k * PACKED_GEMM_MR + i] = transposed ? a[(size_t)k * rows + m] : a[(size_t)m * cols + k];
+      }
+    }
+  }
+}
+
+
+// Depth of the A and B blocks a micro-tile accumulates at once, and width of
+// the B block reused across all panels, so that the (KC x MR) panel slice
+// stays in L1 and the (KC x NC) B block in L2.
+static const int PACKED_GEMM_KC = 256;
+static const int PACKED_GEMM_NC = 192;
+
+// Multiply-adds below which the product stays on the calling thread.
+static const int PACKED_GEMM_PARALLEL_THRESHOLD = 1 << 20;
+
+struct PackedGemmArgs {
+  const float* a;
+  int m, n, k;
+  const float* b;
+  int rsb, csb;
+  const float* bias;
+  float beta;
+  float* c;
+  int rsc, csc;
+};
+
+
+#ifdef HYPERTEA_SIMD_VECTOR
+
+#pragma GCC diagnostic ignored "-Wpsabi"
+
+#define SIMD_INLINE inline __attribute__((always_inline))
+
+// One vector per MR rows of a panel; it is split into 2 or 4 registers on
+// AVX2 and SSE2 / NEON.
+typedef float v16sf __attribute__((vector_size(PACKED_GEMM_MR * sizeof(float))));
+
+
+// C(rows x NR) tile of one panel over kc steps of k. The first k block
+// starts from the bias and applies beta, later ones accumulate into C.
+template <int NR>
+SIMD_INLINE void micro_tile(const PackedGemmArgs& g, const float* a, const int kc,
+    const float* b, const float* bias, const int rows, const bool first, float* c) {
+
+  v16sf init = {};
+  if (first && bias != nullptr) {
+    memcpy(&init, bias, rows * sizeof(float));
+  }
+
+  v16sf acc[NR];
+  for (int j = 0; j < NR; ++j) { acc[j] = init; }
+
+  for (int k = 0; k < kc; ++k) {
+    v16sf av;
+    memcpy(&av, a + k * PACKED_GEMM_MR, sizeof(av));
+    const float* bk = b + k * g.rsb;
+    for (int j = 0; j < NR; ++j) {
+      acc[j] += av * bk[j * g.csb];
+    }
+  }
+
+  const bool read_c = !first || g.beta != 0;
+  const float scale = first ? g.beta : 1.f;
+
+  for (int j = 0; j < NR; ++j) {
+
+    float* cj = c + j * g.csc;
+
+    if (g.rsc == 1 && rows == PACKED_GEMM_MR) {
+      v16sf cv = acc[j];
+      if (read_c) {
+        v16sf old;
+        memcpy(&old, cj, sizeof(old));
+        cv += old * scale;
+      }
+      memcpy(cj, &cv, sizeof(cv));
+      continue;
+    }
+
+    float t[PACKED_GEMM_MR];
+    memcpy(t, &acc[j], sizeof(t));
+    for (int i = 0; i < rows; ++i) {
+      float& ci = cj[i * g.rsc];
+      ci = read_c ? t[i] + scale * ci : t[i];
+    }
+  }
+}
+
+
+// Dispatches the last, narrower column tile to micro_tile<nr>.
+template <int NR>
+SIMD_INLINE void micro_tile_tail(const int nr, const PackedGemmArgs& g, const float* a, const int kc,
+    const float* b, const float* bias, const int rows, const bool first, float* c) {
+  if (nr == NR) {
+    micro_tile<NR>(g, a, kc, b, bias, rows, first, c);
+  } else {
+    micro_tile_tail<NR - 1>(nr, g, a, kc, b, bias, rows, first, c);
+  }
+}
+
+template <>
+SIMD_INLINE void micro_tile_tail<0>(const int, const PackedGemmArgs&, const float*, const int,
+    const float*, const float*, const int, const bool, float*) {}
+
+
+template <int NR>
+SIMD_INLINE void packed_gemm_panels(const PackedGemmArgs& g, const int panel_begin, const int panel_end) {
+
+  for (int kb = 0; kb < g.k; kb += PACKED_GEMM_KC) {
+
+    const int kc = std::min(PACKED_GEMM_KC, g.k - kb);
+    const bool first = kb == 0;
+
+    for (int jb = 0; jb < g.n; jb += PACKED_GEMM_NC) {
+
+      const int nc = std::min(PACKED_GEMM_NC, g.n - jb);
+
+      for (int p = panel_begin; p < panel_end; ++p) {
+
+        const int row = p * PACKED_GEMM_MR;
+        const int rows = std::min(PACKED_GEMM_MR, g.m - row);
+        const float* a = g.a + ((size_t)p * g.k + kb) * PACKED_GEMM_MR;
+        const float* bias = g.bias ? g.bias + row : nullptr;
+
+        int j = jb;
+        for (; j + NR <= jb + nc; j += NR) {
+          micro_tile<NR>(g, a, kc, g.b + kb * g.rsb + j * g.csb, bias, rows, first,
+            g.c + row * g.rsc + j * g.csc);
+        }
+        if (j < jb + nc) {
+          micro_tile_tail<NR - 1>(jb + nc - j, g, a, kc, g.b + kb * g.rsb + j * g.csb, bias, rows, first,
+            g.c + row * g.rsc + j * g.csc);
+        }
+      }
+    }
+  }
+}
+
+
+// NR columns per micro-tile: the accumulators take 8 of the 32 AVX-512
+// registers, 12 of the 16 AVX2 ones and 12 of the 16 SSE2 / NEON ones.
+#define DEFINE_PACKED_GEMM_KERNEL(suffix, NR, attribute) \
+  attribute void packed_gemm_##suffix(const PackedGemmArgs& g, int begin, int end) { \
+    packed_gemm_panels<NR>(g, begin, end); \
+  }
+
+DEFINE_PACKED_GEMM_KERNEL(vec4, 3, static)
+
+#ifdef HYPERTEA_SIMD_X86
+DEFINE_PACKED_GEMM_KERNEL(avx2, 6, static __attribute__((target("avx2,fma"))))
+DEFINE_PACKED_GEMM_KERNEL(avx512, 8, static __attribute__((target("avx512f"))))
+#endif //HYPERTEA_SIMD_X86
+
+#else  // scalar fallback
+
+static void packed_gemm_scalar(const PackedGemmArgs& g, int begin, int end) {
+
+  for (int p = begin; p < end; ++p) {
+    const int row = p * PACKED_GEMM_MR;
+    const int rows = std::min(PACKED_GEMM_MR, g.m - row);
+    const float* a = g.a + (size_t)p * g.k * PACKED_GEMM_MR;
+
+    for (int i = 0; i < rows; ++i) {
+      for (int j = 0; j < g.n; ++j) {
+        float sum = g.bias ? g.bias[row + i] : 0.f;
+        for (int k = 0; k < g.k; ++k) {
+          sum += a[k * PACKED_GEMM_MR + i] * g.b[k * g.rsb + j * g.csb];
+        }
+        float& cij = g.c[(row + i) * g.rsc + j * g.csc];
+        cij = g.beta != 0 ? sum + g.beta * cij : sum;
+      }
+    }
+  }
+}
+
+#endif //HYPERTEA_SIMD_VECTOR
+
+
+typedef void (*packed_gemm_kernel)(const PackedGemmArgs& g, int begin, int end);
+
+static packed_gemm_kernel select_packed_gemm_kernel() {
+
+#ifdef HYPERTEA_SIMD_X86
+  __builtin_cpu_init();
+  if (__builtin_cpu_supports("avx512f")) {
+    return packed_gemm_avx512;
+  }
+  if (__builtin_cpu_supports("avx2") && __builtin_cpu_supports("fma")) {
+    return packed_gemm_avx2;
+  }
+  return packed_gemm_vec4;
+#elif defined(HYPERTEA_SIMD_VECTOR)
+  return packed_gemm_vec4;
+#else
+  return packed_gemm_scalar;
+#endif
+}
+
+
+
+void packed_gemm(const PackedMatrix& a, const int n,
+    const float* b, const int b_row_stride, const int b_col_stride,
+    const float* bias, const float beta,
+    float* c, const int c_row_stride, const int c_col_stride) {
+
+  static const packed_gemm_kernel kernel = select_packed_gemm_kernel();
+
+  const PackedGemmArgs g = {
+    a.data(), a.rows(), n, a.cols(),
+    b, b_row_stride, b_col_stride,
+    bias, beta,
+    c, c_row_stride, c_col_stride
+  };
+
+  if (g.m == 0 || g.n == 0) { return; }
+
+  const int panels = (g.m + PACKED_GEMM_MR - 1) / PACKED_GEMM_MR;
+  const int workers = std::min(ThreadPool::Gemm().num_workers(), panels);
+
+  if (workers <= 1 || (double)g.m * g.n * g.k < PACKED_GEMM_PARALLEL_THRESHOLD) {
+    kernel(g, 0, panels);
+    return;
+  }
+
+  ThreadPool::Gemm().parallel_for(workers, [&](int w, int) {
+    kernel(g, panels * w / workers, panels * (w + 1) / workers);
+  });
+}
+
+}  // namespace hypertea
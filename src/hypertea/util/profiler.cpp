@@ -0,0 +1,249 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <algorithm>
+#include <fstream>
+
+#include "hypertea/common.hpp"
+#include "hypertea/util/profiler.hpp"
+
+namespace hypertea {
+
+
+static thread_local int profile_depth_ = 0;
+static std::atomic<int> profile_threads_(0);
+
+static int profile_thread_id() {
+  static thread_local int id = profile_threads_++;
+  return id;
+}
+
+
+Profiler& Profiler::Get() {
+  static Profiler* profiler = new Profiler();
+  return *profiler;
+}
+
+Profiler::Profiler() : enabled_(getenv("HYPERTEA_PROFILE") != nullptr) {}
+
+
+size_t& Profiler::allocated_bytes() {
+  static thread_local size_t bytes = 0;
+  return bytes;
+}
+
+double Profiler::now_us() {
+  static const auto origin = std::chrono::steady_clock::now();
+  return std::chrono::duration<double, std::micro>(std::chrono::steady_clock::now() - origin).count();
+}
+
+
+void Profiler::set_name(const void* op, const std::string& name) {
+  std::lock_guard<std::mutex> lock(mutex_);
+  names_[op] = name;
+}
+
+// Caller holds mutex_.
+std::string Profiler::name_of(const void* op, const char* type) {
+  auto it = names_.find(op);
+  if (it == names_.end()) {
+    it = names_.insert(std::make_pair(op, std::string(type) + "_" + std::to_string(type_counts_[type]++))).first;
+  }
+  return it->second;
+}
+
+
+void Profiler::add(const Record& record) {
+  std::lock_guard<std::mutex> lock(mutex_);
+  name_of(record.op, record.type);
+  records_.push_back(record);
+}
+
+
+void Profiler::clear() {
+  std::lock_guard<std::mutex> lock(mutex_);
+  resolve_device_times();
+  records_.clear();
+  device_us_.clear();
+}
+
+
+// Device (start, duration) of every record in microseconds, (0, -1) where
+// there is none; events are released once read. Caller holds mutex_.
+void Profiler::resolve_device_times() {
+
+  device_us_.resize(records_.size(), std::make_pair(0.0, -1.0));
+
+#ifdef USE_OPENCL
+  for (size_t i = 0; i < records_.size(); ++i) {
+
+    Record& r = records_[i];
+    if (r.device_end == nullptr) { continue; }
+
+    cl_ulong begin = 0, end = 0;
+    OPENCL_CHECK(clWaitForEvents(1, &r.device_end));
+    OPENCL_CHECK(clGetEventProfilingInfo(r.device_begin, CL_PROFILING_COMMAND_END, sizeof(begin), &begin, NULL));
+    OPENCL_CHECK(clGetEventProfilingInfo(r.device_end, CL_PROFILING_COMMAND_END, sizeof(end), &end, NULL));
+    device_us_[i] = std::make_pair(begin / 1000.0, (end - begin) / 1000.0);
+
+    clReleaseEvent(r.device_begin);
+    clReleaseEvent(r.device_end);
+    r.device_begin = r.device_end = nullptr;
+  }
+#endif //USE_OPENCL
+}
+
+
+void Profiler::report(std::ostream& out) {
+
+  std::lock_guard<std::mutex> lock(mutex_);
+  resolve_device_times();
+
+  struct Row {
+    std::string name;
+    const char* type;
+    int calls = 0;
+    double host_us = 0;
+    double device_us = 0;
+    size_t bytes = 0;
+  };
+
+  std::map<const void*, Row> rows;
+  double total_us = 0;
+  bool device = false;
+
+  for (size_t i = 0; i < records_.size(); ++i) {
+    const Record& r = records_[i];
+    Row& row = rows[r.op];
+    row.name = name_of(r.op, r.type);
+    row.type = r.type;
+    row.calls += 1;
+    row.host_us += r.duration_us;
+    row.bytes += r.bytes;
+    if (device_us_[i].second >= 0) {
+      row.device_us += device_us_[i].second;
+      device = true;
+    }
+    // nested invocations are part of their parent already
+    if (r.depth == 0) { total_us += device_us_[i].second >= 0 ? device_us_[i].second : r.duration_us; }
+  }
+
+  std::vector<Row> sorted;
+  for (auto& row : rows) { sorted.push_back(row.second); }
+  std::sort(sorted.begin(), sorted.end(), [device](const Row& a, const Row& b) {
+    return (device ? a.device_us : a.host_us) > (device ? b.device_us : b.host_us);
+  });
+
+  char line[256];
+  snprintf(line, sizeof(line), "%-28s %-20s %7s %12s %12s %12s %7s %12s\n",
+    "operator", "type", "calls", "host ms", "device ms", "mean ms", "%", "bytes");
+  out << line;
+
+  for (auto& row : sorted) {
+    const double us = device ? row.device_us : row.host_us;
+    snprintf(line, sizeof(line), "%-28s %-20s %7d %12.3f %12.3f %12.4f %7.2f %12zu\n",
+      row.name.c_str(), row.type, row.calls, row.host_us / 1000, row.device_us / 1000,
+      us / 1000 / row.calls, total_us > 0 ? 100 * us / total_us : 0, row.bytes);
+    out << line;
+  }
+
+  snprintf(line, sizeof(line), "total %.3f ms in %zu invocations\n", total_us / 1000, records_.size());
+  out << line;
+}
+
+
+static std::string json_string(const std::string& s) {
+  std::string escaped = "\"";
+  for (char c : s) {
+    if (c == '"' || c == '\\') { escaped += '\\'; }
+    if ((unsigned char)c >= 0x20) { escaped += c; }
+  }
+  return escaped + "\"";
+}
+
+
+// Host invocations are on process 0, one track per thread; device time on
+// process 1, shifted so that the first device interval starts with its
+// host call.
+bool Profiler::write_chrome_trace(const std::string& path) {
+
+  std::lock_guard<std::mutex> lock(mutex_);
+  resolve_device_times();
+
+  std::ofstream file(path);
+  if (!file) { return false; }
+
+  double device_shift = 0;
+  for (size_t i = 0; i < records_.size(); ++i) {
+    if (device_us_[i].second >= 0) {
+      device_shift = records_[i].start_us - device_us_[i].first;
+      break;
+    }
+  }
+
+  char buffer[128];
+  file << "{\"traceEvents\":[" << std::endl;
+
+  bool first = true;
+  for (size_t i = 0; i < records_.size(); ++i) {
+
+    const Record& r = records_[i];
+    const std::string name = json_string(name_of(r.op, r.type));
+
+    snprintf(buffer, sizeof(buffer), "\"ph\":\"X\",\"pid\":0,\"tid\":%d,\"ts\":%.3f,\"dur\":%.3f",
+      r.thread, r.start_us, r.duration_us);
+    file << (first ? "" : ",\n") << "{\"name\":" << name << ",\"cat\":" << json_string(r.type)
+         << "," << buffer << ",\"args\":{\"bytes\":" << r.bytes << "}}";
+    first = false;
+
+    if (device_us_[i].second >= 0) {
+      snprintf(buffer, sizeof(buffer), "\"ph\":\"X\",\"pid\":1,\"tid\":0,\"ts\":%.3f,\"dur\":%.3f",
+        device_us_[i].first + device_shift, device_us_[i].second);
+      file << ",\n{\"name\":" << name << ",\"cat\":" << json_string(r.type) << "," << buffer << "}";
+    }
+  }
+
+  file << std::endl << "],\"displayTimeUnit\":\"ms\"}" << std::endl;
+  return (bool)file;
+}
+
+
+
+
+void OperatorProfileScope::begin(const void* op, const char* type, bool device) {
+
+  active_ = true;
+  record_.op = op;
+  record_.type = type;
+  record_.thread = profile_thread_id();
+  record_.depth = profile_depth_++;
+  record_.bytes = Profiler::allocated_bytes();
+
+#ifdef USE_OPENCL
+  if (device) {
+    OPENCL_CHECK(clEnqueueMarkerWithWaitList(current_queue(), 0, NULL, &record_.device_begin));
+  }
+#else
+  (void)device;
+#endif //USE_OPENCL
+
+  record_.start_us = Profiler::now_us();
+}
+
+
+void OperatorProfileScope::end() {
+
+  record_.duration_us = Profiler::now_us() - record_.start_us;
+  record_.bytes = Profiler::allocated_bytes() - record_.bytes;
+  profile_depth_ -= 1;
+
+#ifdef USE_OPENCL
+  if (record_.device_begin != nullptr) {
+    OPENCL_CHECK(clEnqueueMarkerWithWaitList(current_queue(), 0, NULL, &record_.device_end));
+  }
+#endif //USE_OPENCL
+
+  Profiler::Get().add(record_);
+}
+
+
+}  // namespace hypertea
@@ -7,6 +7,7 @@
 
 #include "hypertea/common.hpp"
 #include "hypertea/util/tensor_gpu_math_func.hpp"
+#include "hypertea/util/device_buffer_pool.hpp"
 
 
 #include <clblast_c.h>
@@ -505,6 +506,71 @@ template TensorGPU<half>& inplace_channeled_add(
 );
 
 
+template <typename Dtype>
+TensorGPU<Dtype>& inplace_channeled_bias_activation(
+
+  TensorGPU<Dtype>& x, 
+  const TensorGPU<Dtype>* bias,
+  int channels,
+  int inner_dim,
+  ACTIVATION_TYPE activation,
+  float alpha,
+  const TensorGPU<Dtype>* slope) {
+  
+
+  int N = x.count();
+  auto data = x.mutable_data();
+  cl_mem bias_ = bias ? bias->mutable_data() : nullptr;
+  cl_mem slope_ = slope ? slope->mutable_data() : nullptr;
+  int has_bias = bias ? 1 : 0;
+  int activation_ = static_cast<int>(activation);
+  Dtype alpha_ = to_dtype<Dtype>(alpha);
+
+
+  opencl_launch_wrapper(
+    OpenCLHandler::Get().math_program,
+    "ChanneledBiasActivationForward",
+    std::vector<std::pair<size_t, const void *> > {
+      std::make_pair(sizeof(cl_mem), (void *)&data),
+      std::make_pair(sizeof(cl_mem), (void *)&data),
+      std::make_pair(sizeof(cl_int), (void *)&N),
+      std::make_pair(sizeof(cl_mem), (void *)&bias_),
+      std::make_pair(sizeof(cl_int), (void *)&has_bias),
+      std::make_pair(sizeof(cl_int), (void *)&channels),
+      std::make_pair(sizeof(cl_int), (void *)&inner_dim),
+      std::make_pair(sizeof(cl_int), (void *)&activation_),
+      std::make_pair(sizeof(Dtype), (void *)&alpha_),
+      std::make_pair(sizeof(cl_mem), (void *)&slope_),
+
+    },
+    std::vector<size_t> {HYPERTEA_GET_BLOCKS(N)},
+    std::vector<size_t> {HYPERTEA_OPENCL_NUM_THREADS}
+  );
+
+  return x;
+}
+
+template TensorGPU<float>& inplace_channeled_bias_activation(
+  TensorGPU<float>& x, 
+  const TensorGPU<float>* bias,
+  int channels,
+  int inner_dim,
+  ACTIVATION_TYPE activation,
+  float alpha,
+  const TensorGPU<float>* slope
+);
+
+template TensorGPU<half>& inplace_channeled_bias_activation(
+  TensorGPU<half>& x, 
+  const TensorGPU<half>* bias,
+  int channels,
+  int inner_dim,
+  ACTIVATION_TYPE activation,
+  float alpha,
+  const TensorGPU<half>* slope
+);
+
+
 template <typename Dtype>
 TensorGPU<Dtype>& inplace_channeled_sub(
   TensorGPU<Dtype>& x, 
@@ -722,7 +788,8 @@ std::vector<int> batched_argmax(
 
 
 
-  cl_mem max_index_ = clCreateBuffer(OpenCLHandler::Get().context, CL_MEM_READ_WRITE, batch_size * sizeof(int), NULL, NULL);
+  auto max_index_buffer = DeviceBufferPool::Get().allocate(batch_size * sizeof(int));
+  cl_mem max_index_ = (cl_mem)max_index_buffer.get();
 
 
   opencl_launch_wrapper(
@@ -741,9 +808,7 @@ std::vector<int> batched_argmax(
 
   auto max_index = std::vector<int>(batch_size);
 
-  OPENCL_CHECK(clEnqueueReadBuffer(OpenCLHandler::Get().commandQueue, max_index_, CL_TRUE, 0, batch_size * sizeof(int), max_index.data(), 0, NULL, NULL));
-
-  clReleaseMemObject(max_index_);
+  OPENCL_CHECK(clEnqueueReadBuffer(current_queue(), max_index_, CL_TRUE, 0, batch_size * sizeof(int), max_index.data(), 0, NULL, NULL));
 
   return max_index;
 
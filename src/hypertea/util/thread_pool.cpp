@@ -0,0 +1,138 @@
+#include <algorithm>
+#include <cblas.h>
+
+#include "hypertea/util/thread_pool.hpp"
+
+namespace hypertea {
+
+static thread_local bool inside_pool_job_ = false;
+
+
+ThreadPool& ThreadPool::Get() {
+  static ThreadPool instance;
+  return instance;
+}
+
+ThreadPool& ThreadPool::Gemm() {
+  static ThreadPool* instance = []() {
+    static ThreadPool pool;
+    pool.resize(std::thread::hardware_concurrency());
+    return &pool;
+  }();
+  return *instance;
+}
+
+ThreadPool::~ThreadPool() {
+  stop_workers();
+}
+
+
+void ThreadPool::set_parallelism(int inter_image, int gemm_threads) {
+
+  resize(inter_image);
+
+  if (gemm_threads > 0) {
+    Gemm().resize(gemm_threads);
+    openblas_set_num_threads(gemm_threads);
+  }
+}
+
+
+void ThreadPool::resize(int workers) {
+  std::lock_guard<std::mutex> run_lock(run_mutex_);
+  stop_workers();
+  start_workers(std::max(workers, 1) - 1);
+}
+
+
+void ThreadPool::start_workers(int count) {
+
+  int generation;
+  {
+    std::lock_guard<std::mutex> lock(mutex_);
+    stop_ = false;
+    generation = generation_;
+  }
+
+  // New workers must not take the last job, which has already completed,
+  // for one published to them.
+  for (int i = 0; i < count; ++i) {
+    threads_.push_back(std::thread(&ThreadPool::worker_loop, this, i + 1, generation));
+  }
+}
+
+void ThreadPool::stop_workers() {
+  {
+    std::lock_guard<std::mutex> lock(mutex_);
+    stop_ = true;
+  }
+  start_.notify_all();
+
+  for (auto& t : threads_) { t.join(); }
+  threads_.clear();
+}
+
+
+void ThreadPool::worker_loop(int worker, int seen_generation) {
+
+  inside_pool_job_ = true;
+
+  while (true) {
+
+    std::unique_lock<std::mutex> lock(mutex_);
+    start_.wait(lock, [&]() { return stop_ || generation_ != seen_generation; });
+
+    if (stop_) { return; }
+
+    seen_generation = generation_;
+    if (worker >= job_workers_) { continue; }
+
+    lock.unlock();
+    run_job(worker);
+    lock.lock();
+
+    if (--active_ == 0) { done_.notify_one(); }
+  }
+}
+
+
+void ThreadPool::run_job(int worker) {
+  int index;
+  while ((index = next_index_++) < job_size_) {
+    (*job_)(index, worker);
+  }
+}
+
+
+void ThreadPool::parallel_for(int n, const std::function<void(int, int)>& fn, int max_workers) {
+
+  const int workers = std::min(std::min(num_workers(), max_workers), n);
+
+  if (workers <= 1 || inside_pool_job_) {
+    for (int i = 0; i < n; ++i) { fn(i, 0); }
+    return;
+  }
+
+  std::lock_guard<std::mutex> run_lock(run_mutex_);
+
+  {
+    std::lock_guard<std::mutex> lock(mutex_);
+    job_ = &fn;
+    job_size_ = n;
+    job_workers_ = workers;
+    next_index_ = 0;
+    active_ = workers - 1;
+    generation_ += 1;
+  }
+  start_.notify_all();
+
+  inside_pool_job_ = true;
+  run_job(0);
+  inside_pool_job_ = false;
+
+  std::unique_lock<std::mutex> lock(mutex_);
+  done_.wait(lock, [&]() { return active_ == 0; });
+  job_ = nullptr;
+}
+
+}  // namespace hypertea
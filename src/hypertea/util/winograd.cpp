@@ -0,0 +1,196 @@
+#include <algorithm>
+#include <vector>
+
+#include "hypertea/util/winograd.hpp"
+
+namespace hypertea {
+
+// The transforms below are B^T d, G g and A^T m written out for one
+// vector; each 2D transform applies them first along columns, then rows.
+
+inline void winograd_input_transform(const float* d, int stride, float* out, int out_stride) {
+  out[0 * out_stride] = 4 * d[0] - 5 * d[2 * stride] + d[4 * stride];
+  out[1 * out_stride] = -4 * (d[stride] + d[2 * stride]) + d[3 * stride] + d[4 * stride];
+  out[2 * out_stride] = 4 * (d[stride] - d[2 * stride]) - d[3 * stride] + d[4 * stride];
+  out[3 * out_stride] = 2 * (d[3 * stride] - d[stride]) - d[2 * stride] + d[4 * stride];
+  out[4 * out_stride] = 2 * (d[stride] - d[3 * stride]) - d[2 * stride] + d[4 * stride];
+  out[5 * out_stride] = 4 * d[stride] - 5 * d[3 * stride] + d[5 * stride];
+}
+
+inline void winograd_weight_transform(const float* g, int stride, float* out, int out_stride) {
+  out[0 * out_stride] = g[0] / 4;
+  out[1 * out_stride] = -(g[0] + g[stride] + g[2 * stride]) / 6;
+  out[2 * out_stride] = -(g[0] - g[stride] + g[2 * stride]) / 6;
+  out[3 * out_stride] = g[0] / 24 + g[stride] / 12 + g[2 * stride] / 6;
+  out[4 * out_stride] = g[0] / 24 - g[stride] / 12 + g[2 * stride] / 6;
+  out[5 * out_stride] = g[2 * stride];
+}
+
+inline void winograd_output_transform(const float* m, int stride, float* out, int out_stride) {
+  float a = m[stride] + m[2 * stride];
+  float b = m[stride] - m[2 * stride];
+  float c = m[3 * stride] + m[4 * stride];
+  float d = m[3 * stride] - m[4 * stride];
+  out[0 * out_stride] = m[0] + a + c;
+  out[1 * out_stride] = b + 2 * d;
+  out[2 * out_stride] = a + 4 * c;
+  out[3 * out_stride] = b + 8 * d + m[5 * stride];
+}
+
+
+TensorCPU<float> winograd_transform_weight(const TensorCPU<float>& weight,
+    const int out_channels, const int in_channels) {
+
+  const int pairs = out_channels * in_channels;
+  auto transformed = TensorCPU<float>(WINOGRAD_ALPHA * WINOGRAD_ALPHA * pairs);
+
+  auto weight_data = weight.immutable_data();
+  auto transformed_data = transformed.mutable_data();
+
+  float tmp[WINOGRAD_ALPHA * 3];
+  float u[WINOGRAD_ALPHA * WINOGRAD_ALPHA];
+
+  for (int p = 0; p < pairs; ++p) {
+    const float* g = weight_data + p * 9;
+
+    for (int j = 0; j < 3; ++j) {
+      winograd_weight_transform(g + j, 3, tmp + j, 3);
+    }
+    for (int i = 0; i < WINOGRAD_ALPHA; ++i) {
+      winograd_weight_transform(tmp + i * 3, 1, u + i * WINOGRAD_ALPHA, 1);
+    }
+
+    for (int xi = 0; xi < WINOGRAD_ALPHA * WINOGRAD_ALPHA; ++xi) {
+      transformed_data[xi * pairs + p] = u[xi];
+    }
+  }
+
+  return transformed;
+}
+
+
+void winograd_conv(const TensorCPU<float>& data_im,
+    const int num, const int channels, const int height, const int width,
+    const int pad_h, const int pad_w,
+    const TensorCPU<float>& transformed_weight, const int out_channels,
+    const int output_h, const int output_w,
+    TensorCPU<float>& data_out,
+    const float* bias,
+    ACTIVATION_TYPE activation,
+    float alpha, const float* slope) {
+
+  const int tiles_h = (output_h + WINOGRAD_TILE - 1) / WINOGRAD_TILE;
+  const int tiles_w = (output_w + WINOGRAD_TILE - 1) / WINOGRAD_TILE;
+  const int tiles = tiles_h * tiles_w;
+  const int total_tiles = num * tiles;
+  const int elements = WINOGRAD_ALPHA * WINOGRAD_ALPHA;
+
+  auto transformed_input = TensorCPU<float>(elements * channels * total_tiles);
+  auto transformed_output = TensorCPU<float>(elements * out_channels * total_tiles);
+
+  auto im_data = data_im.immutable_data();
+  auto v_data = transformed_input.mutable_data();
+  auto m_data = transformed_output.mutable_data();
+  auto out_data = data_out.mutable_data();
+
+  const int v_stride = channels * total_tiles;
+  const int m_stride = out_channels * total_tiles;
+
+  float d[elements];
+  float tmp[elements];
+  float v[elements];
+
+  for (int n = 0; n < num; ++n) {
+    for (int c = 0; c < channels; ++c) {
+
+      const float* channel_data = im_data + (n * channels + c) * height * width;
+
+      for (int th = 0; th < tiles_h; ++th) {
+        for (int tw = 0; tw < tiles_w; ++tw) {
+
+          const int row0 = th * WINOGRAD_TILE - pad_h;
+          const int col0 = tw * WINOGRAD_TILE - pad_w;
+
+          for (int i = 0; i < WINOGRAD_ALPHA; ++i) {
+            const int row = row0 + i;
+            for (int j = 0; j < WINOGRAD_ALPHA; ++j) {
+              const int col = col0 + j;
+              d[i * WINOGRAD_ALPHA + j] =
+                (row >= 0 && row < height && col >= 0 && col < width) ?
+                channel_data[row * width + col] : 0;
+            }
+          }
+
+          for (int j = 0; j < WINOGRAD_ALPHA; ++j) {
+            winograd_input_transform(d + j, WINOGRAD_ALPHA, tmp + j, WINOGRAD_ALPHA);
+          }
+          for (int i = 0; i < WINOGRAD_ALPHA; ++i) {
+            winograd_input_transform(tmp + i * WINOGRAD_ALPHA, 1, v + i * WINOGRAD_ALPHA, 1);
+          }
+
+          const int t = n * tiles + th * tiles_w + tw;
+          for (int xi = 0; xi < elements; ++xi) {
+            v_data[xi * v_stride + c * total_tiles + t] = v[xi];
+          }
+        }
+      }
+    }
+  }
+
+
+  auto u_data = transformed_weight.immutable_data();
+
+  for (int xi = 0; xi < elements; ++xi) {
+    cblas_sgemm(CblasRowMajor, CblasNoTrans, CblasNoTrans,
+      out_channels, total_tiles, channels,
+      1., u_data + xi * out_channels * channels, channels,
+      v_data + xi * v_stride, total_tiles,
+      0., m_data + xi * m_stride, total_tiles);
+  }
+
+
+  float m[elements];
+  float y[WINOGRAD_TILE * WINOGRAD_ALPHA];
+  float o[WINOGRAD_TILE * WINOGRAD_TILE];
+
+  for (int n = 0; n < num; ++n) {
+    for (int k = 0; k < out_channels; ++k) {
+
+      float* channel_out = out_data + (n * out_channels + k) * output_h * output_w;
+      const float b = bias ? bias[k] : 0;
+      const float a = (activation == ACTIVATION_TYPE::PRELU) ? slope[k] : alpha;
+
+      for (int th = 0; th < tiles_h; ++th) {
+        for (int tw = 0; tw < tiles_w; ++tw) {
+
+          const int t = n * tiles + th * tiles_w + tw;
+          for (int xi = 0; xi < elements; ++xi) {
+            m[xi] = m_data[xi * m_stride + k * total_tiles + t];
+          }
+
+          for (int j = 0; j < WINOGRAD_ALPHA; ++j) {
+            winograd_output_transform(m + j, WINOGRAD_ALPHA, y + j, WINOGRAD_ALPHA);
+          }
+          for (int i = 0; i < WINOGRAD_TILE; ++i) {
+            winograd_output_transform(y + i * WINOGRAD_ALPHA, 1, o + i * WINOGRAD_TILE, 1);
+          }
+
+          const int row0 = th * WINOGRAD_TILE;
+          const int col0 = tw * WINOGRAD_TILE;
+          const int rows = std::min(WINOGRAD_TILE, output_h - row0);
+          const int cols = std::min(WINOGRAD_TILE, output_w - col0);
+
+          for (int i = 0; i < rows; ++i) {
+            for (int j = 0; j < cols; ++j) {
+              channel_out[(row0 + i) * output_w + col0 + j] =
+                activation_value(o[i * WINOGRAD_TILE + j] + b, activation, a);
+            }
+          }
+        }
+      }
+    }
+  }
+
+}
+
+}  // namespace hypertea
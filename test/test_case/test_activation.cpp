@@ -188,4 +188,34 @@ TYPED_TEST(ACTIVATION_Test, test_outplace_tanh) {
 
 }
 
+
+TYPED_TEST(ACTIVATION_Test, test_softmax) {
+
+  using DeviceTensor = TypeParam;
+  
+  fake_random_number random_generator;
+
+  const int spatial_dim = 16;
+
+  auto softmax_op = SoftMaxOp<DeviceTensor>(spatial_dim);
+
+  auto a = DeviceTensor(random_generator.generate_random_vector(64));
+  auto a_data = a.debug_gtest_cpu_data();
+  
+  auto y = softmax_op(a);
+  
+  auto y_data = y.debug_gtest_cpu_data();
+
+  for (int n = 0; n < a.count() / spatial_dim; ++n) {
+    float sum = 0;
+    for (int i = 0; i < spatial_dim; ++i) {
+      sum += exp(a_data.get()[n * spatial_dim + i]);
+    }
+    for (int i = 0; i < spatial_dim; ++i) {
+      EXPECT_NEAR(y_data.get()[n * spatial_dim + i], exp(a_data.get()[n * spatial_dim + i]) / sum, 1e-3);
+    }
+  }
+
+}
+
 }  // namespace caffe
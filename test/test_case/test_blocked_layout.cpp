@@ -0,0 +1,160 @@
+#include <algorithm>
+#include <vector>
+
+#include "gtest/gtest.h"
+
+
+#include "hypertea/common.hpp"
+
+#include "test_hypertea_util.hpp"
+#include "hypertea/operators/blocked_op.hpp"
+#include "hypertea/operators/conv_op.hpp"
+
+
+namespace hypertea {
+
+
+static TensorCPU<float> to_blocked(TensorCPU<float>& x, int channels, int spatial_dim, int block) {
+  return ReorderOp(channels, spatial_dim, block, LAYOUT_REORDER::TO_NCHWC)(x);
+}
+
+static TensorCPU<float> to_nchw(TensorCPU<float>& x, int channels, int spatial_dim, int block) {
+  return ReorderOp(channels, spatial_dim, block, LAYOUT_REORDER::TO_NCHW)(x);
+}
+
+
+TEST(BLOCKED_LAYOUT_Test, test_reorder_round_trip) {
+
+  fake_random_number random_generator;
+
+  const int num = 2, channels = 11, spatial_dim = 7;
+  auto x = TensorCPU<float>(random_generator.generate_random_vector(num * channels * spatial_dim));
+
+  for (int block : {8, 16}) {
+
+    auto blocked = to_blocked(x, channels, spatial_dim, block);
+    ASSERT_EQ(blocked.count(), num * blocked_channels(channels, block) * spatial_dim);
+
+    // Channel c of pixel s sits at lane c % block of block c / block.
+    auto b = blocked.immutable_data();
+    EXPECT_EQ(b[(1 * (blocked_channels(channels, block) / block) + 10 / block) * spatial_dim * block + 3 * block + 10 % block],
+      x.immutable_data()[(1 * channels + 10) * spatial_dim + 3]);
+    // Channels 11 .. 15 of the last block are padding.
+    EXPECT_EQ(b[(blocked_channels(channels, block) / block - 1) * spatial_dim * block + block - 1], 0.f);
+
+    auto y = to_nchw(blocked, channels, spatial_dim, block).debug_gtest_cpu_data();
+    for (int i = 0; i < x.count(); ++i) {
+      EXPECT_EQ(y.get()[i], x.immutable_data()[i]);
+    }
+  }
+}
+
+
+TEST(BLOCKED_LAYOUT_Test, test_blocked_conv_matches_conv) {
+
+  fake_random_number random_generator;
+
+  struct Case { int channels, out_channels, kernel, stride, pad, dilation; ACTIVATION_TYPE activation; };
+  const Case cases[] = {
+    {5, 7, 3, 1, 1, 1, ACTIVATION_TYPE::RELU},
+    {16, 16, 3, 2, 1, 1, ACTIVATION_TYPE::NONE},
+    {20, 9, 1, 1, 0, 1, ACTIVATION_TYPE::ELU},
+    {3, 18, 5, 1, 2, 1, ACTIVATION_TYPE::TANH},
+    {8, 8, 3, 1, 2, 2, ACTIVATION_TYPE::RELU},
+  };
+
+  const int num = 2, height = 13, width = 17;
+
+  for (auto& c : cases) {
+    for (int block : {8, 16}) {
+
+      const int extent = c.dilation * (c.kernel - 1) + 1;
+      const int output_h = (height + 2 * c.pad - extent) / c.stride + 1;
+      const int output_w = (width + 2 * c.pad - extent) / c.stride + 1;
+
+      auto weight = TensorCPU<float>(random_generator.generate_random_vector(c.out_channels * c.channels * c.kernel * c.kernel));
+      auto bias = TensorCPU<float>(random_generator.generate_random_vector(c.out_channels));
+      auto input = TensorCPU<float>(random_generator.generate_random_vector(num * c.channels * height * width));
+
+      std::vector<int> kernel {c.kernel, c.kernel}, stride {c.stride, c.stride}, pad {c.pad, c.pad}, dilation {c.dilation, c.dilation};
+      std::vector<int> input_shape {num, c.channels, height, width}, output_shape {num, c.out_channels, output_h, output_w};
+
+      auto conv = FusedConvolutionOp<TensorCPU<float>>(&weight, &bias, 1, c.kernel == 1,
+        kernel, stride, pad, dilation, input_shape, output_shape, c.activation, 0.1);
+      auto blocked_conv = BlockedConvolutionOp(&weight, &bias,
+        kernel, stride, pad, dilation, input_shape, output_shape, block, c.activation, 0.1);
+
+      auto expected = conv(input).debug_gtest_cpu_data();
+
+      auto blocked_input = to_blocked(input, c.channels, height * width, block);
+      auto blocked_output = blocked_conv(blocked_input);
+      auto output = to_nchw(blocked_output, c.out_channels, output_h * output_w, block).debug_gtest_cpu_data();
+
+      for (int i = 0; i < num * c.out_channels * output_h * output_w; ++i) {
+        EXPECT_NEAR(output.get()[i], expected.get()[i], 1e-3);
+      }
+    }
+  }
+}
+
+
+TEST(BLOCKED_LAYOUT_Test, test_blocked_batch_norm) {
+
+  fake_random_number random_generator;
+
+  const int num = 2, channels = 10, spatial_dim = 15, block = 8;
+
+  auto mean = TensorCPU<float>(random_generator.generate_random_vector(channels));
+  auto variance = TensorCPU<float>(random_generator.generate_random_vector(channels));
+  auto weight = TensorCPU<float>(random_generator.generate_random_vector(channels));
+  auto bias = TensorCPU<float>(random_generator.generate_random_vector(channels));
+  auto input = TensorCPU<float>(random_generator.generate_random_vector(num * channels * spatial_dim));
+
+  inplace_abs(variance);
+
+  auto bn = BatchNormOp<TensorCPU<float>>(channels, spatial_dim, 1e-5, &mean, &variance, &weight, &bias);
+  auto blocked_bn = BlockedBatchNormOp(channels, spatial_dim, 1e-5, mean, variance, &weight, &bias, block);
+
+  auto expected = bn(input).debug_gtest_cpu_data();
+
+  auto blocked_input = to_blocked(input, channels, spatial_dim, block);
+  auto blocked_output = blocked_bn(blocked_input);
+  auto output = to_nchw(blocked_output, channels, spatial_dim, block).debug_gtest_cpu_data();
+
+  for (int i = 0; i < input.count(); ++i) {
+    EXPECT_NEAR(output.get()[i], expected.get()[i], 1e-3);
+  }
+}
+
+
+TEST(BLOCKED_LAYOUT_Test, test_blocked_upsampling_and_concate) {
+
+  fake_random_number random_generator;
+
+  const int num = 2, height = 3, width = 5, block = 8;
+
+  auto a = TensorCPU<float>(random_generator.generate_random_vector(num * 16 * height * width));
+  auto b = TensorCPU<float>(random_generator.generate_random_vector(num * 5 * height * width));
+
+  auto expected_up = upsampling_2d(b, 2, height, width, height * width).debug_gtest_cpu_data();
+
+  auto blocked_b = to_blocked(b, 5, height * width, block);
+  auto up = blocked_upsampling_2d(blocked_b, 2, height, width, block);
+  auto output_up = to_nchw(up, 5, height * width * 4, block).debug_gtest_cpu_data();
+
+  for (int i = 0; i < b.count() * 4; ++i) {
+    EXPECT_EQ(output_up.get()[i], expected_up.get()[i]);
+  }
+
+  auto expected_cat = hconcate(std::vector<TensorCPU<float>* > {&a, &b}, num).debug_gtest_cpu_data();
+
+  auto blocked_a = to_blocked(a, 16, height * width, block);
+  auto cat = blocked_concate(std::vector<TensorCPU<float>* > {&blocked_a, &blocked_b}, num);
+  auto output_cat = to_nchw(cat, 21, height * width, block).debug_gtest_cpu_data();
+
+  for (int i = 0; i < a.count() + b.count(); ++i) {
+    EXPECT_EQ(output_cat.get()[i], expected_cat.get()[i]);
+  }
+}
+
+}  // namespace hypertea
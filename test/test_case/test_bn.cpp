@@ -8,6 +8,7 @@
 
 #include "test_hypertea_util.hpp"
 #include "hypertea/operators/batch_norm_op.hpp"
+#include "hypertea/operators/conv_op.hpp"
 #include "test_result/bn_result.hpp"
 
 
@@ -253,6 +254,64 @@ TYPED_TEST(BNTest, test_bn_1_f_t_t) {
 }
 
     
+TYPED_TEST(BNTest, test_bn_fold_into_conv) {
+  typedef TypeParam DeviceTensor;
+  
+  fake_random_number random_generator;
+
+  auto conv_weight = DeviceTensor(random_generator.generate_random_vector(54));
+  auto conv_bias = DeviceTensor(random_generator.generate_random_vector(3));
+
+  auto mean = DeviceTensor(random_generator.generate_random_vector(3));
+  auto var = DeviceTensor(random_generator.generate_random_vector(3));
+  inplace_abs(var);
+  auto weight = DeviceTensor(random_generator.generate_random_vector(3));
+  auto bias = DeviceTensor(random_generator.generate_random_vector(3));
+
+  auto input_tensor = DeviceTensor(random_generator.generate_random_vector(256));
+
+  auto conv = ConvolutionOp<DeviceTensor>(&conv_weight, &conv_bias, 1, false, std::vector<int> {3,3}, std::vector<int> {1,1}, std::vector<int> {1,1}, std::vector<int> {1,1}, std::vector<int> {2,2,8,8}, std::vector<int> {2,3,8,8});
+  auto bn = BatchNormOp<DeviceTensor>(3, 64, 1e-05, &mean, &var, &weight, &bias, NOT_IN_PLACE);
+
+  auto expected = bn(conv(input_tensor)).debug_gtest_cpu_data();
+
+  ASSERT_TRUE(bn.foldable());
+  conv.fold_batch_norm(bn);
+
+  auto output_data = conv(input_tensor).debug_gtest_cpu_data();
+
+  for (int i = 0; i < 2 * 3 * 64; ++i) {
+    EXPECT_NEAR(output_data.get()[i], expected.get()[i], 1e-3);
+  }
+}
+
+
+TYPED_TEST(BNTest, test_bn_fold_without_running_stats) {
+  typedef TypeParam DeviceTensor;
+
+  fake_random_number random_generator;
+
+  auto conv_weight = DeviceTensor(random_generator.generate_random_vector(54));
+  auto conv_bias = DeviceTensor(random_generator.generate_random_vector(3));
+  auto weight_before = conv_weight.debug_gtest_cpu_data();
+  auto bias_before = conv_bias.debug_gtest_cpu_data();
+
+  auto bn = BatchNormOp<DeviceTensor>(3, 64, 1e-05, nullptr, nullptr, nullptr, nullptr, NOT_IN_PLACE);
+  ASSERT_FALSE(bn.foldable());
+
+  auto folded_bias = bn.fold_into(conv_weight, &conv_bias).debug_gtest_cpu_data();
+  auto weight_after = conv_weight.debug_gtest_cpu_data();
+
+  for (int i = 0; i < 54; ++i) {
+    EXPECT_EQ(weight_after.get()[i], weight_before.get()[i]);
+  }
+  for (int i = 0; i < 3; ++i) {
+    EXPECT_EQ(folded_bias.get()[i], bias_before.get()[i]);
+  }
+}
+
+    
+
   
 /*
 
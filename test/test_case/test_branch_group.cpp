@@ -0,0 +1,62 @@
+#ifdef USE_OPENCL
+
+#include <cmath>
+#include <vector>
+
+#include "gtest/gtest.h"
+
+
+#include "hypertea/hypertea.hpp"
+
+#include "test_hypertea_util.hpp"
+
+
+namespace hypertea {
+
+
+TEST(BRANCH_GROUP_Test, test_branches_run_on_own_queues) {
+
+  auto trunk = current_queue();
+  std::vector<cl_command_queue> queues;
+
+  {
+    BranchGroup group;
+    group.run([&]() { queues.push_back(current_queue()); });
+    group.run([&]() { queues.push_back(current_queue()); });
+  }
+
+  EXPECT_EQ(current_queue(), trunk);
+  EXPECT_NE(queues[0], trunk);
+  EXPECT_NE(queues[1], trunk);
+  EXPECT_NE(queues[0], queues[1]);
+}
+
+
+TEST(BRANCH_GROUP_Test, test_branch_results_after_join) {
+
+  fake_random_number random_generator;
+  const int N = 1000;
+
+  auto x_vec = random_generator.generate_random_vector(N);
+  TensorGPU<float> x(x_vec);
+
+  TensorGPU<float> a(N), b(N);
+
+  BranchGroup group;
+  group.run([&]() { a.copy_data(outplace_exp(x)); });
+  TensorGPU<float> y = outplace_add_scalar(x, 1.0f);  // trunk work in between
+  group.run([&]() { b.copy_data(outplace_abs(y)); });
+  group.join();
+
+  auto a_data = a.debug_gtest_cpu_data();
+  auto b_data = b.debug_gtest_cpu_data();
+  for (int i = 0; i < N; ++i) {
+    EXPECT_NEAR(a_data.get()[i], expf(x_vec[i]), 1e-4);
+    EXPECT_NEAR(b_data.get()[i], fabs(x_vec[i] + 1.0f), 1e-4);
+  }
+}
+
+
+}  // namespace hypertea
+
+#endif //USE_OPENCL
@@ -9,6 +9,7 @@
 #include "test_hypertea_util.hpp"
 #include "hypertea/operators/conv_op.hpp"
 #include "hypertea/operators/deconv_op.hpp"
+#include "hypertea/operators/activation.hpp"
 
 #include "test_result/conv_result.hpp"
 #include "test_result/deconv_result.hpp"
@@ -241,6 +242,308 @@ TYPED_TEST(CONV_Test, test_conv_4_3_3_2_2_3) {
 
     
 
+TEST(CONV_Winograd_Test, test_winograd_matches_conv_oracles) {
+
+  fake_random_number random_generator;
+
+  auto weight = TensorCPU<float>(random_generator.generate_random_vector(54));
+  auto bias = TensorCPU<float>(random_generator.generate_random_vector(3));
+  auto input_tensor = TensorCPU<float>(random_generator.generate_random_vector(256));
+
+  auto convolutional = ConvolutionOp<TensorCPU<float>>(&weight, &bias, 1, false, std::vector<int> {3,3}, std::vector<int> {1,1}, std::vector<int> {0,0}, std::vector<int> {1,1}, std::vector<int> {2,2,8,8}, std::vector<int> {2,3,6,6});
+  ASSERT_TRUE(convolutional.use_winograd());
+
+  auto output_data = convolutional(input_tensor).debug_gtest_cpu_data();
+  for (int i = 0; i < test_result::conv_2_3_3_1_0_1_result.size(); ++i) {
+    EXPECT_NEAR(output_data.get()[i], test_result::conv_2_3_3_1_0_1_result[i], 1e-3);
+  }
+
+
+  random_generator.pos = 0;
+
+  auto weight4 = TensorCPU<float>(random_generator.generate_random_vector(108));
+  auto bias4 = TensorCPU<float>(random_generator.generate_random_vector(3));
+  auto input_tensor4 = TensorCPU<float>(random_generator.generate_random_vector(512));
+
+  auto convolutional4 = ConvolutionOp<TensorCPU<float>>(&weight4, &bias4, 1, false, std::vector<int> {3,3}, std::vector<int> {1,1}, std::vector<int> {0,0}, std::vector<int> {1,1}, std::vector<int> {2,4,8,8}, std::vector<int> {2,3,6,6});
+  ASSERT_TRUE(convolutional4.use_winograd());
+
+  output_data = convolutional4(input_tensor4).debug_gtest_cpu_data();
+  for (int i = 0; i < test_result::conv_4_3_3_1_0_1_result.size(); ++i) {
+    EXPECT_NEAR(output_data.get()[i], test_result::conv_4_3_3_1_0_1_result[i], 1e-3);
+  }
+}
+
+
+TEST(CONV_Winograd_Test, test_winograd_padded_partial_tiles) {
+
+  const int num = 2, channels = 5, out_channels = 7, height = 11, width = 9;
+
+  fake_random_number random_generator;
+
+  auto weight = TensorCPU<float>(random_generator.generate_random_vector(out_channels * channels * 9));
+  auto input_tensor = TensorCPU<float>(random_generator.generate_random_vector(num * channels * height * width));
+
+  auto convolutional = ConvolutionOp<TensorCPU<float>>(&weight, nullptr, 1, false, std::vector<int> {3,3}, std::vector<int> {1,1}, std::vector<int> {1,1}, std::vector<int> {1,1}, std::vector<int> {num,channels,height,width}, std::vector<int> {num,out_channels,height,width});
+  ASSERT_TRUE(convolutional.use_winograd());
+
+  auto output_data = convolutional(input_tensor).debug_gtest_cpu_data();
+
+  auto w = weight.immutable_data();
+  auto x = input_tensor.immutable_data();
+
+  for (int n = 0; n < num; ++n) {
+    for (int k = 0; k < out_channels; ++k) {
+      for (int h = 0; h < height; ++h) {
+        for (int v = 0; v < width; ++v) {
+
+          float expected = 0;
+          for (int c = 0; c < channels; ++c) {
+            for (int i = 0; i < 3; ++i) {
+              for (int j = 0; j < 3; ++j) {
+                int row = h + i - 1, col = v + j - 1;
+                if (row < 0 || row >= height || col < 0 || col >= width) { continue; }
+                expected += w[((k * channels + c) * 3 + i) * 3 + j]
+                  * x[((n * channels + c) * height + row) * width + col];
+              }
+            }
+          }
+
+          EXPECT_NEAR(output_data.get()[((n * out_channels + k) * height + h) * width + v], expected, 1e-3);
+        }
+      }
+    }
+  }
+}
+
+    
+
+
+// Direct convolution used as oracle by the grouped / depthwise tests.
+static std::vector<float> reference_conv(const float* x, const float* w, const float* bias,
+    int num, int channels, int height, int width, int out_channels, int group,
+    int kernel, int pad, int stride, int output_h, int output_w) {
+
+  const int group_in = channels / group, group_out = out_channels / group;
+  std::vector<float> y(num * out_channels * output_h * output_w);
+
+  for (int n = 0; n < num; ++n) {
+    for (int k = 0; k < out_channels; ++k) {
+      const int g = k / group_out;
+      for (int h = 0; h < output_h; ++h) {
+        for (int v = 0; v < output_w; ++v) {
+
+          float sum = bias ? bias[k] : 0;
+          for (int c = 0; c < group_in; ++c) {
+            for (int i = 0; i < kernel; ++i) {
+              for (int j = 0; j < kernel; ++j) {
+                int row = h * stride + i - pad, col = v * stride + j - pad;
+                if (row < 0 || row >= height || col < 0 || col >= width) { continue; }
+                sum += w[((k * group_in + c) * kernel + i) * kernel + j]
+                  * x[((n * channels + g * group_in + c) * height + row) * width + col];
+              }
+            }
+          }
+          y[((n * out_channels + k) * output_h + h) * output_w + v] = sum;
+        }
+      }
+    }
+  }
+  return y;
+}
+
+
+TEST(CONV_Group_Test, test_grouped_conv) {
+
+  fake_random_number random_generator;
+
+  const int num = 2, channels = 4, out_channels = 6, height = 7, width = 5;
+
+  for (int kernel : {1, 3}) {
+
+    const int pad = kernel / 2;
+
+    auto weight = TensorCPU<float>(random_generator.generate_random_vector(out_channels * channels / 2 * kernel * kernel));
+    auto bias = TensorCPU<float>(random_generator.generate_random_vector(out_channels));
+    auto input_tensor = TensorCPU<float>(random_generator.generate_random_vector(num * channels * height * width));
+
+    auto convolutional = ConvolutionOp<TensorCPU<float>>(&weight, &bias, 2, kernel == 1, std::vector<int> {kernel,kernel}, std::vector<int> {1,1}, std::vector<int> {pad,pad}, std::vector<int> {1,1}, std::vector<int> {num,channels,height,width}, std::vector<int> {num,out_channels,height,width});
+    ASSERT_FALSE(convolutional.use_winograd());
+    ASSERT_FALSE(convolutional.use_depthwise());
+
+    auto output_data = convolutional(input_tensor).debug_gtest_cpu_data();
+    auto expected = reference_conv(input_tensor.immutable_data(), weight.immutable_data(), bias.immutable_data(),
+      num, channels, height, width, out_channels, 2, kernel, pad, 1, height, width);
+
+    for (int i = 0; i < expected.size(); ++i) {
+      EXPECT_NEAR(output_data.get()[i], expected[i], 1e-3);
+    }
+  }
+}
+
+
+// Large enough that the CPU path gathers several im2col tiles per image,
+// the last one ending in the middle of an output row.
+TEST(CONV_Group_Test, test_tiled_im2col_conv) {
+
+  fake_random_number random_generator;
+
+  const int num = 2, channels = 16, out_channels = 6, height = 81, width = 75, kernel = 5;
+
+  for (int group : {1, 2}) {
+    for (int stride : {1, 2}) {
+
+      const int pad = 2;
+      const int output_h = (height + 2 * pad - kernel) / stride + 1;
+      const int output_w = (width + 2 * pad - kernel) / stride + 1;
+
+      auto weight = TensorCPU<float>(random_generator.generate_random_vector(out_channels * channels / group * kernel * kernel));
+      auto bias = TensorCPU<float>(random_generator.generate_random_vector(out_channels));
+      auto input_tensor = TensorCPU<float>(random_generator.generate_random_vector(num * channels * height * width));
+
+      auto convolutional = ConvolutionOp<TensorCPU<float>>(&weight, &bias, group, false, std::vector<int> {kernel,kernel}, std::vector<int> {stride,stride}, std::vector<int> {pad,pad}, std::vector<int> {1,1}, std::vector<int> {num,channels,height,width}, std::vector<int> {num,out_channels,output_h,output_w});
+
+      auto output_data = convolutional(input_tensor).debug_gtest_cpu_data();
+      auto expected = reference_conv(input_tensor.immutable_data(), weight.immutable_data(), bias.immutable_data(),
+        num, channels, height, width, out_channels, group, kernel, pad, stride, output_h, output_w);
+
+      for (int i = 0; i < expected.size(); ++i) {
+        EXPECT_NEAR(output_data.get()[i], expected[i], 1e-2);
+      }
+    }
+  }
+}
+
+
+TEST(CONV_Group_Test, test_depthwise_conv3x3) {
+
+  fake_random_number random_generator;
+
+  const int num = 2, channels = 5, height = 9, width = 11;
+
+  for (int stride : {1, 2, 3}) {
+    for (int pad : {0, 1}) {
+
+      const int output_h = (height + 2 * pad - 3) / stride + 1;
+      const int output_w = (width + 2 * pad - 3) / stride + 1;
+
+      auto weight = TensorCPU<float>(random_generator.generate_random_vector(channels * 9));
+      auto bias = TensorCPU<float>(random_generator.generate_random_vector(channels));
+      auto input_tensor = TensorCPU<float>(random_generator.generate_random_vector(num * channels * height * width));
+
+      auto convolutional = FusedConvolutionOp<TensorCPU<float>>(&weight, &bias, channels, false, std::vector<int> {3,3}, std::vector<int> {stride,stride}, std::vector<int> {pad,pad}, std::vector<int> {1,1}, std::vector<int> {num,channels,height,width}, std::vector<int> {num,channels,output_h,output_w}, ACTIVATION_TYPE::RELU, 0.1);
+      ASSERT_TRUE(convolutional.use_depthwise());
+
+      auto output_data = convolutional(input_tensor).debug_gtest_cpu_data();
+      auto expected = reference_conv(input_tensor.immutable_data(), weight.immutable_data(), bias.immutable_data(),
+        num, channels, height, width, channels, channels, 3, pad, stride, output_h, output_w);
+
+      for (int i = 0; i < expected.size(); ++i) {
+        const float relu = expected[i] > 0 ? expected[i] : expected[i] * 0.1f;
+        EXPECT_NEAR(output_data.get()[i], relu, 1e-3);
+      }
+    }
+  }
+}
+
+
+TEST(CONV_ThreadPool_Test, test_batch_parallel_conv_deconv) {
+
+  ThreadPool::Get().set_parallelism(3);
+  ASSERT_EQ(ThreadPool::Get().num_workers(), 3);
+
+  fake_random_number random_generator;
+
+  auto weight = TensorCPU<float>(random_generator.generate_random_vector(108));
+  auto bias = TensorCPU<float>(random_generator.generate_random_vector(3));
+  auto input_tensor = TensorCPU<float>(random_generator.generate_random_vector(512));
+
+  auto convolutional = ConvolutionOp<TensorCPU<float>>(&weight, &bias, 1, false, std::vector<int> {3,3}, std::vector<int> {2,2}, std::vector<int> {2,2}, std::vector<int> {3,3}, std::vector<int> {2,4,8,8}, std::vector<int> {2,3,3,3});
+
+  auto output_data = convolutional(input_tensor).debug_gtest_cpu_data();
+  for (int i = 0; i < test_result::conv_4_3_3_2_2_3_result.size(); ++i) {
+    EXPECT_NEAR(output_data.get()[i], test_result::conv_4_3_3_2_2_3_result[i], 1e-3);
+  }
+
+
+  random_generator.pos = 0;
+
+  auto deconv_weight = TensorCPU<float>(random_generator.generate_random_vector(108));
+  auto deconv_bias = TensorCPU<float>(random_generator.generate_random_vector(4));
+  auto deconv_input = TensorCPU<float>(random_generator.generate_random_vector(384));
+
+  auto deconvolutional = DeconvolutionOp<TensorCPU<float>>(&deconv_weight, &deconv_bias, 1, false, std::vector<int> {3,3}, std::vector<int> {2,2}, std::vector<int> {2,2}, std::vector<int> {3,3}, std::vector<int> {2,3,8,8}, std::vector<int> {2,4,17,17});
+
+  output_data = deconvolutional(deconv_input).debug_gtest_cpu_data();
+  for (int i = 0; i < test_result::deconv_3_4_3_2_2_3_result.size(); ++i) {
+    EXPECT_NEAR(output_data.get()[i], test_result::deconv_3_4_3_2_2_3_result[i], 1e-3);
+  }
+
+
+  std::vector<int> visited(1000, 0);
+  ThreadPool::Get().parallel_for(1000, [&visited](int i, int) { visited[i] += 1; });
+  EXPECT_EQ(std::count(visited.begin(), visited.end(), 1), 1000);
+
+  ThreadPool::Get().set_parallelism(1);
+}
+
+    
+
+
+
+TYPED_TEST(CONV_Test, test_fused_conv_activation) {
+  
+  using DeviceTensor = TypeParam;
+  
+  fake_random_number random_generator;
+
+  auto weight = DeviceTensor(random_generator.generate_random_vector(108));
+  auto bias = DeviceTensor(random_generator.generate_random_vector(3));
+  auto slope = DeviceTensor(random_generator.generate_random_vector(3));
+
+  auto input_tensor = DeviceTensor(random_generator.generate_random_vector(512));
+
+  // stride 1 goes through Winograd on CPU, stride 2 through im2col + gemm
+  for (int stride = 1; stride <= 2; ++stride) {
+
+    int out_hw = stride == 1 ? 8 : 4;
+    auto conv_shape = std::vector<int> {2,3,out_hw,out_hw};
+    int spatial_dim = out_hw * out_hw;
+
+    auto conv = ConvolutionOp<DeviceTensor>(&weight, &bias, 1, false, std::vector<int> {3,3}, std::vector<int> {stride,stride}, std::vector<int> {1,1}, std::vector<int> {1,1}, std::vector<int> {2,4,8,8}, conv_shape);
+    auto reference = conv(input_tensor);
+
+    auto activations = std::vector<ACTIVATION_TYPE> {
+      ACTIVATION_TYPE::NONE, ACTIVATION_TYPE::RELU, ACTIVATION_TYPE::RELU,
+      ACTIVATION_TYPE::ELU, ACTIVATION_TYPE::PRELU, ACTIVATION_TYPE::TANH
+    };
+    auto alphas = std::vector<float> {0, 0, 0.1, 1, 0, 0};
+
+    for (int a = 0; a < activations.size(); ++a) {
+
+      auto fused = FusedConvolutionOp<DeviceTensor>(&weight, &bias, 1, false, std::vector<int> {3,3}, std::vector<int> {stride,stride}, std::vector<int> {1,1}, std::vector<int> {1,1}, std::vector<int> {2,4,8,8}, conv_shape, activations[a], alphas[a], &slope);
+
+      DeviceTensor expected = reference.duplicate();
+      switch (activations[a]) {
+        case ACTIVATION_TYPE::RELU: expected = ReLUOp<DeviceTensor>(alphas[a])(reference); break;
+        case ACTIVATION_TYPE::ELU: expected = ELUOp<DeviceTensor>(alphas[a])(reference); break;
+        case ACTIVATION_TYPE::PRELU: expected = PReLUOp<DeviceTensor>(&slope, 3, spatial_dim)(reference); break;
+        case ACTIVATION_TYPE::TANH: expected = TanHOp<DeviceTensor>()(reference); break;
+        default: break;
+      }
+
+      auto output_data = fused(input_tensor).debug_gtest_cpu_data();
+      auto expected_data = expected.debug_gtest_cpu_data();
+
+      for (int i = 0; i < 2 * 3 * spatial_dim; ++i) {
+        EXPECT_NEAR(output_data.get()[i], expected_data.get()[i], 1e-3);
+      }
+    }
+  }
+}
+
+    
+
 
 TYPED_TEST(CONV_Test, test_deconv_2_2_1_1_0_1) {
   
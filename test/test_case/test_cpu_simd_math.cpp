@@ -0,0 +1,118 @@
+#include <algorithm>
+#include <cmath>
+#include <limits>
+#include <vector>
+
+#include "gtest/gtest.h"
+
+
+#include "hypertea/common.hpp"
+
+#include "test_hypertea_util.hpp"
+#include "hypertea/util/cpu_simd_math.hpp"
+
+
+namespace hypertea {
+
+// Distance to a double precision reference in units of the float ulp at
+// the reference value.
+static double ulp_error(float value, double reference) {
+
+  if (value == (float)reference) { return 0; }
+
+  int exponent;
+  frexp(reference, &exponent);
+  const double ulp = ldexp(1.0, std::max(exponent, -125) - 24);
+
+  return fabs(value - reference) / ulp;
+}
+
+template <typename SimdFunc, typename RefFunc>
+static double max_ulp_error(float lo, float hi, SimdFunc simd_func, RefFunc ref_func) {
+
+  // Odd count, so that the vector tail is exercised too.
+  const int n = 200003;
+
+  std::vector<float> x(n);
+  for (int i = 0; i < n; ++i) {
+    x[i] = lo + (hi - lo) * double(i) / (n - 1);
+  }
+
+  std::vector<float> y(x);
+  simd_func(n, y.data());
+
+  double max_error = 0;
+  for (int i = 0; i < n; ++i) {
+    max_error = std::max(max_error, ulp_error(y[i], ref_func(x[i])));
+  }
+  return max_error;
+}
+
+
+static double ref_exp(double x) { return exp(x); }
+static double ref_log(double x) { return log(x); }
+static double ref_tanh(double x) { return tanh(x); }
+static double ref_sigmoid(double x) { return 1 / (1 + exp(-x)); }
+static double ref_elu(double x) { return x > 0 ? x : 0.5 * expm1(x); }
+static void simd_elu_half(const int n, float* y) { simd_elu(n, 0.5f, y); }
+
+
+TEST(CPU_SIMD_MATH_Test, test_exp_ulp) {
+  EXPECT_LE(max_ulp_error(-87.3f, 88.7f, simd_exp, ref_exp), 1.0);
+  EXPECT_LE(max_ulp_error(-1.f, 1.f, simd_exp, ref_exp), 1.0);
+}
+
+TEST(CPU_SIMD_MATH_Test, test_log_ulp) {
+  EXPECT_LE(max_ulp_error(1e-30f, 1e30f, simd_log, ref_log), 1.0);
+  EXPECT_LE(max_ulp_error(0.01f, 10.f, simd_log, ref_log), 1.0);
+}
+
+TEST(CPU_SIMD_MATH_Test, test_tanh_ulp) {
+  EXPECT_LE(max_ulp_error(-10.f, 10.f, simd_tanh, ref_tanh), 1.5);
+  EXPECT_LE(max_ulp_error(-1.f, 1.f, simd_tanh, ref_tanh), 1.5);
+}
+
+TEST(CPU_SIMD_MATH_Test, test_sigmoid_ulp) {
+  EXPECT_LE(max_ulp_error(-80.f, 80.f, simd_sigmoid, ref_sigmoid), 2.5);
+  EXPECT_LE(max_ulp_error(-10.f, 10.f, simd_sigmoid, ref_sigmoid), 2.5);
+}
+
+TEST(CPU_SIMD_MATH_Test, test_elu_ulp) {
+  EXPECT_LE(max_ulp_error(-20.f, 20.f, simd_elu_half, ref_elu), 1.5);
+  EXPECT_LE(max_ulp_error(-1e-3f, 1e-3f, simd_elu_half, ref_elu), 1.5);
+}
+
+
+TEST(CPU_SIMD_MATH_Test, test_special_values) {
+
+  const float inf = std::numeric_limits<float>::infinity();
+
+  std::vector<float> e = {-100.f, 100.f, 0.f, -inf, inf};
+  simd_exp(e.size(), e.data());
+  EXPECT_EQ(e[0], 0.f);
+  EXPECT_EQ(e[1], inf);
+  EXPECT_EQ(e[2], 1.f);
+  EXPECT_EQ(e[3], 0.f);
+  EXPECT_EQ(e[4], inf);
+
+  std::vector<float> l = {0.f, -1.f, inf, 1.f};
+  simd_log(l.size(), l.data());
+  EXPECT_EQ(l[0], -inf);
+  EXPECT_TRUE(std::isnan(l[1]));
+  EXPECT_EQ(l[2], inf);
+  EXPECT_EQ(l[3], 0.f);
+
+  std::vector<float> t = {-inf, inf, 0.f};
+  simd_tanh(t.size(), t.data());
+  EXPECT_EQ(t[0], -1.f);
+  EXPECT_EQ(t[1], 1.f);
+  EXPECT_EQ(t[2], 0.f);
+
+  std::vector<float> s = {-inf, inf, 0.f};
+  simd_sigmoid(s.size(), s.data());
+  EXPECT_EQ(s[0], 0.f);
+  EXPECT_EQ(s[1], 1.f);
+  EXPECT_EQ(s[2], 0.5f);
+}
+
+}  // namespace hypertea
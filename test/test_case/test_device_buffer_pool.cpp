@@ -0,0 +1,136 @@
+#ifdef USE_OPENCL
+
+#include <vector>
+
+#include "gtest/gtest.h"
+
+
+#include "hypertea/hypertea.hpp"
+#include "hypertea/util/device_buffer_pool.hpp"
+
+#include "test_hypertea_util.hpp"
+
+
+namespace hypertea {
+
+
+TEST(DEVICE_BUFFER_POOL_Test, test_bucket_size) {
+
+  EXPECT_EQ(DeviceBufferPool::bucket_size(1), 256);
+  EXPECT_EQ(DeviceBufferPool::bucket_size(256), 256);
+  EXPECT_EQ(DeviceBufferPool::bucket_size(257), 320);
+  EXPECT_EQ(DeviceBufferPool::bucket_size(600), 640);
+  EXPECT_EQ(DeviceBufferPool::bucket_size(1000), 1024);
+  EXPECT_EQ(DeviceBufferPool::bucket_size(1025), 1280);
+}
+
+
+TEST(DEVICE_BUFFER_POOL_Test, test_released_buffer_is_reused) {
+
+  auto& pool = DeviceBufferPool::Get();
+
+  cl_mem first;
+  {
+    TensorGPU<float> x(1000);
+    first = x.mutable_data();
+  }
+
+  auto before = pool.stats();
+  TensorGPU<float> y(990);
+
+  EXPECT_EQ(y.mutable_data(), first);
+  EXPECT_EQ(pool.stats().hits, before.hits + 1);
+  EXPECT_EQ(pool.stats().misses, before.misses);
+  EXPECT_EQ(pool.stats().bytes_held, before.bytes_held - DeviceBufferPool::bucket_size(4000));
+}
+
+
+TEST(DEVICE_BUFFER_POOL_Test, test_views_are_cached) {
+
+  fake_random_number random_generator;
+  const int N = 256;
+
+  auto x_vec = random_generator.generate_random_vector(N);
+  TensorGPU<float> x(x_vec);
+
+  auto& pool = DeviceBufferPool::Get();
+
+  auto chunks = x.chunked_tensors(2);
+  auto misses = pool.stats().sub_buffer_misses;
+
+  auto again = x.chunked_tensors(2);
+  EXPECT_EQ(pool.stats().sub_buffer_misses, misses);
+  EXPECT_EQ(again[1].mutable_data(), chunks[1].mutable_data());
+
+  auto chunk_data = again[1].debug_gtest_cpu_data();
+  for (int i = 0; i < N / 2; ++i) {
+    EXPECT_NEAR(chunk_data.get()[i], x_vec[N / 2 + i], 1e-6);
+  }
+}
+
+
+TEST(DEVICE_BUFFER_POOL_Test, test_view_keeps_parent) {
+
+  auto& pool = DeviceBufferPool::Get();
+
+  cl_mem parent;
+  std::vector<TensorGPU<float> > chunks;
+  {
+    TensorGPU<float> x(512, 1.0f);
+    parent = x.mutable_data();
+    chunks = x.chunked_tensors(4);
+  }
+
+  // x is gone but its chunks are alive: the buffer must not be handed out.
+  TensorGPU<float> y(512);
+  EXPECT_NE(y.mutable_data(), parent);
+
+  auto chunk_data = chunks[3].debug_gtest_cpu_data();
+  for (int i = 0; i < 128; ++i) {
+    EXPECT_NEAR(chunk_data.get()[i], 1.0f, 1e-6);
+  }
+
+  pool.trim();
+  EXPECT_EQ(pool.stats().bytes_held, 0);
+}
+
+
+
+TEST(DEVICE_BUFFER_POOL_Test, test_views_of_views) {
+
+  fake_random_number random_generator;
+  const int N = 512;
+
+  auto x_vec = random_generator.generate_random_vector(N);
+
+  auto check = [&](TensorGPU<float> x) {
+    auto view = x.sub_view(128, 256);
+    auto chunks = view.chunked_tensors(4);
+    auto inner = chunks[2].sub_view(16, 32);
+
+    auto chunk_data = chunks[3].debug_gtest_cpu_data();
+    for (int i = 0; i < 64; ++i) {
+      EXPECT_NEAR(chunk_data.get()[i], x_vec[128 + 192 + i], 1e-6);
+    }
+    auto inner_data = inner.debug_gtest_cpu_data();
+    for (int i = 0; i < 32; ++i) {
+      EXPECT_NEAR(inner_data.get()[i], x_vec[128 + 128 + 16 + i], 1e-6);
+    }
+  };
+
+  // A pooled buffer, then an arena block (itself a sub-buffer) of a
+  // planned pass.
+  check(TensorGPU<float>(x_vec));
+
+  MemoryPlanner planner;
+  for (int pass = 0; pass < 2; ++pass) {
+    MemoryPlanScope scope(planner);
+    check(TensorGPU<float>(x_vec));
+  }
+  EXPECT_GT(planner.arena_allocations(), 0);
+}
+
+
+}  // namespace hypertea
+
+#endif //USE_OPENCL
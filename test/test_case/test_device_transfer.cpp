@@ -0,0 +1,77 @@
+#ifdef USE_OPENCL
+
+#include <vector>
+
+#include "gtest/gtest.h"
+
+
+#include "hypertea/hypertea.hpp"
+
+#include "test_hypertea_util.hpp"
+
+
+namespace hypertea {
+
+
+TEST(DEVICE_TRANSFER_Test, test_async_round_trip) {
+
+  fake_random_number random_generator;
+  const int N = 1000;
+
+  auto x_vec = random_generator.generate_random_vector(N);
+  TensorGPU<float> x(N);
+
+  x.copy_from_ptr_async(x_vec.data());
+  inplace_abs(x);
+  auto pending = x.cpu_data_async();
+
+  auto y = pending.get();
+  EXPECT_TRUE(pending.ready());
+  for (int i = 0; i < N; ++i) {
+    EXPECT_NEAR(y[i], fabs(x_vec[i]), 1e-6);
+  }
+
+  std::vector<float> z(N);
+  x.copy_to_ptr_async(z.data()).wait();
+  for (int i = 0; i < N; ++i) {
+    EXPECT_NEAR(z[i], fabs(x_vec[i]), 1e-6);
+  }
+}
+
+
+TEST(DEVICE_TRANSFER_Test, test_uploader_pipeline) {
+
+  const int N = 500;
+  const int frames = 5;
+
+  std::vector<std::vector<float> > inputs;
+  for (int f = 0; f < frames; ++f) {
+    inputs.push_back(std::vector<float>(N, float(f)));
+  }
+
+  TensorUploader<float> uploader(N);
+  EXPECT_TRUE(uploader.take() == nullptr);
+  EXPECT_TRUE(uploader.upload(inputs[0].data()));
+
+  for (int f = 0; f < frames; ++f) {
+    auto x = uploader.take();
+    ASSERT_TRUE(x != nullptr);
+    if (f + 1 < frames) {
+      EXPECT_TRUE(uploader.upload(inputs[f + 1].data()));
+      // The other tensor is pending, this one in use.
+      EXPECT_FALSE(uploader.upload(inputs[0].data()));
+    }
+
+    auto y = outplace_add_scalar(*x, 1.0f).cpu_data_async();
+    for (int i = 0; i < N; ++i) {
+      EXPECT_NEAR(y.get()[i], f + 1.0f, 1e-6);
+    }
+  }
+
+  EXPECT_EQ(uploader.pending(), 0);
+}
+
+
+}  // namespace hypertea
+
+#endif //USE_OPENCL
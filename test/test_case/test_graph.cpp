@@ -0,0 +1,244 @@
+#include <sstream>
+#include <string>
+#include <vector>
+
+#include "gtest/gtest.h"
+
+
+#include "hypertea/common.hpp"
+
+#include "test_hypertea_util.hpp"
+#include "hypertea/operators/activation.hpp"
+#include "hypertea/graph.hpp"
+
+
+namespace hypertea {
+
+
+template <typename TypeParam>
+class GRAPH_Test : public ::testing::Test {
+ public:
+  // typedef typename TypeParam::Dtype Dtype;
+ protected:
+  GRAPH_Test() {
+#ifdef USE_OPENCL
+    hypertea::OpenCLHandler::Get().build_opencl_math_code(false);
+#endif
+  }
+  virtual ~GRAPH_Test() {}
+};
+
+
+
+TYPED_TEST_CASE(GRAPH_Test, TestDtypes);
+
+
+TYPED_TEST(GRAPH_Test, test_graph_matches_direct_calls) {
+
+  using DeviceTensor = TypeParam;
+
+  fake_random_number random_generator;
+
+  ReLUOp<DeviceTensor> relu(0.1, NOT_IN_PLACE);
+  TanHOp<DeviceTensor> tanh_op(NOT_IN_PLACE);
+  ELUOp<DeviceTensor> elu(1.0, NOT_IN_PLACE);
+
+  GraphBuilder<DeviceTensor> b;
+  GraphValue x = b.input("x", {64});
+  GraphValue y = b.chain(x, {&relu, &tanh_op});
+  y = b.add(y, b.op(elu, x, "elu"));
+  b.output(y);
+  auto graph = b.build();
+
+  auto x_tensor = DeviceTensor(random_generator.generate_random_vector(64));
+  auto x_data = x_tensor.debug_gtest_cpu_data();
+
+  auto expected = tanh_op(relu(x_tensor));
+  expected += elu(x_tensor);
+  auto expected_data = expected.debug_gtest_cpu_data();
+
+  auto y_data = graph.run(x_tensor).debug_gtest_cpu_data();
+
+  for (int i = 0; i < 64; ++i) {
+    EXPECT_NEAR(y_data.get()[i], expected_data.get()[i], 1e-3);
+  }
+
+  // The graph input is left untouched.
+  auto x_after = x_tensor.debug_gtest_cpu_data();
+  for (int i = 0; i < 64; ++i) {
+    EXPECT_EQ(x_after.get()[i], x_data.get()[i]);
+  }
+
+  EXPECT_EQ(graph.values()[graph.outputs()[0]].count, 64);
+}
+
+
+TYPED_TEST(GRAPH_Test, test_add_copies_input_still_read) {
+
+  using DeviceTensor = TypeParam;
+
+  fake_random_number random_generator;
+
+  ReLUOp<DeviceTensor> relu(0, NOT_IN_PLACE);
+  TanHOp<DeviceTensor> tanh_op(NOT_IN_PLACE);
+
+  GraphBuilder<DeviceTensor> b;
+  GraphValue x = b.input("x");
+  GraphValue r = b.op(relu, x);
+  GraphValue s = b.add(r, x);
+  GraphValue t = b.op(tanh_op, r);
+  b.output(s);
+  b.output(t);
+  auto graph = b.build();
+
+  // add() reads r after the relu node, tanh reads r again, so add() must not
+  // write r; its first input x is a graph input.
+  auto& add_node = graph.nodes()[1];
+  EXPECT_EQ(add_node.type, "add");
+  EXPECT_TRUE(add_node.copy_input);
+
+  auto x_tensor = DeviceTensor(random_generator.generate_random_vector(32));
+  auto outputs = graph.run(std::vector<DeviceTensor> {x_tensor});
+
+  auto r_expected = relu(x_tensor);
+  auto s_expected = r_expected.duplicate();
+  s_expected += x_tensor;
+  auto t_expected = tanh_op(r_expected);
+
+  auto s_data = outputs[0].debug_gtest_cpu_data();
+  auto t_data = outputs[1].debug_gtest_cpu_data();
+  auto s_expected_data = s_expected.debug_gtest_cpu_data();
+  auto t_expected_data = t_expected.debug_gtest_cpu_data();
+
+  for (int i = 0; i < 32; ++i) {
+    EXPECT_NEAR(s_data.get()[i], s_expected_data.get()[i], 1e-3);
+    EXPECT_NEAR(t_data.get()[i], t_expected_data.get()[i], 1e-3);
+  }
+}
+
+
+TYPED_TEST(GRAPH_Test, test_liveness_and_branches) {
+
+  using DeviceTensor = TypeParam;
+
+  fake_random_number random_generator;
+
+  ReLUOp<DeviceTensor> relu(0, NOT_IN_PLACE);
+  TanHOp<DeviceTensor> tanh_op(NOT_IN_PLACE);
+  ELUOp<DeviceTensor> elu(1.0, NOT_IN_PLACE);
+
+  GraphBuilder<DeviceTensor> b;
+  GraphValue x = b.input("x");
+  GraphValue r = b.op(relu, x);
+  GraphValue head;
+  b.branch([&]() {
+    head = b.op(tanh_op, r, "head");
+  });
+  GraphValue e = b.op(elu, r);
+  GraphValue sum = b.add(e, head);
+  b.output(sum);
+  auto graph = b.build();
+
+  auto& nodes = graph.nodes();
+  ASSERT_EQ(nodes.size(), 4);
+  EXPECT_EQ(nodes[0].branch, 0);
+  EXPECT_NE(nodes[1].branch, 0);
+  EXPECT_EQ(nodes[2].branch, 0);
+
+  // r dies at elu, its last consumer; e and head are consumed by the add,
+  // which may then write e in place.
+  EXPECT_EQ(nodes[2].release, std::vector<int>({r.id}));
+  EXPECT_EQ(nodes[3].release, std::vector<int>({head.id, e.id}));
+  EXPECT_FALSE(nodes[3].copy_input);
+
+  std::stringstream dump;
+  graph.dump(dump);
+  EXPECT_NE(dump.str().find("head branch 1"), std::string::npos);
+
+  auto x_tensor = DeviceTensor(random_generator.generate_random_vector(48));
+
+  auto r_expected = relu(x_tensor);
+  auto expected = elu(r_expected);
+  expected += tanh_op(r_expected);
+  auto expected_data = expected.debug_gtest_cpu_data();
+
+  auto y_data = graph.run(x_tensor).debug_gtest_cpu_data();
+
+  for (int i = 0; i < 48; ++i) {
+    EXPECT_NEAR(y_data.get()[i], expected_data.get()[i], 1e-3);
+  }
+}
+
+TYPED_TEST(GRAPH_Test, test_residual_chain_adds_in_place) {
+
+  using DeviceTensor = TypeParam;
+
+  fake_random_number random_generator;
+
+  TanHOp<DeviceTensor> tanh_op(NOT_IN_PLACE);
+
+  GraphBuilder<DeviceTensor> b;
+  GraphValue x = b.input("x");
+  x = b.op(tanh_op, x);
+  for (int k = 0; k < 3; ++k) {
+    x = b.add(x, b.op(tanh_op, x));
+  }
+  b.output(x);
+  auto graph = b.build();
+
+  int adds = 0;
+  for (auto& node : graph.nodes()) {
+    if (node.type != "add") { continue; }
+    ++adds;
+    EXPECT_FALSE(node.copy_input);
+  }
+  EXPECT_EQ(adds, 3);
+
+  auto x_tensor = DeviceTensor(random_generator.generate_random_vector(32));
+
+  auto expected = tanh_op(x_tensor);
+  for (int k = 0; k < 3; ++k) {
+    auto f = tanh_op(expected);
+    expected += f;
+  }
+  auto expected_data = expected.debug_gtest_cpu_data();
+
+  auto y_data = graph.run(x_tensor).debug_gtest_cpu_data();
+
+  for (int i = 0; i < 32; ++i) {
+    EXPECT_NEAR(y_data.get()[i], expected_data.get()[i], 1e-3);
+  }
+}
+
+
+TYPED_TEST(GRAPH_Test, test_failed_node_stops_the_run) {
+
+  using DeviceTensor = TypeParam;
+
+  fake_random_number random_generator;
+
+  TanHOp<DeviceTensor> tanh_op(NOT_IN_PLACE);
+
+  int later_nodes_run = 0;
+
+  GraphBuilder<DeviceTensor> b;
+  GraphValue x = b.input("x");
+  auto split = b.function("broken_split", {x}, 2, [](std::vector<DeviceTensor>& args) {
+    return std::vector<DeviceTensor> {args[0]};
+  });
+  GraphValue y = b.function("count", {split[1]}, [&](std::vector<DeviceTensor>& args) {
+    ++later_nodes_run;
+    return args[0];
+  });
+  b.output(b.op(tanh_op, y));
+  auto graph = b.build();
+
+  auto x_tensor = DeviceTensor(random_generator.generate_random_vector(16));
+  EXPECT_TRUE(graph.run(std::vector<DeviceTensor> {x_tensor}).empty());
+  EXPECT_EQ(later_nodes_run, 0);
+
+  // Wrong number of inputs.
+  EXPECT_TRUE(graph.run(std::vector<DeviceTensor> {}).empty());
+}
+
+}  // namespace hypertea
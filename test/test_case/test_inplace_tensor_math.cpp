@@ -1,4 +1,6 @@
 #include <algorithm>
+#include <atomic>
+#include <thread>
 #include <vector>
 
 #include "gtest/gtest.h"
@@ -427,4 +429,66 @@ TYPED_TEST(INPLACE_TENSOR_MATH_Test, test_inplace_div_scalar) {
   }
 }
 
+
+TEST(INPLACE_CHANNELED_Test, test_inplace_channeled_parallel) {
+
+  ThreadPool::Get().set_parallelism(3);
+
+  fake_random_number random_generator;
+  const int num = 2, channels = 16, spatial_dim = 4096;
+  const int N = num * channels * spatial_dim;
+
+  auto x = TensorCPU<float>(random_generator.generate_random_vector(N));
+  auto weight = TensorCPU<float>(random_generator.generate_random_vector(channels));
+  auto bias = TensorCPU<float>(random_generator.generate_random_vector(channels));
+
+  auto x_data = x.debug_gtest_cpu_data();
+  auto w_data = weight.immutable_data();
+  auto b_data = bias.immutable_data();
+
+  auto scaladd = x.duplicate();
+  inplace_channeled_scaladd(scaladd, weight, bias, channels, spatial_dim);
+
+  auto prelu = x.duplicate();
+  inplace_prelu(prelu, weight, channels, spatial_dim);
+
+  auto sub = x.duplicate();
+  inplace_channeled_sub(sub, bias, channels, spatial_dim);
+
+  for (int i = 0; i < N; ++i) {
+    const int c = (i / spatial_dim) % channels;
+    const float v = x_data.get()[i];
+    EXPECT_NEAR(scaladd.immutable_data()[i], v * w_data[c] + b_data[c], 1e-5);
+    EXPECT_NEAR(prelu.immutable_data()[i], v > 0 ? v : v * w_data[c], 1e-5);
+    EXPECT_NEAR(sub.immutable_data()[i], v - b_data[c], 1e-5);
+  }
+
+  ThreadPool::Get().set_parallelism(1);
+}
+
+
+TEST(THREAD_POOL_Test, test_parallel_for_after_restart) {
+
+  // Workers started by a later set_parallelism() must wait for the next job
+  // instead of joining the one before them.
+  ThreadPool::Get().set_parallelism(3);
+  ThreadPool::Get().parallel_for(8, [](int, int) {});
+  ThreadPool::Get().set_parallelism(1);
+  ThreadPool::Get().set_parallelism(3);
+
+  for (int round = 0; round < 200; ++round) {
+    std::atomic<int> running(0), done(0);
+    ThreadPool::Get().parallel_for(16, [&](int, int) {
+      running++;
+      std::this_thread::yield();
+      done++;
+      running--;
+    });
+    ASSERT_EQ(done, 16);
+    ASSERT_EQ(running, 0);
+  }
+
+  ThreadPool::Get().set_parallelism(1);
+}
+
 }  // namespace caffe
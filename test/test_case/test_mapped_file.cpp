@@ -0,0 +1,63 @@
+#include <stdio.h>
+#include <vector>
+
+#include "gtest/gtest.h"
+
+
+#include "hypertea/hypertea.hpp"
+
+#include "test_hypertea_util.hpp"
+
+
+namespace hypertea {
+
+
+TEST(MAPPED_FILE_Test, test_load_weight_tensor_cpu) {
+
+  const std::string path = "mapped_file_test_weights.bin";
+  const int N = 1000;
+
+  fake_random_number random_generator;
+  auto weights = random_generator.generate_random_vector(N);
+
+  FILE* f = fopen(path.c_str(), "wb");
+  fwrite(weights.data(), sizeof(float), N, f);
+  fclose(f);
+
+  {
+    auto param = load_weight_tensor<TensorCPU<float>>(path, N);
+    auto view = param.sub_view(10, 20);
+
+    for (int i = 0; i < N; ++i) {
+      EXPECT_EQ(param.immutable_data()[i], weights[i]);
+    }
+    EXPECT_EQ(view.immutable_data()[0], weights[10]);
+
+    // Writes (e.g. BatchNorm folding) stay private to this process.
+    inplace_mul_scalar(view, 2.0f);
+    EXPECT_EQ(param.immutable_data()[10], weights[10] * 2.0f);
+  }
+
+  auto reloaded = load_weight_tensor<TensorCPU<float>>(path, N);
+  EXPECT_EQ(reloaded.immutable_data()[10], weights[10]);
+
+  remove(path.c_str());
+}
+
+
+TEST(MAPPED_FILE_Test, test_map_file_too_short) {
+
+  const std::string path = "mapped_file_test_short.bin";
+
+  FILE* f = fopen(path.c_str(), "wb");
+  float value = 1;
+  fwrite(&value, sizeof(float), 1, f);
+  fclose(f);
+
+  EXPECT_TRUE(map_file(path, 4 * sizeof(float)) == nullptr);
+  EXPECT_TRUE(map_file(path, sizeof(float)) != nullptr);
+
+  remove(path.c_str());
+}
+
+}  // namespace hypertea
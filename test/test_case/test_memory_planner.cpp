@@ -0,0 +1,115 @@
+#include <algorithm>
+#include <vector>
+
+#include "gtest/gtest.h"
+
+
+#include "hypertea/common.hpp"
+
+#include "test_hypertea_util.hpp"
+#include "hypertea/operators/conv_op.hpp"
+#include "hypertea/operators/activation.hpp"
+#include "hypertea/util/memory_planner.hpp"
+
+
+namespace hypertea {
+
+template <typename TypeParam>
+class MEMORY_PLANNER_Test : public ::testing::Test {
+ public:
+ protected:
+  MEMORY_PLANNER_Test() {
+#ifdef USE_OPENCL
+    hypertea::OpenCLHandler::Get().build_opencl_math_code(false);
+#endif
+  }
+  virtual ~MEMORY_PLANNER_Test() {}
+};
+
+
+TYPED_TEST_CASE(MEMORY_PLANNER_Test, TestDtypes);
+
+
+TYPED_TEST(MEMORY_PLANNER_Test, test_planned_conv_pipeline) {
+
+  using DeviceTensor = TypeParam;
+
+  fake_random_number random_generator;
+
+  auto weight1 = DeviceTensor(random_generator.generate_random_vector(54));
+  auto bias1 = DeviceTensor(random_generator.generate_random_vector(3));
+  auto weight2 = DeviceTensor(random_generator.generate_random_vector(81));
+  auto input_vector = random_generator.generate_random_vector(256);
+
+  auto conv1 = ConvolutionOp<DeviceTensor>(&weight1, &bias1, 1, false, std::vector<int> {3,3}, std::vector<int> {1,1}, std::vector<int> {1,1}, std::vector<int> {1,1}, std::vector<int> {2,2,8,8}, std::vector<int> {2,3,8,8});
+  auto conv2 = ConvolutionOp<DeviceTensor>(&weight2, nullptr, 1, false, std::vector<int> {3,3}, std::vector<int> {1,1}, std::vector<int> {1,1}, std::vector<int> {1,1}, std::vector<int> {2,3,8,8}, std::vector<int> {2,3,8,8});
+  auto relu = ReLUOp<DeviceTensor>(0.1, IN_PLACE);
+
+  auto forward = [&]() {
+    auto x = DeviceTensor(input_vector);
+    x = relu(conv1(x));
+    x = outplace_tanh(x) + conv2(x) * 0.5;
+    return x.debug_gtest_cpu_data();
+  };
+
+  auto expected = forward();
+
+  MemoryPlanner planner;
+
+  for (int pass = 0; pass < 3; ++pass) {
+
+    std::shared_ptr<float> output_data;
+    {
+      MemoryPlanScope scope(planner);
+      output_data = forward();
+
+      if (pass > 0) {
+        EXPECT_EQ(planner.heap_allocations(), 0);
+        EXPECT_GT(planner.arena_allocations(), 0);
+      }
+    }
+
+    EXPECT_TRUE(planner.planned());
+
+    for (int i = 0; i < 2 * 3 * 8 * 8; ++i) {
+      EXPECT_NEAR(output_data.get()[i], expected.get()[i], 1e-5);
+    }
+  }
+
+  EXPECT_GE(planner.host_arena_size() + planner.device_arena_size(), planner.peak_live_bytes());
+}
+
+
+TYPED_TEST(MEMORY_PLANNER_Test, test_planner_replans_on_new_shape) {
+
+  using DeviceTensor = TypeParam;
+
+  fake_random_number random_generator;
+
+  auto forward = [&](int count) {
+    auto x = DeviceTensor(random_generator.generate_random_vector(count));
+    auto y = outplace_sigmoid(x) * x;
+    y += 1;
+    return (y * y).debug_gtest_cpu_data();
+  };
+
+  MemoryPlanner planner;
+
+  { MemoryPlanScope scope(planner); forward(64); }
+  { MemoryPlanScope scope(planner); forward(64); EXPECT_EQ(planner.heap_allocations(), 0); }
+  { MemoryPlanScope scope(planner); forward(128); EXPECT_GT(planner.heap_allocations(), 0); }
+
+  random_generator.pos = 0;
+  auto expected = forward(128);
+
+  random_generator.pos = 0;
+  MemoryPlanScope scope(planner);
+  auto output_data = forward(128);
+
+  EXPECT_EQ(planner.heap_allocations(), 0);
+  for (int i = 0; i < 128; ++i) {
+    EXPECT_NEAR(output_data.get()[i], expected.get()[i], 1e-5);
+  }
+}
+
+}  // namespace hypertea
@@ -0,0 +1,115 @@
+#ifdef USE_OPENCL
+
+#include <cmath>
+#include <vector>
+
+#include "gtest/gtest.h"
+
+
+#include "hypertea/hypertea.hpp"
+#include "hypertea/util/opencl_fusion.hpp"
+
+#include "test_hypertea_util.hpp"
+
+
+namespace hypertea {
+
+
+static float sigmoid_ref(float x) { return 0.5f * tanhf(0.5f * x) + 0.5f; }
+
+
+TEST(OPENCL_FUSION_Test, test_fused_chain) {
+
+  fake_random_number random_generator;
+  const int N = 1000;
+
+  auto a_vec = random_generator.generate_random_vector(N);
+  auto b_vec = random_generator.generate_random_vector(N);
+
+  TensorGPU<float> a(a_vec), b(b_vec), y(N);
+
+  fused_assign(y, fused_sigmoid((fused(a) - fused(b)) * 0.5f + 1) * fused(a) / 3);
+
+  auto y_data = y.debug_gtest_cpu_data();
+  for (int i = 0; i < N; ++i) {
+    EXPECT_NEAR(y_data.get()[i], sigmoid_ref((a_vec[i] - b_vec[i]) * 0.5f + 1) * a_vec[i] / 3, 1e-4);
+  }
+}
+
+
+TEST(OPENCL_FUSION_Test, test_fused_program_cache) {
+
+  fake_random_number random_generator;
+  const int N = 64;
+
+  TensorGPU<float> a(random_generator.generate_random_vector(N)), y(N);
+
+  fused_assign(y, fused_tanh(fused(a) * 2 + 1));
+  const size_t programs = fused_program_count();
+
+  // Same chain with other scalars and tensors: the program is reused.
+  TensorGPU<float> b(random_generator.generate_random_vector(N));
+  fused_assign(y, fused_tanh(fused(b) * 3 + 0.5f));
+  EXPECT_EQ(fused_program_count(), programs);
+
+  fused_assign(y, fused_exp(fused(a) * 2 + 1));
+  EXPECT_EQ(fused_program_count(), programs + 1);
+}
+
+
+TEST(OPENCL_FUSION_Test, test_fused_outputs_alias_operands) {
+
+  fake_random_number random_generator;
+  const int N = 300;
+
+  auto x_vec = random_generator.generate_random_vector(N);
+  auto g_vec = random_generator.generate_random_vector(N);
+
+  TensorGPU<float> x(x_vec), g(g_vec), out(N);
+
+  // x = x * sigmoid(g) + g, out = tanh(new x), both in one launch.
+  auto cy = fused(x) * fused_sigmoid(fused(g)) + fused(g);
+  fused_assign<float>({{&x, cy}, {&out, fused_tanh(cy)}});
+
+  auto x_data = x.debug_gtest_cpu_data();
+  auto out_data = out.debug_gtest_cpu_data();
+  for (int i = 0; i < N; ++i) {
+    const float expected = x_vec[i] * sigmoid_ref(g_vec[i]) + g_vec[i];
+    EXPECT_NEAR(x_data.get()[i], expected, 1e-4);
+    EXPECT_NEAR(out_data.get()[i], tanhf(expected), 1e-4);
+  }
+}
+
+
+TEST(OPENCL_FUSION_Test, test_temporary_operand_and_count_mismatch) {
+
+  fake_random_number random_generator;
+  const int N = 256;
+
+  auto a_vec = random_generator.generate_random_vector(N);
+  TensorGPU<float> a(a_vec), y(N, 0.f);
+
+  // The outplace_exp temporary is only held by the expression; were its
+  // buffer back in the pool, other would take it over.
+  FusedExpression<float> e = fused(outplace_exp(a)) + 1;
+  TensorGPU<float> other(N, 5.f);
+  fused_assign(y, e);
+
+  auto y_data = y.debug_gtest_cpu_data();
+  for (int i = 0; i < N; ++i) {
+    EXPECT_NEAR(y_data.get()[i], expf(a_vec[i]) + 1, 1e-4);
+  }
+
+  // A shorter operand launches nothing, y keeps its values.
+  TensorGPU<float> short_operand(N / 2, 1.f);
+  fused_assign(y, fused(a) + fused(short_operand));
+
+  y_data = y.debug_gtest_cpu_data();
+  for (int i = 0; i < N; ++i) {
+    EXPECT_NEAR(y_data.get()[i], expf(a_vec[i]) + 1, 1e-4);
+  }
+}
+
+}  // namespace hypertea
+
+#endif //USE_OPENCL
@@ -0,0 +1,42 @@
+#ifdef USE_OPENCL
+
+#include <vector>
+
+#include "gtest/gtest.h"
+
+
+#include "hypertea/hypertea.hpp"
+
+#include "test_hypertea_util.hpp"
+
+
+namespace hypertea {
+
+
+TEST(OPENCL_KERNEL_CACHE_Test, test_launches_reuse_kernel) {
+
+  fake_random_number random_generator;
+  const int N = 100;
+
+  auto x_vec = random_generator.generate_random_vector(N);
+  TensorGPU<float> x(x_vec);
+
+  inplace_abs(x);
+  const size_t kernels = opencl_kernel_cache_size();
+
+  for (int i = 0; i < 10; ++i) { inplace_abs(x); }
+  EXPECT_EQ(opencl_kernel_cache_size(), kernels);
+
+  inplace_sqr(x);
+  EXPECT_EQ(opencl_kernel_cache_size(), kernels + 1);
+
+  auto x_data = x.debug_gtest_cpu_data();
+  for (int i = 0; i < N; ++i) {
+    EXPECT_NEAR(x_data.get()[i], x_vec[i] * x_vec[i], 1e-4);
+  }
+}
+
+
+}  // namespace hypertea
+
+#endif //USE_OPENCL
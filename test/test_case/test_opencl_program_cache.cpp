@@ -0,0 +1,72 @@
+#ifdef USE_OPENCL
+
+#include <dirent.h>
+#include <stdlib.h>
+#include <fstream>
+#include <string>
+#include <vector>
+
+#include "gtest/gtest.h"
+
+
+#include "hypertea/hypertea.hpp"
+
+#include "test_hypertea_util.hpp"
+
+
+namespace hypertea {
+
+
+static std::vector<std::string> cache_entries(const std::string& dir) {
+  std::vector<std::string> entries;
+  if (DIR* d = opendir(dir.c_str())) {
+    while (dirent* e = readdir(d)) {
+      std::string name = e->d_name;
+      if (name.size() > 6 && name.substr(name.size() - 6) == ".clbin") { entries.push_back(dir + "/" + name); }
+    }
+    closedir(d);
+  }
+  return entries;
+}
+
+
+TEST(OPENCL_PROGRAM_CACHE_Test, test_binary_is_cached_and_reused) {
+
+  char dir_template[] = "/tmp/hypertea_program_cache_XXXXXX";
+  const std::string dir = mkdtemp(dir_template);
+
+  auto& handler = OpenCLHandler::Get();
+  const std::string saved_dir = handler.program_cache_dir;
+  handler.program_cache_dir = dir;
+
+  const std::string source = "__kernel void twice(__global float* x) { x[get_global_id(0)] *= 2; }";
+
+  cl_program program;
+  handler.build_opencl_program(source, program);
+  auto entries = cache_entries(dir);
+  ASSERT_EQ(entries.size(), 1);
+
+  // Loaded from the cache: nothing new is written.
+  cl_program cached;
+  handler.build_opencl_program(source, cached);
+  EXPECT_EQ(cache_entries(dir).size(), 1);
+
+  // Other options are another program.
+  cl_program other;
+  handler.build_opencl_program(source, other, "-cl-fast-relaxed-math");
+  EXPECT_EQ(cache_entries(dir).size(), 2);
+
+  // A damaged entry is rebuilt from the source.
+  { std::ofstream(entries[0], std::ios::out | std::ios::binary) << "garbage"; }
+  cl_program rebuilt;
+  handler.build_opencl_program(source, rebuilt);
+  std::ifstream file(entries[0], std::ios::in | std::ios::binary | std::ios::ate);
+  EXPECT_GT((size_t)file.tellg(), 7);
+
+  handler.program_cache_dir = saved_dir;
+}
+
+
+}  // namespace hypertea
+
+#endif //USE_OPENCL
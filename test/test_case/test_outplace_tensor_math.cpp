@@ -400,6 +400,74 @@ TYPED_TEST(OUTPLACE_TENSOR_MATH_Test, test_outplace_div_scalar) {
 }
 
 
+TYPED_TEST(OUTPLACE_TENSOR_MATH_Test, test_outplace_arithmetic_chain) {
+  
+  using DeviceTensor = TypeParam;
+  
+  fake_random_number random_generator;
+  const int N = 64;
+
+  auto a = DeviceTensor(random_generator.generate_random_vector(N));
+  auto b = DeviceTensor(random_generator.generate_random_vector(N));
+  auto a_data = a.debug_gtest_cpu_data();
+  auto b_data = b.debug_gtest_cpu_data();
+
+  auto c = ((a - b) * b + 1.5) / 2;
+  auto d = 3 - a * 0.5;
+  auto c_data = c.debug_gtest_cpu_data();
+  auto d_data = d.debug_gtest_cpu_data();
+
+  for (int i = 0; i < N; ++i) {
+    EXPECT_NEAR(c_data.get()[i], ((a_data.get()[i] - b_data.get()[i]) * b_data.get()[i] + 1.5) / 2, 1e-3);
+    EXPECT_NEAR(d_data.get()[i], 3 - a_data.get()[i] * 0.5, 1e-3);
+  }
+
+  // Compound and in-place updates read the destination as an operand.
+  c += a * b;
+  a.copy_data((a + 1) * a);
+  c_data = c.debug_gtest_cpu_data();
+  auto new_a_data = a.debug_gtest_cpu_data();
+
+  for (int i = 0; i < N; ++i) {
+    EXPECT_NEAR(c_data.get()[i], ((a_data.get()[i] - b_data.get()[i]) * b_data.get()[i] + 1.5) / 2
+      + a_data.get()[i] * b_data.get()[i], 1e-3);
+    EXPECT_NEAR(new_a_data.get()[i], (a_data.get()[i] + 1) * a_data.get()[i], 1e-3);
+  }
+}
+
+
+TEST(OUTPLACE_TENSOR_MATH_CPU_Test, test_lazy_expressions) {
+
+  fake_random_number random_generator;
+  const int N = 64;
+
+  auto a = TensorCPU<float>(random_generator.generate_random_vector(N));
+  auto b = TensorCPU<float>(random_generator.generate_random_vector(N));
+  auto a_data = a.debug_gtest_cpu_data();
+  auto b_data = b.debug_gtest_cpu_data();
+
+  // Plain operators give tensors, so auto holds the result, not a view of
+  // a temporary.
+  static_assert(std::is_same<decltype(a + b), TensorCPU<float> >::value, "eager");
+  static_assert(std::is_same<decltype(a * 2 + 1), TensorCPU<float> >::value, "eager");
+  auto t = TensorCPU<float>(a.duplicate()) + 1;
+
+  TensorCPU<float> c = ((lazy(a) - b) * b + 1.5) / 2;
+  c += lazy(a) * b;
+  a.copy_data((lazy(a) + 1) * a);
+  auto c_data = c.debug_gtest_cpu_data();
+  auto new_a_data = a.debug_gtest_cpu_data();
+  auto t_data = t.debug_gtest_cpu_data();
+
+  for (int i = 0; i < N; ++i) {
+    EXPECT_NEAR(c_data.get()[i], ((a_data.get()[i] - b_data.get()[i]) * b_data.get()[i] + 1.5) / 2
+      + a_data.get()[i] * b_data.get()[i], 1e-3);
+    EXPECT_NEAR(new_a_data.get()[i], (a_data.get()[i] + 1) * a_data.get()[i], 1e-3);
+    EXPECT_NEAR(t_data.get()[i], a_data.get()[i] + 1, 1e-3);
+  }
+}
+
+
 TYPED_TEST(OUTPLACE_TENSOR_MATH_Test, test_outplace_avg_g128) {
   
   using DeviceTensor = TypeParam;
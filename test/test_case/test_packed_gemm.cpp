@@ -0,0 +1,163 @@
+#include <algorithm>
+#include <cmath>
+#include <thread>
+#include <vector>
+
+#include "gtest/gtest.h"
+
+
+#include "hypertea/common.hpp"
+
+#include "test_hypertea_util.hpp"
+#include "hypertea/util/packed_gemm.hpp"
+#include "hypertea/util/thread_pool.hpp"
+#include "hypertea/operators/linear_op.hpp"
+
+
+namespace hypertea {
+
+// Naive C = A * B + bias + beta * C with the same strided addressing.
+static void reference_gemm(const std::vector<float>& a, int m, int n, int k,
+    const float* b, int rsb, int csb, const float* bias, float beta,
+    float* c, int rsc, int csc) {
+
+  for (int i = 0; i < m; ++i) {
+    for (int j = 0; j < n; ++j) {
+      double sum = bias ? bias[i] : 0;
+      for (int p = 0; p < k; ++p) {
+        sum += a[i * k + p] * b[p * rsb + j * csb];
+      }
+      float& cij = c[i * rsc + j * csc];
+      cij = beta != 0 ? sum + beta * cij : sum;
+    }
+  }
+}
+
+
+TEST(PACKED_GEMM_Test, test_packed_gemm_shapes) {
+
+  fake_random_number random_generator;
+
+  // Partial panels, partial column tiles and depths beyond one k block.
+  const int shapes[][3] = {{1, 1, 1}, {16, 7, 5}, {37, 1, 300}, {50, 29, 513}, {8, 200, 64}};
+
+  for (auto& shape : shapes) {
+
+    const int m = shape[0], n = shape[1], k = shape[2];
+
+    auto a = random_generator.generate_random_vector(m * k);
+    auto b = random_generator.generate_random_vector(k * n);
+    auto bias = random_generator.generate_random_vector(m);
+    auto c_init = random_generator.generate_random_vector(m * n);
+
+    PackedMatrix packed(a.data(), m, k);
+
+    for (bool transposed_b : {false, true}) {
+      for (float beta : {0.f, 0.5f}) {
+
+        const int rsb = transposed_b ? 1 : n, csb = transposed_b ? k : 1;
+
+        // Row-major C for the plain B, transposed C (as LinearOp writes it) otherwise.
+        const int rsc = transposed_b ? 1 : n, csc = transposed_b ? m : 1;
+
+        std::vector<float> c(c_init), expected(c_init);
+
+        packed_gemm(packed, n, b.data(), rsb, csb, bias.data(), beta, c.data(), rsc, csc);
+        reference_gemm(a, m, n, k, b.data(), rsb, csb, bias.data(), beta, expected.data(), rsc, csc);
+
+        for (int i = 0; i < m * n; ++i) {
+          EXPECT_NEAR(c[i], expected[i], 1e-3);
+        }
+      }
+    }
+  }
+}
+
+
+TEST(PACKED_GEMM_Test, test_packed_gemm_threads) {
+
+  fake_random_number random_generator;
+
+  // Large enough to be split over the gemm threads; every panel is computed
+  // the same way by whichever thread, so results match bit for bit.
+  const int m = 100, n = 130, k = 100;
+
+  auto a = random_generator.generate_random_vector(m * k);
+  auto b = random_generator.generate_random_vector(k * n);
+  auto bias = random_generator.generate_random_vector(m);
+
+  PackedMatrix packed(a.data(), m, k);
+  std::vector<float> serial(m * n), threaded(m * n), expected(m * n);
+
+  ThreadPool::Get().set_parallelism(1, 1);
+  packed_gemm(packed, n, b.data(), n, 1, bias.data(), 0, serial.data(), n, 1);
+
+  ThreadPool::Get().set_parallelism(1, 4);
+  EXPECT_EQ(ThreadPool::Gemm().num_workers(), 4);
+  packed_gemm(packed, n, b.data(), n, 1, bias.data(), 0, threaded.data(), n, 1);
+
+  reference_gemm(a, m, n, k, b.data(), n, 1, bias.data(), 0, expected.data(), n, 1);
+
+  for (int i = 0; i < m * n; ++i) {
+    EXPECT_EQ(threaded[i], serial[i]);
+    EXPECT_NEAR(threaded[i], expected[i], 1e-3);
+  }
+
+  ThreadPool::Get().set_parallelism(1, std::thread::hardware_concurrency());
+}
+
+
+TEST(PACKED_GEMM_Test, test_packed_transposed_source) {
+
+  fake_random_number random_generator;
+
+  const int m = 21, n = 9, k = 13;
+
+  auto a = random_generator.generate_random_vector(m * k);
+
+  // at is a^T stored row-major, i.e. (k x m).
+  std::vector<float> at(k * m);
+  for (int i = 0; i < m; ++i) {
+    for (int p = 0; p < k; ++p) { at[p * m + i] = a[i * k + p]; }
+  }
+
+  auto b = random_generator.generate_random_vector(k * n);
+  std::vector<float> c(m * n), expected(m * n);
+
+  packed_gemm(PackedMatrix(at.data(), m, k, true), n, b.data(), n, 1, nullptr, 0, c.data(), n, 1);
+  reference_gemm(a, m, n, k, b.data(), n, 1, nullptr, 0, expected.data(), n, 1);
+
+  for (int i = 0; i < m * n; ++i) {
+    EXPECT_NEAR(c[i], expected[i], 1e-3);
+  }
+}
+
+
+TEST(PACKED_GEMM_Test, test_linear_op) {
+
+  fake_random_number random_generator;
+
+  const int batch = 3, in_features = 40, out_features = 19;
+
+  auto weight = TensorCPU<float>(random_generator.generate_random_vector(out_features * in_features));
+  auto bias = TensorCPU<float>(random_generator.generate_random_vector(out_features));
+  auto input = TensorCPU<float>(random_generator.generate_random_vector(batch * in_features));
+
+  auto linear = LinearOp<TensorCPU<float>>(&weight, &bias, in_features, out_features);
+  auto output = linear(input).debug_gtest_cpu_data();
+
+  auto w = weight.immutable_data();
+  auto x = input.immutable_data();
+
+  for (int i = 0; i < batch; ++i) {
+    for (int o = 0; o < out_features; ++o) {
+      double sum = bias.immutable_data()[o];
+      for (int f = 0; f < in_features; ++f) {
+        sum += w[o * in_features + f] * x[i * in_features + f];
+      }
+      EXPECT_NEAR(output.get()[i * out_features + o], sum, 1e-3);
+    }
+  }
+}
+
+}  // namespace hypertea
@@ -0,0 +1,102 @@
+#include <fstream>
+#include <sstream>
+#include <string>
+#include <vector>
+
+#include "gtest/gtest.h"
+
+
+#include "hypertea/common.hpp"
+
+#include "test_hypertea_util.hpp"
+#include "hypertea/operators/activation.hpp"
+#include "hypertea/util/profiler.hpp"
+
+
+namespace hypertea {
+
+
+class PROFILER_Test : public ::testing::Test {
+ protected:
+  PROFILER_Test() { Profiler::Get().clear(); }
+  virtual ~PROFILER_Test() {
+    Profiler::Get().enable(false);
+    Profiler::Get().clear();
+  }
+};
+
+
+TEST_F(PROFILER_Test, test_disabled_records_nothing) {
+
+  ReLUOp<TensorCPU<float> > relu(0, NOT_IN_PLACE);
+  TensorCPU<float> x(64, 1.0f);
+
+  Profiler::Get().enable(false);
+  relu(x);
+
+  std::stringstream report;
+  Profiler::Get().report(report);
+  EXPECT_NE(report.str().find("in 0 invocations"), std::string::npos);
+}
+
+
+TEST_F(PROFILER_Test, test_report_aggregates_per_instance) {
+
+  ReLUOp<TensorCPU<float> > relu(0, NOT_IN_PLACE);
+  TanHOp<TensorCPU<float> > tanh_op(NOT_IN_PLACE);
+  TensorCPU<float> x(1000, 1.0f);
+
+  Profiler::Get().enable();
+  Profiler::Get().set_name(&tanh_op, "head_tanh");
+  relu(x);
+  relu(x);
+  tanh_op(x);
+
+  std::stringstream report;
+  Profiler::Get().report(report);
+  const std::string table = report.str();
+
+  EXPECT_NE(table.find("in 3 invocations"), std::string::npos);
+  EXPECT_NE(table.find("head_tanh"), std::string::npos);
+
+  // ReLU_k with 2 calls, each allocating the 4000 byte output.
+  std::istringstream lines(table);
+  std::string line;
+  bool found = false;
+  while (std::getline(lines, line)) {
+    if (line.compare(0, 4, "ReLU") != 0) { continue; }
+    std::istringstream fields(line);
+    std::string name, type;
+    int calls;
+    double host_ms, device_ms, mean_ms, percent;
+    size_t bytes;
+    fields >> name >> type >> calls >> host_ms >> device_ms >> mean_ms >> percent >> bytes;
+    EXPECT_EQ(calls, 2);
+    EXPECT_EQ(bytes, 2 * 1000 * sizeof(float));
+    found = true;
+  }
+  EXPECT_TRUE(found);
+}
+
+
+TEST_F(PROFILER_Test, test_chrome_trace) {
+
+  ReLUOp<TensorCPU<float> > relu(0, NOT_IN_PLACE);
+  TensorCPU<float> x(10, 1.0f);
+
+  Profiler::Get().enable();
+  relu(x);
+
+  const std::string path = "profiler_test_trace.json";
+  ASSERT_TRUE(Profiler::Get().write_chrome_trace(path));
+
+  std::ifstream file(path);
+  std::string trace((std::istreambuf_iterator<char>(file)), std::istreambuf_iterator<char>());
+  EXPECT_EQ(trace.compare(0, 15, "{\"traceEvents\":"), 0);
+  EXPECT_NE(trace.find("\"ph\":\"X\""), std::string::npos);
+  EXPECT_NE(trace.find("\"cat\":\"ReLU\""), std::string::npos);
+  remove(path.c_str());
+}
+
+
+}  // namespace hypertea
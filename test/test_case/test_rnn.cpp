@@ -520,4 +520,76 @@ TYPED_TEST(RNN_Test, test_bi_multi3_lstm) {
 
 
 
+
+TYPED_TEST(RNN_Test, test_batched_bi_lstm) {
+
+  using DeviceTensor = TypeParam;
+
+  fake_random_number random_generator;
+
+  const int batch = 3, length = 5, input_dim = 64, hidden_dim = 32;
+
+  auto w_ih = random_generator.generate_random_vector(4*32*64);
+  auto w_hh = random_generator.generate_random_vector(4*32*32);
+  auto b_ih = random_generator.generate_random_vector(4*32);
+  auto b_hh = random_generator.generate_random_vector(4*32);
+  auto r_w_ih = random_generator.generate_random_vector(4*32*64);
+  auto r_w_hh = random_generator.generate_random_vector(4*32*32);
+  auto r_b_ih = random_generator.generate_random_vector(4*32);
+  auto r_b_hh = random_generator.generate_random_vector(4*32);
+
+  auto make_lstm = [&]() {
+    return new hypertea::BidirectionalRNN<DeviceTensor> (
+      input_dim, hidden_dim,
+      DeviceTensor(w_ih), DeviceTensor(r_w_ih),
+      DeviceTensor(w_hh), DeviceTensor(r_w_hh),
+      DeviceTensor(b_ih), DeviceTensor(r_b_ih),
+      DeviceTensor(b_hh), DeviceTensor(r_b_hh),
+      hypertea::RNN_CELL_TYPE::LSTM_CELL
+    );
+  };
+
+  // Inputs are (length, batch, input_dim), hidden states (direction, {h, c}, batch, hidden_dim).
+  std::vector<float> batched_input(length * batch * input_dim);
+  std::vector<float> batched_hidden(2 * 2 * batch * hidden_dim);
+  std::vector<std::vector<float> > expected;
+
+  for (int b = 0; b < batch; ++b) {
+
+    auto input = random_generator.generate_random_vector(length * input_dim);
+    auto hidden = random_generator.generate_random_vector(2 * 2 * hidden_dim);
+
+    for (int t = 0; t < length; ++t) {
+      std::copy(input.begin() + t * input_dim, input.begin() + (t + 1) * input_dim,
+        batched_input.begin() + (t * batch + b) * input_dim);
+    }
+    for (int s = 0; s < 4; ++s) {
+      std::copy(hidden.begin() + s * hidden_dim, hidden.begin() + (s + 1) * hidden_dim,
+        batched_hidden.begin() + (s * batch + b) * hidden_dim);
+    }
+
+    std::unique_ptr<hypertea::RNNOp<DeviceTensor> > lstm(make_lstm());
+    auto input_tensor = DeviceTensor(input);
+    auto hidden_tensor = DeviceTensor(hidden);
+    auto output_data = lstm->Forward(input_tensor, hidden_tensor).debug_gtest_cpu_data();
+    expected.push_back(std::vector<float>(output_data.get(), output_data.get() + length * 2 * hidden_dim));
+  }
+
+  std::unique_ptr<hypertea::RNNOp<DeviceTensor> > lstm(make_lstm());
+  auto input_tensor = DeviceTensor(batched_input);
+  auto hidden_tensor = DeviceTensor(batched_hidden);
+  auto output_tensor = lstm->Forward(input_tensor, hidden_tensor);
+
+  ASSERT_EQ(output_tensor.count(), length * batch * 2 * hidden_dim);
+  auto output_data = output_tensor.debug_gtest_cpu_data();
+
+  for (int t = 0; t < length; ++t) {
+    for (int b = 0; b < batch; ++b) {
+      for (int i = 0; i < 2 * hidden_dim; ++i) {
+        EXPECT_NEAR(output_data.get()[(t * batch + b) * 2 * hidden_dim + i], expected[b][t * 2 * hidden_dim + i], 1e-3);
+      }
+    }
+  }
+}
+
 }  // namespace caffe
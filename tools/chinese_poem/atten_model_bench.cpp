@@ -0,0 +1,34 @@
+#include "demo_net.hpp"
+#include "../model_bench.hpp"
+
+
+#ifdef USE_OPENCL
+using DeviceTensor = hypertea::TensorGPU<float>;
+#else
+using DeviceTensor = hypertea::TensorCPU<float>;
+#endif
+
+// ./atten_model_bench --iterations=200 --output=atten_model.json
+int main(int argc, char** argv) {
+
+    hypertea::ModelBenchmarkOptions options;
+    if (!hypertea::parse_model_benchmark_options(argc, argv, options)) { return 1; }
+
+    std::vector<int> input_vector(25, 1);
+    input_vector[0] = 0;
+    std::vector<int> output_vector(1);
+
+    hypertea::ModelWeights weights(options, 2766703);
+    hypertea::AttenNet<DeviceTensor> poem_net(weights.path());
+
+    if (options.check) {
+        std::vector<int> reference_vector(1);
+        poem_net.reference_inference(input_vector, reference_vector);
+        poem_net.inference(input_vector, output_vector);
+        return hypertea::check_model_outputs("atten_model", output_vector, reference_vector, 0);
+    }
+
+    return hypertea::run_model_benchmark("atten_model", options, [&]() {
+        poem_net.inference(input_vector, output_vector);
+    });
+}
@@ -7,17 +7,29 @@ class AttenNet {
 
 public:
 
-    AttenNet(const std::string &param_file) { 
+    AttenNet(const std::string &param_file)
+        : param(load_weight_tensor<DeviceTensor>(param_file, 2766703)) {
 
         compile_opencl_kernels(" ", " ");
-        
-        load_weight_to_tensor(param_file, param);
+
+        build_graph();
 
     }
 
     
     
     void inference( std::vector<int> &data_from_user, std::vector<int> &data_to_user) {
+
+        MemoryPlanScope plan_scope(planner_);
+
+        auto embeds = embedding(data_from_user);
+        auto output = graph_.run(embeds);
+        data_to_user = batched_argmax(output, 4975);
+    }
+
+
+    void reference_inference( std::vector<int> &data_from_user, std::vector<int> &data_to_user) {
+        
         
         // TensorCPU<float> data(data_from_user);
         auto hidden = std::vector<DeviceTensor>{DeviceTensor(128, 0)};
@@ -76,11 +88,55 @@ public:
 
     }
 
-
 private:
+
+    // The net from the embeddings to the output logits; the embedding
+    // lookup and the argmax work on word ids and stay outside.
+    void build_graph() {
+
+        GraphBuilder<DeviceTensor> b;
+
+        auto embeds = b.input("embeds", {25, 128});
+        auto encoder_inputs = b.sub_view(embeds, 128, 128 * 24);
+        auto decoder_inputs = b.sub_view(embeds, 0, 128 * 24);
+
+        auto hidden = b.function("hidden", {}, [](std::vector<DeviceTensor>&) {
+            return DeviceTensor(128, 0);
+        });
+
+        // The decoder starts from the hidden state the encoder leaves.
+        auto rnn = [&](StackedRNN<DeviceTensor>& stacked, const std::string& name, GraphValue x, GraphValue h) {
+            return b.function(name, {x, h}, 2, [&stacked](std::vector<DeviceTensor>& xs) {
+                auto hidden = std::vector<DeviceTensor>{xs[1]};
+                auto y = stacked.Forward(xs[0], hidden);
+                return std::vector<DeviceTensor>{y, hidden[0]};
+            });
+        };
+
+        auto encoder_out = rnn(encoder, "encoder", encoder_inputs, hidden);
+        auto decoder_out = rnn(decoder, "decoder", decoder_inputs, encoder_out[1]);
+
+        auto encoder_steps = b.function("select_steps", {encoder_out[0]}, [](std::vector<DeviceTensor>& xs) {
+            auto steps = xs[0].chunked_tensors(24);
+            return concate(std::vector<DeviceTensor*> { &steps[0], &steps[6], &steps[12], &steps[18]});
+        });
+
+        auto attn_mid = b.op(attn_mul, encoder_steps, "attn_mul");
+        auto attn_weights = b.gemm(CblasNoTrans, CblasTrans, 24, 4, 128, 1.0, decoder_out[0], attn_mid, 0.0);
+        attn_weights = b.op(attn_softmax, attn_weights, "attn_softmax");
+        auto attn_applied = b.gemm(CblasNoTrans, CblasNoTrans, 24, 128, 4, 1.0, attn_weights, encoder_steps, 0.0);
+
+        auto output = b.hconcate({attn_applied, decoder_out[0]}, 24);
+        b.output(b.op(out, output, "out", {24, 4975}));
+
+        graph_ = b.build();
+    }
+
+
+    MemoryPlanner planner_;
     
     
-    DeviceTensor param = DeviceTensor(2766703);
+    DeviceTensor param;
 
      DeviceTensor embedding_weight = param.sub_view(0, 636800);
      DeviceTensor encoder_weight_ih_l0 = param.sub_view(636800, 49152);
@@ -113,6 +169,8 @@ private:
     LinearOp<DeviceTensor> attn_mul = LinearOp<DeviceTensor> ( &attn_mul_weight, nullptr, 128, 128 );
     LinearOp<DeviceTensor> out = LinearOp<DeviceTensor> ( &out_weight, &out_bias, 256, 4975 );
 
+    Graph<DeviceTensor> graph_;
+
 
 };
 
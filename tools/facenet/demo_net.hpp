@@ -8,18 +8,27 @@ class facenet {
 
 public:
 
-    facenet(const std::string &param_file) { 
+    facenet(const std::string &param_file)
+        : param(load_weight_tensor<DeviceTensor>(param_file, 28095118)) {
 
         compile_opencl_kernels(conv_opencl_funcs, " ");
-        
-        load_weight_to_tensor(param_file, param);
+
+        build_graph();
 
     }
 
     
     
     void inference( std::vector<float> &data_from_user, std::vector<int> &data_to_user) {
-        
+
+        MemoryPlanScope plan_scope(planner_);
+
+        auto x = graph_.run(DeviceTensor(data_from_user));
+        data_to_user = x.argmax();
+    }
+
+    void reference_inference( std::vector<float> &data_from_user, std::vector<int> &data_to_user) {
+
         auto x = DeviceTensor(data_from_user);
 
 
@@ -51,8 +60,42 @@ public:
 
 
 private:
+
+    // The net up to the fc6 logits, their argmax stays outside.
+    void build_graph() {
+
+        GraphBuilder<DeviceTensor> b;
+
+        auto x = b.input("data", {3, 112, 96});
+
+        x = b.chain(x, {&conv1_1, &relu1_1});
+
+        x = b.add(x, b.chain(x, {&conv1_2, &relu1_2, &conv1_3, &relu1_3}));
+
+        x = b.chain(x, {&conv2_1, &relu2_1});
+        x = b.add(x, b.chain(x, {&conv2_2, &relu2_2, &conv2_3, &relu2_3}));
+        x = b.add(x, b.chain(x, {&conv2_4, &relu2_4, &conv2_5, &relu2_5}));
+
+        x = b.chain(x, {&conv3_1, &relu3_1});
+        x = b.add(x, b.chain(x, {&conv3_2, &relu3_2, &conv3_3, &relu3_3}));
+        x = b.add(x, b.chain(x, {&conv3_4, &relu3_4, &conv3_5, &relu3_5}));
+        x = b.add(x, b.chain(x, {&conv3_6, &relu3_6, &conv3_7, &relu3_7}));
+        x = b.add(x, b.chain(x, {&conv3_8, &relu3_8, &conv3_9, &relu3_9}));
+
+        x = b.chain(x, {&conv4_1, &relu4_1});
+        x = b.add(x, b.chain(x, {&conv4_2, &relu4_2, &conv4_3, &relu4_3}));
+
+        x = b.chain(x, {&fc5, &fc6});
+
+        b.output(x);
+
+        graph_ = b.build();
+    }
+
+
+    MemoryPlanner planner_;
     
-    DeviceTensor param = DeviceTensor(28095118);
+    DeviceTensor param;
 
      DeviceTensor conv1_1_bias = param.sub_view(0, 64);
      DeviceTensor conv1_1_weight = param.sub_view(64, 1728);
@@ -161,6 +204,8 @@ private:
     LinearOp<DeviceTensor> fc5 = LinearOp<DeviceTensor> ( &fc5_weight, &fc5_bias, 21504, 512 );
     LinearOp<DeviceTensor> fc6 = LinearOp<DeviceTensor> ( &fc6_weight, &fc6_bias, 512, 10574 );
 
+    Graph<DeviceTensor> graph_;
+
 };
 
 
@@ -0,0 +1,33 @@
+#include "demo_net.hpp"
+#include "../model_bench.hpp"
+
+
+#ifdef USE_OPENCL
+using DeviceTensor = hypertea::TensorGPU<float>;
+#else
+using DeviceTensor = hypertea::TensorCPU<float>;
+#endif
+
+// ./facenet_bench --iterations=100 --output=facenet.json
+int main(int argc, char** argv) {
+
+    hypertea::ModelBenchmarkOptions options;
+    if (!hypertea::parse_model_benchmark_options(argc, argv, options)) { return 1; }
+
+    std::vector<float> input_vector = hypertea::synthetic_input(3*112*96);
+    std::vector<int> output_vector(1);
+
+    hypertea::ModelWeights weights(options, 28095118);
+    hypertea::facenet<DeviceTensor> face_net(weights.path());
+
+    if (options.check) {
+        std::vector<int> reference_vector(1);
+        face_net.reference_inference(input_vector, reference_vector);
+        face_net.inference(input_vector, output_vector);
+        return hypertea::check_model_outputs("facenet", output_vector, reference_vector, 0);
+    }
+
+    return hypertea::run_model_benchmark("facenet", options, [&]() {
+        face_net.inference(input_vector, output_vector);
+    });
+}
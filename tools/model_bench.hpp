@@ -0,0 +1,292 @@
+#ifndef HYPERTEA_TOOLS_MODEL_BENCH_HPP_
+#define HYPERTEA_TOOLS_MODEL_BENCH_HPP_
+
+// End-to-end benchmark of a demo net, shared by the tools/*/*_bench.cpp
+// drivers. The net is built from synthetic weights (see ModelWeights) unless
+// --weights names a real weight file, then run for --warmup untimed and
+// --iterations timed inferences. The result is one
+// JSON object on stdout (and in --output if given):
+//
+//   {"model": "facenet", "device": "opencl", "weights": "synthetic:1",
+//    "warmup": 5, "iterations": 50,
+//    "latency_ms": {"min": .., "mean": .., "p50": .., "p90": .., "p99": .., "max": ..},
+//    "throughput_per_s": ..,
+//    "setup_peak_rss_kb": .., "peak_rss_kb": ..,
+//    "per_inference": {"heap_allocations": .., "heap_bytes": .., "tensor_bytes": ..}}
+//
+// --check instead runs the net once through its graph and once through its
+// hand-written reference_inference() and fails unless both agree.
+//
+// heap_* count the global operator new calls of an inference, which this
+// header replaces, so include it from the driver .cpp only. tensor_bytes is
+// the tensor storage requested through the memory planner, whether it came
+// from the plan or from the heap (Profiler::allocated_bytes).
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdint.h>
+#include <sys/resource.h>
+#include <unistd.h>
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cmath>
+#include <new>
+#include <random>
+#include <sstream>
+#include <string>
+#include <vector>
+
+#include "hypertea/hypertea.hpp"
+
+
+static std::atomic<long long> model_bench_heap_allocations(0);
+static std::atomic<long long> model_bench_heap_bytes(0);
+
+void* operator new(size_t size) {
+  model_bench_heap_allocations++;
+  model_bench_heap_bytes += size;
+  void* p = malloc(size ? size : 1);
+  if (p == nullptr) { throw std::bad_alloc(); }
+  return p;
+}
+
+void operator delete(void* p) noexcept { free(p); }
+
+
+namespace hypertea {
+
+struct ModelBenchmarkOptions {
+  std::string weights;              // empty for synthetic weights
+  unsigned seed = 1;
+  int warmup = 5;
+  int iterations = 50;
+  std::string output;
+  bool check = false;
+};
+
+
+inline bool parse_model_benchmark_options(int argc, char** argv, ModelBenchmarkOptions& options) {
+
+  for (int i = 1; i < argc; ++i) {
+    std::string arg = argv[i];
+    size_t eq = arg.find('=');
+    std::string flag = arg.substr(0, eq);
+    std::string value = eq == std::string::npos ? "" : arg.substr(eq + 1);
+
+    if (flag == "--weights") {
+      options.weights = value;
+    } else if (flag == "--seed") {
+      options.seed = strtoul(value.c_str(), nullptr, 10);
+    } else if (flag == "--warmup") {
+      options.warmup = atoi(value.c_str());
+    } else if (flag == "--iterations") {
+      options.iterations = std::max(1, atoi(value.c_str()));
+    } else if (flag == "--output") {
+      options.output = value;
+    } else if (arg == "--check") {
+      options.check = true;
+    } else {
+      fprintf(stderr, "usage: %s [--weights=path | --seed=%u] [--warmup=%d] [--iterations=%d] [--output=file.json] [--check]\n",
+        argv[0], options.seed, options.warmup, options.iterations);
+      return false;
+    }
+  }
+  return true;
+}
+
+
+// The weight file of a net: --weights, or else a temporary file of count
+// deterministic pseudo-random floats, uniform in [-0.05, 0.05) and the same
+// on every platform for a given --seed, removed again with this object. The
+// net loads it like any weight file, so the library only ever maps files.
+class ModelWeights {
+public:
+
+  ModelWeights(const ModelBenchmarkOptions& options, int count) : path_(options.weights) {
+
+    if (!path_.empty()) { return; }
+
+    const char* dir = getenv("TMPDIR");
+    std::string name = std::string(dir ? dir : "/tmp") + "/hypertea_weights_XXXXXX";
+    std::vector<char> buffer(name.begin(), name.end());
+    buffer.push_back('\0');
+
+    int fd = mkstemp(buffer.data());
+    FILE* f = fd < 0 ? nullptr : fdopen(fd, "wb");
+    if (f == nullptr) {
+      fprintf(stderr, "Cannot create a synthetic weight file in %s\n", name.c_str());
+      if (fd >= 0) { close(fd); }
+      return;
+    }
+    path_ = buffer.data();
+    temporary_ = true;
+
+    // xorshift32, the top 24 bits of each state as the mantissa.
+    uint32_t state = options.seed * 2654435761u + 1;
+
+    std::vector<float> chunk(1 << 16);
+    for (int written = 0; written < count; ) {
+      const int n = std::min<int>(chunk.size(), count - written);
+      for (int i = 0; i < n; ++i) {
+        state ^= state << 13;
+        state ^= state >> 17;
+        state ^= state << 5;
+        chunk[i] = (state >> 8) * (0.1f / (1 << 24)) - 0.05f;
+      }
+      fwrite(chunk.data(), sizeof(float), n, f);
+      written += n;
+    }
+    fclose(f);
+  }
+
+  ~ModelWeights() {
+    if (temporary_) { remove(path_.c_str()); }
+  }
+
+  ModelWeights(const ModelWeights&) = delete;
+  ModelWeights& operator=(const ModelWeights&) = delete;
+
+  const std::string& path() const { return path_; }
+
+private:
+
+  std::string path_;
+  bool temporary_ = false;
+
+};
+
+
+// A deterministic input of count values uniform in [0, scale), e.g. an
+// image with scale 1 or 255.
+inline std::vector<float> synthetic_input(int count, float scale = 1) {
+  std::mt19937 generator(42);
+  std::uniform_real_distribution<float> distribution(0, scale);
+  std::vector<float> input(count);
+  for (auto& v : input) { v = distribution(generator); }
+  return input;
+}
+
+
+// Peak resident set size of the process so far.
+inline long peak_rss_kb() {
+  struct rusage usage;
+  getrusage(RUSAGE_SELF, &usage);
+#ifdef __APPLE__
+  return usage.ru_maxrss / 1024;
+#else
+  return usage.ru_maxrss;
+#endif
+}
+
+
+// Nearest-rank percentile of sorted samples.
+inline double percentile(const std::vector<double>& sorted, double p) {
+  int rank = (int)std::ceil(p / 100 * sorted.size());
+  return sorted[std::min<int>(sorted.size(), std::max(rank, 1)) - 1];
+}
+
+
+// Compares the outputs of a graph run against the reference run, NaN
+// matching NaN (synthetic weights may well produce some).
+template <typename T>
+int check_model_outputs(const std::string& model, const std::vector<T>& outputs,
+  const std::vector<T>& reference, double tolerance = 1e-5) {
+
+  if (outputs.size() != reference.size()) {
+    fprintf(stderr, "%s: %zu outputs, reference has %zu\n", model.c_str(), outputs.size(), reference.size());
+    return 1;
+  }
+
+  int mismatches = 0;
+  double max_diff = 0;
+  for (size_t i = 0; i < outputs.size(); ++i) {
+    const double a = outputs[i], b = reference[i];
+    if (std::isnan(a) && std::isnan(b)) { continue; }
+    const double diff = std::fabs(a - b);
+    if (!(diff <= tolerance * std::max(1.0, std::fabs(b)))) { ++mismatches; }
+    if (diff > max_diff) { max_diff = diff; }
+  }
+
+  printf("%s: graph vs reference, %zu outputs, %d mismatches, max abs diff %g\n",
+    model.c_str(), outputs.size(), mismatches, max_diff);
+  return mismatches ? 1 : 0;
+}
+
+
+template <typename Func>
+int run_model_benchmark(const std::string& model, const ModelBenchmarkOptions& options, Func inference) {
+
+  const long setup_rss = peak_rss_kb();
+
+  for (int i = 0; i < options.warmup; ++i) {
+    inference();
+  }
+
+  const long long allocations_before = model_bench_heap_allocations;
+  const long long heap_bytes_before = model_bench_heap_bytes;
+  const size_t tensor_bytes_before = Profiler::allocated_bytes();
+
+  std::vector<double> latency_ms;
+  latency_ms.reserve(options.iterations);
+
+  for (int i = 0; i < options.iterations; ++i) {
+    auto start = std::chrono::steady_clock::now();
+    inference();
+    latency_ms.push_back(std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count());
+  }
+
+  const double n = options.iterations;
+  // latency_ms's own buffer was reserved above, nothing else is counted.
+  const double allocations = (model_bench_heap_allocations - allocations_before) / n;
+  const double heap_bytes = (model_bench_heap_bytes - heap_bytes_before) / n;
+  const double tensor_bytes = (Profiler::allocated_bytes() - tensor_bytes_before) / n;
+
+  double total_ms = 0;
+  for (double t : latency_ms) { total_ms += t; }
+  std::sort(latency_ms.begin(), latency_ms.end());
+
+  std::stringstream json;
+  json.precision(6);
+  json << "{\"model\": \"" << model << "\", "
+#ifdef USE_OPENCL
+       << "\"device\": \"opencl\", "
+#else
+       << "\"device\": \"cpu\", "
+#endif
+       << "\"weights\": \"" << (options.weights.empty() ? "synthetic:" + std::to_string(options.seed) : options.weights) << "\", "
+       << "\"warmup\": " << options.warmup << ", "
+       << "\"iterations\": " << options.iterations << ", "
+       << "\"latency_ms\": {"
+       << "\"min\": " << latency_ms.front() << ", "
+       << "\"mean\": " << total_ms / n << ", "
+       << "\"p50\": " << percentile(latency_ms, 50) << ", "
+       << "\"p90\": " << percentile(latency_ms, 90) << ", "
+       << "\"p99\": " << percentile(latency_ms, 99) << ", "
+       << "\"max\": " << latency_ms.back() << "}, "
+       << "\"throughput_per_s\": " << n * 1000 / total_ms << ", "
+       << "\"setup_peak_rss_kb\": " << setup_rss << ", "
+       << "\"peak_rss_kb\": " << peak_rss_kb() << ", "
+       << "\"per_inference\": {"
+       << "\"heap_allocations\": " << allocations << ", "
+       << "\"heap_bytes\": " << heap_bytes << ", "
+       << "\"tensor_bytes\": " << tensor_bytes << "}}";
+
+  printf("%s\n", json.str().c_str());
+
+  if (!options.output.empty()) {
+    FILE* f = fopen(options.output.c_str(), "w");
+    if (f == nullptr) {
+      fprintf(stderr, "Cannot write %s\n", options.output.c_str());
+      return 1;
+    }
+    fprintf(f, "%s\n", json.str().c_str());
+    fclose(f);
+  }
+  return 0;
+}
+
+}  // namespace hypertea
+
+#endif  // HYPERTEA_TOOLS_MODEL_BENCH_HPP_
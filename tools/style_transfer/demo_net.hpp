@@ -8,18 +8,27 @@ class new_net {
 
 public:
 
-    new_net(const std::string &param_file) { 
+    new_net(const std::string &param_file)
+        : param(load_weight_tensor<DeviceTensor>(param_file, 1821315)) {
 
         compile_opencl_kernels(conv_opencl_funcs, " ");
-        
-        load_weight_to_tensor(param_file, param);
+
+        build_graph();
 
     }
 
     
     
     void inference( std::vector<float> &data_from_user, std::vector<float> &data_to_user) {
-        
+
+        MemoryPlanScope plan_scope(planner_);
+
+        auto temp = graph_.run(DeviceTensor(data_from_user));
+        temp.copy_to_ptr((void*)data_to_user.data());
+    }
+
+    void reference_inference( std::vector<float> &data_from_user, std::vector<float> &data_to_user) {
+
         auto data = DeviceTensor(data_from_user);
 
         auto temp = bn1(outplace_elu(conv1(data)));
@@ -46,8 +55,51 @@ public:
 
 
 private:
+
+    void build_graph() {
+
+        GraphBuilder<DeviceTensor> b;
+
+        auto elu = [&](GraphValue x) {
+            return b.function("elu", {x}, [](std::vector<DeviceTensor>& xs) { return outplace_elu(xs[0]); });
+        };
+        auto relu = [&](GraphValue x) {
+            return b.function("relu", {x}, [](std::vector<DeviceTensor>& xs) { return outplace_relu(xs[0]); });
+        };
+
+        auto data = b.input("data", {3, 512, 512});
+
+        auto temp = b.op(bn1, elu(b.op(conv1, data)));
+
+        temp = b.op(bn2, elu(b.op(conv2, temp)));
+        temp = b.op(bn3, elu(b.op(conv3, temp)));
+
+        temp = b.add(temp, b.chain(relu(b.chain(temp, {&res1_conv1, &res1_bn1})), {&res1_conv2, &res1_bn2}));
+        temp = b.add(temp, b.chain(relu(b.chain(temp, {&res2_conv1, &res2_bn1})), {&res2_conv2, &res2_bn2}));
+        temp = b.add(temp, b.chain(relu(b.chain(temp, {&res3_conv1, &res3_bn1})), {&res3_conv2, &res3_bn2}));
+        temp = b.add(temp, b.chain(relu(b.chain(temp, {&res4_conv1, &res4_bn1})), {&res4_conv2, &res4_bn2}));
+        temp = b.add(temp, b.chain(relu(b.chain(temp, {&res5_conv1, &res5_bn1})), {&res5_conv2, &res5_bn2}));
+
+        temp = b.op(de_bn1, elu(b.op(deconv1, temp)));
+        temp = b.op(de_bn2, elu(b.op(deconv2, temp)));
+        temp = b.function("tanh", {b.op(deconv3, temp)}, [](std::vector<DeviceTensor>& xs) {
+            return outplace_tanh(xs[0]);
+        });
+
+        // From [-1, 1] to pixel values.
+        temp = b.function("rescale", {temp}, [](std::vector<DeviceTensor>& xs) {
+            return (xs[0] + 1) * 127.5;
+        });
+
+        b.output(temp);
+
+        graph_ = b.build();
+    }
+
+
+    MemoryPlanner planner_;
     
-    DeviceTensor param = DeviceTensor(1821315);
+    DeviceTensor param;
 
      DeviceTensor conv1_bias = param.sub_view(0, 32);
      DeviceTensor conv1_weight = param.sub_view(32, 7776);
@@ -144,6 +196,8 @@ private:
     LibDNNDeconvOp<DeviceTensor> deconv3 = LibDNNDeconvOp<DeviceTensor> ("deconv3_forward", 786432, &deconv3_weight, &deconv3_bias, std::vector<size_t> {16,4,1}, std::vector<size_t> {32768,4,1});
     TanHOp<DeviceTensor> de_tanh3 = TanHOp<DeviceTensor> ( NOT_IN_PLACE );
 
+    Graph<DeviceTensor> graph_;
+
 };
 
 
@@ -0,0 +1,33 @@
+#include "demo_net.hpp"
+#include "../model_bench.hpp"
+
+
+#ifdef USE_OPENCL
+using DeviceTensor = hypertea::TensorGPU<float>;
+#else
+using DeviceTensor = hypertea::TensorCPU<float>;
+#endif
+
+// ./style_transfer_bench --iterations=20 --output=style_transfer.json
+int main(int argc, char** argv) {
+
+    hypertea::ModelBenchmarkOptions options;
+    if (!hypertea::parse_model_benchmark_options(argc, argv, options)) { return 1; }
+
+    std::vector<float> input_vector = hypertea::synthetic_input(512*512*3, 255);
+    std::vector<float> output_vector(512*512*3, 0);
+
+    hypertea::ModelWeights weights(options, 1821315);
+    hypertea::new_net<DeviceTensor> style_transfer_net(weights.path());
+
+    if (options.check) {
+        std::vector<float> reference_vector(512*512*3, 0);
+        style_transfer_net.reference_inference(input_vector, reference_vector);
+        style_transfer_net.inference(input_vector, output_vector);
+        return hypertea::check_model_outputs("style_transfer", output_vector, reference_vector);
+    }
+
+    return hypertea::run_model_benchmark("style_transfer", options, [&]() {
+        style_transfer_net.inference(input_vector, output_vector);
+    });
+}
@@ -31,8 +31,9 @@ public:
 };
 
 
+// prediction is the host copy of one detection head.
 void predict_transform(
-    DeviceTensor prediction, 
+    const float* cpu_data, 
     int batch_size, 
     int stride, 
     int grid_size, 
@@ -55,8 +56,6 @@ void predict_transform(
     float confidence_inv_sigmoid = log(confidence / (1 - confidence));
 
 
-    auto cpu_data = prediction.debug_gtest_cpu_data();
-
     std::vector<int> pos_index;
     std::vector<int> anchor_index;
 
@@ -64,7 +63,7 @@ void predict_transform(
     for (int n = 0; n < num_anchors; ++n) {
         int anchor_offset = (n * bbox_attrs + 4) * grid_square;
         for (int i = 0; i < grid_square; ++i) {
-            if (cpu_data.get()[anchor_offset + i] > confidence_inv_sigmoid) {
+            if (cpu_data[anchor_offset + i] > confidence_inv_sigmoid) {
                 pos_index.push_back(i);
                 anchor_index.push_back(n);
             }
@@ -83,7 +82,7 @@ void predict_transform(
 
     for (int i = 0; i < bbox_attrs; ++i) {
         for (int n = 0; n < out_num; ++n) {
-            output_data[i * out_num + n] = cpu_data.get()[(anchor_index[n] * bbox_attrs + i) * grid_square + pos_index[n]];
+            output_data[i * out_num + n] = cpu_data[(anchor_index[n] * bbox_attrs + i) * grid_square + pos_index[n]];
         }
         
     }
@@ -143,20 +142,113 @@ class yolo_net {
 
 public:
 
-    yolo_net(const std::string &param_file) { 
+    yolo_net(const std::string &param_file)
+        : param(load_weight_tensor<DeviceTensor>(param_file, 62001757)) {
 
         compile_opencl_kernels(conv_opencl_funcs, " ");
-        
-        load_weight_to_tensor(param_file, param);
+
+        // Every bn_i runs on running statistics right after a bias-free conv_i:
+        // fold it into conv_i_weight, bn_i is left with the per-channel bias.
+        fold_batch_norm(conv_0_weight, (DeviceTensor*)nullptr, bn_0_mean, bn_0_var, &bn_0_weight, &bn_0_bias, 32, 1e-05, bn_0_bias);
+        fold_batch_norm(conv_1_weight, (DeviceTensor*)nullptr, bn_1_mean, bn_1_var, &bn_1_weight, &bn_1_bias, 64, 1e-05, bn_1_bias);
+        fold_batch_norm(conv_2_weight, (DeviceTensor*)nullptr, bn_2_mean, bn_2_var, &bn_2_weight, &bn_2_bias, 32, 1e-05, bn_2_bias);
+        fold_batch_norm(conv_3_weight, (DeviceTensor*)nullptr, bn_3_mean, bn_3_var, &bn_3_weight, &bn_3_bias, 64, 1e-05, bn_3_bias);
+        fold_batch_norm(conv_5_weight, (DeviceTensor*)nullptr, bn_5_mean, bn_5_var, &bn_5_weight, &bn_5_bias, 128, 1e-05, bn_5_bias);
+        fold_batch_norm(conv_6_weight, (DeviceTensor*)nullptr, bn_6_mean, bn_6_var, &bn_6_weight, &bn_6_bias, 64, 1e-05, bn_6_bias);
+        fold_batch_norm(conv_7_weight, (DeviceTensor*)nullptr, bn_7_mean, bn_7_var, &bn_7_weight, &bn_7_bias, 128, 1e-05, bn_7_bias);
+        fold_batch_norm(conv_9_weight, (DeviceTensor*)nullptr, bn_9_mean, bn_9_var, &bn_9_weight, &bn_9_bias, 64, 1e-05, bn_9_bias);
+        fold_batch_norm(conv_10_weight, (DeviceTensor*)nullptr, bn_10_mean, bn_10_var, &bn_10_weight, &bn_10_bias, 128, 1e-05, bn_10_bias);
+        fold_batch_norm(conv_12_weight, (DeviceTensor*)nullptr, bn_12_mean, bn_12_var, &bn_12_weight, &bn_12_bias, 256, 1e-05, bn_12_bias);
+        fold_batch_norm(conv_13_weight, (DeviceTensor*)nullptr, bn_13_mean, bn_13_var, &bn_13_weight, &bn_13_bias, 128, 1e-05, bn_13_bias);
+        fold_batch_norm(conv_14_weight, (DeviceTensor*)nullptr, bn_14_mean, bn_14_var, &bn_14_weight, &bn_14_bias, 256, 1e-05, bn_14_bias);
+        fold_batch_norm(conv_16_weight, (DeviceTensor*)nullptr, bn_16_mean, bn_16_var, &bn_16_weight, &bn_16_bias, 128, 1e-05, bn_16_bias);
+        fold_batch_norm(conv_17_weight, (DeviceTensor*)nullptr, bn_17_mean, bn_17_var, &bn_17_weight, &bn_17_bias, 256, 1e-05, bn_17_bias);
+        fold_batch_norm(conv_19_weight, (DeviceTensor*)nullptr, bn_19_mean, bn_19_var, &bn_19_weight, &bn_19_bias, 128, 1e-05, bn_19_bias);
+        fold_batch_norm(conv_20_weight, (DeviceTensor*)nullptr, bn_20_mean, bn_20_var, &bn_20_weight, &bn_20_bias, 256, 1e-05, bn_20_bias);
+        fold_batch_norm(conv_22_weight, (DeviceTensor*)nullptr, bn_22_mean, bn_22_var, &bn_22_weight, &bn_22_bias, 128, 1e-05, bn_22_bias);
+        fold_batch_norm(conv_23_weight, (DeviceTensor*)nullptr, bn_23_mean, bn_23_var, &bn_23_weight, &bn_23_bias, 256, 1e-05, bn_23_bias);
+        fold_batch_norm(conv_25_weight, (DeviceTensor*)nullptr, bn_25_mean, bn_25_var, &bn_25_weight, &bn_25_bias, 128, 1e-05, bn_25_bias);
+        fold_batch_norm(conv_26_weight, (DeviceTensor*)nullptr, bn_26_mean, bn_26_var, &bn_26_weight, &bn_26_bias, 256, 1e-05, bn_26_bias);
+        fold_batch_norm(conv_28_weight, (DeviceTensor*)nullptr, bn_28_mean, bn_28_var, &bn_28_weight, &bn_28_bias, 128, 1e-05, bn_28_bias);
+        fold_batch_norm(conv_29_weight, (DeviceTensor*)nullptr, bn_29_mean, bn_29_var, &bn_29_weight, &bn_29_bias, 256, 1e-05, bn_29_bias);
+        fold_batch_norm(conv_31_weight, (DeviceTensor*)nullptr, bn_31_mean, bn_31_var, &bn_31_weight, &bn_31_bias, 128, 1e-05, bn_31_bias);
+        fold_batch_norm(conv_32_weight, (DeviceTensor*)nullptr, bn_32_mean, bn_32_var, &bn_32_weight, &bn_32_bias, 256, 1e-05, bn_32_bias);
+        fold_batch_norm(conv_34_weight, (DeviceTensor*)nullptr, bn_34_mean, bn_34_var, &bn_34_weight, &bn_34_bias, 128, 1e-05, bn_34_bias);
+        fold_batch_norm(conv_35_weight, (DeviceTensor*)nullptr, bn_35_mean, bn_35_var, &bn_35_weight, &bn_35_bias, 256, 1e-05, bn_35_bias);
+        fold_batch_norm(conv_37_weight, (DeviceTensor*)nullptr, bn_37_mean, bn_37_var, &bn_37_weight, &bn_37_bias, 512, 1e-05, bn_37_bias);
+        fold_batch_norm(conv_38_weight, (DeviceTensor*)nullptr, bn_38_mean, bn_38_var, &bn_38_weight, &bn_38_bias, 256, 1e-05, bn_38_bias);
+        fold_batch_norm(conv_39_weight, (DeviceTensor*)nullptr, bn_39_mean, bn_39_var, &bn_39_weight, &bn_39_bias, 512, 1e-05, bn_39_bias);
+        fold_batch_norm(conv_41_weight, (DeviceTensor*)nullptr, bn_41_mean, bn_41_var, &bn_41_weight, &bn_41_bias, 256, 1e-05, bn_41_bias);
+        fold_batch_norm(conv_42_weight, (DeviceTensor*)nullptr, bn_42_mean, bn_42_var, &bn_42_weight, &bn_42_bias, 512, 1e-05, bn_42_bias);
+        fold_batch_norm(conv_44_weight, (DeviceTensor*)nullptr, bn_44_mean, bn_44_var, &bn_44_weight, &bn_44_bias, 256, 1e-05, bn_44_bias);
+        fold_batch_norm(conv_45_weight, (DeviceTensor*)nullptr, bn_45_mean, bn_45_var, &bn_45_weight, &bn_45_bias, 512, 1e-05, bn_45_bias);
+        fold_batch_norm(conv_47_weight, (DeviceTensor*)nullptr, bn_47_mean, bn_47_var, &bn_47_weight, &bn_47_bias, 256, 1e-05, bn_47_bias);
+        fold_batch_norm(conv_48_weight, (DeviceTensor*)nullptr, bn_48_mean, bn_48_var, &bn_48_weight, &bn_48_bias, 512, 1e-05, bn_48_bias);
+        fold_batch_norm(conv_50_weight, (DeviceTensor*)nullptr, bn_50_mean, bn_50_var, &bn_50_weight, &bn_50_bias, 256, 1e-05, bn_50_bias);
+        fold_batch_norm(conv_51_weight, (DeviceTensor*)nullptr, bn_51_mean, bn_51_var, &bn_51_weight, &bn_51_bias, 512, 1e-05, bn_51_bias);
+        fold_batch_norm(conv_53_weight, (DeviceTensor*)nullptr, bn_53_mean, bn_53_var, &bn_53_weight, &bn_53_bias, 256, 1e-05, bn_53_bias);
+        fold_batch_norm(conv_54_weight, (DeviceTensor*)nullptr, bn_54_mean, bn_54_var, &bn_54_weight, &bn_54_bias, 512, 1e-05, bn_54_bias);
+        fold_batch_norm(conv_56_weight, (DeviceTensor*)nullptr, bn_56_mean, bn_56_var, &bn_56_weight, &bn_56_bias, 256, 1e-05, bn_56_bias);
+        fold_batch_norm(conv_57_weight, (DeviceTensor*)nullptr, bn_57_mean, bn_57_var, &bn_57_weight, &bn_57_bias, 512, 1e-05, bn_57_bias);
+        fold_batch_norm(conv_59_weight, (DeviceTensor*)nullptr, bn_59_mean, bn_59_var, &bn_59_weight, &bn_59_bias, 256, 1e-05, bn_59_bias);
+        fold_batch_norm(conv_60_weight, (DeviceTensor*)nullptr, bn_60_mean, bn_60_var, &bn_60_weight, &bn_60_bias, 512, 1e-05, bn_60_bias);
+        fold_batch_norm(conv_62_weight, (DeviceTensor*)nullptr, bn_62_mean, bn_62_var, &bn_62_weight, &bn_62_bias, 1024, 1e-05, bn_62_bias);
+        fold_batch_norm(conv_63_weight, (DeviceTensor*)nullptr, bn_63_mean, bn_63_var, &bn_63_weight, &bn_63_bias, 512, 1e-05, bn_63_bias);
+        fold_batch_norm(conv_64_weight, (DeviceTensor*)nullptr, bn_64_mean, bn_64_var, &bn_64_weight, &bn_64_bias, 1024, 1e-05, bn_64_bias);
+        fold_batch_norm(conv_66_weight, (DeviceTensor*)nullptr, bn_66_mean, bn_66_var, &bn_66_weight, &bn_66_bias, 512, 1e-05, bn_66_bias);
+        fold_batch_norm(conv_67_weight, (DeviceTensor*)nullptr, bn_67_mean, bn_67_var, &bn_67_weight, &bn_67_bias, 1024, 1e-05, bn_67_bias);
+        fold_batch_norm(conv_69_weight, (DeviceTensor*)nullptr, bn_69_mean, bn_69_var, &bn_69_weight, &bn_69_bias, 512, 1e-05, bn_69_bias);
+        fold_batch_norm(conv_70_weight, (DeviceTensor*)nullptr, bn_70_mean, bn_70_var, &bn_70_weight, &bn_70_bias, 1024, 1e-05, bn_70_bias);
+        fold_batch_norm(conv_72_weight, (DeviceTensor*)nullptr, bn_72_mean, bn_72_var, &bn_72_weight, &bn_72_bias, 512, 1e-05, bn_72_bias);
+        fold_batch_norm(conv_73_weight, (DeviceTensor*)nullptr, bn_73_mean, bn_73_var, &bn_73_weight, &bn_73_bias, 1024, 1e-05, bn_73_bias);
+        fold_batch_norm(conv_75_weight, (DeviceTensor*)nullptr, bn_75_mean, bn_75_var, &bn_75_weight, &bn_75_bias, 512, 1e-05, bn_75_bias);
+        fold_batch_norm(conv_76_weight, (DeviceTensor*)nullptr, bn_76_mean, bn_76_var, &bn_76_weight, &bn_76_bias, 1024, 1e-05, bn_76_bias);
+        fold_batch_norm(conv_77_weight, (DeviceTensor*)nullptr, bn_77_mean, bn_77_var, &bn_77_weight, &bn_77_bias, 512, 1e-05, bn_77_bias);
+        fold_batch_norm(conv_78_weight, (DeviceTensor*)nullptr, bn_78_mean, bn_78_var, &bn_78_weight, &bn_78_bias, 1024, 1e-05, bn_78_bias);
+        fold_batch_norm(conv_79_weight, (DeviceTensor*)nullptr, bn_79_mean, bn_79_var, &bn_79_weight, &bn_79_bias, 512, 1e-05, bn_79_bias);
+        fold_batch_norm(conv_80_weight, (DeviceTensor*)nullptr, bn_80_mean, bn_80_var, &bn_80_weight, &bn_80_bias, 1024, 1e-05, bn_80_bias);
+        fold_batch_norm(conv_84_weight, (DeviceTensor*)nullptr, bn_84_mean, bn_84_var, &bn_84_weight, &bn_84_bias, 256, 1e-05, bn_84_bias);
+        fold_batch_norm(conv_87_weight, (DeviceTensor*)nullptr, bn_87_mean, bn_87_var, &bn_87_weight, &bn_87_bias, 256, 1e-05, bn_87_bias);
+        fold_batch_norm(conv_88_weight, (DeviceTensor*)nullptr, bn_88_mean, bn_88_var, &bn_88_weight, &bn_88_bias, 512, 1e-05, bn_88_bias);
+        fold_batch_norm(conv_89_weight, (DeviceTensor*)nullptr, bn_89_mean, bn_89_var, &bn_89_weight, &bn_89_bias, 256, 1e-05, bn_89_bias);
+        fold_batch_norm(conv_90_weight, (DeviceTensor*)nullptr, bn_90_mean, bn_90_var, &bn_90_weight, &bn_90_bias, 512, 1e-05, bn_90_bias);
+        fold_batch_norm(conv_91_weight, (DeviceTensor*)nullptr, bn_91_mean, bn_91_var, &bn_91_weight, &bn_91_bias, 256, 1e-05, bn_91_bias);
+        fold_batch_norm(conv_92_weight, (DeviceTensor*)nullptr, bn_92_mean, bn_92_var, &bn_92_weight, &bn_92_bias, 512, 1e-05, bn_92_bias);
+        fold_batch_norm(conv_96_weight, (DeviceTensor*)nullptr, bn_96_mean, bn_96_var, &bn_96_weight, &bn_96_bias, 128, 1e-05, bn_96_bias);
+        fold_batch_norm(conv_99_weight, (DeviceTensor*)nullptr, bn_99_mean, bn_99_var, &bn_99_weight, &bn_99_bias, 128, 1e-05, bn_99_bias);
+        fold_batch_norm(conv_100_weight, (DeviceTensor*)nullptr, bn_100_mean, bn_100_var, &bn_100_weight, &bn_100_bias, 256, 1e-05, bn_100_bias);
+        fold_batch_norm(conv_101_weight, (DeviceTensor*)nullptr, bn_101_mean, bn_101_var, &bn_101_weight, &bn_101_bias, 128, 1e-05, bn_101_bias);
+        fold_batch_norm(conv_102_weight, (DeviceTensor*)nullptr, bn_102_mean, bn_102_var, &bn_102_weight, &bn_102_bias, 256, 1e-05, bn_102_bias);
+        fold_batch_norm(conv_103_weight, (DeviceTensor*)nullptr, bn_103_mean, bn_103_var, &bn_103_weight, &bn_103_bias, 128, 1e-05, bn_103_bias);
+        fold_batch_norm(conv_104_weight, (DeviceTensor*)nullptr, bn_104_mean, bn_104_var, &bn_104_weight, &bn_104_bias, 256, 1e-05, bn_104_bias);
+
+        build_graph();
 
     }
 
     void inference( const std::vector<float> &data_from_user, std::vector<float> &data_to_user) {
-        
-        std::vector<DetectedInfo> detected_result;
+        inference(DeviceTensor(data_from_user), data_to_user);
+    }
+
+    void inference( const DeviceTensor &input, std::vector<float> &data_to_user) {
 
+        MemoryPlanScope plan_scope(planner_);
 
-        DeviceTensor x(data_from_user);
+        // The heads are read back without stalling a queue as soon as they
+        // are enqueued, and decoded once all kernels of the frame are. Stored
+        // by output index, the order the heads complete in may differ.
+        std::vector<PendingHostData<float> > predictions(graph_.outputs().size());
+        auto outputs = graph_.run(std::vector<DeviceTensor> {input}, [&](int k, const DeviceTensor& head) {
+            predictions[k] = head.cpu_data_async();
+        });
+        if (outputs.empty()) { return; }
+
+        decode(predictions, data_to_user);
+    }
+
+    void reference_inference( const DeviceTensor &input, std::vector<float> &data_to_user) {
+
+        DeviceTensor x = input;
 
         x = leaky_1(bn_1(conv_1(leaky_0(bn_0(conv_0(x))))));
         x += leaky_3(bn_3(conv_3(leaky_2(bn_2(conv_2(x))))));
@@ -194,12 +286,15 @@ public:
         
 
 
-        predict_transform(
-            conv_81(leaky_80(bn_80(conv_80(x)))), 
-            1, 32, 13, 
-            std::vector<float> {116, 90, 156, 198, 373, 326}, 
-            80, 0.4, detected_result
-        );
+        // The detection heads branch off the trunk onto queues of their own,
+        // are read back without stalling a queue and decoded once all
+        // kernels of the frame are enqueued.
+        BranchGroup heads;
+        std::vector<PendingHostData<float> > predictions;
+
+        heads.run([&]() {
+            predictions.push_back(conv_81(leaky_80(bn_80(conv_80(x)))).cpu_data_async());
+        });
 
 
 
@@ -216,12 +311,9 @@ public:
         x = leaky_91(bn_91(conv_91(x)));
 
 
-        predict_transform(
-            conv_93(leaky_92(bn_92(conv_92(x)))), 
-            1, 16, 26, 
-            std::vector<float> {30, 61, 62, 45, 59, 119}, 
-            80, 0.4, detected_result
-        );
+        heads.run([&]() {
+            predictions.push_back(conv_93(leaky_92(bn_92(conv_92(x)))).cpu_data_async());
+        });
 
 
         x = leaky_96(bn_96(conv_96(x)));
@@ -234,8 +326,37 @@ public:
         x = leaky_103(bn_103(conv_103(x)));
 
 
+        predictions.push_back(conv_105(leaky_104(bn_104(conv_104(x)))).cpu_data_async());
+        heads.join();
+
+
+        decode(predictions, data_to_user);
+    }
+
+private:
+
+    // Decodes the three heads into detections, written to data_to_user as
+    // x1, y1, x2, y2, object_conf, pos_conf, object_index each.
+    void decode(const std::vector<PendingHostData<float> >& predictions, std::vector<float> &data_to_user) {
+
+        std::vector<DetectedInfo> detected_result;
+
         predict_transform(
-            conv_105(leaky_104(bn_104(conv_104(x)))), 
+            predictions[0].get(), 
+            1, 32, 13, 
+            std::vector<float> {116, 90, 156, 198, 373, 326}, 
+            80, 0.4, detected_result
+        );
+
+        predict_transform(
+            predictions[1].get(), 
+            1, 16, 26, 
+            std::vector<float> {30, 61, 62, 45, 59, 119}, 
+            80, 0.4, detected_result
+        );
+
+        predict_transform(
+            predictions[2].get(), 
             1, 8, 52, 
             std::vector<float> {10, 13, 16, 30, 33, 23}, 
             80, 0.4, detected_result
@@ -258,11 +379,95 @@ public:
 
         }
 
+        data_to_user.clear();
+        for (auto& d : detected_result) {
+            data_to_user.insert(data_to_user.end(),
+                {d.x1_, d.y1_, d.x2_, d.y2_, d.object_conf_, d.pos_conf_, (float)d.object_index_});
+        }
+    }
+
+
+    // The trunk runs in order, the detection heads on branches of their own
+    // (the last one ends the trunk); outputs are the heads, 13, 26 and 52.
+    void build_graph() {
+
+        GraphBuilder<DeviceTensor> b;
+
+        auto x = b.input("data", {3, 416, 416});
+
+        x = b.chain(x, {&conv_0, &bn_0, &leaky_0, &conv_1, &bn_1, &leaky_1});
+        x = b.add(x, b.chain(x, {&conv_2, &bn_2, &leaky_2, &conv_3, &bn_3, &leaky_3}));
+        x = b.chain(x, {&conv_5, &bn_5, &leaky_5});
+        x = b.add(x, b.chain(x, {&conv_6, &bn_6, &leaky_6, &conv_7, &bn_7, &leaky_7}));
+        x = b.add(x, b.chain(x, {&conv_9, &bn_9, &leaky_9, &conv_10, &bn_10, &leaky_10}));
+        x = b.chain(x, {&conv_12, &bn_12, &leaky_12});
+        x = b.add(x, b.chain(x, {&conv_13, &bn_13, &leaky_13, &conv_14, &bn_14, &leaky_14}));
+        x = b.add(x, b.chain(x, {&conv_16, &bn_16, &leaky_16, &conv_17, &bn_17, &leaky_17}));
+        x = b.add(x, b.chain(x, {&conv_19, &bn_19, &leaky_19, &conv_20, &bn_20, &leaky_20}));
+        x = b.add(x, b.chain(x, {&conv_22, &bn_22, &leaky_22, &conv_23, &bn_23, &leaky_23}));
+        x = b.add(x, b.chain(x, {&conv_25, &bn_25, &leaky_25, &conv_26, &bn_26, &leaky_26}));
+        x = b.add(x, b.chain(x, {&conv_28, &bn_28, &leaky_28, &conv_29, &bn_29, &leaky_29}));
+        x = b.add(x, b.chain(x, {&conv_31, &bn_31, &leaky_31, &conv_32, &bn_32, &leaky_32}));
+        x = b.add(x, b.chain(x, {&conv_34, &bn_34, &leaky_34, &conv_35, &bn_35, &leaky_35}));
+        auto x1 = x;
+        x = b.chain(x, {&conv_37, &bn_37, &leaky_37});
+        x = b.add(x, b.chain(x, {&conv_38, &bn_38, &leaky_38, &conv_39, &bn_39, &leaky_39}));
+        x = b.add(x, b.chain(x, {&conv_41, &bn_41, &leaky_41, &conv_42, &bn_42, &leaky_42}));
+        x = b.add(x, b.chain(x, {&conv_44, &bn_44, &leaky_44, &conv_45, &bn_45, &leaky_45}));
+        x = b.add(x, b.chain(x, {&conv_47, &bn_47, &leaky_47, &conv_48, &bn_48, &leaky_48}));
+        x = b.add(x, b.chain(x, {&conv_50, &bn_50, &leaky_50, &conv_51, &bn_51, &leaky_51}));
+        x = b.add(x, b.chain(x, {&conv_53, &bn_53, &leaky_53, &conv_54, &bn_54, &leaky_54}));
+        x = b.add(x, b.chain(x, {&conv_56, &bn_56, &leaky_56, &conv_57, &bn_57, &leaky_57}));
+        x = b.add(x, b.chain(x, {&conv_59, &bn_59, &leaky_59, &conv_60, &bn_60, &leaky_60}));
+        auto x2 = x;
+        x = b.chain(x, {&conv_62, &bn_62, &leaky_62});
+        x = b.add(x, b.chain(x, {&conv_63, &bn_63, &leaky_63, &conv_64, &bn_64, &leaky_64}));
+        x = b.add(x, b.chain(x, {&conv_66, &bn_66, &leaky_66, &conv_67, &bn_67, &leaky_67}));
+        x = b.add(x, b.chain(x, {&conv_69, &bn_69, &leaky_69, &conv_70, &bn_70, &leaky_70}));
+        x = b.add(x, b.chain(x, {&conv_72, &bn_72, &leaky_72, &conv_73, &bn_73, &leaky_73}));
+        x = b.chain(x, {&conv_75, &bn_75, &leaky_75});
+        x = b.chain(x, {&conv_76, &bn_76, &leaky_76});
+        x = b.chain(x, {&conv_77, &bn_77, &leaky_77});
+        x = b.chain(x, {&conv_78, &bn_78, &leaky_78});
+        x = b.chain(x, {&conv_79, &bn_79, &leaky_79});
+
+        b.branch([&]() {
+            b.output(b.chain(x, {&conv_80, &bn_80, &leaky_80, &conv_81}));
+        });
+
+        x = b.chain(x, {&conv_84, &bn_84, &leaky_84});
+        x = b.op(upsampling_85, x, "upsampling_85");
+        x = b.concate({x, x2});
+
+        x = b.chain(x, {&conv_87, &bn_87, &leaky_87});
+        x = b.chain(x, {&conv_88, &bn_88, &leaky_88});
+        x = b.chain(x, {&conv_89, &bn_89, &leaky_89});
+        x = b.chain(x, {&conv_90, &bn_90, &leaky_90});
+        x = b.chain(x, {&conv_91, &bn_91, &leaky_91});
+
+        b.branch([&]() {
+            b.output(b.chain(x, {&conv_92, &bn_92, &leaky_92, &conv_93}));
+        });
+
+        x = b.chain(x, {&conv_96, &bn_96, &leaky_96});
+        x = b.op(upsampling_97, x, "upsampling_97");
+        x = b.concate({x, x1});
+
+        x = b.chain(x, {&conv_99, &bn_99, &leaky_99});
+        x = b.chain(x, {&conv_100, &bn_100, &leaky_100});
+        x = b.chain(x, {&conv_101, &bn_101, &leaky_101});
+        x = b.chain(x, {&conv_102, &bn_102, &leaky_102});
+        x = b.chain(x, {&conv_103, &bn_103, &leaky_103});
+
+        b.output(b.chain(x, {&conv_104, &bn_104, &leaky_104, &conv_105}));
+
+        graph_ = b.build();
     }
 
-private:
+
+    MemoryPlanner planner_;
     
-    DeviceTensor param = DeviceTensor(62001757);
+    DeviceTensor param;
 
      DeviceTensor conv_0_weight = param.sub_view(0, 864);
      DeviceTensor bn_0_mean = param.sub_view(864, 32);
@@ -631,227 +836,229 @@ private:
      DeviceTensor conv_105_bias = param.sub_view(61936222, 255);
      DeviceTensor conv_105_weight = param.sub_view(61936477, 65280);
     LibDNNConvOp<DeviceTensor> conv_0 = LibDNNConvOp<DeviceTensor> ("conv_0_forward", 5537792, &conv_0_weight, nullptr, std::vector<size_t> {16,4,1}, std::vector<size_t> {21632,8,1});
-    BatchNormOp<DeviceTensor> bn_0 = BatchNormOp<DeviceTensor> (32, 173056, 1e-05, &bn_0_mean, &bn_0_var, &bn_0_weight, &bn_0_bias);
+    ScaleOp<DeviceTensor> bn_0 = ScaleOp<DeviceTensor> (nullptr, &bn_0_bias, 32, 173056, IN_PLACE);
     ReLUOp<DeviceTensor> leaky_0 = ReLUOp<DeviceTensor> ( 0.1, IN_PLACE );
     LibDNNConvOp<DeviceTensor> conv_1 = LibDNNConvOp<DeviceTensor> ("conv_1_forward", 2768896, &conv_1_weight, nullptr, std::vector<size_t> {16,4,1}, std::vector<size_t> {5408,16,1});
-    BatchNormOp<DeviceTensor> bn_1 = BatchNormOp<DeviceTensor> (64, 43264, 1e-05, &bn_1_mean, &bn_1_var, &bn_1_weight, &bn_1_bias);
+    ScaleOp<DeviceTensor> bn_1 = ScaleOp<DeviceTensor> (nullptr, &bn_1_bias, 64, 43264, IN_PLACE);
     ReLUOp<DeviceTensor> leaky_1 = ReLUOp<DeviceTensor> ( 0.1, IN_PLACE );
     LibDNNConvOp<DeviceTensor> conv_2 = LibDNNConvOp<DeviceTensor> ("conv_2_forward", 1384448, &conv_2_weight, nullptr, std::vector<size_t> {16,4,1}, std::vector<size_t> {5408,8,1});
-    BatchNormOp<DeviceTensor> bn_2 = BatchNormOp<DeviceTensor> (32, 43264, 1e-05, &bn_2_mean, &bn_2_var, &bn_2_weight, &bn_2_bias);
+    ScaleOp<DeviceTensor> bn_2 = ScaleOp<DeviceTensor> (nullptr, &bn_2_bias, 32, 43264, IN_PLACE);
     ReLUOp<DeviceTensor> leaky_2 = ReLUOp<DeviceTensor> ( 0.1, IN_PLACE );
     LibDNNConvOp<DeviceTensor> conv_3 = LibDNNConvOp<DeviceTensor> ("conv_3_forward", 2768896, &conv_3_weight, nullptr, std::vector<size_t> {16,4,1}, std::vector<size_t> {5408,16,1});
-    BatchNormOp<DeviceTensor> bn_3 = BatchNormOp<DeviceTensor> (64, 43264, 1e-05, &bn_3_mean, &bn_3_var, &bn_3_weight, &bn_3_bias);
+    ScaleOp<DeviceTensor> bn_3 = ScaleOp<DeviceTensor> (nullptr, &bn_3_bias, 64, 43264, IN_PLACE);
     ReLUOp<DeviceTensor> leaky_3 = ReLUOp<DeviceTensor> ( 0.1, IN_PLACE );
     LibDNNConvOp<DeviceTensor> conv_5 = LibDNNConvOp<DeviceTensor> ("conv_5_forward", 1384448, &conv_5_weight, nullptr, std::vector<size_t> {16,4,1}, std::vector<size_t> {1360,32,1});
-    BatchNormOp<DeviceTensor> bn_5 = BatchNormOp<DeviceTensor> (128, 10816, 1e-05, &bn_5_mean, &bn_5_var, &bn_5_weight, &bn_5_bias);
+    ScaleOp<DeviceTensor> bn_5 = ScaleOp<DeviceTensor> (nullptr, &bn_5_bias, 128, 10816, IN_PLACE);
     ReLUOp<DeviceTensor> leaky_5 = ReLUOp<DeviceTensor> ( 0.1, IN_PLACE );
     LibDNNConvOp<DeviceTensor> conv_6 = LibDNNConvOp<DeviceTensor> ("conv_6_forward", 692224, &conv_6_weight, nullptr, std::vector<size_t> {16,4,1}, std::vector<size_t> {1360,16,1});
-    BatchNormOp<DeviceTensor> bn_6 = BatchNormOp<DeviceTensor> (64, 10816, 1e-05, &bn_6_mean, &bn_6_var, &bn_6_weight, &bn_6_bias);
+    ScaleOp<DeviceTensor> bn_6 = ScaleOp<DeviceTensor> (nullptr, &bn_6_bias, 64, 10816, IN_PLACE);
     ReLUOp<DeviceTensor> leaky_6 = ReLUOp<DeviceTensor> ( 0.1, IN_PLACE );
     LibDNNConvOp<DeviceTensor> conv_7 = LibDNNConvOp<DeviceTensor> ("conv_7_forward", 1384448, &conv_7_weight, nullptr, std::vector<size_t> {16,4,1}, std::vector<size_t> {1360,32,1});
-    BatchNormOp<DeviceTensor> bn_7 = BatchNormOp<DeviceTensor> (128, 10816, 1e-05, &bn_7_mean, &bn_7_var, &bn_7_weight, &bn_7_bias);
+    ScaleOp<DeviceTensor> bn_7 = ScaleOp<DeviceTensor> (nullptr, &bn_7_bias, 128, 10816, IN_PLACE);
     ReLUOp<DeviceTensor> leaky_7 = ReLUOp<DeviceTensor> ( 0.1, IN_PLACE );
     LibDNNConvOp<DeviceTensor> conv_9 = LibDNNConvOp<DeviceTensor> ("conv_9_forward", 692224, &conv_9_weight, nullptr, std::vector<size_t> {16,4,1}, std::vector<size_t> {1360,16,1});
-    BatchNormOp<DeviceTensor> bn_9 = BatchNormOp<DeviceTensor> (64, 10816, 1e-05, &bn_9_mean, &bn_9_var, &bn_9_weight, &bn_9_bias);
+    ScaleOp<DeviceTensor> bn_9 = ScaleOp<DeviceTensor> (nullptr, &bn_9_bias, 64, 10816, IN_PLACE);
     ReLUOp<DeviceTensor> leaky_9 = ReLUOp<DeviceTensor> ( 0.1, IN_PLACE );
     LibDNNConvOp<DeviceTensor> conv_10 = LibDNNConvOp<DeviceTensor> ("conv_10_forward", 1384448, &conv_10_weight, nullptr, std::vector<size_t> {16,4,1}, std::vector<size_t> {1360,32,1});
-    BatchNormOp<DeviceTensor> bn_10 = BatchNormOp<DeviceTensor> (128, 10816, 1e-05, &bn_10_mean, &bn_10_var, &bn_10_weight, &bn_10_bias);
+    ScaleOp<DeviceTensor> bn_10 = ScaleOp<DeviceTensor> (nullptr, &bn_10_bias, 128, 10816, IN_PLACE);
     ReLUOp<DeviceTensor> leaky_10 = ReLUOp<DeviceTensor> ( 0.1, IN_PLACE );
     LibDNNConvOp<DeviceTensor> conv_12 = LibDNNConvOp<DeviceTensor> ("conv_12_forward", 692224, &conv_12_weight, nullptr, std::vector<size_t> {16,4,1}, std::vector<size_t> {352,64,1});
-    BatchNormOp<DeviceTensor> bn_12 = BatchNormOp<DeviceTensor> (256, 2704, 1e-05, &bn_12_mean, &bn_12_var, &bn_12_weight, &bn_12_bias);
+    ScaleOp<DeviceTensor> bn_12 = ScaleOp<DeviceTensor> (nullptr, &bn_12_bias, 256, 2704, IN_PLACE);
     ReLUOp<DeviceTensor> leaky_12 = ReLUOp<DeviceTensor> ( 0.1, IN_PLACE );
     LibDNNConvOp<DeviceTensor> conv_13 = LibDNNConvOp<DeviceTensor> ("conv_13_forward", 346112, &conv_13_weight, nullptr, std::vector<size_t> {16,4,1}, std::vector<size_t> {352,32,1});
-    BatchNormOp<DeviceTensor> bn_13 = BatchNormOp<DeviceTensor> (128, 2704, 1e-05, &bn_13_mean, &bn_13_var, &bn_13_weight, &bn_13_bias);
+    ScaleOp<DeviceTensor> bn_13 = ScaleOp<DeviceTensor> (nullptr, &bn_13_bias, 128, 2704, IN_PLACE);
     ReLUOp<DeviceTensor> leaky_13 = ReLUOp<DeviceTensor> ( 0.1, IN_PLACE );
     LibDNNConvOp<DeviceTensor> conv_14 = LibDNNConvOp<DeviceTensor> ("conv_14_forward", 692224, &conv_14_weight, nullptr, std::vector<size_t> {16,4,1}, std::vector<size_t> {352,64,1});
-    BatchNormOp<DeviceTensor> bn_14 = BatchNormOp<DeviceTensor> (256, 2704, 1e-05, &bn_14_mean, &bn_14_var, &bn_14_weight, &bn_14_bias);
+    ScaleOp<DeviceTensor> bn_14 = ScaleOp<DeviceTensor> (nullptr, &bn_14_bias, 256, 2704, IN_PLACE);
     ReLUOp<DeviceTensor> leaky_14 = ReLUOp<DeviceTensor> ( 0.1, IN_PLACE );
     LibDNNConvOp<DeviceTensor> conv_16 = LibDNNConvOp<DeviceTensor> ("conv_16_forward", 346112, &conv_16_weight, nullptr, std::vector<size_t> {16,4,1}, std::vector<size_t> {352,32,1});
-    BatchNormOp<DeviceTensor> bn_16 = BatchNormOp<DeviceTensor> (128, 2704, 1e-05, &bn_16_mean, &bn_16_var, &bn_16_weight, &bn_16_bias);
+    ScaleOp<DeviceTensor> bn_16 = ScaleOp<DeviceTensor> (nullptr, &bn_16_bias, 128, 2704, IN_PLACE);
     ReLUOp<DeviceTensor> leaky_16 = ReLUOp<DeviceTensor> ( 0.1, IN_PLACE );
     LibDNNConvOp<DeviceTensor> conv_17 = LibDNNConvOp<DeviceTensor> ("conv_17_forward", 692224, &conv_17_weight, nullptr, std::vector<size_t> {16,4,1}, std::vector<size_t> {352,64,1});
-    BatchNormOp<DeviceTensor> bn_17 = BatchNormOp<DeviceTensor> (256, 2704, 1e-05, &bn_17_mean, &bn_17_var, &bn_17_weight, &bn_17_bias);
+    ScaleOp<DeviceTensor> bn_17 = ScaleOp<DeviceTensor> (nullptr, &bn_17_bias, 256, 2704, IN_PLACE);
     ReLUOp<DeviceTensor> leaky_17 = ReLUOp<DeviceTensor> ( 0.1, IN_PLACE );
     LibDNNConvOp<DeviceTensor> conv_19 = LibDNNConvOp<DeviceTensor> ("conv_19_forward", 346112, &conv_19_weight, nullptr, std::vector<size_t> {16,4,1}, std::vector<size_t> {352,32,1});
-    BatchNormOp<DeviceTensor> bn_19 = BatchNormOp<DeviceTensor> (128, 2704, 1e-05, &bn_19_mean, &bn_19_var, &bn_19_weight, &bn_19_bias);
+    ScaleOp<DeviceTensor> bn_19 = ScaleOp<DeviceTensor> (nullptr, &bn_19_bias, 128, 2704, IN_PLACE);
     ReLUOp<DeviceTensor> leaky_19 = ReLUOp<DeviceTensor> ( 0.1, IN_PLACE );
     LibDNNConvOp<DeviceTensor> conv_20 = LibDNNConvOp<DeviceTensor> ("conv_20_forward", 692224, &conv_20_weight, nullptr, std::vector<size_t> {16,4,1}, std::vector<size_t> {352,64,1});
-    BatchNormOp<DeviceTensor> bn_20 = BatchNormOp<DeviceTensor> (256, 2704, 1e-05, &bn_20_mean, &bn_20_var, &bn_20_weight, &bn_20_bias);
+    ScaleOp<DeviceTensor> bn_20 = ScaleOp<DeviceTensor> (nullptr, &bn_20_bias, 256, 2704, IN_PLACE);
     ReLUOp<DeviceTensor> leaky_20 = ReLUOp<DeviceTensor> ( 0.1, IN_PLACE );
     LibDNNConvOp<DeviceTensor> conv_22 = LibDNNConvOp<DeviceTensor> ("conv_22_forward", 346112, &conv_22_weight, nullptr, std::vector<size_t> {16,4,1}, std::vector<size_t> {352,32,1});
-    BatchNormOp<DeviceTensor> bn_22 = BatchNormOp<DeviceTensor> (128, 2704, 1e-05, &bn_22_mean, &bn_22_var, &bn_22_weight, &bn_22_bias);
+    ScaleOp<DeviceTensor> bn_22 = ScaleOp<DeviceTensor> (nullptr, &bn_22_bias, 128, 2704, IN_PLACE);
     ReLUOp<DeviceTensor> leaky_22 = ReLUOp<DeviceTensor> ( 0.1, IN_PLACE );
     LibDNNConvOp<DeviceTensor> conv_23 = LibDNNConvOp<DeviceTensor> ("conv_23_forward", 692224, &conv_23_weight, nullptr, std::vector<size_t> {16,4,1}, std::vector<size_t> {352,64,1});
-    BatchNormOp<DeviceTensor> bn_23 = BatchNormOp<DeviceTensor> (256, 2704, 1e-05, &bn_23_mean, &bn_23_var, &bn_23_weight, &bn_23_bias);
+    ScaleOp<DeviceTensor> bn_23 = ScaleOp<DeviceTensor> (nullptr, &bn_23_bias, 256, 2704, IN_PLACE);
     ReLUOp<DeviceTensor> leaky_23 = ReLUOp<DeviceTensor> ( 0.1, IN_PLACE );
     LibDNNConvOp<DeviceTensor> conv_25 = LibDNNConvOp<DeviceTensor> ("conv_25_forward", 346112, &conv_25_weight, nullptr, std::vector<size_t> {16,4,1}, std::vector<size_t> {352,32,1});
-    BatchNormOp<DeviceTensor> bn_25 = BatchNormOp<DeviceTensor> (128, 2704, 1e-05, &bn_25_mean, &bn_25_var, &bn_25_weight, &bn_25_bias);
+    ScaleOp<DeviceTensor> bn_25 = ScaleOp<DeviceTensor> (nullptr, &bn_25_bias, 128, 2704, IN_PLACE);
     ReLUOp<DeviceTensor> leaky_25 = ReLUOp<DeviceTensor> ( 0.1, IN_PLACE );
     LibDNNConvOp<DeviceTensor> conv_26 = LibDNNConvOp<DeviceTensor> ("conv_26_forward", 692224, &conv_26_weight, nullptr, std::vector<size_t> {16,4,1}, std::vector<size_t> {352,64,1});
-    BatchNormOp<DeviceTensor> bn_26 = BatchNormOp<DeviceTensor> (256, 2704, 1e-05, &bn_26_mean, &bn_26_var, &bn_26_weight, &bn_26_bias);
+    ScaleOp<DeviceTensor> bn_26 = ScaleOp<DeviceTensor> (nullptr, &bn_26_bias, 256, 2704, IN_PLACE);
     ReLUOp<DeviceTensor> leaky_26 = ReLUOp<DeviceTensor> ( 0.1, IN_PLACE );
     LibDNNConvOp<DeviceTensor> conv_28 = LibDNNConvOp<DeviceTensor> ("conv_28_forward", 346112, &conv_28_weight, nullptr, std::vector<size_t> {16,4,1}, std::vector<size_t> {352,32,1});
-    BatchNormOp<DeviceTensor> bn_28 = BatchNormOp<DeviceTensor> (128, 2704, 1e-05, &bn_28_mean, &bn_28_var, &bn_28_weight, &bn_28_bias);
+    ScaleOp<DeviceTensor> bn_28 = ScaleOp<DeviceTensor> (nullptr, &bn_28_bias, 128, 2704, IN_PLACE);
     ReLUOp<DeviceTensor> leaky_28 = ReLUOp<DeviceTensor> ( 0.1, IN_PLACE );
     LibDNNConvOp<DeviceTensor> conv_29 = LibDNNConvOp<DeviceTensor> ("conv_29_forward", 692224, &conv_29_weight, nullptr, std::vector<size_t> {16,4,1}, std::vector<size_t> {352,64,1});
-    BatchNormOp<DeviceTensor> bn_29 = BatchNormOp<DeviceTensor> (256, 2704, 1e-05, &bn_29_mean, &bn_29_var, &bn_29_weight, &bn_29_bias);
+    ScaleOp<DeviceTensor> bn_29 = ScaleOp<DeviceTensor> (nullptr, &bn_29_bias, 256, 2704, IN_PLACE);
     ReLUOp<DeviceTensor> leaky_29 = ReLUOp<DeviceTensor> ( 0.1, IN_PLACE );
     LibDNNConvOp<DeviceTensor> conv_31 = LibDNNConvOp<DeviceTensor> ("conv_31_forward", 346112, &conv_31_weight, nullptr, std::vector<size_t> {16,4,1}, std::vector<size_t> {352,32,1});
-    BatchNormOp<DeviceTensor> bn_31 = BatchNormOp<DeviceTensor> (128, 2704, 1e-05, &bn_31_mean, &bn_31_var, &bn_31_weight, &bn_31_bias);
+    ScaleOp<DeviceTensor> bn_31 = ScaleOp<DeviceTensor> (nullptr, &bn_31_bias, 128, 2704, IN_PLACE);
     ReLUOp<DeviceTensor> leaky_31 = ReLUOp<DeviceTensor> ( 0.1, IN_PLACE );
     LibDNNConvOp<DeviceTensor> conv_32 = LibDNNConvOp<DeviceTensor> ("conv_32_forward", 692224, &conv_32_weight, nullptr, std::vector<size_t> {16,4,1}, std::vector<size_t> {352,64,1});
-    BatchNormOp<DeviceTensor> bn_32 = BatchNormOp<DeviceTensor> (256, 2704, 1e-05, &bn_32_mean, &bn_32_var, &bn_32_weight, &bn_32_bias);
+    ScaleOp<DeviceTensor> bn_32 = ScaleOp<DeviceTensor> (nullptr, &bn_32_bias, 256, 2704, IN_PLACE);
     ReLUOp<DeviceTensor> leaky_32 = ReLUOp<DeviceTensor> ( 0.1, IN_PLACE );
     LibDNNConvOp<DeviceTensor> conv_34 = LibDNNConvOp<DeviceTensor> ("conv_34_forward", 346112, &conv_34_weight, nullptr, std::vector<size_t> {16,4,1}, std::vector<size_t> {352,32,1});
-    BatchNormOp<DeviceTensor> bn_34 = BatchNormOp<DeviceTensor> (128, 2704, 1e-05, &bn_34_mean, &bn_34_var, &bn_34_weight, &bn_34_bias);
+    ScaleOp<DeviceTensor> bn_34 = ScaleOp<DeviceTensor> (nullptr, &bn_34_bias, 128, 2704, IN_PLACE);
     ReLUOp<DeviceTensor> leaky_34 = ReLUOp<DeviceTensor> ( 0.1, IN_PLACE );
     LibDNNConvOp<DeviceTensor> conv_35 = LibDNNConvOp<DeviceTensor> ("conv_35_forward", 692224, &conv_35_weight, nullptr, std::vector<size_t> {16,4,1}, std::vector<size_t> {352,64,1});
-    BatchNormOp<DeviceTensor> bn_35 = BatchNormOp<DeviceTensor> (256, 2704, 1e-05, &bn_35_mean, &bn_35_var, &bn_35_weight, &bn_35_bias);
+    ScaleOp<DeviceTensor> bn_35 = ScaleOp<DeviceTensor> (nullptr, &bn_35_bias, 256, 2704, IN_PLACE);
     ReLUOp<DeviceTensor> leaky_35 = ReLUOp<DeviceTensor> ( 0.1, IN_PLACE );
     LibDNNConvOp<DeviceTensor> conv_37 = LibDNNConvOp<DeviceTensor> ("conv_37_forward", 346112, &conv_37_weight, nullptr, std::vector<size_t> {16,4,1}, std::vector<size_t> {96,128,1});
-    BatchNormOp<DeviceTensor> bn_37 = BatchNormOp<DeviceTensor> (512, 676, 1e-05, &bn_37_mean, &bn_37_var, &bn_37_weight, &bn_37_bias);
+    ScaleOp<DeviceTensor> bn_37 = ScaleOp<DeviceTensor> (nullptr, &bn_37_bias, 512, 676, IN_PLACE);
     ReLUOp<DeviceTensor> leaky_37 = ReLUOp<DeviceTensor> ( 0.1, IN_PLACE );
     LibDNNConvOp<DeviceTensor> conv_38 = LibDNNConvOp<DeviceTensor> ("conv_38_forward", 173056, &conv_38_weight, nullptr, std::vector<size_t> {16,4,1}, std::vector<size_t> {96,64,1});
-    BatchNormOp<DeviceTensor> bn_38 = BatchNormOp<DeviceTensor> (256, 676, 1e-05, &bn_38_mean, &bn_38_var, &bn_38_weight, &bn_38_bias);
+    ScaleOp<DeviceTensor> bn_38 = ScaleOp<DeviceTensor> (nullptr, &bn_38_bias, 256, 676, IN_PLACE);
     ReLUOp<DeviceTensor> leaky_38 = ReLUOp<DeviceTensor> ( 0.1, IN_PLACE );
     LibDNNConvOp<DeviceTensor> conv_39 = LibDNNConvOp<DeviceTensor> ("conv_39_forward", 346112, &conv_39_weight, nullptr, std::vector<size_t> {16,4,1}, std::vector<size_t> {96,128,1});
-    BatchNormOp<DeviceTensor> bn_39 = BatchNormOp<DeviceTensor> (512, 676, 1e-05, &bn_39_mean, &bn_39_var, &bn_39_weight, &bn_39_bias);
+    ScaleOp<DeviceTensor> bn_39 = ScaleOp<DeviceTensor> (nullptr, &bn_39_bias, 512, 676, IN_PLACE);
     ReLUOp<DeviceTensor> leaky_39 = ReLUOp<DeviceTensor> ( 0.1, IN_PLACE );
     LibDNNConvOp<DeviceTensor> conv_41 = LibDNNConvOp<DeviceTensor> ("conv_41_forward", 173056, &conv_41_weight, nullptr, std::vector<size_t> {16,4,1}, std::vector<size_t> {96,64,1});
-    BatchNormOp<DeviceTensor> bn_41 = BatchNormOp<DeviceTensor> (256, 676, 1e-05, &bn_41_mean, &bn_41_var, &bn_41_weight, &bn_41_bias);
+    ScaleOp<DeviceTensor> bn_41 = ScaleOp<DeviceTensor> (nullptr, &bn_41_bias, 256, 676, IN_PLACE);
     ReLUOp<DeviceTensor> leaky_41 = ReLUOp<DeviceTensor> ( 0.1, IN_PLACE );
     LibDNNConvOp<DeviceTensor> conv_42 = LibDNNConvOp<DeviceTensor> ("conv_42_forward", 346112, &conv_42_weight, nullptr, std::vector<size_t> {16,4,1}, std::vector<size_t> {96,128,1});
-    BatchNormOp<DeviceTensor> bn_42 = BatchNormOp<DeviceTensor> (512, 676, 1e-05, &bn_42_mean, &bn_42_var, &bn_42_weight, &bn_42_bias);
+    ScaleOp<DeviceTensor> bn_42 = ScaleOp<DeviceTensor> (nullptr, &bn_42_bias, 512, 676, IN_PLACE);
     ReLUOp<DeviceTensor> leaky_42 = ReLUOp<DeviceTensor> ( 0.1, IN_PLACE );
     LibDNNConvOp<DeviceTensor> conv_44 = LibDNNConvOp<DeviceTensor> ("conv_44_forward", 173056, &conv_44_weight, nullptr, std::vector<size_t> {16,4,1}, std::vector<size_t> {96,64,1});
-    BatchNormOp<DeviceTensor> bn_44 = BatchNormOp<DeviceTensor> (256, 676, 1e-05, &bn_44_mean, &bn_44_var, &bn_44_weight, &bn_44_bias);
+    ScaleOp<DeviceTensor> bn_44 = ScaleOp<DeviceTensor> (nullptr, &bn_44_bias, 256, 676, IN_PLACE);
     ReLUOp<DeviceTensor> leaky_44 = ReLUOp<DeviceTensor> ( 0.1, IN_PLACE );
     LibDNNConvOp<DeviceTensor> conv_45 = LibDNNConvOp<DeviceTensor> ("conv_45_forward", 346112, &conv_45_weight, nullptr, std::vector<size_t> {16,4,1}, std::vector<size_t> {96,128,1});
-    BatchNormOp<DeviceTensor> bn_45 = BatchNormOp<DeviceTensor> (512, 676, 1e-05, &bn_45_mean, &bn_45_var, &bn_45_weight, &bn_45_bias);
+    ScaleOp<DeviceTensor> bn_45 = ScaleOp<DeviceTensor> (nullptr, &bn_45_bias, 512, 676, IN_PLACE);
     ReLUOp<DeviceTensor> leaky_45 = ReLUOp<DeviceTensor> ( 0.1, IN_PLACE );
     LibDNNConvOp<DeviceTensor> conv_47 = LibDNNConvOp<DeviceTensor> ("conv_47_forward", 173056, &conv_47_weight, nullptr, std::vector<size_t> {16,4,1}, std::vector<size_t> {96,64,1});
-    BatchNormOp<DeviceTensor> bn_47 = BatchNormOp<DeviceTensor> (256, 676, 1e-05, &bn_47_mean, &bn_47_var, &bn_47_weight, &bn_47_bias);
+    ScaleOp<DeviceTensor> bn_47 = ScaleOp<DeviceTensor> (nullptr, &bn_47_bias, 256, 676, IN_PLACE);
     ReLUOp<DeviceTensor> leaky_47 = ReLUOp<DeviceTensor> ( 0.1, IN_PLACE );
     LibDNNConvOp<DeviceTensor> conv_48 = LibDNNConvOp<DeviceTensor> ("conv_48_forward", 346112, &conv_48_weight, nullptr, std::vector<size_t> {16,4,1}, std::vector<size_t> {96,128,1});
-    BatchNormOp<DeviceTensor> bn_48 = BatchNormOp<DeviceTensor> (512, 676, 1e-05, &bn_48_mean, &bn_48_var, &bn_48_weight, &bn_48_bias);
+    ScaleOp<DeviceTensor> bn_48 = ScaleOp<DeviceTensor> (nullptr, &bn_48_bias, 512, 676, IN_PLACE);
     ReLUOp<DeviceTensor> leaky_48 = ReLUOp<DeviceTensor> ( 0.1, IN_PLACE );
     LibDNNConvOp<DeviceTensor> conv_50 = LibDNNConvOp<DeviceTensor> ("conv_50_forward", 173056, &conv_50_weight, nullptr, std::vector<size_t> {16,4,1}, std::vector<size_t> {96,64,1});
-    BatchNormOp<DeviceTensor> bn_50 = BatchNormOp<DeviceTensor> (256, 676, 1e-05, &bn_50_mean, &bn_50_var, &bn_50_weight, &bn_50_bias);
+    ScaleOp<DeviceTensor> bn_50 = ScaleOp<DeviceTensor> (nullptr, &bn_50_bias, 256, 676, IN_PLACE);
     ReLUOp<DeviceTensor> leaky_50 = ReLUOp<DeviceTensor> ( 0.1, IN_PLACE );
     LibDNNConvOp<DeviceTensor> conv_51 = LibDNNConvOp<DeviceTensor> ("conv_51_forward", 346112, &conv_51_weight, nullptr, std::vector<size_t> {16,4,1}, std::vector<size_t> {96,128,1});
-    BatchNormOp<DeviceTensor> bn_51 = BatchNormOp<DeviceTensor> (512, 676, 1e-05, &bn_51_mean, &bn_51_var, &bn_51_weight, &bn_51_bias);
+    ScaleOp<DeviceTensor> bn_51 = ScaleOp<DeviceTensor> (nullptr, &bn_51_bias, 512, 676, IN_PLACE);
     ReLUOp<DeviceTensor> leaky_51 = ReLUOp<DeviceTensor> ( 0.1, IN_PLACE );
     LibDNNConvOp<DeviceTensor> conv_53 = LibDNNConvOp<DeviceTensor> ("conv_53_forward", 173056, &conv_53_weight, nullptr, std::vector<size_t> {16,4,1}, std::vector<size_t> {96,64,1});
-    BatchNormOp<DeviceTensor> bn_53 = BatchNormOp<DeviceTensor> (256, 676, 1e-05, &bn_53_mean, &bn_53_var, &bn_53_weight, &bn_53_bias);
+    ScaleOp<DeviceTensor> bn_53 = ScaleOp<DeviceTensor> (nullptr, &bn_53_bias, 256, 676, IN_PLACE);
     ReLUOp<DeviceTensor> leaky_53 = ReLUOp<DeviceTensor> ( 0.1, IN_PLACE );
     LibDNNConvOp<DeviceTensor> conv_54 = LibDNNConvOp<DeviceTensor> ("conv_54_forward", 346112, &conv_54_weight, nullptr, std::vector<size_t> {16,4,1}, std::vector<size_t> {96,128,1});
-    BatchNormOp<DeviceTensor> bn_54 = BatchNormOp<DeviceTensor> (512, 676, 1e-05, &bn_54_mean, &bn_54_var, &bn_54_weight, &bn_54_bias);
+    ScaleOp<DeviceTensor> bn_54 = ScaleOp<DeviceTensor> (nullptr, &bn_54_bias, 512, 676, IN_PLACE);
     ReLUOp<DeviceTensor> leaky_54 = ReLUOp<DeviceTensor> ( 0.1, IN_PLACE );
     LibDNNConvOp<DeviceTensor> conv_56 = LibDNNConvOp<DeviceTensor> ("conv_56_forward", 173056, &conv_56_weight, nullptr, std::vector<size_t> {16,4,1}, std::vector<size_t> {96,64,1});
-    BatchNormOp<DeviceTensor> bn_56 = BatchNormOp<DeviceTensor> (256, 676, 1e-05, &bn_56_mean, &bn_56_var, &bn_56_weight, &bn_56_bias);
+    ScaleOp<DeviceTensor> bn_56 = ScaleOp<DeviceTensor> (nullptr, &bn_56_bias, 256, 676, IN_PLACE);
     ReLUOp<DeviceTensor> leaky_56 = ReLUOp<DeviceTensor> ( 0.1, IN_PLACE );
     LibDNNConvOp<DeviceTensor> conv_57 = LibDNNConvOp<DeviceTensor> ("conv_57_forward", 346112, &conv_57_weight, nullptr, std::vector<size_t> {16,4,1}, std::vector<size_t> {96,128,1});
-    BatchNormOp<DeviceTensor> bn_57 = BatchNormOp<DeviceTensor> (512, 676, 1e-05, &bn_57_mean, &bn_57_var, &bn_57_weight, &bn_57_bias);
+    ScaleOp<DeviceTensor> bn_57 = ScaleOp<DeviceTensor> (nullptr, &bn_57_bias, 512, 676, IN_PLACE);
     ReLUOp<DeviceTensor> leaky_57 = ReLUOp<DeviceTensor> ( 0.1, IN_PLACE );
     LibDNNConvOp<DeviceTensor> conv_59 = LibDNNConvOp<DeviceTensor> ("conv_59_forward", 173056, &conv_59_weight, nullptr, std::vector<size_t> {16,4,1}, std::vector<size_t> {96,64,1});
-    BatchNormOp<DeviceTensor> bn_59 = BatchNormOp<DeviceTensor> (256, 676, 1e-05, &bn_59_mean, &bn_59_var, &bn_59_weight, &bn_59_bias);
+    ScaleOp<DeviceTensor> bn_59 = ScaleOp<DeviceTensor> (nullptr, &bn_59_bias, 256, 676, IN_PLACE);
     ReLUOp<DeviceTensor> leaky_59 = ReLUOp<DeviceTensor> ( 0.1, IN_PLACE );
     LibDNNConvOp<DeviceTensor> conv_60 = LibDNNConvOp<DeviceTensor> ("conv_60_forward", 346112, &conv_60_weight, nullptr, std::vector<size_t> {16,4,1}, std::vector<size_t> {96,128,1});
-    BatchNormOp<DeviceTensor> bn_60 = BatchNormOp<DeviceTensor> (512, 676, 1e-05, &bn_60_mean, &bn_60_var, &bn_60_weight, &bn_60_bias);
+    ScaleOp<DeviceTensor> bn_60 = ScaleOp<DeviceTensor> (nullptr, &bn_60_bias, 512, 676, IN_PLACE);
     ReLUOp<DeviceTensor> leaky_60 = ReLUOp<DeviceTensor> ( 0.1, IN_PLACE );
     LibDNNConvOp<DeviceTensor> conv_62 = LibDNNConvOp<DeviceTensor> ("conv_62_forward", 173056, &conv_62_weight, nullptr, std::vector<size_t> {16,4,1}, std::vector<size_t> {32,256,1});
-    BatchNormOp<DeviceTensor> bn_62 = BatchNormOp<DeviceTensor> (1024, 169, 1e-05, &bn_62_mean, &bn_62_var, &bn_62_weight, &bn_62_bias);
+    ScaleOp<DeviceTensor> bn_62 = ScaleOp<DeviceTensor> (nullptr, &bn_62_bias, 1024, 169, IN_PLACE);
     ReLUOp<DeviceTensor> leaky_62 = ReLUOp<DeviceTensor> ( 0.1, IN_PLACE );
     LibDNNConvOp<DeviceTensor> conv_63 = LibDNNConvOp<DeviceTensor> ("conv_63_forward", 86528, &conv_63_weight, nullptr, std::vector<size_t> {16,4,1}, std::vector<size_t> {32,128,1});
-    BatchNormOp<DeviceTensor> bn_63 = BatchNormOp<DeviceTensor> (512, 169, 1e-05, &bn_63_mean, &bn_63_var, &bn_63_weight, &bn_63_bias);
+    ScaleOp<DeviceTensor> bn_63 = ScaleOp<DeviceTensor> (nullptr, &bn_63_bias, 512, 169, IN_PLACE);
     ReLUOp<DeviceTensor> leaky_63 = ReLUOp<DeviceTensor> ( 0.1, IN_PLACE );
     LibDNNConvOp<DeviceTensor> conv_64 = LibDNNConvOp<DeviceTensor> ("conv_64_forward", 173056, &conv_64_weight, nullptr, std::vector<size_t> {16,4,1}, std::vector<size_t> {32,256,1});
-    BatchNormOp<DeviceTensor> bn_64 = BatchNormOp<DeviceTensor> (1024, 169, 1e-05, &bn_64_mean, &bn_64_var, &bn_64_weight, &bn_64_bias);
+    ScaleOp<DeviceTensor> bn_64 = ScaleOp<DeviceTensor> (nullptr, &bn_64_bias, 1024, 169, IN_PLACE);
     ReLUOp<DeviceTensor> leaky_64 = ReLUOp<DeviceTensor> ( 0.1, IN_PLACE );
     LibDNNConvOp<DeviceTensor> conv_66 = LibDNNConvOp<DeviceTensor> ("conv_66_forward", 86528, &conv_66_weight, nullptr, std::vector<size_t> {16,4,1}, std::vector<size_t> {32,128,1});
-    BatchNormOp<DeviceTensor> bn_66 = BatchNormOp<DeviceTensor> (512, 169, 1e-05, &bn_66_mean, &bn_66_var, &bn_66_weight, &bn_66_bias);
+    ScaleOp<DeviceTensor> bn_66 = ScaleOp<DeviceTensor> (nullptr, &bn_66_bias, 512, 169, IN_PLACE);
     ReLUOp<DeviceTensor> leaky_66 = ReLUOp<DeviceTensor> ( 0.1, IN_PLACE );
     LibDNNConvOp<DeviceTensor> conv_67 = LibDNNConvOp<DeviceTensor> ("conv_67_forward", 173056, &conv_67_weight, nullptr, std::vector<size_t> {16,4,1}, std::vector<size_t> {32,256,1});
-    BatchNormOp<DeviceTensor> bn_67 = BatchNormOp<DeviceTensor> (1024, 169, 1e-05, &bn_67_mean, &bn_67_var, &bn_67_weight, &bn_67_bias);
+    ScaleOp<DeviceTensor> bn_67 = ScaleOp<DeviceTensor> (nullptr, &bn_67_bias, 1024, 169, IN_PLACE);
     ReLUOp<DeviceTensor> leaky_67 = ReLUOp<DeviceTensor> ( 0.1, IN_PLACE );
     LibDNNConvOp<DeviceTensor> conv_69 = LibDNNConvOp<DeviceTensor> ("conv_69_forward", 86528, &conv_69_weight, nullptr, std::vector<size_t> {16,4,1}, std::vector<size_t> {32,128,1});
-    BatchNormOp<DeviceTensor> bn_69 = BatchNormOp<DeviceTensor> (512, 169, 1e-05, &bn_69_mean, &bn_69_var, &bn_69_weight, &bn_69_bias);
+    ScaleOp<DeviceTensor> bn_69 = ScaleOp<DeviceTensor> (nullptr, &bn_69_bias, 512, 169, IN_PLACE);
     ReLUOp<DeviceTensor> leaky_69 = ReLUOp<DeviceTensor> ( 0.1, IN_PLACE );
     LibDNNConvOp<DeviceTensor> conv_70 = LibDNNConvOp<DeviceTensor> ("conv_70_forward", 173056, &conv_70_weight, nullptr, std::vector<size_t> {16,4,1}, std::vector<size_t> {32,256,1});
-    BatchNormOp<DeviceTensor> bn_70 = BatchNormOp<DeviceTensor> (1024, 169, 1e-05, &bn_70_mean, &bn_70_var, &bn_70_weight, &bn_70_bias);
+    ScaleOp<DeviceTensor> bn_70 = ScaleOp<DeviceTensor> (nullptr, &bn_70_bias, 1024, 169, IN_PLACE);
     ReLUOp<DeviceTensor> leaky_70 = ReLUOp<DeviceTensor> ( 0.1, IN_PLACE );
     LibDNNConvOp<DeviceTensor> conv_72 = LibDNNConvOp<DeviceTensor> ("conv_72_forward", 86528, &conv_72_weight, nullptr, std::vector<size_t> {16,4,1}, std::vector<size_t> {32,128,1});
-    BatchNormOp<DeviceTensor> bn_72 = BatchNormOp<DeviceTensor> (512, 169, 1e-05, &bn_72_mean, &bn_72_var, &bn_72_weight, &bn_72_bias);
+    ScaleOp<DeviceTensor> bn_72 = ScaleOp<DeviceTensor> (nullptr, &bn_72_bias, 512, 169, IN_PLACE);
     ReLUOp<DeviceTensor> leaky_72 = ReLUOp<DeviceTensor> ( 0.1, IN_PLACE );
     LibDNNConvOp<DeviceTensor> conv_73 = LibDNNConvOp<DeviceTensor> ("conv_73_forward", 173056, &conv_73_weight, nullptr, std::vector<size_t> {16,4,1}, std::vector<size_t> {32,256,1});
-    BatchNormOp<DeviceTensor> bn_73 = BatchNormOp<DeviceTensor> (1024, 169, 1e-05, &bn_73_mean, &bn_73_var, &bn_73_weight, &bn_73_bias);
+    ScaleOp<DeviceTensor> bn_73 = ScaleOp<DeviceTensor> (nullptr, &bn_73_bias, 1024, 169, IN_PLACE);
     ReLUOp<DeviceTensor> leaky_73 = ReLUOp<DeviceTensor> ( 0.1, IN_PLACE );
     LibDNNConvOp<DeviceTensor> conv_75 = LibDNNConvOp<DeviceTensor> ("conv_75_forward", 86528, &conv_75_weight, nullptr, std::vector<size_t> {16,4,1}, std::vector<size_t> {32,128,1});
-    BatchNormOp<DeviceTensor> bn_75 = BatchNormOp<DeviceTensor> (512, 169, 1e-05, &bn_75_mean, &bn_75_var, &bn_75_weight, &bn_75_bias);
+    ScaleOp<DeviceTensor> bn_75 = ScaleOp<DeviceTensor> (nullptr, &bn_75_bias, 512, 169, IN_PLACE);
     ReLUOp<DeviceTensor> leaky_75 = ReLUOp<DeviceTensor> ( 0.1, IN_PLACE );
     LibDNNConvOp<DeviceTensor> conv_76 = LibDNNConvOp<DeviceTensor> ("conv_76_forward", 173056, &conv_76_weight, nullptr, std::vector<size_t> {16,4,1}, std::vector<size_t> {32,256,1});
-    BatchNormOp<DeviceTensor> bn_76 = BatchNormOp<DeviceTensor> (1024, 169, 1e-05, &bn_76_mean, &bn_76_var, &bn_76_weight, &bn_76_bias);
+    ScaleOp<DeviceTensor> bn_76 = ScaleOp<DeviceTensor> (nullptr, &bn_76_bias, 1024, 169, IN_PLACE);
     ReLUOp<DeviceTensor> leaky_76 = ReLUOp<DeviceTensor> ( 0.1, IN_PLACE );
     LibDNNConvOp<DeviceTensor> conv_77 = LibDNNConvOp<DeviceTensor> ("conv_77_forward", 86528, &conv_77_weight, nullptr, std::vector<size_t> {16,4,1}, std::vector<size_t> {32,128,1});
-    BatchNormOp<DeviceTensor> bn_77 = BatchNormOp<DeviceTensor> (512, 169, 1e-05, &bn_77_mean, &bn_77_var, &bn_77_weight, &bn_77_bias);
+    ScaleOp<DeviceTensor> bn_77 = ScaleOp<DeviceTensor> (nullptr, &bn_77_bias, 512, 169, IN_PLACE);
     ReLUOp<DeviceTensor> leaky_77 = ReLUOp<DeviceTensor> ( 0.1, IN_PLACE );
     LibDNNConvOp<DeviceTensor> conv_78 = LibDNNConvOp<DeviceTensor> ("conv_78_forward", 173056, &conv_78_weight, nullptr, std::vector<size_t> {16,4,1}, std::vector<size_t> {32,256,1});
-    BatchNormOp<DeviceTensor> bn_78 = BatchNormOp<DeviceTensor> (1024, 169, 1e-05, &bn_78_mean, &bn_78_var, &bn_78_weight, &bn_78_bias);
+    ScaleOp<DeviceTensor> bn_78 = ScaleOp<DeviceTensor> (nullptr, &bn_78_bias, 1024, 169, IN_PLACE);
     ReLUOp<DeviceTensor> leaky_78 = ReLUOp<DeviceTensor> ( 0.1, IN_PLACE );
     LibDNNConvOp<DeviceTensor> conv_79 = LibDNNConvOp<DeviceTensor> ("conv_79_forward", 86528, &conv_79_weight, nullptr, std::vector<size_t> {16,4,1}, std::vector<size_t> {32,128,1});
-    BatchNormOp<DeviceTensor> bn_79 = BatchNormOp<DeviceTensor> (512, 169, 1e-05, &bn_79_mean, &bn_79_var, &bn_79_weight, &bn_79_bias);
+    ScaleOp<DeviceTensor> bn_79 = ScaleOp<DeviceTensor> (nullptr, &bn_79_bias, 512, 169, IN_PLACE);
     ReLUOp<DeviceTensor> leaky_79 = ReLUOp<DeviceTensor> ( 0.1, IN_PLACE );
     LibDNNConvOp<DeviceTensor> conv_80 = LibDNNConvOp<DeviceTensor> ("conv_80_forward", 173056, &conv_80_weight, nullptr, std::vector<size_t> {16,4,1}, std::vector<size_t> {32,256,1});
-    BatchNormOp<DeviceTensor> bn_80 = BatchNormOp<DeviceTensor> (1024, 169, 1e-05, &bn_80_mean, &bn_80_var, &bn_80_weight, &bn_80_bias);
+    ScaleOp<DeviceTensor> bn_80 = ScaleOp<DeviceTensor> (nullptr, &bn_80_bias, 1024, 169, IN_PLACE);
     ReLUOp<DeviceTensor> leaky_80 = ReLUOp<DeviceTensor> ( 0.1, IN_PLACE );
     LibDNNConvOp<DeviceTensor> conv_81 = LibDNNConvOp<DeviceTensor> ("conv_81_forward", 43095, &conv_81_weight, &conv_81_bias, std::vector<size_t> {16,4,1}, std::vector<size_t> {32,64,1});
     LibDNNConvOp<DeviceTensor> conv_84 = LibDNNConvOp<DeviceTensor> ("conv_84_forward", 43264, &conv_84_weight, nullptr, std::vector<size_t> {16,4,1}, std::vector<size_t> {32,64,1});
     UpSampling2D<DeviceTensor> upsampling_85 = UpSampling2D<DeviceTensor>(2, 13, 13);
-    BatchNormOp<DeviceTensor> bn_84 = BatchNormOp<DeviceTensor> (256, 169, 1e-05, &bn_84_mean, &bn_84_var, &bn_84_weight, &bn_84_bias);
+    ScaleOp<DeviceTensor> bn_84 = ScaleOp<DeviceTensor> (nullptr, &bn_84_bias, 256, 169, IN_PLACE);
     ReLUOp<DeviceTensor> leaky_84 = ReLUOp<DeviceTensor> ( 0.1, IN_PLACE );
     LibDNNConvOp<DeviceTensor> conv_87 = LibDNNConvOp<DeviceTensor> ("conv_87_forward", 173056, &conv_87_weight, nullptr, std::vector<size_t> {16,4,1}, std::vector<size_t> {96,64,1});
-    BatchNormOp<DeviceTensor> bn_87 = BatchNormOp<DeviceTensor> (256, 676, 1e-05, &bn_87_mean, &bn_87_var, &bn_87_weight, &bn_87_bias);
+    ScaleOp<DeviceTensor> bn_87 = ScaleOp<DeviceTensor> (nullptr, &bn_87_bias, 256, 676, IN_PLACE);
     ReLUOp<DeviceTensor> leaky_87 = ReLUOp<DeviceTensor> ( 0.1, IN_PLACE );
     LibDNNConvOp<DeviceTensor> conv_88 = LibDNNConvOp<DeviceTensor> ("conv_88_forward", 346112, &conv_88_weight, nullptr, std::vector<size_t> {16,4,1}, std::vector<size_t> {96,128,1});
-    BatchNormOp<DeviceTensor> bn_88 = BatchNormOp<DeviceTensor> (512, 676, 1e-05, &bn_88_mean, &bn_88_var, &bn_88_weight, &bn_88_bias);
+    ScaleOp<DeviceTensor> bn_88 = ScaleOp<DeviceTensor> (nullptr, &bn_88_bias, 512, 676, IN_PLACE);
     ReLUOp<DeviceTensor> leaky_88 = ReLUOp<DeviceTensor> ( 0.1, IN_PLACE );
     LibDNNConvOp<DeviceTensor> conv_89 = LibDNNConvOp<DeviceTensor> ("conv_89_forward", 173056, &conv_89_weight, nullptr, std::vector<size_t> {16,4,1}, std::vector<size_t> {96,64,1});
-    BatchNormOp<DeviceTensor> bn_89 = BatchNormOp<DeviceTensor> (256, 676, 1e-05, &bn_89_mean, &bn_89_var, &bn_89_weight, &bn_89_bias);
+    ScaleOp<DeviceTensor> bn_89 = ScaleOp<DeviceTensor> (nullptr, &bn_89_bias, 256, 676, IN_PLACE);
     ReLUOp<DeviceTensor> leaky_89 = ReLUOp<DeviceTensor> ( 0.1, IN_PLACE );
     LibDNNConvOp<DeviceTensor> conv_90 = LibDNNConvOp<DeviceTensor> ("conv_90_forward", 346112, &conv_90_weight, nullptr, std::vector<size_t> {16,4,1}, std::vector<size_t> {96,128,1});
-    BatchNormOp<DeviceTensor> bn_90 = BatchNormOp<DeviceTensor> (512, 676, 1e-05, &bn_90_mean, &bn_90_var, &bn_90_weight, &bn_90_bias);
+    ScaleOp<DeviceTensor> bn_90 = ScaleOp<DeviceTensor> (nullptr, &bn_90_bias, 512, 676, IN_PLACE);
     ReLUOp<DeviceTensor> leaky_90 = ReLUOp<DeviceTensor> ( 0.1, IN_PLACE );
     LibDNNConvOp<DeviceTensor> conv_91 = LibDNNConvOp<DeviceTensor> ("conv_91_forward", 173056, &conv_91_weight, nullptr, std::vector<size_t> {16,4,1}, std::vector<size_t> {96,64,1});
-    BatchNormOp<DeviceTensor> bn_91 = BatchNormOp<DeviceTensor> (256, 676, 1e-05, &bn_91_mean, &bn_91_var, &bn_91_weight, &bn_91_bias);
+    ScaleOp<DeviceTensor> bn_91 = ScaleOp<DeviceTensor> (nullptr, &bn_91_bias, 256, 676, IN_PLACE);
     ReLUOp<DeviceTensor> leaky_91 = ReLUOp<DeviceTensor> ( 0.1, IN_PLACE );
     LibDNNConvOp<DeviceTensor> conv_92 = LibDNNConvOp<DeviceTensor> ("conv_92_forward", 346112, &conv_92_weight, nullptr, std::vector<size_t> {16,4,1}, std::vector<size_t> {96,128,1});
-    BatchNormOp<DeviceTensor> bn_92 = BatchNormOp<DeviceTensor> (512, 676, 1e-05, &bn_92_mean, &bn_92_var, &bn_92_weight, &bn_92_bias);
+    ScaleOp<DeviceTensor> bn_92 = ScaleOp<DeviceTensor> (nullptr, &bn_92_bias, 512, 676, IN_PLACE);
     ReLUOp<DeviceTensor> leaky_92 = ReLUOp<DeviceTensor> ( 0.1, IN_PLACE );
     LibDNNConvOp<DeviceTensor> conv_93 = LibDNNConvOp<DeviceTensor> ("conv_93_forward", 172380, &conv_93_weight, &conv_93_bias, std::vector<size_t> {16,4,1}, std::vector<size_t> {96,64,1});
     LibDNNConvOp<DeviceTensor> conv_96 = LibDNNConvOp<DeviceTensor> ("conv_96_forward", 86528, &conv_96_weight, nullptr, std::vector<size_t> {16,4,1}, std::vector<size_t> {96,32,1});
-    BatchNormOp<DeviceTensor> bn_96 = BatchNormOp<DeviceTensor> (128, 676, 1e-05, &bn_96_mean, &bn_96_var, &bn_96_weight, &bn_96_bias);
+    ScaleOp<DeviceTensor> bn_96 = ScaleOp<DeviceTensor> (nullptr, &bn_96_bias, 128, 676, IN_PLACE);
     ReLUOp<DeviceTensor> leaky_96 = ReLUOp<DeviceTensor> ( 0.1, IN_PLACE );
     UpSampling2D<DeviceTensor> upsampling_97 = UpSampling2D<DeviceTensor>(2, 26, 26);
     LibDNNConvOp<DeviceTensor> conv_99 = LibDNNConvOp<DeviceTensor> ("conv_99_forward", 346112, &conv_99_weight, nullptr, std::vector<size_t> {16,4,1}, std::vector<size_t> {352,32,1});
-    BatchNormOp<DeviceTensor> bn_99 = BatchNormOp<DeviceTensor> (128, 2704, 1e-05, &bn_99_mean, &bn_99_var, &bn_99_weight, &bn_99_bias);
+    ScaleOp<DeviceTensor> bn_99 = ScaleOp<DeviceTensor> (nullptr, &bn_99_bias, 128, 2704, IN_PLACE);
     ReLUOp<DeviceTensor> leaky_99 = ReLUOp<DeviceTensor> ( 0.1, IN_PLACE );
     LibDNNConvOp<DeviceTensor> conv_100 = LibDNNConvOp<DeviceTensor> ("conv_100_forward", 692224, &conv_100_weight, nullptr, std::vector<size_t> {16,4,1}, std::vector<size_t> {352,64,1});
-    BatchNormOp<DeviceTensor> bn_100 = BatchNormOp<DeviceTensor> (256, 2704, 1e-05, &bn_100_mean, &bn_100_var, &bn_100_weight, &bn_100_bias);
+    ScaleOp<DeviceTensor> bn_100 = ScaleOp<DeviceTensor> (nullptr, &bn_100_bias, 256, 2704, IN_PLACE);
     ReLUOp<DeviceTensor> leaky_100 = ReLUOp<DeviceTensor> ( 0.1, IN_PLACE );
     LibDNNConvOp<DeviceTensor> conv_101 = LibDNNConvOp<DeviceTensor> ("conv_101_forward", 346112, &conv_101_weight, nullptr, std::vector<size_t> {16,4,1}, std::vector<size_t> {352,32,1});
-    BatchNormOp<DeviceTensor> bn_101 = BatchNormOp<DeviceTensor> (128, 2704, 1e-05, &bn_101_mean, &bn_101_var, &bn_101_weight, &bn_101_bias);
+    ScaleOp<DeviceTensor> bn_101 = ScaleOp<DeviceTensor> (nullptr, &bn_101_bias, 128, 2704, IN_PLACE);
     ReLUOp<DeviceTensor> leaky_101 = ReLUOp<DeviceTensor> ( 0.1, IN_PLACE );
     LibDNNConvOp<DeviceTensor> conv_102 = LibDNNConvOp<DeviceTensor> ("conv_102_forward", 692224, &conv_102_weight, nullptr, std::vector<size_t> {16,4,1}, std::vector<size_t> {352,64,1});
-    BatchNormOp<DeviceTensor> bn_102 = BatchNormOp<DeviceTensor> (256, 2704, 1e-05, &bn_102_mean, &bn_102_var, &bn_102_weight, &bn_102_bias);
+    ScaleOp<DeviceTensor> bn_102 = ScaleOp<DeviceTensor> (nullptr, &bn_102_bias, 256, 2704, IN_PLACE);
     ReLUOp<DeviceTensor> leaky_102 = ReLUOp<DeviceTensor> ( 0.1, IN_PLACE );
     LibDNNConvOp<DeviceTensor> conv_103 = LibDNNConvOp<DeviceTensor> ("conv_103_forward", 346112, &conv_103_weight, nullptr, std::vector<size_t> {16,4,1}, std::vector<size_t> {352,32,1});
-    BatchNormOp<DeviceTensor> bn_103 = BatchNormOp<DeviceTensor> (128, 2704, 1e-05, &bn_103_mean, &bn_103_var, &bn_103_weight, &bn_103_bias);
+    ScaleOp<DeviceTensor> bn_103 = ScaleOp<DeviceTensor> (nullptr, &bn_103_bias, 128, 2704, IN_PLACE);
     ReLUOp<DeviceTensor> leaky_103 = ReLUOp<DeviceTensor> ( 0.1, IN_PLACE );
     LibDNNConvOp<DeviceTensor> conv_104 = LibDNNConvOp<DeviceTensor> ("conv_104_forward", 692224, &conv_104_weight, nullptr, std::vector<size_t> {16,4,1}, std::vector<size_t> {352,64,1});
-    BatchNormOp<DeviceTensor> bn_104 = BatchNormOp<DeviceTensor> (256, 2704, 1e-05, &bn_104_mean, &bn_104_var, &bn_104_weight, &bn_104_bias);
+    ScaleOp<DeviceTensor> bn_104 = ScaleOp<DeviceTensor> (nullptr, &bn_104_bias, 256, 2704, IN_PLACE);
     ReLUOp<DeviceTensor> leaky_104 = ReLUOp<DeviceTensor> ( 0.1, IN_PLACE );
     LibDNNConvOp<DeviceTensor> conv_105 = LibDNNConvOp<DeviceTensor> ("conv_105_forward", 689520, &conv_105_weight, &conv_105_bias, std::vector<size_t> {16,4,1}, std::vector<size_t> {352,64,1});
 
+    Graph<DeviceTensor> graph_;
+
 };
 
 
@@ -0,0 +1,37 @@
+#include "demo_net.hpp"
+#include "../model_bench.hpp"
+
+
+#ifdef USE_OPENCL
+using DeviceTensor = hypertea::TensorGPU<float>;
+#else
+using DeviceTensor = hypertea::TensorCPU<float>;
+#endif
+
+// ./yolo_bench --iterations=100 --output=yolo.json
+//
+// Synthetic weights make the folded BatchNorm statistics meaningless, so
+// hardly anything is detected and the host side post-processing is cheaper
+// than on real weights and images.
+int main(int argc, char** argv) {
+
+    hypertea::ModelBenchmarkOptions options;
+    if (!hypertea::parse_model_benchmark_options(argc, argv, options)) { return 1; }
+
+    std::vector<float> input_vector = hypertea::synthetic_input(3*416*416);
+    std::vector<float> output_vector(3*416*416);
+
+    hypertea::ModelWeights weights(options, 62001757);
+    hypertea::yolo_net<DeviceTensor> yolo3(weights.path());
+
+    if (options.check) {
+        std::vector<float> reference_vector;
+        yolo3.reference_inference(DeviceTensor(input_vector), reference_vector);
+        yolo3.inference(input_vector, output_vector);
+        return hypertea::check_model_outputs("yolo", output_vector, reference_vector);
+    }
+
+    return hypertea::run_model_benchmark("yolo", options, [&]() {
+        yolo3.inference(input_vector, output_vector);
+    });
+}
@@ -51,14 +51,32 @@ int main(int argc, char** argv) {
     Timer timer;
 
     timer.Start();
-    
+
+#ifdef USE_OPENCL
+    // Frame i + 1 is uploaded while the kernels of frame i run.
+    hypertea::TensorUploader<float> uploader(input_vector.size());
+    uploader.upload(input_vector.data());
+
+    for (int i = 0; i < 500; ++i) {
+        auto x = uploader.take();
+        if (i + 1 < 500) { uploader.upload(input_vector.data()); }
+        yolo3.inference(*x, output_vector);
+    }
+#else
     for (int i = 0; i < 500; ++i) {
         yolo3.inference(input_vector, output_vector);
     }
+#endif
     
     timer.Stop();
 
     std::cout << "Time difference = " << timer.MilliSeconds() << "ms" <<std::endl;
+
+    // HYPERTEA_PROFILE=1 ./yolo_demo
+    if (hypertea::Profiler::Get().enabled()) {
+        hypertea::Profiler::Get().report(std::cout);
+        hypertea::Profiler::Get().write_chrome_trace("yolo_trace.json");
+    }
     
 
     // for (auto const&x: output_vector) {